@@ -182,6 +182,7 @@ fuzztest::Domain<MeshFormat::IndexFormat> ArbitraryMeshIndexFormat() {
   return fuzztest::ElementOf({
       MeshFormat::IndexFormat::k16BitUnpacked16BitPacked,
       MeshFormat::IndexFormat::k32BitUnpacked16BitPacked,
+      MeshFormat::IndexFormat::k32BitUnpacked32BitPacked,
   });
 }
 // LINT.ThenChange()
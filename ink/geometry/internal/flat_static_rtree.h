@@ -0,0 +1,1028 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INK_GEOMETRY_INTERNAL_FLAT_STATIC_RTREE_H_
+#define INK_GEOMETRY_INTERNAL_FLAT_STATIC_RTREE_H_
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/functional/function_ref.h"
+#include "absl/log/absl_check.h"
+#include "absl/strings/substitute.h"
+#include "absl/types/span.h"
+#include "ink/geometry/envelope.h"
+#include "ink/geometry/internal/intersects_internal.h"
+#include "ink/geometry/internal/static_rtree.h"
+#include "ink/geometry/point.h"
+#include "ink/geometry/rect.h"
+
+namespace ink::geometry_internal {
+
+// A variant of `StaticRTree` whose storage is laid out for fast queries.
+// It is built with the same Sort-Tile-Recursive bulk-loading, so it has the
+// same tree structure, but:
+// - The bounds of every node's children, including the leaf elements, are
+//   computed once at construction and stored alongside the parent. This means
+//   that no bounds function is kept, and queries never need to recompute the
+//   bounds of an element (e.g. by decoding the vertices of a triangle).
+// - Each branch node's child bounds are stored as a structure-of-arrays block
+//   of `kBranchingFactor` x-min, y-min, x-max, and y-max values, so a single
+//   branch-free loop tests a query against all children of a node at once.
+// - Branch nodes are stored in breadth-first order, so the children of each
+//   branch node are contiguous, and a node only needs the index of its first
+//   child instead of a list of child indices.
+//
+// The trade-off is memory: this stores 16 bytes of bounds per element (plus
+// padding for branch nodes that aren't full), which `StaticRTree` recomputes
+// on demand instead.
+//
+// Template parameters `T` and `kBranchingFactor` are as for `StaticRTree`.
+// `kBranchingFactor` may not exceed 32, so that the result of testing a node's
+// children fits in a `uint32_t` bitmask.
+template <typename T, uint32_t kBranchingFactor = 16>
+class FlatStaticRTree {
+ public:
+  static_assert(kBranchingFactor >= 2,
+                "kBranchingFactor must be at least 2 to form a tree");
+  static_assert(kBranchingFactor <= 32,
+                "kBranchingFactor must be at most 32 to fit in a bitmask");
+
+  // Constructs an empty `FlatStaticRTree`.
+  FlatStaticRTree() = default;
+
+  // Constructs a `FlatStaticRTree` containing `elements`, using `bounds_func`
+  // to compute the bounding rectangle of each element.
+  //
+  // Template parameter `BoundsFunc` must have a function call operator of the
+  // form:
+  //   Rect Foo(const T& element)
+  // It is only called during construction, so it may safely reference data
+  // that does not outlive the `FlatStaticRTree`.
+  //
+  // This CHECK-fails if `elements` contains more than 2^32 (4294967296)
+  // elements.
+  template <typename BoundsFunc>
+  FlatStaticRTree(absl::Span<const T> elements, BoundsFunc bounds_func);
+
+  // Constructs a `FlatStaticRTree` containing `n_elements` objects, which are
+  // generated by repeatedly calling `generator`, using `bounds_func` to compute
+  // the bounding rectangle of each element.
+  //
+  // Template parameter `Generator` must have a zero-argument function call
+  // operator that returns an object that is convertible to `T`, and it must be
+  // valid to call `generator()` at least `n_elements` times. Template parameter
+  // `BoundsFunc` is as above.
+  template <typename Generator, typename BoundsFunc>
+  FlatStaticRTree(uint32_t n_elements, Generator generator,
+                  BoundsFunc bounds_func);
+
+  // Returns a `FlatStaticRTree` with the structure described by `elements`
+  // and `child_counts`, which must be the `Elements()` and `ChildCounts()` of
+  // an existing tree, using `bounds_func` (as above) to compute the bounding
+  // rectangle of each element. Since the elements are already in order, this
+  // skips the sorting done by the other constructors, e.g. to restore a tree
+  // that was stored alongside its elements.
+  //
+  // Returns `std::nullopt` if `child_counts` does not describe a valid tree
+  // of `elements.size()` elements, laid out as by the other constructors.
+  template <typename BoundsFunc>
+  static std::optional<FlatStaticRTree> FromLayout(
+      std::vector<T> elements, absl::Span<const uint32_t> child_counts,
+      BoundsFunc bounds_func);
+
+  FlatStaticRTree(const FlatStaticRTree&) = default;
+  FlatStaticRTree(FlatStaticRTree&&) = default;
+  FlatStaticRTree& operator=(const FlatStaticRTree&) = default;
+  FlatStaticRTree& operator=(FlatStaticRTree&&) = default;
+
+  // Visits the elements whose bounding box intersects `bounds`, (per the
+  // `Intersects` function), with the same semantics as
+  // `StaticRTree::VisitIntersectedElements`.
+  void VisitIntersectedElements(
+      const Rect& bounds, absl::FunctionRef<bool(const T&)> visitor) const;
+
+  // Visits, for each rectangle in `queries`, the elements whose bounding box
+  // intersects it, as if by calling `VisitIntersectedElements` once per query.
+  // The queries are sorted into small groups of nearby rectangles, and the
+  // tree is traversed once per group using the group's combined bounds, so the
+  // branch nodes above the leaves are tested once per group instead of once per
+  // query. This is faster than separate queries when nearby queries hit the
+  // same nodes, e.g. for the segments of an eraser path.
+  //
+  // `visitor` is called with the index of the query in `queries` and the
+  // element. If it returns false, no more elements will be visited for that
+  // query; the traversal continues for the other queries. The visitation order
+  // should be assumed to be arbitrary, including the interleaving of queries.
+  //
+  // This CHECK-fails if `queries` contains more than 2^32 (4294967296)
+  // rectangles.
+  void VisitIntersectedElementsBatch(
+      absl::Span<const Rect> queries,
+      absl::FunctionRef<bool(size_t query_index, const T&)> visitor) const;
+
+  // The return value of the visitor passed to `VisitIntersectedElementPairs`.
+  enum class PairFlowControl {
+    // Continue to the next pair.
+    kContinue,
+    // Skip the remaining pairs for the current element of this tree.
+    kNextElement,
+    // Stop the traversal.
+    kBreak,
+  };
+
+  // Visits, for each element of this tree whose bounding box intersects
+  // `bounds`, the elements of `other` whose bounding box intersects its
+  // bounding box mapped into `other`'s coordinate space by `bounds_to_other`.
+  // This traverses both trees at once: each branch node of this tree carries
+  // the set of `other`'s nodes that may intersect it, which is narrowed as the
+  // traversal descends, so `other` is not searched from the root for each
+  // element.
+  //
+  // `bounds_to_other` must be conservative and monotonic: the result for a
+  // rectangle must contain the result for any rectangle inside of it.
+  // Otherwise, pairs of elements may be missed.
+  //
+  // All of the pairs for an element of this tree are visited consecutively,
+  // and each pair is visited at most once. Otherwise, the visitation order
+  // should be assumed to be arbitrary.
+  template <typename U>
+  void VisitIntersectedElementPairs(
+      const Rect& bounds, const FlatStaticRTree<U, kBranchingFactor>& other,
+      absl::FunctionRef<Rect(const Rect&)> bounds_to_other,
+      // `std::type_identity_t` prevents `U` from being deduced from this
+      // argument, so that it can be passed a lambda.
+      absl::FunctionRef<PairFlowControl(const T&,
+                                        const std::type_identity_t<U>&)>
+          visitor) const;
+
+  // Sets the weight of each element to `weight_func(element)`, and stores the
+  // total weight of each sub-tree, for use with
+  // `WeightOfIntersectedElementsIsGreaterThan`. Weights must be non-negative.
+  template <typename WeightFunc>
+  void InitializeWeights(WeightFunc weight_func);
+
+  // Returns true if `InitializeWeights` has been called.
+  bool HasWeights() const { return has_weights_; }
+
+  // How a query relates to a rectangle, as reported by the `bounds_relation`
+  // callback of `WeightOfIntersectedElementsIsGreaterThan`.
+  enum class BoundsRelation {
+    // The query does not intersect the rectangle.
+    kDisjoint,
+    // The query contains the rectangle, and therefore every element inside it.
+    kContained,
+    // Neither of the above is known to hold.
+    kIntersecting,
+  };
+
+  // Returns whether the total weight of the elements that intersect a query is
+  // greater than `threshold`. The query is described by two callbacks:
+  // `bounds_relation`, which classifies a rectangle against the query, and
+  // `intersects_element`, which tests an element whose bounds were classified
+  // as `kIntersecting`. If `bounds_relation` returns `kContained` for a
+  // sub-tree's bounds, all of its elements are counted without visiting them.
+  //
+  // This stops as soon as the weight found so far exceeds `threshold`, or the
+  // weight that remains to be classified can no longer bring it above
+  // `threshold`.
+  //
+  // This CHECK-fails if the tree is non-empty and `InitializeWeights` has not
+  // been called.
+  bool WeightOfIntersectedElementsIsGreaterThan(
+      double threshold,
+      absl::FunctionRef<BoundsRelation(const Rect&)> bounds_relation,
+      absl::FunctionRef<bool(const T&)> intersects_element) const;
+
+  // An element, and its distance from a query.
+  struct ElementAndDistance {
+    T element;
+    float distance;
+  };
+
+  // Returns the element nearest to a query, as measured by `element_distance`,
+  // if its distance is at most `max_distance`; otherwise, returns
+  // `std::nullopt`. If several elements are equally near, which one is
+  // returned is unspecified.
+  //
+  // `bounds_distance` must return a lower bound on `element_distance` for all
+  // elements whose bounds lie inside the given rectangle. Nodes are searched
+  // best-first by that bound, and nodes that can't contain an element nearer
+  // than the best one found so far (or within `max_distance`) are skipped, so
+  // a small `max_distance` limits the search to the nodes near the query.
+  std::optional<ElementAndDistance> FindNearestElement(
+      float max_distance, absl::FunctionRef<float(const Rect&)> bounds_distance,
+      absl::FunctionRef<float(const T&)> element_distance) const;
+
+  // Returns the elements in the tree. Note that these are reordered during
+  // construction, so that the children of each branch node are contiguous.
+  absl::Span<const T> Elements() const { return elements_; }
+
+  // Returns the number of branch nodes in the tree.
+  uint32_t BranchNodeCount() const { return first_child_indices_.size(); }
+
+  // Returns the number of children of each branch node, in breadth-first
+  // order. Together with `Elements()`, this describes the structure of the
+  // tree; see `FromLayout`.
+  std::vector<uint32_t> ChildCounts() const;
+
+ private:
+  template <typename U, uint32_t kOtherBranchingFactor>
+  friend class FlatStaticRTree;
+
+  // The number of floats in the bounds block for each branch node.
+  static constexpr size_t kBoundsBlockSize = 4 * kBranchingFactor;
+
+  // The number of queries that share a traversal in
+  // `VisitIntersectedElementsBatch`.
+  static constexpr size_t kBatchGroupSize = 8;
+
+  // Builds the tree from `elements_`, whose bounds are `element_bounds`, and
+  // reorders `elements_` to match the leaf order. If `elements_` is empty,
+  // this is a no-op.
+  void InitializeTree(absl::Span<const Rect> element_bounds);
+
+  // A branch node, and its bounds.
+  struct BoundedBranch {
+    uint32_t branch_idx;
+    Rect bounds;
+  };
+
+  // Sets the bounds of the `child`th child of the branch node at
+  // `branch_index`.
+  void SetChildBounds(uint32_t branch_index, uint32_t child,
+                      const Rect& bounds);
+
+  // Returns the bounds of the `child`th child of the branch node at
+  // `branch_index`, or `std::nullopt` if that slot is padding.
+  std::optional<Rect> ChildBounds(uint32_t branch_index, uint32_t child) const;
+
+  // Returns a bitmask in which bit `i` is set if the `i`th child of the branch
+  // node at `branch_index` intersects `bounds`.
+  uint32_t IntersectedChildMask(uint32_t branch_index,
+                                const Rect& bounds) const;
+
+  // Returns the position of the center of `rect` along a Z-order curve through
+  // the root bounds, used to group nearby queries in
+  // `VisitIntersectedElementsBatch`.
+  uint32_t ZOrderOfCenter(const Rect& rect) const;
+
+  // Visits the pairs of `element`, whose bounds mapped into `other`'s space are
+  // `mapped_bounds`, with the elements of `other` in the sub-trees rooted at
+  // `other_branches` whose bounds intersect `mapped_bounds`. Returns `kBreak`
+  // if the visitor did, and `kContinue` otherwise.
+  template <typename U>
+  PairFlowControl VisitElementPairs(
+      const T& element, const Rect& mapped_bounds,
+      const FlatStaticRTree<U, kBranchingFactor>& other,
+      absl::Span<const typename FlatStaticRTree<U, kBranchingFactor>::
+                     BoundedBranch>
+          other_branches,
+      absl::FunctionRef<PairFlowControl(const T&, const U&)> visitor) const;
+
+  // The bounds of the root node, i.e. of all elements.
+  Rect root_bounds_;
+
+  // For each branch node, in breadth-first order, a block of
+  // `kBoundsBlockSize` floats, holding the x-min, y-min, x-max, and y-max of
+  // its children, in that order. Unused slots hold NaN, so that they never
+  // compare as intersecting.
+  std::vector<float> child_bounds_;
+
+  // For each branch node, in breadth-first order, the index of its first
+  // child. For branch nodes at or after `first_leaf_parent_index_`, this is an
+  // index into `elements_`; for the others, it is the index of a branch node.
+  std::vector<uint32_t> first_child_indices_;
+
+  // The index of the first branch node whose children are elements. Because
+  // the tree is balanced, these are exactly the last nodes in breadth-first
+  // order.
+  uint32_t first_leaf_parent_index_ = 0;
+
+  // For each branch node, in breadth-first order, a block of
+  // `kBranchingFactor` doubles, holding the total weight of each of its
+  // children. Unused slots hold zero. This is empty until `InitializeWeights`
+  // is called.
+  std::vector<double> child_weights_;
+
+  // The total weight of all elements.
+  double root_weight_ = 0;
+
+  bool has_weights_ = false;
+
+  std::vector<T> elements_;
+};
+
+// -----------------------------------------------------------------------------
+//                     Implementation details below
+
+template <typename T, uint32_t kBranchingFactor>
+template <typename BoundsFunc>
+FlatStaticRTree<T, kBranchingFactor>::FlatStaticRTree(
+    absl::Span<const T> elements, BoundsFunc bounds_func)
+    : elements_(elements.begin(), elements.end()) {
+  ABSL_CHECK_LE(elements.size(), uint64_t{1} << 32) << absl::Substitute(
+      "FlatStaticRTree supports a maximum of 2^32 (4294967296) elements; $0 "
+      "were given",
+      elements.size());
+  std::vector<Rect> element_bounds(elements_.size());
+  absl::c_transform(elements_, element_bounds.begin(), bounds_func);
+  InitializeTree(element_bounds);
+}
+
+template <typename T, uint32_t kBranchingFactor>
+template <typename Generator, typename BoundsFunc>
+FlatStaticRTree<T, kBranchingFactor>::FlatStaticRTree(uint32_t n_elements,
+                                                      Generator generator,
+                                                      BoundsFunc bounds_func) {
+  elements_.resize(n_elements);
+  absl::c_generate(elements_, generator);
+  std::vector<Rect> element_bounds(elements_.size());
+  absl::c_transform(elements_, element_bounds.begin(), bounds_func);
+  InitializeTree(element_bounds);
+}
+
+template <typename T, uint32_t kBranchingFactor>
+void FlatStaticRTree<T, kBranchingFactor>::InitializeTree(
+    absl::Span<const Rect> element_bounds) {
+  if (elements_.empty()) return;
+
+  // First, build the tree with the same depth-major layout as `StaticRTree`,
+  // recording the children of each branch node as a span of `child_indices`.
+  absl::InlinedVector<uint32_t, kMaxExpectedRTreeBranchDepth>
+      n_branch_nodes_at_depth = ComputeNumberOfRTreeBranchNodesAtDepth(
+          elements_.size(), kBranchingFactor);
+  absl::InlinedVector<uint32_t, kMaxExpectedRTreeBranchDepth>
+      branch_depth_offsets =
+          ComputeRTreeBranchDepthOffsets(n_branch_nodes_at_depth);
+  uint32_t n_branch_nodes =
+      branch_depth_offsets.back() + n_branch_nodes_at_depth.back();
+
+  std::vector<Rect> branch_bounds(n_branch_nodes);
+  std::vector<uint32_t> child_indices;
+  child_indices.reserve(elements_.size() + n_branch_nodes - 1);
+  std::vector<uint32_t> child_index_offsets(n_branch_nodes);
+  std::vector<uint32_t> child_counts(n_branch_nodes);
+  auto assign_children_to_parent =
+      [&branch_bounds, &child_indices, &child_index_offsets, &child_counts](
+          uint32_t parent_idx, const Rect& bounds,
+          absl::Span<const uint32_t> children) {
+        branch_bounds[parent_idx] = bounds;
+        child_index_offsets[parent_idx] = child_indices.size();
+        child_counts[parent_idx] = children.size();
+        child_indices.insert(child_indices.end(), children.begin(),
+                             children.end());
+      };
+
+  BulkLoadOneLevelOfNodes(
+      branch_depth_offsets.back(), n_branch_nodes_at_depth.back(),
+      /* index_of_first_child_node = */ 0, elements_.size(),
+      [element_bounds](uint32_t idx) { return element_bounds[idx]; },
+      assign_children_to_parent, kBranchingFactor);
+  for (int depth = n_branch_nodes_at_depth.size() - 2; depth >= 0; --depth) {
+    BulkLoadOneLevelOfNodes(
+        branch_depth_offsets[depth], n_branch_nodes_at_depth[depth],
+        branch_depth_offsets[depth + 1], n_branch_nodes_at_depth[depth + 1],
+        [&branch_bounds](uint32_t idx) { return branch_bounds[idx]; },
+        assign_children_to_parent, kBranchingFactor);
+  }
+
+  // Then, copy the nodes into breadth-first order. `bfs_order` maps each new
+  // branch node index to its index in the depth-major layout; it is extended
+  // with each node's children as that node is copied.
+  root_bounds_ = branch_bounds.front();
+  first_leaf_parent_index_ = branch_depth_offsets.back();
+  child_bounds_.assign(n_branch_nodes * kBoundsBlockSize,
+                       std::numeric_limits<float>::quiet_NaN());
+  first_child_indices_.resize(n_branch_nodes);
+  std::vector<uint32_t> bfs_order = {0};
+  bfs_order.reserve(n_branch_nodes);
+  std::vector<T> ordered_elements;
+  ordered_elements.reserve(elements_.size());
+  for (uint32_t branch_idx = 0; branch_idx < n_branch_nodes; ++branch_idx) {
+    uint32_t old_idx = bfs_order[branch_idx];
+    bool is_leaf_parent = branch_idx >= first_leaf_parent_index_;
+    // Breadth-first order visits the tree one depth at a time, so it keeps
+    // the leaf parents at the end.
+    ABSL_DCHECK_EQ(is_leaf_parent, old_idx >= first_leaf_parent_index_);
+    first_child_indices_[branch_idx] =
+        is_leaf_parent ? ordered_elements.size() : bfs_order.size();
+    absl::Span<const uint32_t> children = absl::MakeConstSpan(
+        &child_indices[child_index_offsets[old_idx]], child_counts[old_idx]);
+    for (size_t i = 0; i < children.size(); ++i) {
+      SetChildBounds(branch_idx, i,
+                     is_leaf_parent ? element_bounds[children[i]]
+                                    : branch_bounds[children[i]]);
+      if (is_leaf_parent) {
+        ordered_elements.push_back(std::move(elements_[children[i]]));
+      } else {
+        bfs_order.push_back(children[i]);
+      }
+    }
+  }
+  elements_ = std::move(ordered_elements);
+}
+
+template <typename T, uint32_t kBranchingFactor>
+template <typename BoundsFunc>
+std::optional<FlatStaticRTree<T, kBranchingFactor>>
+FlatStaticRTree<T, kBranchingFactor>::FromLayout(
+    std::vector<T> elements, absl::Span<const uint32_t> child_counts,
+    BoundsFunc bounds_func) {
+  FlatStaticRTree rtree;
+  if (elements.empty()) {
+    if (!child_counts.empty()) return std::nullopt;
+    return rtree;
+  }
+  if (elements.size() > uint64_t{1} << 32) return std::nullopt;
+
+  absl::InlinedVector<uint32_t, kMaxExpectedRTreeBranchDepth>
+      n_branch_nodes_at_depth = ComputeNumberOfRTreeBranchNodesAtDepth(
+          elements.size(), kBranchingFactor);
+  absl::InlinedVector<uint32_t, kMaxExpectedRTreeBranchDepth>
+      branch_depth_offsets =
+          ComputeRTreeBranchDepthOffsets(n_branch_nodes_at_depth);
+  uint32_t n_branch_nodes =
+      branch_depth_offsets.back() + n_branch_nodes_at_depth.back();
+  if (child_counts.size() != n_branch_nodes) return std::nullopt;
+
+  // In breadth-first order, the children of each branch node immediately
+  // follow those of the previous one, so the index of each node's first child
+  // is the sum of the child counts before it. Every branch node but the root
+  // must be the child of exactly one other, and likewise every element; since
+  // every node's children come after it, this guarantees that the result is a
+  // tree.
+  rtree.first_leaf_parent_index_ = branch_depth_offsets.back();
+  rtree.first_child_indices_.resize(n_branch_nodes);
+  uint64_t next_branch_idx = 1;
+  uint64_t next_element_idx = 0;
+  for (uint32_t branch_idx = 0; branch_idx < n_branch_nodes; ++branch_idx) {
+    uint32_t n_children = child_counts[branch_idx];
+    if (n_children == 0 || n_children > kBranchingFactor) return std::nullopt;
+    uint64_t& next_child_idx = branch_idx < rtree.first_leaf_parent_index_
+                                   ? next_branch_idx
+                                   : next_element_idx;
+    rtree.first_child_indices_[branch_idx] = next_child_idx;
+    next_child_idx += n_children;
+  }
+  if (next_branch_idx != n_branch_nodes ||
+      next_element_idx != elements.size()) {
+    return std::nullopt;
+  }
+
+  // Compute the bounds of each branch node from those of its children, from
+  // the leaves up.
+  rtree.elements_ = std::move(elements);
+  rtree.child_bounds_.assign(n_branch_nodes * kBoundsBlockSize,
+                             std::numeric_limits<float>::quiet_NaN());
+  std::vector<Rect> branch_bounds(n_branch_nodes);
+  for (uint32_t branch_idx = n_branch_nodes; branch_idx-- > 0;) {
+    bool is_leaf_parent = branch_idx >= rtree.first_leaf_parent_index_;
+    uint32_t first_child_idx = rtree.first_child_indices_[branch_idx];
+    Envelope envelope;
+    for (uint32_t child = 0; child < child_counts[branch_idx]; ++child) {
+      Rect bounds = is_leaf_parent
+                        ? bounds_func(rtree.elements_[first_child_idx + child])
+                        : branch_bounds[first_child_idx + child];
+      rtree.SetChildBounds(branch_idx, child, bounds);
+      envelope.Add(bounds);
+    }
+    branch_bounds[branch_idx] = *envelope.AsRect();
+  }
+  rtree.root_bounds_ = branch_bounds.front();
+  return rtree;
+}
+
+template <typename T, uint32_t kBranchingFactor>
+std::vector<uint32_t> FlatStaticRTree<T, kBranchingFactor>::ChildCounts()
+    const {
+  std::vector<uint32_t> child_counts;
+  child_counts.reserve(BranchNodeCount());
+  for (uint32_t branch_idx = 0; branch_idx < BranchNodeCount(); ++branch_idx) {
+    // The children of each branch node are packed at the start of its block,
+    // followed by padding.
+    uint32_t n_children = 0;
+    while (n_children < kBranchingFactor &&
+           ChildBounds(branch_idx, n_children).has_value()) {
+      ++n_children;
+    }
+    child_counts.push_back(n_children);
+  }
+  return child_counts;
+}
+
+template <typename T, uint32_t kBranchingFactor>
+void FlatStaticRTree<T, kBranchingFactor>::SetChildBounds(
+    uint32_t branch_index, uint32_t child, const Rect& bounds) {
+  float* block = &child_bounds_[branch_index * kBoundsBlockSize];
+  block[child] = bounds.XMin();
+  block[kBranchingFactor + child] = bounds.YMin();
+  block[2 * kBranchingFactor + child] = bounds.XMax();
+  block[3 * kBranchingFactor + child] = bounds.YMax();
+}
+
+template <typename T, uint32_t kBranchingFactor>
+std::optional<Rect> FlatStaticRTree<T, kBranchingFactor>::ChildBounds(
+    uint32_t branch_index, uint32_t child) const {
+  const float* x_min = &child_bounds_[branch_index * kBoundsBlockSize];
+  const float* y_min = x_min + kBranchingFactor;
+  const float* x_max = y_min + kBranchingFactor;
+  const float* y_max = x_max + kBranchingFactor;
+  if (std::isnan(x_min[child])) return std::nullopt;
+  return Rect::FromTwoPoints({x_min[child], y_min[child]},
+                             {x_max[child], y_max[child]});
+}
+
+template <typename T, uint32_t kBranchingFactor>
+uint32_t FlatStaticRTree<T, kBranchingFactor>::IntersectedChildMask(
+    uint32_t branch_index, const Rect& bounds) const {
+  const float* x_min = &child_bounds_[branch_index * kBoundsBlockSize];
+  const float* y_min = x_min + kBranchingFactor;
+  const float* x_max = y_min + kBranchingFactor;
+  const float* y_max = x_max + kBranchingFactor;
+  float query_x_min = bounds.XMin();
+  float query_y_min = bounds.YMin();
+  float query_x_max = bounds.XMax();
+  float query_y_max = bounds.YMax();
+  // This loop has a fixed trip count and no branches, which allows the
+  // compiler to vectorize it.
+  uint32_t mask = 0;
+  for (uint32_t i = 0; i < kBranchingFactor; ++i) {
+    bool intersects = (x_min[i] <= query_x_max) & (query_x_min <= x_max[i]) &
+                      (y_min[i] <= query_y_max) & (query_y_min <= y_max[i]);
+    mask |= static_cast<uint32_t>(intersects) << i;
+  }
+  return mask;
+}
+
+template <typename T, uint32_t kBranchingFactor>
+void FlatStaticRTree<T, kBranchingFactor>::VisitIntersectedElements(
+    const Rect& bounds, absl::FunctionRef<bool(const T&)> visitor) const {
+  if (elements_.empty() || !IntersectsInternal(root_bounds_, bounds)) return;
+
+  // A depth-first traversal holds at most `kBranchingFactor - 1` pending
+  // siblings for each level of the tree, plus the node being expanded.
+  absl::InlinedVector<uint32_t,
+                      kMaxExpectedRTreeBranchDepth * kBranchingFactor>
+      pending_branch_indices = {0};
+  while (!pending_branch_indices.empty()) {
+    uint32_t branch_idx = pending_branch_indices.back();
+    pending_branch_indices.pop_back();
+    uint32_t mask = IntersectedChildMask(branch_idx, bounds);
+    uint32_t first_child_idx = first_child_indices_[branch_idx];
+    if (branch_idx >= first_leaf_parent_index_) {
+      for (; mask != 0; mask &= mask - 1) {
+        if (!visitor(elements_[first_child_idx + std::countr_zero(mask)])) {
+          return;
+        }
+      }
+    } else {
+      // Push the children in reverse, so that they are popped in order.
+      while (mask != 0) {
+        int child = std::bit_width(mask) - 1;
+        mask ^= uint32_t{1} << child;
+        pending_branch_indices.push_back(first_child_idx + child);
+      }
+    }
+  }
+}
+
+template <typename T, uint32_t kBranchingFactor>
+void FlatStaticRTree<T, kBranchingFactor>::VisitIntersectedElementsBatch(
+    absl::Span<const Rect> queries,
+    absl::FunctionRef<bool(size_t query_index, const T&)> visitor) const {
+  ABSL_CHECK_LE(queries.size(), uint64_t{1} << 32) << absl::Substitute(
+      "FlatStaticRTree supports a maximum of 2^32 (4294967296) queries per "
+      "batch; $0 were given",
+      queries.size());
+  if (elements_.empty()) return;
+
+  // Sort the queries that can hit anything along a Z-order curve through the
+  // root bounds, so that consecutive queries are close to each other, and
+  // split them into groups.
+  struct SortedQuery {
+    uint32_t z_order;
+    uint32_t query_idx;
+  };
+  std::vector<SortedQuery> sorted_queries;
+  for (uint32_t query_idx = 0; query_idx < queries.size(); ++query_idx) {
+    if (IntersectsInternal(root_bounds_, queries[query_idx])) {
+      sorted_queries.push_back(
+          {.z_order = ZOrderOfCenter(queries[query_idx]),
+           .query_idx = query_idx});
+    }
+  }
+  absl::c_sort(sorted_queries, [](const SortedQuery& a, const SortedQuery& b) {
+    return a.z_order < b.z_order;
+  });
+
+  // Each group is traversed once, using the union of its queries' bounds, so
+  // the branch nodes above the leaves are only tested once per group rather
+  // than once per query. The queries are tested individually only at the
+  // parents of the leaves, against the child masks that the group's bounds
+  // hit.
+  std::vector<bool> is_query_stopped(queries.size(), false);
+  absl::InlinedVector<uint32_t,
+                      kMaxExpectedRTreeBranchDepth * kBranchingFactor>
+      pending_branch_indices;
+  for (size_t group_start = 0; group_start < sorted_queries.size();
+       group_start += kBatchGroupSize) {
+    absl::Span<const SortedQuery> group =
+        absl::MakeConstSpan(sorted_queries)
+            .subspan(group_start, kBatchGroupSize);
+    Envelope group_envelope;
+    for (const SortedQuery& query : group) {
+      group_envelope.Add(queries[query.query_idx]);
+    }
+    Rect group_bounds = *group_envelope.AsRect();
+    size_t n_active_queries = group.size();
+
+    pending_branch_indices = {0};
+    while (!pending_branch_indices.empty() && n_active_queries > 0) {
+      uint32_t branch_idx = pending_branch_indices.back();
+      pending_branch_indices.pop_back();
+      uint32_t group_mask = IntersectedChildMask(branch_idx, group_bounds);
+      if (group_mask == 0) continue;
+      uint32_t first_child_idx = first_child_indices_[branch_idx];
+      if (branch_idx < first_leaf_parent_index_) {
+        // Push the children in reverse, so that they are popped in order.
+        while (group_mask != 0) {
+          int child = std::bit_width(group_mask) - 1;
+          group_mask ^= uint32_t{1} << child;
+          pending_branch_indices.push_back(first_child_idx + child);
+        }
+        continue;
+      }
+      for (const SortedQuery& query : group) {
+        if (is_query_stopped[query.query_idx]) continue;
+        // A query that is the only one in its group has the same bounds as
+        // the group, so there's no need to test it again.
+        uint32_t mask =
+            group.size() == 1
+                ? group_mask
+                : group_mask & IntersectedChildMask(branch_idx,
+                                                    queries[query.query_idx]);
+        for (; mask != 0; mask &= mask - 1) {
+          if (!visitor(query.query_idx,
+                       elements_[first_child_idx + std::countr_zero(mask)])) {
+            is_query_stopped[query.query_idx] = true;
+            --n_active_queries;
+            break;
+          }
+        }
+      }
+    }
+  }
+}
+
+template <typename T, uint32_t kBranchingFactor>
+uint32_t FlatStaticRTree<T, kBranchingFactor>::ZOrderOfCenter(
+    const Rect& rect) const {
+  // Maps a coordinate to a 16-bit position within the root bounds, clamping
+  // centers that lie outside of it.
+  auto quantize = [](float value, float min, float size) -> uint32_t {
+    float t = size > 0 ? (value - min) / size : 0;
+    return static_cast<uint32_t>(std::clamp(t, 0.f, 1.f) * 0xffff);
+  };
+  // Spreads the low 16 bits of `v` out to the even bits.
+  auto spread_bits = [](uint32_t v) {
+    v = (v | (v << 8)) & 0x00ff00ff;
+    v = (v | (v << 4)) & 0x0f0f0f0f;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+  };
+  Point center = rect.Center();
+  return spread_bits(quantize(center.x, root_bounds_.XMin(),
+                              root_bounds_.Width())) |
+         spread_bits(quantize(center.y, root_bounds_.YMin(),
+                              root_bounds_.Height()))
+             << 1;
+}
+
+template <typename T, uint32_t kBranchingFactor>
+template <typename U>
+void FlatStaticRTree<T, kBranchingFactor>::VisitIntersectedElementPairs(
+    const Rect& bounds, const FlatStaticRTree<U, kBranchingFactor>& other,
+    absl::FunctionRef<Rect(const Rect&)> bounds_to_other,
+    absl::FunctionRef<PairFlowControl(const T&,
+                                      const std::type_identity_t<U>&)>
+        visitor) const {
+  if (elements_.empty() || other.elements_.empty() ||
+      !IntersectsInternal(root_bounds_, bounds)) {
+    return;
+  }
+
+  using OtherBranch = typename FlatStaticRTree<U, kBranchingFactor>::
+      BoundedBranch;
+  // A node of this tree, with its bounds mapped into `other`'s space, along
+  // with a range of `other_branches` holding the disjoint sub-trees of `other`
+  // that may intersect it. Because the traversal is depth-first, each node's
+  // range is appended after its parent's, so the vector can be truncated when
+  // the node is popped. The range is narrowed down when the node is popped,
+  // rather than when it is pushed, so that stopping early is cheap.
+  struct PendingBranch {
+    uint32_t branch_idx;
+    Rect mapped_bounds;
+    uint32_t first_other_branch;
+    uint32_t n_other_branches;
+  };
+  absl::InlinedVector<OtherBranch,
+                      kMaxExpectedRTreeBranchDepth * kBranchingFactor>
+      other_branches = {{.branch_idx = 0, .bounds = other.root_bounds_}};
+  absl::InlinedVector<PendingBranch,
+                      kMaxExpectedRTreeBranchDepth * kBranchingFactor>
+      pending_branches = {
+      {.branch_idx = 0,
+       .mapped_bounds = bounds_to_other(root_bounds_),
+       .first_other_branch = 0,
+       .n_other_branches = 1}};
+  while (!pending_branches.empty()) {
+    PendingBranch branch = pending_branches.back();
+    pending_branches.pop_back();
+    other_branches.resize(branch.first_other_branch + branch.n_other_branches);
+
+    // Narrow `other`'s sub-trees down to those that intersect this node,
+    // splitting any that are larger than it, so that both trees are descended
+    // at a similar rate.
+    uint32_t first_other_branch = other_branches.size();
+    for (uint32_t i = branch.first_other_branch;
+         i < branch.first_other_branch + branch.n_other_branches; ++i) {
+      // This is a copy, because `other_branches` may be reallocated below.
+      OtherBranch other_branch = other_branches[i];
+      if (!IntersectsInternal(other_branch.bounds, branch.mapped_bounds)) {
+        continue;
+      }
+      if (other_branch.branch_idx >= other.first_leaf_parent_index_ ||
+          other_branch.bounds.Width() * other_branch.bounds.Height() <=
+              branch.mapped_bounds.Width() * branch.mapped_bounds.Height()) {
+        other_branches.push_back(other_branch);
+        continue;
+      }
+      uint32_t other_first_child_idx =
+          other.first_child_indices_[other_branch.branch_idx];
+      for (uint32_t mask = other.IntersectedChildMask(other_branch.branch_idx,
+                                                      branch.mapped_bounds);
+           mask != 0; mask &= mask - 1) {
+        uint32_t other_child = std::countr_zero(mask);
+        other_branches.push_back(
+            {.branch_idx = other_first_child_idx + other_child,
+             .bounds =
+                 *other.ChildBounds(other_branch.branch_idx, other_child)});
+      }
+    }
+    uint32_t n_other_branches = other_branches.size() - first_other_branch;
+    if (n_other_branches == 0) continue;
+    Envelope other_branches_envelope;
+    for (uint32_t i = first_other_branch; i < other_branches.size(); ++i) {
+      other_branches_envelope.Add(other_branches[i].bounds);
+    }
+    Rect other_branches_bounds = *other_branches_envelope.AsRect();
+
+    bool is_leaf_parent = branch.branch_idx >= first_leaf_parent_index_;
+    uint32_t first_child_idx = first_child_indices_[branch.branch_idx];
+    for (uint32_t mask = IntersectedChildMask(branch.branch_idx, bounds);
+         mask != 0; mask &= mask - 1) {
+      uint32_t child = std::countr_zero(mask);
+      Rect mapped_bounds =
+          bounds_to_other(*ChildBounds(branch.branch_idx, child));
+      if (!IntersectsInternal(mapped_bounds, other_branches_bounds)) continue;
+      if (!is_leaf_parent) {
+        pending_branches.push_back(
+            {.branch_idx = first_child_idx + child,
+             .mapped_bounds = mapped_bounds,
+             .first_other_branch = first_other_branch,
+             .n_other_branches = n_other_branches});
+        continue;
+      }
+      if (VisitElementPairs<U>(
+              elements_[first_child_idx + child], mapped_bounds, other,
+              absl::MakeConstSpan(other_branches)
+                  .subspan(first_other_branch, n_other_branches),
+              visitor) == PairFlowControl::kBreak) {
+        return;
+      }
+    }
+  }
+}
+
+template <typename T, uint32_t kBranchingFactor>
+template <typename U>
+typename FlatStaticRTree<T, kBranchingFactor>::PairFlowControl
+FlatStaticRTree<T, kBranchingFactor>::VisitElementPairs(
+    const T& element, const Rect& mapped_bounds,
+    const FlatStaticRTree<U, kBranchingFactor>& other,
+    absl::Span<const typename FlatStaticRTree<U, kBranchingFactor>::
+                   BoundedBranch>
+        other_branches,
+    absl::FunctionRef<PairFlowControl(const T&, const U&)> visitor) const {
+  absl::InlinedVector<uint32_t, 32> branch_stack;
+  for (const auto& other_branch : other_branches) {
+    if (IntersectsInternal(other_branch.bounds, mapped_bounds)) {
+      branch_stack.push_back(other_branch.branch_idx);
+    }
+  }
+  while (!branch_stack.empty()) {
+    uint32_t branch_idx = branch_stack.back();
+    branch_stack.pop_back();
+    uint32_t first_child_idx = other.first_child_indices_[branch_idx];
+    uint32_t mask = other.IntersectedChildMask(branch_idx, mapped_bounds);
+    if (branch_idx < other.first_leaf_parent_index_) {
+      for (; mask != 0; mask &= mask - 1) {
+        branch_stack.push_back(first_child_idx + std::countr_zero(mask));
+      }
+      continue;
+    }
+    for (; mask != 0; mask &= mask - 1) {
+      const U& other_element =
+          other.elements_[first_child_idx + std::countr_zero(mask)];
+      switch (visitor(element, other_element)) {
+        case PairFlowControl::kContinue:
+          break;
+        case PairFlowControl::kNextElement:
+          return PairFlowControl::kContinue;
+        case PairFlowControl::kBreak:
+          return PairFlowControl::kBreak;
+      }
+    }
+  }
+  return PairFlowControl::kContinue;
+}
+
+template <typename T, uint32_t kBranchingFactor>
+template <typename WeightFunc>
+void FlatStaticRTree<T, kBranchingFactor>::InitializeWeights(
+    WeightFunc weight_func) {
+  child_weights_.assign(first_child_indices_.size() * kBranchingFactor, 0);
+  // Children always come after their parents in breadth-first order, so
+  // visiting the branch nodes in reverse order computes each child's weight
+  // before it is needed.
+  for (uint32_t branch_idx = first_child_indices_.size(); branch_idx-- > 0;) {
+    uint32_t first_child_idx = first_child_indices_[branch_idx];
+    double* weights = &child_weights_[branch_idx * kBranchingFactor];
+    for (uint32_t child = 0; child < kBranchingFactor; ++child) {
+      if (!ChildBounds(branch_idx, child).has_value()) continue;
+      if (branch_idx >= first_leaf_parent_index_) {
+        weights[child] = weight_func(elements_[first_child_idx + child]);
+        ABSL_DCHECK_GE(weights[child], 0);
+      } else {
+        const double* child_weights =
+            &child_weights_[(first_child_idx + child) * kBranchingFactor];
+        for (uint32_t i = 0; i < kBranchingFactor; ++i) {
+          weights[child] += child_weights[i];
+        }
+      }
+    }
+  }
+  root_weight_ = 0;
+  for (uint32_t child = 0; child < kBranchingFactor && !child_weights_.empty();
+       ++child) {
+    root_weight_ += child_weights_[child];
+  }
+  has_weights_ = true;
+}
+
+template <typename T, uint32_t kBranchingFactor>
+bool FlatStaticRTree<T, kBranchingFactor>::
+    WeightOfIntersectedElementsIsGreaterThan(
+        double threshold,
+        absl::FunctionRef<BoundsRelation(const Rect&)> bounds_relation,
+        absl::FunctionRef<bool(const T&)> intersects_element) const {
+  if (elements_.empty()) return 0 > threshold;
+  ABSL_CHECK(has_weights_)
+      << "`InitializeWeights` must be called before querying weights";
+
+  switch (bounds_relation(root_bounds_)) {
+    case BoundsRelation::kDisjoint:
+      return 0 > threshold;
+    case BoundsRelation::kContained:
+      return root_weight_ > threshold;
+    case BoundsRelation::kIntersecting:
+      break;
+  }
+
+  // `found_weight` is the weight of the elements known to intersect the
+  // query, and `pending_weight` is the weight of those that have not been
+  // classified yet, i.e. the pending branch nodes, and the unvisited children
+  // of the current one. Their sum is an upper bound on the final weight.
+  double found_weight = 0;
+  double pending_weight = root_weight_;
+  absl::InlinedVector<uint32_t,
+                      kMaxExpectedRTreeBranchDepth * kBranchingFactor>
+      pending_branch_indices = {0};
+  while (!pending_branch_indices.empty()) {
+    uint32_t branch_idx = pending_branch_indices.back();
+    pending_branch_indices.pop_back();
+    bool is_leaf_parent = branch_idx >= first_leaf_parent_index_;
+    uint32_t first_child_idx = first_child_indices_[branch_idx];
+    for (uint32_t child = 0; child < kBranchingFactor; ++child) {
+      std::optional<Rect> child_bounds = ChildBounds(branch_idx, child);
+      if (!child_bounds.has_value()) continue;
+      double weight = child_weights_[branch_idx * kBranchingFactor + child];
+      pending_weight -= weight;
+      switch (bounds_relation(*child_bounds)) {
+        case BoundsRelation::kDisjoint:
+          break;
+        case BoundsRelation::kContained:
+          found_weight += weight;
+          break;
+        case BoundsRelation::kIntersecting:
+          if (!is_leaf_parent) {
+            pending_branch_indices.push_back(first_child_idx + child);
+            pending_weight += weight;
+          } else if (intersects_element(elements_[first_child_idx + child])) {
+            found_weight += weight;
+          }
+          break;
+      }
+      if (found_weight > threshold) return true;
+      if (found_weight + pending_weight <= threshold) return false;
+    }
+  }
+  return found_weight > threshold;
+}
+
+template <typename T, uint32_t kBranchingFactor>
+std::optional<typename FlatStaticRTree<T, kBranchingFactor>::ElementAndDistance>
+FlatStaticRTree<T, kBranchingFactor>::FindNearestElement(
+    float max_distance, absl::FunctionRef<float(const Rect&)> bounds_distance,
+    absl::FunctionRef<float(const T&)> element_distance) const {
+  if (elements_.empty()) return std::nullopt;
+
+  std::optional<ElementAndDistance> nearest;
+  // Returns true if something at a distance of at least `lower_bound` could
+  // be nearer than the best element found so far.
+  auto may_be_nearer = [&nearest, max_distance](float lower_bound) {
+    return nearest.has_value() ? lower_bound < nearest->distance
+                               : lower_bound <= max_distance;
+  };
+
+  // The pending branch nodes, as a min-heap on the lower bound of the
+  // distance to their elements.
+  struct PendingBranch {
+    float lower_bound;
+    uint32_t branch_idx;
+  };
+  auto farther = [](const PendingBranch& a, const PendingBranch& b) {
+    return a.lower_bound > b.lower_bound;
+  };
+  absl::InlinedVector<PendingBranch,
+                      kMaxExpectedRTreeBranchDepth * kBranchingFactor>
+      pending_branches;
+
+  float root_lower_bound = bounds_distance(root_bounds_);
+  if (may_be_nearer(root_lower_bound)) {
+    pending_branches.push_back({root_lower_bound, 0});
+  }
+  while (!pending_branches.empty()) {
+    absl::c_pop_heap(pending_branches, farther);
+    PendingBranch branch = pending_branches.back();
+    pending_branches.pop_back();
+    // Since the branches are searched in order of their lower bounds, if this
+    // one can't hold a nearer element, none of the others can either.
+    if (!may_be_nearer(branch.lower_bound)) break;
+
+    bool is_leaf_parent = branch.branch_idx >= first_leaf_parent_index_;
+    uint32_t first_child_idx = first_child_indices_[branch.branch_idx];
+    for (uint32_t child = 0; child < kBranchingFactor; ++child) {
+      std::optional<Rect> child_bounds = ChildBounds(branch.branch_idx, child);
+      if (!child_bounds.has_value()) continue;
+      float lower_bound = bounds_distance(*child_bounds);
+      if (!may_be_nearer(lower_bound)) continue;
+      if (is_leaf_parent) {
+        const T& element = elements_[first_child_idx + child];
+        float distance = element_distance(element);
+        if (may_be_nearer(distance)) nearest = {element, distance};
+      } else {
+        pending_branches.push_back({lower_bound, first_child_idx + child});
+        absl::c_push_heap(pending_branches, farther);
+      }
+    }
+  }
+  return nearest;
+}
+
+}  // namespace ink::geometry_internal
+
+#endif  // INK_GEOMETRY_INTERNAL_FLAT_STATIC_RTREE_H_
@@ -0,0 +1,733 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ink/geometry/internal/flat_static_rtree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "ink/geometry/internal/intersects_internal.h"
+#include "ink/geometry/internal/static_rtree.h"
+#include "ink/geometry/point.h"
+#include "ink/geometry/rect.h"
+
+namespace ink::geometry_internal {
+namespace {
+
+using ::testing::Contains;
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+using ::testing::IsEmpty;
+using ::testing::Not;
+using ::testing::UnorderedElementsAre;
+using ::testing::UnorderedElementsAreArray;
+
+// Convenience alias for a `FlatStaticRTree` of `Points`. We use a small value
+// for `kBranchingFactor` so that we can test trees of different depths without
+// needing thousands of elements.
+using PointRTree = FlatStaticRTree<Point, 3>;
+
+// Bounds computation functor for a `FlatStaticRTree` of `Point`s
+auto point_bounds = [](const Point& p) {
+  return Rect::FromCenterAndDimensions(p, 0, 0);
+};
+
+// Visits all the elements of `rtree` that intersect `r`, and places them in a
+// `std::vector` for easier verification.
+template <typename RTree>
+std::vector<Point> GetIntersectedPoints(const RTree& rtree, const Rect& r) {
+  std::vector<Point> intersected_points;
+  rtree.VisitIntersectedElements(r, [&intersected_points](const Point& p) {
+    intersected_points.push_back(p);
+    return true;
+  });
+  return intersected_points;
+}
+
+TEST(FlatStaticRTreeTest, DefaultCtor) {
+  PointRTree rtree;
+
+  EXPECT_EQ(rtree.BranchNodeCount(), 0);
+  EXPECT_THAT(rtree.Elements(), IsEmpty());
+  EXPECT_THAT(GetIntersectedPoints(rtree, Rect::FromTwoPoints({0, 0}, {1, 1})),
+              IsEmpty());
+}
+
+TEST(FlatStaticRTreeTest, CreateEmptyRTree) {
+  PointRTree rtree(std::vector<Point>(), point_bounds);
+
+  EXPECT_EQ(rtree.BranchNodeCount(), 0);
+  EXPECT_THAT(rtree.Elements(), IsEmpty());
+}
+
+TEST(FlatStaticRTreeTest, CreateFromOnePoint) {
+  PointRTree rtree(std::vector<Point>{{1, 2}}, point_bounds);
+
+  EXPECT_EQ(rtree.BranchNodeCount(), 1);
+  EXPECT_THAT(rtree.Elements(), UnorderedElementsAre(Point{1, 2}));
+  EXPECT_THAT(GetIntersectedPoints(rtree, Rect::FromTwoPoints({0, 0}, {1, 2})),
+              UnorderedElementsAre(Point{1, 2}));
+  EXPECT_THAT(GetIntersectedPoints(rtree, Rect::FromTwoPoints({0, 0}, {1, 1})),
+              IsEmpty());
+}
+
+TEST(FlatStaticRTreeTest, CreateWithGenerator) {
+  std::vector<Point> points{{-1, -1}, {0, 2}, {4, 3}, {2, 1}, {-2, 0}};
+  auto generator = [&points, i = 0]() mutable { return points[i++]; };
+
+  PointRTree rtree(points.size(), generator, point_bounds);
+
+  // Same as `StaticRTree`, this has a root with two leaf parents.
+  EXPECT_EQ(rtree.BranchNodeCount(), 3);
+  EXPECT_THAT(rtree.Elements(), UnorderedElementsAreArray(points));
+}
+
+TEST(FlatStaticRTreeTest, BranchNodeCountMatchesStaticRTree) {
+  for (int n_elements : {10, 100, 1000, 10000}) {
+    std::vector<Point> points(n_elements);
+    EXPECT_EQ(FlatStaticRTree<Point>(points, point_bounds).BranchNodeCount(),
+              StaticRTree<Point>(points, point_bounds).BranchNodes().size())
+        << "n_elements: " << n_elements;
+  }
+}
+
+TEST(FlatStaticRTreeTest, VisitIntersectedElementsPointsWithRectQuery) {
+  // There are 20 points, laid out on an integer grid like so:
+  //
+  //  9 . . . . . . . . . .
+  //    . . . . . . X X . X
+  //    . . . . . . . X . .
+  //  6 . . X . X . . . X .
+  //    X . . . . . . . . X
+  //    . . . . . . X X X .
+  //  3 . . . X . . . . . .
+  //    . X . . . . . . X .
+  //    . . . X . X . . . X
+  //  0 . . . . . . X . . X
+  //    0     3     6     9
+  std::vector<Point> points{{1, 2}, {7, 8}, {0, 5}, {8, 4}, {2, 6},
+                            {8, 6}, {9, 1}, {6, 4}, {9, 0}, {8, 2},
+                            {7, 4}, {5, 1}, {7, 7}, {6, 8}, {3, 1},
+                            {3, 3}, {4, 6}, {6, 0}, {9, 5}, {9, 8}};
+
+  PointRTree rtree(points, point_bounds);
+
+  EXPECT_THAT(rtree.Elements(), UnorderedElementsAreArray(points));
+  // This query completely misses the R-Tree, it's off to the side.
+  EXPECT_THAT(
+      GetIntersectedPoints(rtree, Rect::FromTwoPoints({20, 20}, {25, 25})),
+      IsEmpty());
+  // This query intersects the bounds of the R-Tree, but falls between the
+  // actually elements without touching them.
+  EXPECT_THAT(GetIntersectedPoints(rtree, Rect::FromTwoPoints({2, 4}, {3, 5})),
+              IsEmpty());
+  // This query covers the entire R-Tree.
+  EXPECT_THAT(
+      GetIntersectedPoints(rtree, Rect::FromTwoPoints({-10, -10}, {30, 30})),
+      UnorderedElementsAreArray(points));
+  // These two queries each partially cover the R-Tree.
+  EXPECT_THAT(GetIntersectedPoints(rtree, Rect::FromTwoPoints({2, 0}, {6, 5})),
+              UnorderedElementsAre(Point{3, 1}, Point{3, 3}, Point{5, 1},
+                                   Point{6, 0}, Point{6, 4}));
+  EXPECT_THAT(
+      GetIntersectedPoints(rtree, Rect::FromTwoPoints({5.5, 3.5}, {8.5, 7.5})),
+      UnorderedElementsAre(Point{8, 4}, Point{8, 6}, Point{6, 4}, Point{7, 4},
+                           Point{7, 7}));
+}
+
+TEST(FlatStaticRTreeTest, InfiniteQueryDoesNotVisitPadding) {
+  // With 4 elements and a branching factor of 3, the second leaf parent only
+  // has one child, so the rest of its bounds block is padding.
+  std::vector<Point> points{{0, 0}, {1, 0}, {2, 0}, {3, 0}};
+  PointRTree rtree(points, point_bounds);
+
+  float inf = std::numeric_limits<float>::infinity();
+  Rect everything = Rect::FromTwoPoints({-inf, -inf}, {inf, inf});
+  EXPECT_THAT(GetIntersectedPoints(rtree, everything),
+              UnorderedElementsAreArray(points));
+}
+
+TEST(FlatStaticRTreeTest, VisitIntersectedElementsStopEarly) {
+  std::vector<Point> points{{0, 0}, {2, 0}, {1, 1}, {4, 1},
+                            {3, 2}, {1, 3}, {2, 4}};
+  PointRTree rtree(points, point_bounds);
+
+  // This visitor will populate `visited` with the first three points it finds,
+  // then stop traversing.
+  std::vector<Point> visited;
+  auto visitor = [&visited](Point p) {
+    visited.push_back(p);
+    return visited.size() < 3;
+  };
+  rtree.VisitIntersectedElements(Rect::FromTwoPoints({1, 1}, {4, 4}), visitor);
+
+  EXPECT_EQ(visited.size(), 3);
+  EXPECT_THAT(visited, Not(Contains(Point{0, 0})));
+  EXPECT_THAT(visited, Not(Contains(Point{2, 0})));
+}
+
+template <uint32_t kBranchingFactor>
+void ExpectSameResultsAsStaticRTree(int n_elements) {
+  std::mt19937_64 rng(n_elements);
+  auto rand_between = [&rng](float a, float b) {
+    return std::uniform_real_distribution<float>(a, b)(rng);
+  };
+  std::vector<Rect> rects(n_elements);
+  for (Rect& rect : rects) {
+    rect = Rect::FromCenterAndDimensions(
+        {rand_between(-100, 100), rand_between(-100, 100)},
+        rand_between(0, 10), rand_between(0, 10));
+  }
+  // The trees hold indices into `rects`, so that results can be compared.
+  auto index_generator = [i = 0u]() mutable { return i++; };
+  auto index_bounds = [&rects](uint32_t i) { return rects[i]; };
+  FlatStaticRTree<uint32_t, kBranchingFactor> flat_rtree(
+      n_elements, index_generator, index_bounds);
+  StaticRTree<uint32_t, kBranchingFactor> rtree(n_elements, index_generator,
+                                                index_bounds);
+
+  auto get_intersected_indices = [](const auto& rtree, const Rect& query) {
+    std::vector<uint32_t> intersected_indices;
+    rtree.VisitIntersectedElements(
+        query, [&intersected_indices](uint32_t i) {
+          intersected_indices.push_back(i);
+          return true;
+        });
+    return intersected_indices;
+  };
+  for (int i = 0; i < 20; ++i) {
+    Rect query = Rect::FromCenterAndDimensions(
+        {rand_between(-110, 110), rand_between(-110, 110)},
+        rand_between(0, 50), rand_between(0, 50));
+    EXPECT_THAT(
+        get_intersected_indices(flat_rtree, query),
+        UnorderedElementsAreArray(get_intersected_indices(rtree, query)))
+        << "n_elements: " << n_elements << ", query " << i;
+  }
+}
+
+TEST(FlatStaticRTreeTest, SameResultsAsStaticRTree) {
+  for (int n_elements : {1, 2, 3, 7, 50, 1000}) {
+    ExpectSameResultsAsStaticRTree<2>(n_elements);
+    ExpectSameResultsAsStaticRTree<3>(n_elements);
+    ExpectSameResultsAsStaticRTree<16>(n_elements);
+    ExpectSameResultsAsStaticRTree<32>(n_elements);
+  }
+}
+
+template <uint32_t kBranchingFactor>
+void ExpectFromLayoutRestoresTree(int n_elements) {
+  std::mt19937_64 rng(n_elements);
+  auto rand_between = [&rng](float a, float b) {
+    return std::uniform_real_distribution<float>(a, b)(rng);
+  };
+  std::vector<Rect> rects(n_elements);
+  for (Rect& rect : rects) {
+    rect = Rect::FromCenterAndDimensions(
+        {rand_between(-100, 100), rand_between(-100, 100)},
+        rand_between(0, 10), rand_between(0, 10));
+  }
+  auto index_bounds = [&rects](uint32_t i) { return rects[i]; };
+  FlatStaticRTree<uint32_t, kBranchingFactor> rtree(
+      n_elements, [i = 0u]() mutable { return i++; }, index_bounds);
+
+  std::optional<FlatStaticRTree<uint32_t, kBranchingFactor>> restored =
+      FlatStaticRTree<uint32_t, kBranchingFactor>::FromLayout(
+          std::vector<uint32_t>(rtree.Elements().begin(),
+                                rtree.Elements().end()),
+          rtree.ChildCounts(), index_bounds);
+  ASSERT_TRUE(restored.has_value()) << "n_elements: " << n_elements;
+  EXPECT_THAT(restored->Elements(), ElementsAreArray(rtree.Elements()));
+  EXPECT_THAT(restored->ChildCounts(), ElementsAreArray(rtree.ChildCounts()));
+
+  // The trees have the same structure, so they visit elements in the same
+  // order.
+  auto get_intersected_indices = [](const auto& rtree, const Rect& query) {
+    std::vector<uint32_t> intersected_indices;
+    rtree.VisitIntersectedElements(
+        query, [&intersected_indices](uint32_t i) {
+          intersected_indices.push_back(i);
+          return true;
+        });
+    return intersected_indices;
+  };
+  for (int i = 0; i < 20; ++i) {
+    Rect query = Rect::FromCenterAndDimensions(
+        {rand_between(-110, 110), rand_between(-110, 110)},
+        rand_between(0, 50), rand_between(0, 50));
+    EXPECT_THAT(get_intersected_indices(*restored, query),
+                ElementsAreArray(get_intersected_indices(rtree, query)))
+        << "n_elements: " << n_elements << ", query " << i;
+  }
+}
+
+TEST(FlatStaticRTreeTest, FromLayoutRestoresTree) {
+  for (int n_elements : {1, 2, 3, 7, 50, 1000}) {
+    ExpectFromLayoutRestoresTree<2>(n_elements);
+    ExpectFromLayoutRestoresTree<3>(n_elements);
+    ExpectFromLayoutRestoresTree<16>(n_elements);
+  }
+}
+
+TEST(FlatStaticRTreeTest, FromLayoutWithEmptyTree) {
+  std::optional<PointRTree> rtree =
+      PointRTree::FromLayout({}, {}, point_bounds);
+  ASSERT_TRUE(rtree.has_value());
+  EXPECT_THAT(rtree->Elements(), IsEmpty());
+  EXPECT_THAT(rtree->ChildCounts(), IsEmpty());
+}
+
+TEST(FlatStaticRTreeTest, FromLayoutRejectsInvalidLayouts) {
+  // Seven elements make a tree with three leaf parents under the root.
+  std::vector<Point> points = {{0, 0}, {1, 0}, {2, 0}, {3, 0},
+                               {4, 0}, {5, 0}, {6, 0}};
+  PointRTree rtree(points, point_bounds);
+  ASSERT_THAT(rtree.ChildCounts(), ElementsAre(3, 3, 3, 1));
+  std::vector<Point> elements(rtree.Elements().begin(),
+                              rtree.Elements().end());
+  ASSERT_TRUE(
+      PointRTree::FromLayout(elements, {3, 3, 3, 1}, point_bounds).has_value());
+
+  // Too few or too many branch nodes.
+  EXPECT_EQ(PointRTree::FromLayout(elements, {3, 3, 1}, point_bounds),
+            std::nullopt);
+  EXPECT_EQ(PointRTree::FromLayout(elements, {3, 3, 3, 1, 1}, point_bounds),
+            std::nullopt);
+  // Too many children for a node.
+  EXPECT_EQ(PointRTree::FromLayout(elements, {3, 4, 2, 1}, point_bounds),
+            std::nullopt);
+  // A node with no children.
+  EXPECT_EQ(PointRTree::FromLayout(elements, {3, 3, 3, 0}, point_bounds),
+            std::nullopt);
+  // The root doesn't have the right number of children.
+  EXPECT_EQ(PointRTree::FromLayout(elements, {2, 3, 3, 1}, point_bounds),
+            std::nullopt);
+  // The leaf parents don't have the right number of elements.
+  EXPECT_EQ(PointRTree::FromLayout(elements, {3, 3, 3, 2}, point_bounds),
+            std::nullopt);
+  EXPECT_EQ(PointRTree::FromLayout(elements, {3, 3, 2, 1}, point_bounds),
+            std::nullopt);
+  // Elements without any child counts.
+  EXPECT_EQ(PointRTree::FromLayout(elements, {}, point_bounds), std::nullopt);
+  // Child counts without any elements.
+  EXPECT_EQ(PointRTree::FromLayout({}, {1}, point_bounds), std::nullopt);
+}
+
+TEST(FlatStaticRTreeTest, BatchMatchesIndividualQueries) {
+  std::mt19937_64 rng(0);
+  auto rand_between = [&rng](float a, float b) {
+    return std::uniform_real_distribution<float>(a, b)(rng);
+  };
+  std::vector<Point> points(500);
+  for (Point& p : points) {
+    p = {rand_between(-100, 100), rand_between(-100, 100)};
+  }
+  FlatStaticRTree<Point, 4> rtree(points, point_bounds);
+  // The queries overlap each other, and some miss the tree entirely.
+  std::vector<Rect> queries(30);
+  for (Rect& query : queries) {
+    query = Rect::FromCenterAndDimensions(
+        {rand_between(-120, 120), rand_between(-120, 120)},
+        rand_between(0, 60), rand_between(0, 60));
+  }
+
+  std::vector<std::vector<Point>> batch_results(queries.size());
+  rtree.VisitIntersectedElementsBatch(
+      queries, [&batch_results](size_t query_index, const Point& p) {
+        batch_results[query_index].push_back(p);
+        return true;
+      });
+
+  for (size_t i = 0; i < queries.size(); ++i) {
+    EXPECT_THAT(batch_results[i],
+                UnorderedElementsAreArray(GetIntersectedPoints(rtree,
+                                                               queries[i])))
+        << "query " << i;
+  }
+}
+
+TEST(FlatStaticRTreeTest, BatchWithZeroSizeRootBounds) {
+  // All of the points are the same, so the queries can't be told apart by
+  // their position within the root bounds.
+  std::vector<Point> points(20, Point{3, 3});
+  FlatStaticRTree<Point, 4> rtree(points, point_bounds);
+  std::vector<Rect> queries;
+  for (int i = 0; i < 10; ++i) {
+    queries.push_back(Rect::FromCenterAndDimensions({3.f + i, 3}, 1, 1));
+  }
+
+  std::vector<int> n_visits(queries.size(), 0);
+  rtree.VisitIntersectedElementsBatch(
+      queries, [&n_visits](size_t query_index, const Point&) {
+        ++n_visits[query_index];
+        return true;
+      });
+
+  EXPECT_THAT(n_visits, ElementsAre(20, 0, 0, 0, 0, 0, 0, 0, 0, 0));
+}
+
+TEST(FlatStaticRTreeTest, BatchOnEmptyRTree) {
+  PointRTree rtree;
+  std::vector<Rect> queries = {Rect::FromTwoPoints({0, 0}, {1, 1})};
+
+  int n_visits = 0;
+  rtree.VisitIntersectedElementsBatch(queries,
+                                      [&n_visits](size_t, const Point&) {
+                                        ++n_visits;
+                                        return true;
+                                      });
+
+  EXPECT_EQ(n_visits, 0);
+}
+
+TEST(FlatStaticRTreeTest, BatchStopEarlyOnlyStopsThatQuery) {
+  std::vector<Point> points{{0, 0}, {2, 0}, {1, 1}, {4, 1},
+                            {3, 2}, {1, 3}, {2, 4}};
+  PointRTree rtree(points, point_bounds);
+  std::vector<Rect> queries = {Rect::FromTwoPoints({1, 1}, {4, 4}),
+                               Rect::FromTwoPoints({-1, -1}, {5, 5})};
+
+  // This visitor stops the first query after one element, and lets the second
+  // one run to completion.
+  std::vector<Point> first_query_visited;
+  std::vector<Point> second_query_visited;
+  rtree.VisitIntersectedElementsBatch(
+      queries, [&first_query_visited, &second_query_visited](
+                   size_t query_index, const Point& p) {
+        if (query_index == 0) {
+          first_query_visited.push_back(p);
+          return false;
+        }
+        second_query_visited.push_back(p);
+        return true;
+      });
+
+  EXPECT_EQ(first_query_visited.size(), 1);
+  EXPECT_THAT(second_query_visited, UnorderedElementsAreArray(points));
+}
+
+TEST(FlatStaticRTreeTest, VisitIntersectedElementPairsMatchesBruteForce) {
+  std::mt19937_64 rng(0);
+  auto rand_between = [&rng](float a, float b) {
+    return std::uniform_real_distribution<float>(a, b)(rng);
+  };
+  auto make_random_rects = [&rand_between](int n_rects) {
+    std::vector<Rect> rects(n_rects);
+    for (Rect& rect : rects) {
+      rect = Rect::FromCenterAndDimensions(
+          {rand_between(-100, 100), rand_between(-100, 100)},
+          rand_between(0, 10), rand_between(0, 10));
+    }
+    return rects;
+  };
+  // The trees hold indices into the vectors of rects, so that results can be
+  // compared.
+  std::vector<Rect> rects = make_random_rects(300);
+  std::vector<Rect> other_rects = make_random_rects(200);
+  auto index_generator = [i = 0u]() mutable { return i++; };
+  FlatStaticRTree<uint32_t, 4> rtree(
+      rects.size(), index_generator,
+      [&rects](uint32_t i) { return rects[i]; });
+  FlatStaticRTree<uint32_t, 4> other_rtree(
+      other_rects.size(), index_generator,
+      [&other_rects](uint32_t i) { return other_rects[i]; });
+  // This maps from `rtree`'s space to `other_rtree`'s space by scaling by 1/2,
+  // so that the trees have different structures in the same space.
+  auto scale = [](const Rect& r) {
+    return Rect::FromTwoPoints({r.XMin() / 2, r.YMin() / 2},
+                               {r.XMax() / 2, r.YMax() / 2});
+  };
+
+  std::vector<std::pair<uint32_t, uint32_t>> visited_pairs;
+  Rect bounds = Rect::FromTwoPoints({-50, -80}, {70, 60});
+  rtree.VisitIntersectedElementPairs(
+      bounds, other_rtree, scale, [&visited_pairs](uint32_t i, uint32_t j) {
+        visited_pairs.emplace_back(i, j);
+        return FlatStaticRTree<uint32_t, 4>::PairFlowControl::kContinue;
+      });
+
+  // Exactly the pairs whose bounds intersect after mapping should be visited,
+  // each one once, for the elements that intersect `bounds`.
+  std::vector<std::pair<uint32_t, uint32_t>> expected_pairs;
+  for (uint32_t i = 0; i < rects.size(); ++i) {
+    if (!IntersectsInternal(rects[i], bounds)) continue;
+    for (uint32_t j = 0; j < other_rects.size(); ++j) {
+      if (IntersectsInternal(scale(rects[i]), other_rects[j])) {
+        expected_pairs.emplace_back(i, j);
+      }
+    }
+  }
+  EXPECT_THAT(expected_pairs, Not(IsEmpty()));
+  EXPECT_THAT(visited_pairs, UnorderedElementsAreArray(expected_pairs));
+}
+
+TEST(FlatStaticRTreeTest, VisitIntersectedElementPairsNextElement) {
+  // Every point's bounds intersect those of every other point after mapping.
+  std::vector<Point> points;
+  for (int i = 0; i < 50; ++i) points.push_back({i * 1.f, i * 2.f});
+  PointRTree rtree(points, point_bounds);
+  Rect everywhere = Rect::FromTwoPoints({-1000, -1000}, {1000, 1000});
+  auto to_everywhere = [&everywhere](const Rect&) { return everywhere; };
+
+  std::vector<Point> visited;
+  rtree.VisitIntersectedElementPairs(
+      everywhere, rtree, to_everywhere,
+      [&visited](const Point& p, const Point&) {
+        visited.push_back(p);
+        return PointRTree::PairFlowControl::kNextElement;
+      });
+
+  EXPECT_THAT(visited, UnorderedElementsAreArray(points));
+}
+
+TEST(FlatStaticRTreeTest, VisitIntersectedElementPairsStopEarly) {
+  std::vector<Point> points{{0, 0}, {2, 0}, {1, 1}, {4, 1},
+                            {3, 2}, {1, 3}, {2, 4}};
+  PointRTree rtree(points, point_bounds);
+  auto identity = [](const Rect& r) { return r; };
+
+  int n_visits = 0;
+  rtree.VisitIntersectedElementPairs(
+      Rect::FromTwoPoints({0, 0}, {4, 4}), rtree, identity,
+      [&n_visits](const Point&, const Point&) {
+        ++n_visits;
+        return n_visits < 3 ? PointRTree::PairFlowControl::kContinue
+                            : PointRTree::PairFlowControl::kBreak;
+      });
+
+  EXPECT_EQ(n_visits, 3);
+}
+
+TEST(FlatStaticRTreeTest, VisitIntersectedElementPairsWithEmptyTree) {
+  PointRTree rtree(std::vector<Point>{{0, 0}}, point_bounds);
+  auto identity = [](const Rect& r) { return r; };
+  auto visitor = [](const Point&, const Point&) {
+    ADD_FAILURE() << "Unexpected visit";
+    return PointRTree::PairFlowControl::kContinue;
+  };
+
+  Rect bounds = Rect::FromTwoPoints({-1, -1}, {1, 1});
+  rtree.VisitIntersectedElementPairs(bounds, PointRTree(), identity, visitor);
+  PointRTree().VisitIntersectedElementPairs(bounds, rtree, identity, visitor);
+}
+
+TEST(FlatStaticRTreeTest, WeightOfIntersectedElementsMatchesBruteForce) {
+  std::mt19937_64 rng(0);
+  auto rand_between = [&rng](float a, float b) {
+    return std::uniform_real_distribution<float>(a, b)(rng);
+  };
+  std::vector<Rect> rects(500);
+  for (Rect& rect : rects) {
+    rect = Rect::FromCenterAndDimensions(
+        {rand_between(-100, 100), rand_between(-100, 100)},
+        rand_between(0, 10), rand_between(0, 10));
+  }
+  // Integer weights keep the sums exact, so that the thresholds below are
+  // unambiguous.
+  auto weight = [](uint32_t i) { return 1 + i % 3; };
+  FlatStaticRTree<uint32_t, 4> rtree(
+      rects.size(), [i = 0u]() mutable { return i++; },
+      [&rects](uint32_t i) { return rects[i]; });
+  rtree.InitializeWeights(weight);
+  ASSERT_TRUE(rtree.HasWeights());
+
+  for (const Rect& query : {Rect::FromTwoPoints({-50, -80}, {70, 60}),
+                            Rect::FromTwoPoints({-10, -10}, {10, 10}),
+                            Rect::FromTwoPoints({0, 0}, {100, 5}),
+                            Rect::FromTwoPoints({200, 200}, {300, 300})}) {
+    using BoundsRelation = FlatStaticRTree<uint32_t, 4>::BoundsRelation;
+    auto bounds_relation = [&query](const Rect& bounds) {
+      if (!IntersectsInternal(query, bounds)) return BoundsRelation::kDisjoint;
+      return query.Contains(bounds) ? BoundsRelation::kContained
+                                    : BoundsRelation::kIntersecting;
+    };
+    auto intersects_element = [&query, &rects](uint32_t i) {
+      return IntersectsInternal(query, rects[i]);
+    };
+    double expected_weight = 0;
+    for (uint32_t i = 0; i < rects.size(); ++i) {
+      if (IntersectsInternal(query, rects[i])) expected_weight += weight(i);
+    }
+
+    for (double threshold :
+         {-0.5, 0.5, expected_weight - 0.5, expected_weight + 0.5}) {
+      EXPECT_EQ(rtree.WeightOfIntersectedElementsIsGreaterThan(
+                    threshold, bounds_relation, intersects_element),
+                expected_weight > threshold)
+          << "query: " << absl::StrCat(query) << ", threshold: " << threshold;
+    }
+  }
+}
+
+TEST(FlatStaticRTreeTest, WeightOfIntersectedElementsSkipsContainedSubTrees) {
+  std::vector<Point> points;
+  for (int i = 0; i < 50; ++i) points.push_back({i * 1.f, i * 2.f});
+  PointRTree rtree(points, point_bounds);
+  rtree.InitializeWeights([](const Point&) { return 1; });
+  auto everything_contained = [](const Rect&) {
+    return PointRTree::BoundsRelation::kContained;
+  };
+  auto intersects_element = [](const Point&) {
+    ADD_FAILURE() << "Unexpected element test";
+    return true;
+  };
+
+  EXPECT_TRUE(rtree.WeightOfIntersectedElementsIsGreaterThan(
+      49.5, everything_contained, intersects_element));
+  EXPECT_FALSE(rtree.WeightOfIntersectedElementsIsGreaterThan(
+      50.5, everything_contained, intersects_element));
+}
+
+TEST(FlatStaticRTreeTest, WeightOfIntersectedElementsStopsEarly) {
+  std::vector<Point> points;
+  for (int i = 0; i < 50; ++i) points.push_back({i * 1.f, i * 2.f});
+  PointRTree rtree(points, point_bounds);
+  rtree.InitializeWeights([](const Point&) { return 1; });
+  auto intersecting = [](const Rect&) {
+    return PointRTree::BoundsRelation::kIntersecting;
+  };
+
+  // Once three elements have been found, the result is known.
+  int n_element_tests = 0;
+  EXPECT_TRUE(rtree.WeightOfIntersectedElementsIsGreaterThan(
+      2.5, intersecting, [&n_element_tests](const Point&) {
+        ++n_element_tests;
+        return true;
+      }));
+  EXPECT_EQ(n_element_tests, 3);
+
+  // Once three elements have been rejected, the remaining ones can't reach
+  // the threshold.
+  n_element_tests = 0;
+  EXPECT_FALSE(rtree.WeightOfIntersectedElementsIsGreaterThan(
+      47.5, intersecting, [&n_element_tests](const Point&) {
+        ++n_element_tests;
+        return false;
+      }));
+  EXPECT_EQ(n_element_tests, 3);
+}
+
+TEST(FlatStaticRTreeTest, WeightOfIntersectedElementsWithEmptyTree) {
+  PointRTree rtree;
+  auto bounds_relation = [](const Rect&) {
+    return PointRTree::BoundsRelation::kContained;
+  };
+  auto intersects_element = [](const Point&) { return true; };
+
+  EXPECT_FALSE(rtree.WeightOfIntersectedElementsIsGreaterThan(
+      0, bounds_relation, intersects_element));
+  EXPECT_TRUE(rtree.WeightOfIntersectedElementsIsGreaterThan(
+      -1, bounds_relation, intersects_element));
+}
+
+// Returns the distance from `point` to the nearest point in `rect`.
+float DistanceToRect(Point point, const Rect& rect) {
+  float dx = std::max({rect.XMin() - point.x, 0.f, point.x - rect.XMax()});
+  float dy = std::max({rect.YMin() - point.y, 0.f, point.y - rect.YMax()});
+  return std::hypot(dx, dy);
+}
+
+TEST(FlatStaticRTreeTest, FindNearestElementMatchesBruteForce) {
+  std::mt19937_64 rng(0);
+  auto rand_between = [&rng](float a, float b) {
+    return std::uniform_real_distribution<float>(a, b)(rng);
+  };
+  std::vector<Point> points(500);
+  for (Point& p : points) {
+    p = {rand_between(-100, 100), rand_between(-100, 100)};
+  }
+  PointRTree rtree(points, point_bounds);
+
+  for (Point query : {Point{0, 0}, Point{-95, 30}, Point{150, -150}}) {
+    float expected_distance = std::numeric_limits<float>::infinity();
+    for (Point p : points) {
+      expected_distance = std::min(expected_distance, (p - query).Magnitude());
+    }
+    auto bounds_distance = [query](const Rect& bounds) {
+      return DistanceToRect(query, bounds);
+    };
+    auto element_distance = [query](const Point& p) {
+      return (p - query).Magnitude();
+    };
+
+    std::optional<PointRTree::ElementAndDistance> nearest =
+        rtree.FindNearestElement(std::numeric_limits<float>::infinity(),
+                                 bounds_distance, element_distance);
+    ASSERT_TRUE(nearest.has_value());
+    EXPECT_EQ(nearest->distance, expected_distance)
+        << "query: " << absl::StrCat(query);
+    EXPECT_EQ((nearest->element - query).Magnitude(), nearest->distance)
+        << "query: " << absl::StrCat(query);
+
+    EXPECT_EQ(rtree.FindNearestElement(expected_distance * 0.99f,
+                                       bounds_distance, element_distance),
+              std::nullopt)
+        << "query: " << absl::StrCat(query);
+  }
+}
+
+TEST(FlatStaticRTreeTest, FindNearestElementOnlyVisitsNearbyElements) {
+  std::vector<Point> points;
+  for (int x = 0; x < 30; ++x) {
+    for (int y = 0; y < 30; ++y) points.push_back({1.f * x, 1.f * y});
+  }
+  PointRTree rtree(points, point_bounds);
+  Point query = {10.25, 20.125};
+
+  int n_element_tests = 0;
+  std::optional<PointRTree::ElementAndDistance> nearest =
+      rtree.FindNearestElement(
+          0.5,
+          [query](const Rect& bounds) { return DistanceToRect(query, bounds); },
+          [query, &n_element_tests](const Point& p) {
+            ++n_element_tests;
+            return (p - query).Magnitude();
+          });
+  ASSERT_TRUE(nearest.has_value());
+  EXPECT_EQ(nearest->element, (Point{10, 20}));
+  EXPECT_FLOAT_EQ(nearest->distance, std::hypot(0.25f, 0.125f));
+  // Only the elements whose bounds are within the cutoff are tested.
+  EXPECT_EQ(n_element_tests, 1);
+}
+
+TEST(FlatStaticRTreeTest, FindNearestElementWithEmptyTree) {
+  PointRTree rtree;
+  EXPECT_EQ(rtree.FindNearestElement(
+                std::numeric_limits<float>::infinity(),
+                [](const Rect&) { return 0.f; },
+                [](const Point&) { return 0.f; }),
+            std::nullopt);
+}
+
+TEST(FlatStaticRTreeDeathTest, WeightOfIntersectedElementsWithoutWeights) {
+  PointRTree rtree(std::vector<Point>{{0, 0}, {1, 1}}, point_bounds);
+  EXPECT_DEATH_IF_SUPPORTED(
+      rtree.WeightOfIntersectedElementsIsGreaterThan(
+          0, [](const Rect&) { return PointRTree::BoundsRelation::kContained; },
+          [](const Point&) { return true; }),
+      "InitializeWeights");
+}
+
+}  // namespace
+}  // namespace ink::geometry_internal
@@ -0,0 +1,41 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INK_GEOMETRY_INTERNAL_INDEX_PAIR_PACKING_H_
+#define INK_GEOMETRY_INTERNAL_INDEX_PAIR_PACKING_H_
+
+#include <cstdint>
+
+#include "ink/geometry/mesh_index_types.h"
+
+namespace ink::geometry_internal {
+
+// Packs a `TriangleIndexPair` into a single 32-bit value, with the mesh index
+// in the high 16 bits and the triangle index in the low 16 bits. This is used
+// for the elements of the spatial index of a `PartitionedMesh`, which can be
+// compared and hashed as plain integers.
+inline uint32_t PackTriangleIndexPair(TriangleIndexPair pair) {
+  return static_cast<uint32_t>(pair.mesh_index) << 16 | pair.triangle_index;
+}
+
+// Returns the `TriangleIndexPair` that was packed into `packed` by
+// `PackTriangleIndexPair`.
+inline TriangleIndexPair UnpackTriangleIndexPair(uint32_t packed) {
+  return {.mesh_index = static_cast<uint16_t>(packed >> 16),
+          .triangle_index = static_cast<uint16_t>(packed & 0xffff)};
+}
+
+}  // namespace ink::geometry_internal
+
+#endif  // INK_GEOMETRY_INTERNAL_INDEX_PAIR_PACKING_H_
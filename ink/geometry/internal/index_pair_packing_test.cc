@@ -0,0 +1,43 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ink/geometry/internal/index_pair_packing.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "ink/geometry/mesh_index_types.h"
+#include "ink/geometry/type_matchers.h"
+
+namespace ink::geometry_internal {
+namespace {
+
+TEST(IndexPairPackingTest, PacksMeshIndexIntoHighBits) {
+  EXPECT_EQ(PackTriangleIndexPair({0, 0}), 0u);
+  EXPECT_EQ(PackTriangleIndexPair({0, 7}), 7u);
+  EXPECT_EQ(PackTriangleIndexPair({3, 7}), 0x30007u);
+  EXPECT_EQ(PackTriangleIndexPair({65535, 65535}), 0xffffffffu);
+}
+
+TEST(IndexPairPackingTest, RoundTripsTriangleIndexPairs) {
+  for (TriangleIndexPair pair :
+       {TriangleIndexPair{0, 0}, TriangleIndexPair{5, 2},
+        TriangleIndexPair{0, 65535}, TriangleIndexPair{65535, 0},
+        TriangleIndexPair{65535, 65535}}) {
+    EXPECT_THAT(UnpackTriangleIndexPair(PackTriangleIndexPair(pair)),
+                TriangleIndexPairEq(pair));
+  }
+}
+
+}  // namespace
+}  // namespace ink::geometry_internal
@@ -98,130 +98,290 @@ bool UnpackedFloatValuesAreRepresentable(
   return true;
 }
 
-void PackQuantizedFloat1PackedInOneUnsignedByte(
-    const SmallArray<uint32_t, 4>& value, absl::Span<std::byte> packed_bytes) {
-  ABSL_DCHECK(MeshFormat::PackedBitsPerComponent(
-                  MeshFormat::AttributeType::kFloat1PackedInOneUnsignedByte)
-                  .value_or(SmallArray<uint8_t, 4>({0})) ==
-              (SmallArray<uint8_t, 4>({8})));
-  packed_bytes[0] = static_cast<std::byte>(value[0]);
-}
-
-void PackQuantizedFloat2PackedInOneFloat(const SmallArray<uint32_t, 4>& value,
-                                         absl::Span<std::byte> packed_bytes) {
-  ABSL_DCHECK(MeshFormat::PackedBitsPerComponent(
-                  MeshFormat::AttributeType::kFloat2PackedInOneFloat)
-                  .value_or(SmallArray<uint8_t, 4>({0, 0})) ==
-              (SmallArray<uint8_t, 4>({12, 12})));
-  float packed_float = {static_cast<float>(value[0] << 12 | value[1])};
-  ABSL_DCHECK_EQ(packed_bytes.size(), sizeof(float));
-  std::memcpy(packed_bytes.data(), &packed_float, sizeof(float));
-}
-
-void PackQuantizedFloat2PackedInThreeUnsignedBytes_XY12(
-    const SmallArray<uint32_t, 4>& value, absl::Span<std::byte> packed_bytes) {
-  ABSL_DCHECK(
-      MeshFormat::PackedBitsPerComponent(
-          MeshFormat::AttributeType::kFloat2PackedInThreeUnsignedBytes_XY12)
-          .value_or(SmallArray<uint8_t, 4>({0, 0})) ==
-      (SmallArray<uint8_t, 4>({12, 12})));
-  packed_bytes[0] = static_cast<std::byte>(value[0] >> 4);
-  packed_bytes[1] =
-      static_cast<std::byte>(((value[0] & 0xF) << 4) + (value[1] >> 8));
-  packed_bytes[2] = static_cast<std::byte>(value[1] & 0xFF);
-}
-
-void PackQuantizedFloat3PackedInFourUnsignedBytes_XYZ10(
-    const SmallArray<uint32_t, 4>& value, absl::Span<std::byte> packed_bytes) {
-  ABSL_DCHECK(
-      MeshFormat::PackedBitsPerComponent(
-          MeshFormat::AttributeType::kFloat3PackedInFourUnsignedBytes_XYZ10)
-          .value_or(SmallArray<uint8_t, 4>({0, 0, 0})) ==
-      (SmallArray<uint8_t, 4>({10, 10, 10})));
-  packed_bytes[0] = static_cast<std::byte>(value[0] >> 2);
-  packed_bytes[1] =
-      static_cast<std::byte>(((value[0] & 0x03) << 6) + (value[1] >> 4));
-  packed_bytes[2] =
-      static_cast<std::byte>(((value[1] & 0x0F) << 4) + (value[2] >> 6));
-  packed_bytes[3] = static_cast<std::byte>((value[2] & 0x3F) << 2);
-}
-
-void PackQuantizedFloat2PackedInFourUnsignedBytes_X12_Y20(
-    const SmallArray<uint32_t, 4>& value, absl::Span<std::byte> packed_bytes) {
-  ABSL_DCHECK(
-      MeshFormat::PackedBitsPerComponent(
-          MeshFormat::AttributeType::kFloat2PackedInFourUnsignedBytes_X12_Y20)
-          .value_or(SmallArray<uint8_t, 4>({0, 0})) ==
-      (SmallArray<uint8_t, 4>({12, 20})));
-  packed_bytes[0] = static_cast<std::byte>(value[0] >> 4);
-  packed_bytes[1] =
-      static_cast<std::byte>(((value[0] & 0xF) << 4) + (value[1] >> 16));
-  packed_bytes[2] = static_cast<std::byte>((value[1] & 0xFF00) >> 8);
-  packed_bytes[3] = static_cast<std::byte>(value[1] & 0xFF);
-}
-
-void PackQuantizedFloat3PackedInOneFloat(const SmallArray<uint32_t, 4>& value,
-                                         absl::Span<std::byte> packed_bytes) {
-  ABSL_DCHECK(MeshFormat::PackedBitsPerComponent(
-                  MeshFormat::AttributeType::kFloat3PackedInOneFloat)
-                  .value_or(SmallArray<uint8_t, 4>({0, 0, 0})) ==
-              (SmallArray<uint8_t, 4>({8, 8, 8})));
-  float packed_float = {
-      static_cast<float>(value[0] << 16 | value[1] << 8 | value[2])};
-  ABSL_DCHECK_EQ(packed_bytes.size(), sizeof(float));
-  std::memcpy(packed_bytes.data(), &packed_float, sizeof(float));
-}
-
-void PackQuantizedFloat3PackedInTwoFloats(const SmallArray<uint32_t, 4>& value,
-                                          absl::Span<std::byte> packed_bytes) {
-  ABSL_DCHECK(MeshFormat::PackedBitsPerComponent(
-                  MeshFormat::AttributeType::kFloat3PackedInTwoFloats)
-                  .value_or(SmallArray<uint8_t, 4>({0, 0, 0})) ==
-              (SmallArray<uint8_t, 4>({16, 16, 16})));
-  std::array<float, 2> floats = {
-      static_cast<float>(value[0] << 8 | value[1] >> 8),
-      static_cast<float>((value[1] & 0x000000FF) << 16 | value[2])};
-  ABSL_DCHECK_EQ(packed_bytes.size(), sizeof(float) * 2);
-  std::memcpy(packed_bytes.data(), floats.data(), sizeof(float) * 2);
-}
-
-void PackQuantizedFloat4PackedInOneFloat(const SmallArray<uint32_t, 4>& value,
-                                         absl::Span<std::byte> packed_bytes) {
-  ABSL_DCHECK(MeshFormat::PackedBitsPerComponent(
-                  MeshFormat::AttributeType::kFloat4PackedInOneFloat)
-                  .value_or(SmallArray<uint8_t, 4>({0, 0, 0, 0})) ==
-              (SmallArray<uint8_t, 4>({6, 6, 6, 6})));
-  float packed_float = {static_cast<float>(value[0] << 18 | value[1] << 12 |
-                                           value[2] << 6 | value[3])};
-  ABSL_DCHECK_EQ(packed_bytes.size(), sizeof(float));
-  std::memcpy(packed_bytes.data(), &packed_float, sizeof(float));
-}
-
-void PackQuantizedFloat4PackedInTwoFloats(const SmallArray<uint32_t, 4>& value,
-                                          absl::Span<std::byte> packed_bytes) {
-  ABSL_DCHECK(MeshFormat::PackedBitsPerComponent(
-                  MeshFormat::AttributeType::kFloat4PackedInTwoFloats)
-                  .value_or(SmallArray<uint8_t, 4>({0, 0, 0, 0})) ==
-              (SmallArray<uint8_t, 4>({12, 12, 12, 12})));
-  std::array<float, 2> floats = {static_cast<float>(value[0] << 12 | value[1]),
-                                 static_cast<float>(value[2] << 12 | value[3])};
-  ABSL_DCHECK_EQ(packed_bytes.size(), sizeof(float) * 2);
-  std::memcpy(packed_bytes.data(), floats.data(), sizeof(float) * 2);
-}
-
-void PackQuantizedFloat4PackedInThreeFloats(
-    const SmallArray<uint32_t, 4>& value, absl::Span<std::byte> packed_bytes) {
-  ABSL_DCHECK(MeshFormat::PackedBitsPerComponent(
-                  MeshFormat::AttributeType::kFloat4PackedInThreeFloats)
-                  .value_or(SmallArray<uint8_t, 4>({0, 0, 0, 0})) ==
-              (SmallArray<uint8_t, 4>({18, 18, 18, 18})));
-  std::array<float, 3> floats = {
-      static_cast<float>(value[0] << 6 | value[1] >> 12),
-      static_cast<float>((value[1] & 0x00000FFF) << 12 | value[2] >> 6),
-      static_cast<float>((value[2] & 0x0000003F) << 18 | value[3]),
-  };
-  ABSL_DCHECK_EQ(packed_bytes.size(), sizeof(float) * 3);
-  std::memcpy(packed_bytes.data(), floats.data(), sizeof(float) * 3);
+// Fixed-width codecs for each packed attribute type. `Pack` writes the
+// `kComponentCount` quantized values at `value` to the `kPackedSize` bytes at
+// `packed`, and `Unpack` does the reverse. These are the only definitions of
+// the packed bit layouts; they are used directly by the bulk functions, so that
+// their per-vertex loops have no indirect calls or temporary containers, and
+// through `VisitPackedTypeCodec` by the single-value functions.
+
+// Returns the float at `packed` (which need not be aligned), truncated to an
+// integer.
+uint32_t LoadFloatAsInteger(const std::byte* absl_nonnull packed) {
+  float value;
+  std::memcpy(&value, packed, sizeof(float));
+  return static_cast<uint32_t>(value);
+}
+
+// Stores `floats` at `packed`, which need not be aligned.
+template <size_t kFloatCount>
+void StoreFloats(const std::array<float, kFloatCount>& floats,
+                 std::byte* absl_nonnull packed) {
+  std::memcpy(packed, floats.data(), sizeof(float) * kFloatCount);
+}
+
+uint32_t ToUint32(std::byte b) { return static_cast<uint32_t>(b); }
+
+struct Float1PackedInOneUnsignedByteCodec {
+  static constexpr MeshFormat::AttributeType kType =
+      MeshFormat::AttributeType::kFloat1PackedInOneUnsignedByte;
+  static constexpr int kComponentCount = 1;
+  static constexpr size_t kPackedSize = 1;
+  static constexpr std::array<uint8_t, kComponentCount> kBitsPerComponent = {
+      8};
+
+  static void Pack(const uint32_t* value, std::byte* packed) {
+    packed[0] = static_cast<std::byte>(value[0]);
+  }
+  static void Unpack(const std::byte* packed, uint32_t* value) {
+    value[0] = ToUint32(packed[0]);
+  }
+};
+
+struct Float2PackedInOneFloatCodec {
+  static constexpr MeshFormat::AttributeType kType =
+      MeshFormat::AttributeType::kFloat2PackedInOneFloat;
+  static constexpr int kComponentCount = 2;
+  static constexpr size_t kPackedSize = sizeof(float);
+  static constexpr std::array<uint8_t, kComponentCount> kBitsPerComponent = {
+      12, 12};
+
+  static void Pack(const uint32_t* value, std::byte* packed) {
+    StoreFloats<1>({static_cast<float>(value[0] << 12 | value[1])}, packed);
+  }
+  static void Unpack(const std::byte* packed, uint32_t* value) {
+    uint32_t packed_integer = LoadFloatAsInteger(packed);
+    value[0] = (packed_integer & 0xFFF000) >> 12;
+    value[1] = (packed_integer & 0x000FFF);
+  }
+};
+
+struct Float2PackedInThreeUnsignedBytes_XY12Codec {
+  static constexpr MeshFormat::AttributeType kType =
+      MeshFormat::AttributeType::kFloat2PackedInThreeUnsignedBytes_XY12;
+  static constexpr int kComponentCount = 2;
+  static constexpr size_t kPackedSize = 3;
+  static constexpr std::array<uint8_t, kComponentCount> kBitsPerComponent = {
+      12, 12};
+
+  static void Pack(const uint32_t* value, std::byte* packed) {
+    packed[0] = static_cast<std::byte>(value[0] >> 4);
+    packed[1] =
+        static_cast<std::byte>(((value[0] & 0xF) << 4) + (value[1] >> 8));
+    packed[2] = static_cast<std::byte>(value[1] & 0xFF);
+  }
+  static void Unpack(const std::byte* packed, uint32_t* value) {
+    value[0] = (ToUint32(packed[0]) << 4) + (ToUint32(packed[1]) >> 4);
+    value[1] = ((ToUint32(packed[1]) & 0x0F) << 8) + ToUint32(packed[2]);
+  }
+};
+
+struct Float2PackedInFourUnsignedBytes_X12_Y20Codec {
+  static constexpr MeshFormat::AttributeType kType =
+      MeshFormat::AttributeType::kFloat2PackedInFourUnsignedBytes_X12_Y20;
+  static constexpr int kComponentCount = 2;
+  static constexpr size_t kPackedSize = 4;
+  static constexpr std::array<uint8_t, kComponentCount> kBitsPerComponent = {
+      12, 20};
+
+  static void Pack(const uint32_t* value, std::byte* packed) {
+    packed[0] = static_cast<std::byte>(value[0] >> 4);
+    packed[1] =
+        static_cast<std::byte>(((value[0] & 0xF) << 4) + (value[1] >> 16));
+    packed[2] = static_cast<std::byte>((value[1] & 0xFF00) >> 8);
+    packed[3] = static_cast<std::byte>(value[1] & 0xFF);
+  }
+  static void Unpack(const std::byte* packed, uint32_t* value) {
+    value[0] = (ToUint32(packed[0]) << 4) + (ToUint32(packed[1]) >> 4);
+    value[1] = ((ToUint32(packed[1]) & 0xF) << 16) +
+               (ToUint32(packed[2]) << 8) + ToUint32(packed[3]);
+  }
+};
+
+struct Float3PackedInOneFloatCodec {
+  static constexpr MeshFormat::AttributeType kType =
+      MeshFormat::AttributeType::kFloat3PackedInOneFloat;
+  static constexpr int kComponentCount = 3;
+  static constexpr size_t kPackedSize = sizeof(float);
+  static constexpr std::array<uint8_t, kComponentCount> kBitsPerComponent = {
+      8, 8, 8};
+
+  static void Pack(const uint32_t* value, std::byte* packed) {
+    StoreFloats<1>(
+        {static_cast<float>(value[0] << 16 | value[1] << 8 | value[2])},
+        packed);
+  }
+  static void Unpack(const std::byte* packed, uint32_t* value) {
+    uint32_t packed_integer = LoadFloatAsInteger(packed);
+    value[0] = (packed_integer & 0xFF0000) >> 16;
+    value[1] = (packed_integer & 0x00FF00) >> 8;
+    value[2] = (packed_integer & 0x0000FF);
+  }
+};
+
+struct Float3PackedInTwoFloatsCodec {
+  static constexpr MeshFormat::AttributeType kType =
+      MeshFormat::AttributeType::kFloat3PackedInTwoFloats;
+  static constexpr int kComponentCount = 3;
+  static constexpr size_t kPackedSize = sizeof(float) * 2;
+  static constexpr std::array<uint8_t, kComponentCount> kBitsPerComponent = {
+      16, 16, 16};
+
+  static void Pack(const uint32_t* value, std::byte* packed) {
+    StoreFloats<2>({static_cast<float>(value[0] << 8 | value[1] >> 8),
+                    static_cast<float>((value[1] & 0x000000FF) << 16 |
+                                       value[2])},
+                   packed);
+  }
+  static void Unpack(const std::byte* packed, uint32_t* value) {
+    uint32_t packed_integer0 = LoadFloatAsInteger(packed);
+    uint32_t packed_integer1 = LoadFloatAsInteger(packed + sizeof(float));
+    value[0] = (packed_integer0 & 0xFFFF00) >> 8;
+    value[1] =
+        (packed_integer0 & 0x0000FF) << 8 | (packed_integer1 & 0xFF0000) >> 16;
+    value[2] = (packed_integer1 & 0x00FFFF);
+  }
+};
+
+struct Float3PackedInFourUnsignedBytes_XYZ10Codec {
+  static constexpr MeshFormat::AttributeType kType =
+      MeshFormat::AttributeType::kFloat3PackedInFourUnsignedBytes_XYZ10;
+  static constexpr int kComponentCount = 3;
+  static constexpr size_t kPackedSize = 4;
+  static constexpr std::array<uint8_t, kComponentCount> kBitsPerComponent = {
+      10, 10, 10};
+
+  static void Pack(const uint32_t* value, std::byte* packed) {
+    packed[0] = static_cast<std::byte>(value[0] >> 2);
+    packed[1] =
+        static_cast<std::byte>(((value[0] & 0x03) << 6) + (value[1] >> 4));
+    packed[2] =
+        static_cast<std::byte>(((value[1] & 0x0F) << 4) + (value[2] >> 6));
+    packed[3] = static_cast<std::byte>((value[2] & 0x3F) << 2);
+  }
+  static void Unpack(const std::byte* packed, uint32_t* value) {
+    value[0] = (ToUint32(packed[0]) << 2) + (ToUint32(packed[1]) >> 6);
+    value[1] = ((ToUint32(packed[1]) & 0x3F) << 4) + (ToUint32(packed[2]) >> 4);
+    value[2] = ((ToUint32(packed[2]) & 0x0F) << 6) +
+               ((ToUint32(packed[3]) & 0xFC) >> 2);
+  }
+};
+
+struct Float4PackedInOneFloatCodec {
+  static constexpr MeshFormat::AttributeType kType =
+      MeshFormat::AttributeType::kFloat4PackedInOneFloat;
+  static constexpr int kComponentCount = 4;
+  static constexpr size_t kPackedSize = sizeof(float);
+  static constexpr std::array<uint8_t, kComponentCount> kBitsPerComponent = {
+      6, 6, 6, 6};
+
+  static void Pack(const uint32_t* value, std::byte* packed) {
+    StoreFloats<1>({static_cast<float>(value[0] << 18 | value[1] << 12 |
+                                       value[2] << 6 | value[3])},
+                   packed);
+  }
+  static void Unpack(const std::byte* packed, uint32_t* value) {
+    uint32_t packed_integer = LoadFloatAsInteger(packed);
+    value[0] = (packed_integer & 0xFC0000) >> 18;
+    value[1] = (packed_integer & 0x03F000) >> 12;
+    value[2] = (packed_integer & 0x000FC0) >> 6;
+    value[3] = (packed_integer & 0x00003F);
+  }
+};
+
+struct Float4PackedInTwoFloatsCodec {
+  static constexpr MeshFormat::AttributeType kType =
+      MeshFormat::AttributeType::kFloat4PackedInTwoFloats;
+  static constexpr int kComponentCount = 4;
+  static constexpr size_t kPackedSize = sizeof(float) * 2;
+  static constexpr std::array<uint8_t, kComponentCount> kBitsPerComponent = {
+      12, 12, 12, 12};
+
+  static void Pack(const uint32_t* value, std::byte* packed) {
+    StoreFloats<2>({static_cast<float>(value[0] << 12 | value[1]),
+                    static_cast<float>(value[2] << 12 | value[3])},
+                   packed);
+  }
+  static void Unpack(const std::byte* packed, uint32_t* value) {
+    uint32_t packed_integer0 = LoadFloatAsInteger(packed);
+    uint32_t packed_integer1 = LoadFloatAsInteger(packed + sizeof(float));
+    value[0] = (packed_integer0 & 0xFFF000) >> 12;
+    value[1] = (packed_integer0 & 0x000FFF);
+    value[2] = (packed_integer1 & 0xFFF000) >> 12;
+    value[3] = (packed_integer1 & 0x000FFF);
+  }
+};
+
+struct Float4PackedInThreeFloatsCodec {
+  static constexpr MeshFormat::AttributeType kType =
+      MeshFormat::AttributeType::kFloat4PackedInThreeFloats;
+  static constexpr int kComponentCount = 4;
+  static constexpr size_t kPackedSize = sizeof(float) * 3;
+  static constexpr std::array<uint8_t, kComponentCount> kBitsPerComponent = {
+      18, 18, 18, 18};
+
+  static void Pack(const uint32_t* value, std::byte* packed) {
+    StoreFloats<3>(
+        {static_cast<float>(value[0] << 6 | value[1] >> 12),
+         static_cast<float>((value[1] & 0x00000FFF) << 12 | value[2] >> 6),
+         static_cast<float>((value[2] & 0x0000003F) << 18 | value[3])},
+        packed);
+  }
+  static void Unpack(const std::byte* packed, uint32_t* value) {
+    uint32_t packed_integer0 = LoadFloatAsInteger(packed);
+    uint32_t packed_integer1 = LoadFloatAsInteger(packed + sizeof(float));
+    uint32_t packed_integer2 = LoadFloatAsInteger(packed + 2 * sizeof(float));
+    value[0] = (packed_integer0 & 0xFFFFC0) >> 6;
+    value[1] = (packed_integer0 & 0x00003F) << 12 |
+               (packed_integer1 & 0xFFF000) >> 12;
+    value[2] =
+        (packed_integer1 & 0x000FFF) << 6 | (packed_integer2 & 0xFC0000) >> 18;
+    value[3] = (packed_integer2 & 0x03FFFF);
+  }
+};
+
+// Calls `visitor` with a default-constructed codec for `type`, which must be a
+// packed attribute type.
+template <typename Visitor>
+void VisitPackedTypeCodec(MeshFormat::AttributeType type, Visitor visitor) {
+  switch (type) {
+    case MeshFormat::AttributeType::kFloat1PackedInOneUnsignedByte:
+      return visitor(Float1PackedInOneUnsignedByteCodec());
+    case MeshFormat::AttributeType::kFloat2PackedInOneFloat:
+      return visitor(Float2PackedInOneFloatCodec());
+    case MeshFormat::AttributeType::kFloat2PackedInThreeUnsignedBytes_XY12:
+      return visitor(Float2PackedInThreeUnsignedBytes_XY12Codec());
+    case MeshFormat::AttributeType::kFloat2PackedInFourUnsignedBytes_X12_Y20:
+      return visitor(Float2PackedInFourUnsignedBytes_X12_Y20Codec());
+    case MeshFormat::AttributeType::kFloat3PackedInOneFloat:
+      return visitor(Float3PackedInOneFloatCodec());
+    case MeshFormat::AttributeType::kFloat3PackedInTwoFloats:
+      return visitor(Float3PackedInTwoFloatsCodec());
+    case MeshFormat::AttributeType::kFloat3PackedInFourUnsignedBytes_XYZ10:
+      return visitor(Float3PackedInFourUnsignedBytes_XYZ10Codec());
+    case MeshFormat::AttributeType::kFloat4PackedInOneFloat:
+      return visitor(Float4PackedInOneFloatCodec());
+    case MeshFormat::AttributeType::kFloat4PackedInTwoFloats:
+      return visitor(Float4PackedInTwoFloatsCodec());
+    case MeshFormat::AttributeType::kFloat4PackedInThreeFloats:
+      return visitor(Float4PackedInThreeFloatsCodec());
+    case MeshFormat::AttributeType::kFloat1Unpacked:
+    case MeshFormat::AttributeType::kFloat2Unpacked:
+    case MeshFormat::AttributeType::kFloat3Unpacked:
+    case MeshFormat::AttributeType::kFloat4Unpacked:
+      break;
+  }
+  ABSL_LOG(FATAL) << "Non-packed AttributeType: " << static_cast<uint8_t>(type);
+}
+
+// Returns true if `Codec` agrees with `MeshFormat` on the layout of its type.
+template <typename Codec>
+bool CodecMatchesMeshFormat() {
+  std::optional<SmallArray<uint8_t, 4>> bits =
+      MeshFormat::PackedBitsPerComponent(Codec::kType);
+  return bits.has_value() &&
+         absl::c_equal(bits->Values(), Codec::kBitsPerComponent) &&
+         MeshFormat::PackedAttributeSize(Codec::kType) == Codec::kPackedSize;
 }
 
 }  // namespace
@@ -260,47 +420,14 @@ void PackQuantizedAttribute(MeshFormat::AttributeType type,
                             absl::Span<std::byte> packed_bytes) {
   ABSL_DCHECK_EQ(quantized_value.Size(), MeshFormat::ComponentCount(type));
   ABSL_DCHECK(!MeshFormat::IsUnpackedType(type));
+  if (MeshFormat::IsUnpackedType(type)) return;
 
-  switch (type) {
-    case MeshFormat::AttributeType::kFloat1PackedInOneUnsignedByte:
-      PackQuantizedFloat1PackedInOneUnsignedByte(quantized_value, packed_bytes);
-      break;
-    case MeshFormat::AttributeType::kFloat2PackedInOneFloat:
-      PackQuantizedFloat2PackedInOneFloat(quantized_value, packed_bytes);
-      break;
-    case MeshFormat::AttributeType::kFloat2PackedInThreeUnsignedBytes_XY12:
-      PackQuantizedFloat2PackedInThreeUnsignedBytes_XY12(quantized_value,
-                                                         packed_bytes);
-      break;
-    case MeshFormat::AttributeType::kFloat2PackedInFourUnsignedBytes_X12_Y20:
-      PackQuantizedFloat2PackedInFourUnsignedBytes_X12_Y20(quantized_value,
-                                                           packed_bytes);
-      break;
-    case MeshFormat::AttributeType::kFloat3PackedInOneFloat:
-      PackQuantizedFloat3PackedInOneFloat(quantized_value, packed_bytes);
-      break;
-    case MeshFormat::AttributeType::kFloat3PackedInTwoFloats:
-      PackQuantizedFloat3PackedInTwoFloats(quantized_value, packed_bytes);
-      break;
-    case MeshFormat::AttributeType::kFloat3PackedInFourUnsignedBytes_XYZ10:
-      PackQuantizedFloat3PackedInFourUnsignedBytes_XYZ10(quantized_value,
-                                                         packed_bytes);
-      break;
-    case MeshFormat::AttributeType::kFloat4PackedInOneFloat:
-      PackQuantizedFloat4PackedInOneFloat(quantized_value, packed_bytes);
-      break;
-    case MeshFormat::AttributeType::kFloat4PackedInTwoFloats:
-      PackQuantizedFloat4PackedInTwoFloats(quantized_value, packed_bytes);
-      break;
-    case MeshFormat::AttributeType::kFloat4PackedInThreeFloats:
-      PackQuantizedFloat4PackedInThreeFloats(quantized_value, packed_bytes);
-      break;
-    case MeshFormat::AttributeType::kFloat1Unpacked:
-    case MeshFormat::AttributeType::kFloat2Unpacked:
-    case MeshFormat::AttributeType::kFloat3Unpacked:
-    case MeshFormat::AttributeType::kFloat4Unpacked:
-      break;
-  }
+  VisitPackedTypeCodec(type, [&](auto codec) {
+    using Codec = decltype(codec);
+    ABSL_DCHECK(CodecMatchesMeshFormat<Codec>());
+    ABSL_DCHECK_GE(packed_bytes.size(), Codec::kPackedSize);
+    Codec::Pack(quantized_value.Values().data(), packed_bytes.data());
+  });
 }
 
 namespace {
@@ -366,192 +493,6 @@ SmallArray<float, 4> UnpackFloatsFromFloat4Unpacked(
   return unpacked_floats;
 }
 
-SmallArray<uint32_t, 4> UnpackIntegersFromFloat1PackedInOneUnsignedByte(
-    absl::Span<const std::byte> packed_value) {
-  ABSL_DCHECK_EQ(
-      packed_value.size(),
-      MeshFormat::PackedAttributeSize(
-          MeshFormat::AttributeType::kFloat1PackedInOneUnsignedByte));
-
-  ABSL_DCHECK(MeshFormat::PackedBitsPerComponent(
-                  MeshFormat::AttributeType::kFloat1PackedInOneUnsignedByte)
-                  .value_or(SmallArray<uint8_t, 4>({0})) ==
-              (SmallArray<uint8_t, 4>({8})));
-  return {static_cast<uint32_t>(packed_value[0])};
-}
-
-SmallArray<uint32_t, 4> UnpackIntegersFromFloat2PackedInOneFloat(
-    absl::Span<const std::byte> packed_value) {
-  ABSL_DCHECK_EQ(packed_value.size(), sizeof(float));
-  float packed_float;
-  std::memcpy(&packed_float, packed_value.data(), sizeof(float));
-
-  uint32_t packed0 = (static_cast<uint32_t>(packed_float) & 0xFFF000) >> 12;
-  uint32_t packed1 = (static_cast<uint32_t>(packed_float) & 0x000FFF);
-
-  ABSL_DCHECK(MeshFormat::PackedBitsPerComponent(
-                  MeshFormat::AttributeType::kFloat2PackedInOneFloat)
-                  .value_or(SmallArray<uint8_t, 4>({0, 0})) ==
-              (SmallArray<uint8_t, 4>({12, 12})));
-  return {packed0, packed1};
-}
-
-SmallArray<uint32_t, 4> UnpackIntegersFromFloat2PackedInThreeUnsignedBytes_XY12(
-    absl::Span<const std::byte> packed_value) {
-  ABSL_DCHECK_EQ(
-      packed_value.size(),
-      MeshFormat::PackedAttributeSize(
-          MeshFormat::AttributeType::kFloat2PackedInThreeUnsignedBytes_XY12));
-
-  uint32_t packed0 = (static_cast<uint32_t>(packed_value[0]) << 4) +
-                     (static_cast<uint32_t>(packed_value[1]) >> 4);
-
-  uint32_t packed1 = ((static_cast<uint32_t>(packed_value[1]) & 0x0F) << 8) +
-                     (static_cast<uint32_t>(packed_value[2]));
-
-  ABSL_DCHECK(
-      MeshFormat::PackedBitsPerComponent(
-          MeshFormat::AttributeType::kFloat2PackedInThreeUnsignedBytes_XY12)
-          .value_or(SmallArray<uint8_t, 4>({0, 0})) ==
-      (SmallArray<uint8_t, 4>({12, 12})));
-  return {packed0, packed1};
-}
-
-SmallArray<uint32_t, 4> UnpackIntegersFromFloat3PackedInFourUnsignedBytes_XYZ10(
-    absl::Span<const std::byte> packed_value) {
-  ABSL_DCHECK_EQ(
-      packed_value.size(),
-      MeshFormat::PackedAttributeSize(
-          MeshFormat::AttributeType::kFloat3PackedInFourUnsignedBytes_XYZ10));
-
-  uint32_t packed0 = (static_cast<uint32_t>(packed_value[0]) << 2) +
-                     (static_cast<uint32_t>(packed_value[1]) >> 6);
-
-  uint32_t packed1 = ((static_cast<uint32_t>(packed_value[1]) & 0x3F) << 4) +
-                     (static_cast<uint32_t>(packed_value[2]) >> 4);
-
-  uint32_t packed2 = ((static_cast<uint32_t>(packed_value[2]) & 0x0F) << 6) +
-                     ((static_cast<uint32_t>(packed_value[3]) & 0xFC) >> 2);
-
-  ABSL_DCHECK(
-      MeshFormat::PackedBitsPerComponent(
-          MeshFormat::AttributeType::kFloat3PackedInFourUnsignedBytes_XYZ10)
-          .value_or(SmallArray<uint8_t, 4>({0, 0, 0})) ==
-      (SmallArray<uint8_t, 4>({10, 10, 10})));
-  return {packed0, packed1, packed2};
-}
-
-SmallArray<uint32_t, 4>
-UnpackIntegersFromFloat2PackedInFourUnsignedBytes_X12_Y20(
-    absl::Span<const std::byte> packed_value) {
-  ABSL_DCHECK_EQ(
-      packed_value.size(),
-      MeshFormat::PackedAttributeSize(
-          MeshFormat::AttributeType::kFloat2PackedInFourUnsignedBytes_X12_Y20));
-
-  uint32_t packed0 = (static_cast<uint32_t>(packed_value[0]) << 4) +
-                     (static_cast<uint32_t>(packed_value[1]) >> 4);
-
-  uint32_t packed1 = ((static_cast<uint32_t>(packed_value[1]) & 0xF) << 16) +
-                     (static_cast<uint32_t>(packed_value[2]) << 8) +
-                     (static_cast<uint32_t>(packed_value[3]));
-
-  ABSL_DCHECK(
-      MeshFormat::PackedBitsPerComponent(
-          MeshFormat::AttributeType::kFloat2PackedInFourUnsignedBytes_X12_Y20)
-          .value_or(SmallArray<uint8_t, 4>({0, 0})) ==
-      (SmallArray<uint8_t, 4>({12, 20})));
-  return {packed0, packed1};
-}
-
-SmallArray<uint32_t, 4> UnpackIntegersFromFloat3PackedInOneFloat(
-    absl::Span<const std::byte> packed_value) {
-  ABSL_DCHECK_EQ(packed_value.size(), sizeof(float));
-  float packed_float;
-  std::memcpy(&packed_float, packed_value.data(), sizeof(float));
-
-  uint32_t packed0 = (static_cast<uint32_t>(packed_float) & 0xFF0000) >> 16;
-  uint32_t packed1 = (static_cast<uint32_t>(packed_float) & 0x00FF00) >> 8;
-  uint32_t packed2 = (static_cast<uint32_t>(packed_float) & 0x0000FF);
-
-  ABSL_DCHECK(MeshFormat::PackedBitsPerComponent(
-                  MeshFormat::AttributeType::kFloat3PackedInOneFloat)
-                  .value_or(SmallArray<uint8_t, 4>({0, 0, 0})) ==
-              (SmallArray<uint8_t, 4>({8, 8, 8})));
-  return {packed0, packed1, packed2};
-}
-
-SmallArray<uint32_t, 4> UnpackIntegersFromFloat3PackedInTwoFloats(
-    absl::Span<const std::byte> packed_value) {
-  ABSL_DCHECK_EQ(packed_value.size(), sizeof(float) * 2);
-  std::array<float, 2> packed_floats;
-  std::memcpy(&packed_floats, packed_value.data(), sizeof(float) * 2);
-
-  uint32_t packed0 = (static_cast<uint32_t>(packed_floats[0]) & 0xFFFF00) >> 8;
-  uint32_t packed1 = (static_cast<uint32_t>(packed_floats[0]) & 0x0000FF) << 8 |
-                     (static_cast<uint32_t>(packed_floats[1]) & 0xFF0000) >> 16;
-  uint32_t packed2 = (static_cast<uint32_t>(packed_floats[1]) & 0x00FFFF);
-  ABSL_DCHECK(MeshFormat::PackedBitsPerComponent(
-                  MeshFormat::AttributeType::kFloat3PackedInTwoFloats)
-                  .value_or(SmallArray<uint8_t, 4>({0, 0, 0})) ==
-              (SmallArray<uint8_t, 4>({16, 16, 16})));
-  return {packed0, packed1, packed2};
-}
-
-SmallArray<uint32_t, 4> UnpackIntegersFromFloat4PackedInOneFloat(
-    absl::Span<const std::byte> packed_value) {
-  ABSL_DCHECK_EQ(packed_value.size(), sizeof(float));
-  float packed_float;
-  std::memcpy(&packed_float, packed_value.data(), sizeof(float));
-
-  uint32_t packed0 = (static_cast<uint32_t>(packed_float) & 0xFC0000) >> 18;
-  uint32_t packed1 = (static_cast<uint32_t>(packed_float) & 0x03F000) >> 12;
-  uint32_t packed2 = (static_cast<uint32_t>(packed_float) & 0x000FC0) >> 6;
-  uint32_t packed3 = (static_cast<uint32_t>(packed_float) & 0x00003F);
-  ABSL_DCHECK(MeshFormat::PackedBitsPerComponent(
-                  MeshFormat::AttributeType::kFloat4PackedInOneFloat)
-                  .value_or(SmallArray<uint8_t, 4>({0, 0, 0, 0})) ==
-              (SmallArray<uint8_t, 4>({6, 6, 6, 6})));
-  return {packed0, packed1, packed2, packed3};
-}
-
-SmallArray<uint32_t, 4> UnpackIntegersFromFloat4PackedInTwoFloats(
-    absl::Span<const std::byte> packed_value) {
-  ABSL_DCHECK_EQ(packed_value.size(), sizeof(float) * 2);
-  std::array<float, 2> packed_floats;
-  std::memcpy(&packed_floats, packed_value.data(), sizeof(float) * 2);
-
-  uint32_t packed0 = (static_cast<uint32_t>(packed_floats[0]) & 0xFFF000) >> 12;
-  uint32_t packed1 = (static_cast<uint32_t>(packed_floats[0]) & 0x000FFF);
-  uint32_t packed2 = (static_cast<uint32_t>(packed_floats[1]) & 0xFFF000) >> 12;
-  uint32_t packed3 = (static_cast<uint32_t>(packed_floats[1]) & 0x000FFF);
-  ABSL_DCHECK(MeshFormat::PackedBitsPerComponent(
-                  MeshFormat::AttributeType::kFloat4PackedInTwoFloats)
-                  .value_or(SmallArray<uint8_t, 4>({0, 0, 0, 0})) ==
-              (SmallArray<uint8_t, 4>({12, 12, 12, 12})));
-  return {packed0, packed1, packed2, packed3};
-}
-
-SmallArray<uint32_t, 4> UnpackIntegersFromFloat4PackedInThreeFloats(
-    absl::Span<const std::byte> packed_value) {
-  ABSL_DCHECK_EQ(packed_value.size(), sizeof(float) * 3);
-  std::array<float, 3> packed_floats;
-  std::memcpy(&packed_floats, packed_value.data(), sizeof(float) * 3);
-
-  uint32_t packed0 = (static_cast<uint32_t>(packed_floats[0]) & 0xFFFFC0) >> 6;
-  uint32_t packed1 = (static_cast<uint32_t>(packed_floats[0]) & 0x00003F)
-                         << 12 |
-                     (static_cast<uint32_t>(packed_floats[1]) & 0xFFF000) >> 12;
-  uint32_t packed2 = (static_cast<uint32_t>(packed_floats[1]) & 0x000FFF) << 6 |
-                     (static_cast<uint32_t>(packed_floats[2]) & 0xFC0000) >> 18;
-  uint32_t packed3 = (static_cast<uint32_t>(packed_floats[2]) & 0x03FFFF);
-  ABSL_DCHECK(MeshFormat::PackedBitsPerComponent(
-                  MeshFormat::AttributeType::kFloat4PackedInThreeFloats)
-                  .value_or(SmallArray<uint8_t, 4>({0, 0, 0, 0})) ==
-              (SmallArray<uint8_t, 4>({18, 18, 18, 18})));
-  return {packed0, packed1, packed2, packed3};
-}
-
 }  // namespace
 
 SmallArray<float, 4> UnpackAttribute(
@@ -587,37 +528,14 @@ SmallArray<uint32_t, 4> UnpackIntegersFromPackedAttribute(
   ABSL_DCHECK(PackedFloatValuesAreFinite(type, packed_value));
   ABSL_DCHECK(PackedFloatValuesAreRepresentable(type, packed_value))
       << "Cannot unpack: Unrepresentable value found";
-  switch (type) {
-    case MeshFormat::AttributeType::kFloat1PackedInOneUnsignedByte:
-      return UnpackIntegersFromFloat1PackedInOneUnsignedByte(packed_value);
-    case MeshFormat::AttributeType::kFloat2PackedInOneFloat:
-      return UnpackIntegersFromFloat2PackedInOneFloat(packed_value);
-    case MeshFormat::AttributeType::kFloat2PackedInThreeUnsignedBytes_XY12:
-      return UnpackIntegersFromFloat2PackedInThreeUnsignedBytes_XY12(
-          packed_value);
-    case MeshFormat::AttributeType::kFloat2PackedInFourUnsignedBytes_X12_Y20:
-      return UnpackIntegersFromFloat2PackedInFourUnsignedBytes_X12_Y20(
-          packed_value);
-    case MeshFormat::AttributeType::kFloat3PackedInOneFloat:
-      return UnpackIntegersFromFloat3PackedInOneFloat(packed_value);
-    case MeshFormat::AttributeType::kFloat3PackedInTwoFloats:
-      return UnpackIntegersFromFloat3PackedInTwoFloats(packed_value);
-    case MeshFormat::AttributeType::kFloat3PackedInFourUnsignedBytes_XYZ10:
-      return UnpackIntegersFromFloat3PackedInFourUnsignedBytes_XYZ10(
-          packed_value);
-    case MeshFormat::AttributeType::kFloat4PackedInOneFloat:
-      return UnpackIntegersFromFloat4PackedInOneFloat(packed_value);
-    case MeshFormat::AttributeType::kFloat4PackedInTwoFloats:
-      return UnpackIntegersFromFloat4PackedInTwoFloats(packed_value);
-    case MeshFormat::AttributeType::kFloat4PackedInThreeFloats:
-      return UnpackIntegersFromFloat4PackedInThreeFloats(packed_value);
-    case MeshFormat::AttributeType::kFloat1Unpacked:
-    case MeshFormat::AttributeType::kFloat2Unpacked:
-    case MeshFormat::AttributeType::kFloat3Unpacked:
-    case MeshFormat::AttributeType::kFloat4Unpacked:
-      break;
-  }
-  ABSL_LOG(FATAL) << "Non-packed AttributeType: " << static_cast<uint8_t>(type);
+  SmallArray<uint32_t, 4> quantized_value(MeshFormat::ComponentCount(type));
+  VisitPackedTypeCodec(type, [&](auto codec) {
+    using Codec = decltype(codec);
+    ABSL_DCHECK(CodecMatchesMeshFormat<Codec>());
+    ABSL_DCHECK_EQ(packed_value.size(), Codec::kPackedSize);
+    Codec::Unpack(packed_value.data(), quantized_value.Values().data());
+  });
+  return quantized_value;
 }
 
 SmallArray<float, 4> ReadFloatsFromUnpackedAttribute(
@@ -646,6 +564,183 @@ SmallArray<float, 4> ReadFloatsFromUnpackedAttribute(
   ABSL_LOG(FATAL) << "Packed AttributeType: " << static_cast<uint8_t>(type);
 }
 
+namespace {
+
+// Returns true if `packed_data_size` bytes are enough to hold `n_values`
+// packed values of `type`, `packed_stride` bytes apart.
+bool PackedDataCanHoldValues(MeshFormat::AttributeType type, size_t n_values,
+                             size_t packed_stride, size_t packed_data_size) {
+  if (n_values == 0) return true;
+  return packed_stride >= MeshFormat::PackedAttributeSize(type) &&
+         packed_data_size >= (n_values - 1) * packed_stride +
+                                 MeshFormat::PackedAttributeSize(type);
+}
+
+// Copies `n_values` values of `kComponents` floats each, which start every
+// `src_stride` bytes in `src`, to every `dst_stride` bytes in `dst`.
+template <int kComponents>
+void CopyStridedFloatValues(const std::byte* src, size_t src_stride,
+                            std::byte* dst, size_t dst_stride,
+                            size_t n_values) {
+  for (size_t i = 0; i < n_values; ++i) {
+    std::memcpy(dst + i * dst_stride, src + i * src_stride,
+                kComponents * sizeof(float));
+  }
+}
+
+void CopyStridedFloatValues(int n_components, const std::byte* src,
+                            size_t src_stride, std::byte* dst,
+                            size_t dst_stride, size_t n_values) {
+  switch (n_components) {
+    case 1:
+      return CopyStridedFloatValues<1>(src, src_stride, dst, dst_stride,
+                                       n_values);
+    case 2:
+      return CopyStridedFloatValues<2>(src, src_stride, dst, dst_stride,
+                                       n_values);
+    case 3:
+      return CopyStridedFloatValues<3>(src, src_stride, dst, dst_stride,
+                                       n_values);
+    case 4:
+      return CopyStridedFloatValues<4>(src, src_stride, dst, dst_stride,
+                                       n_values);
+  }
+  ABSL_LOG(FATAL) << "Invalid component count: " << n_components;
+}
+
+}  // namespace
+
+void PackAttributeValues(MeshFormat::AttributeType type,
+                         const MeshAttributeCodingParams& packing_params,
+                         absl::Span<const float> unpacked_values,
+                         size_t packed_stride,
+                         absl::Span<std::byte> packed_data) {
+  ABSL_DCHECK(IsValidCodingParams(type, packing_params))
+      << "Invalid packing params";
+  const int n_components = MeshFormat::ComponentCount(type);
+  ABSL_DCHECK_EQ(unpacked_values.size() % n_components, 0u);
+  const size_t n_values = unpacked_values.size() / n_components;
+  ABSL_DCHECK(PackedDataCanHoldValues(type, n_values, packed_stride,
+                                      packed_data.size()));
+  ABSL_DCHECK(absl::c_all_of(unpacked_values, ink_internal::IsFinite));
+
+  if (MeshFormat::IsUnpackedType(type)) {
+    CopyStridedFloatValues(
+        n_components,
+        reinterpret_cast<const std::byte*>(unpacked_values.data()),
+        n_components * sizeof(float), packed_data.data(), packed_stride,
+        n_values);
+    return;
+  }
+
+  VisitPackedTypeCodec(type, [&](auto codec) {
+    using Codec = decltype(codec);
+    constexpr int kComponents = Codec::kComponentCount;
+    std::array<ComponentCodingParams, kComponents> components;
+    absl::c_copy(packing_params.components.Values(), components.begin());
+    ABSL_DCHECK(CodecMatchesMeshFormat<Codec>());
+    const float* src = unpacked_values.data();
+    std::byte* dst = packed_data.data();
+    for (size_t i = 0; i < n_values;
+         ++i, src += kComponents, dst += packed_stride) {
+      ABSL_DCHECK(UnpackedFloatValuesAreRepresentable(
+          type, packing_params,
+          SmallArray<float, 4>(absl::MakeConstSpan(src, kComponents))));
+      std::array<uint32_t, kComponents> quantized;
+      for (int c = 0; c < kComponents; ++c) {
+        quantized[c] = PackSingleFloat(components[c], src[c]);
+      }
+      Codec::Pack(quantized.data(), dst);
+    }
+  });
+}
+
+void PackQuantizedAttributeValues(MeshFormat::AttributeType type,
+                                  absl::Span<const uint32_t> quantized_values,
+                                  size_t packed_stride,
+                                  absl::Span<std::byte> packed_data) {
+  ABSL_DCHECK(!MeshFormat::IsUnpackedType(type));
+  const int n_components = MeshFormat::ComponentCount(type);
+  ABSL_DCHECK_EQ(quantized_values.size() % n_components, 0u);
+  const size_t n_values = quantized_values.size() / n_components;
+  ABSL_DCHECK(PackedDataCanHoldValues(type, n_values, packed_stride,
+                                      packed_data.size()));
+
+  VisitPackedTypeCodec(type, [&](auto codec) {
+    using Codec = decltype(codec);
+    constexpr int kComponents = Codec::kComponentCount;
+    ABSL_DCHECK(CodecMatchesMeshFormat<Codec>());
+    const uint32_t* src = quantized_values.data();
+    std::byte* dst = packed_data.data();
+    for (size_t i = 0; i < n_values;
+         ++i, src += kComponents, dst += packed_stride) {
+      Codec::Pack(src, dst);
+    }
+  });
+}
+
+void UnpackAttributeValues(MeshFormat::AttributeType type,
+                           const MeshAttributeCodingParams& unpacking_params,
+                           absl::Span<const std::byte> packed_data,
+                           size_t packed_stride,
+                           absl::Span<float> unpacked_values) {
+  ABSL_DCHECK(IsValidCodingParams(type, unpacking_params))
+      << "Invalid unpacking params";
+  const int n_components = MeshFormat::ComponentCount(type);
+  ABSL_DCHECK_EQ(unpacked_values.size() % n_components, 0u);
+  const size_t n_values = unpacked_values.size() / n_components;
+  ABSL_DCHECK(PackedDataCanHoldValues(type, n_values, packed_stride,
+                                      packed_data.size()));
+
+  if (MeshFormat::IsUnpackedType(type)) {
+    CopyStridedFloatValues(n_components, packed_data.data(), packed_stride,
+                           reinterpret_cast<std::byte*>(unpacked_values.data()),
+                           n_components * sizeof(float), n_values);
+    return;
+  }
+
+  VisitPackedTypeCodec(type, [&](auto codec) {
+    using Codec = decltype(codec);
+    constexpr int kComponents = Codec::kComponentCount;
+    std::array<ComponentCodingParams, kComponents> components;
+    absl::c_copy(unpacking_params.components.Values(), components.begin());
+    ABSL_DCHECK(CodecMatchesMeshFormat<Codec>());
+    const std::byte* src = packed_data.data();
+    float* dst = unpacked_values.data();
+    for (size_t i = 0; i < n_values;
+         ++i, src += packed_stride, dst += kComponents) {
+      std::array<uint32_t, kComponents> quantized;
+      Codec::Unpack(src, quantized.data());
+      for (int c = 0; c < kComponents; ++c) {
+        dst[c] = UnpackSingleFloat(components[c], quantized[c]);
+      }
+    }
+  });
+}
+
+void UnpackIntegersFromPackedAttributeValues(
+    MeshFormat::AttributeType type, absl::Span<const std::byte> packed_data,
+    size_t packed_stride, absl::Span<uint32_t> quantized_values) {
+  ABSL_DCHECK(!MeshFormat::IsUnpackedType(type));
+  const int n_components = MeshFormat::ComponentCount(type);
+  ABSL_DCHECK_EQ(quantized_values.size() % n_components, 0u);
+  const size_t n_values = quantized_values.size() / n_components;
+  ABSL_DCHECK(PackedDataCanHoldValues(type, n_values, packed_stride,
+                                      packed_data.size()));
+
+  VisitPackedTypeCodec(type, [&](auto codec) {
+    using Codec = decltype(codec);
+    constexpr int kComponents = Codec::kComponentCount;
+    ABSL_DCHECK(CodecMatchesMeshFormat<Codec>());
+    const std::byte* src = packed_data.data();
+    uint32_t* dst = quantized_values.data();
+    for (size_t i = 0; i < n_values;
+         ++i, src += packed_stride, dst += kComponents) {
+      Codec::Unpack(src, dst);
+    }
+  });
+}
+
 std::array<uint32_t, 3> ReadTriangleIndicesFromByteArray(
     uint32_t triangle_index, uint8_t index_stride,
     absl::Span<const std::byte> index_data) {
@@ -949,41 +1044,49 @@ std::vector<std::byte> CopyAndPackPartitionVertices(
     packed_vertex_stride += original_attr.packed_width;
   }
 
-  // Returns the unpacked attribute value read from `unpacked_vertex_data` or
-  // the override position, if applicable.
-  auto get_unpacked_attribute_value =
-      [&](uint32_t original_vertex_index,
-          int original_attribute_index) -> SmallArray<float, 4> {
-    if (original_attribute_index == original_format.PositionAttributeIndex()) {
-      auto override_it = override_vertex_positions.find(original_vertex_index);
-      if (override_it != override_vertex_positions.end()) {
-        return {override_it->second.x, override_it->second.y};
-      }
-    }
-    return ReadUnpackedFloatAttributeFromByteArray(
-        original_vertex_index, original_attribute_index, unpacked_vertex_data,
-        original_format);
-  };
+  // Vertices are packed one attribute at a time, in blocks that are small
+  // enough to gather the unpacked values into a buffer on the stack.
+  constexpr size_t kVerticesPerBlock = 256;
+  std::array<float, 4 * kVerticesPerBlock> unpacked_values;
+  const size_t unpacked_vertex_stride = original_format.UnpackedVertexStride();
+  const size_t position_attr_idx = original_format.PositionAttributeIndex();
 
   std::vector<std::byte> partition_vertex_data(partition_vertex_indices.size() *
                                                packed_vertex_stride);
-  for (uint32_t partition_vertex_idx = 0;
-       partition_vertex_idx < partition_vertex_indices.size();
-       ++partition_vertex_idx) {
-    uint32_t original_vertex_idx =
-        partition_vertex_indices[partition_vertex_idx];
+  for (size_t block_start = 0; block_start < partition_vertex_indices.size();
+       block_start += kVerticesPerBlock) {
+    absl::Span<const uint32_t> block_vertex_indices =
+        partition_vertex_indices.subspan(block_start, kVerticesPerBlock);
     for (size_t original_attr_idx = 0, packed_attr_idx = 0;
          original_attr_idx < n_original_attrs; ++original_attr_idx) {
       MeshFormat::Attribute original_attr = original_attrs[original_attr_idx];
       if (omit_set.contains(original_attr.id)) continue;
-      absl::Span<std::byte> packed_value = absl::MakeSpan(
-          &partition_vertex_data[partition_vertex_idx * packed_vertex_stride +
-                                 packed_attribute_offsets[packed_attr_idx]],
-          original_attr.packed_width);
-      mesh_internal::PackAttribute(
+      int n_components = MeshFormat::ComponentCount(original_attr.type);
+      for (size_t i = 0; i < block_vertex_indices.size(); ++i) {
+        std::memcpy(&unpacked_values[i * n_components],
+                    &unpacked_vertex_data[block_vertex_indices[i] *
+                                              unpacked_vertex_stride +
+                                          original_attr.unpacked_offset],
+                    n_components * sizeof(float));
+      }
+      if (original_attr_idx == position_attr_idx &&
+          !override_vertex_positions.empty()) {
+        for (size_t i = 0; i < block_vertex_indices.size(); ++i) {
+          auto override_it =
+              override_vertex_positions.find(block_vertex_indices[i]);
+          if (override_it == override_vertex_positions.end()) continue;
+          unpacked_values[2 * i] = override_it->second.x;
+          unpacked_values[2 * i + 1] = override_it->second.y;
+        }
+      }
+      PackAttributeValues(
           original_attr.type, packing_params_array[packed_attr_idx],
-          get_unpacked_attribute_value(original_vertex_idx, original_attr_idx),
-          packed_value);
+          absl::MakeConstSpan(unpacked_values.data(),
+                              block_vertex_indices.size() * n_components),
+          packed_vertex_stride,
+          absl::MakeSpan(partition_vertex_data)
+              .subspan(block_start * packed_vertex_stride +
+                       packed_attribute_offsets[packed_attr_idx]));
       ++packed_attr_idx;
     }
   }
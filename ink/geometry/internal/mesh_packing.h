@@ -146,6 +146,42 @@ SmallArray<uint32_t, 4> UnpackIntegersFromPackedAttribute(
 SmallArray<float, 4> ReadFloatsFromUnpackedAttribute(
     MeshFormat::AttributeType type, absl::Span<const std::byte> packed_value);
 
+// Bulk versions of `PackAttribute`, `PackQuantizedAttribute`,
+// `UnpackAttribute`, and `UnpackIntegersFromPackedAttribute`, which operate on
+// the same attribute for a run of vertices. These dispatch on `type` once per
+// call, rather than once per vertex, so that the per-vertex work is a
+// fixed-width sequence of inlined bit operations, with no indirect calls or
+// temporary containers. Note that the loops over vertices are not vectorized,
+// since the packed side has a run-time stride.
+//
+// The unpacked (or quantized) side holds `ComponentCount(type)` values per
+// vertex, with the components of each vertex adjacent, and determines the
+// number of vertices. The packed side holds the packed value of the i-th
+// vertex starting at byte `i * packed_stride` of `packed_data`, which allows
+// reading and writing one attribute of interleaved vertex data in place.
+//
+// These have the same restrictions on `type`, the coding params, and the
+// values as the single-vertex functions. In addition, they DCHECK-fail if the
+// number of unpacked values is not a multiple of `ComponentCount(type)`, or if
+// `packed_data` is too small to hold all of the packed values.
+void PackAttributeValues(MeshFormat::AttributeType type,
+                         const MeshAttributeCodingParams& packing_params,
+                         absl::Span<const float> unpacked_values,
+                         size_t packed_stride,
+                         absl::Span<std::byte> packed_data);
+void PackQuantizedAttributeValues(MeshFormat::AttributeType type,
+                                  absl::Span<const uint32_t> quantized_values,
+                                  size_t packed_stride,
+                                  absl::Span<std::byte> packed_data);
+void UnpackAttributeValues(MeshFormat::AttributeType type,
+                           const MeshAttributeCodingParams& unpacking_params,
+                           absl::Span<const std::byte> packed_data,
+                           size_t packed_stride,
+                           absl::Span<float> unpacked_values);
+void UnpackIntegersFromPackedAttributeValues(
+    MeshFormat::AttributeType type, absl::Span<const std::byte> packed_data,
+    size_t packed_stride, absl::Span<uint32_t> quantized_values);
+
 // Reads/writes triangle indices from/to a vector of bytes. The following
 // conditions are expected to be enforced by the logic in `Mesh` and
 // `MutableMesh`, and are enforced via DCHECK:
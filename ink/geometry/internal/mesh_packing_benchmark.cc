@@ -0,0 +1,142 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "absl/log/absl_check.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "ink/geometry/internal/mesh_packing.h"
+#include "ink/geometry/mesh_format.h"
+#include "ink/geometry/mesh_packing_types.h"
+#include "ink/types/small_array.h"
+
+namespace ink::mesh_internal {
+namespace {
+
+using AttrType = MeshFormat::AttributeType;
+
+constexpr AttrType kAllAttributeTypes[] = {
+    AttrType::kFloat1Unpacked,
+    AttrType::kFloat1PackedInOneUnsignedByte,
+    AttrType::kFloat2Unpacked,
+    AttrType::kFloat2PackedInOneFloat,
+    AttrType::kFloat2PackedInThreeUnsignedBytes_XY12,
+    AttrType::kFloat2PackedInFourUnsignedBytes_X12_Y20,
+    AttrType::kFloat3Unpacked,
+    AttrType::kFloat3PackedInOneFloat,
+    AttrType::kFloat3PackedInTwoFloats,
+    AttrType::kFloat3PackedInFourUnsignedBytes_XYZ10,
+    AttrType::kFloat4Unpacked,
+    AttrType::kFloat4PackedInOneFloat,
+    AttrType::kFloat4PackedInTwoFloats,
+    AttrType::kFloat4PackedInThreeFloats,
+};
+constexpr int kNumAttributeTypes = std::size(kAllAttributeTypes);
+
+// The number of vertices packed or unpacked per iteration.
+constexpr int kVertexCount = 1000;
+
+// The vertex stride used for the packed data, as if the attribute were one of
+// several in the vertex.
+constexpr size_t kPackedVertexStride = 32;
+
+// Holds an attribute of type `kAllAttributeTypes[state.range(0)]` on
+// `kVertexCount` vertices, both unpacked and packed.
+struct BenchmarkData {
+  explicit BenchmarkData(benchmark::State& state)
+      : type(kAllAttributeTypes[state.range(0)]),
+        n_components(MeshFormat::ComponentCount(type)),
+        packed_size(MeshFormat::PackedAttributeSize(type)),
+        unpacked_values(kVertexCount * n_components),
+        packed_data(kVertexCount * kPackedVertexStride) {
+    state.SetLabel(absl::StrCat(type));
+    state.SetItemsProcessed(state.max_iterations * kVertexCount);
+    for (size_t i = 0; i < unpacked_values.size(); ++i) {
+      unpacked_values[i] = static_cast<float>((i * 37) % 101);
+    }
+    absl::StatusOr<MeshAttributeCodingParams> params = ComputeCodingParams(
+        type, {.minimum = SmallArray<float, 4>(n_components, 0),
+               .maximum = SmallArray<float, 4>(n_components, 100)});
+    ABSL_CHECK_OK(params);
+    coding_params = *params;
+    PackAttributeValues(type, coding_params, unpacked_values,
+                        kPackedVertexStride, absl::MakeSpan(packed_data));
+  }
+
+  AttrType type;
+  int n_components;
+  size_t packed_size;
+  MeshAttributeCodingParams coding_params;
+  std::vector<float> unpacked_values;
+  std::vector<std::byte> packed_data;
+};
+
+void BM_PackAttribute(benchmark::State& state) {
+  BenchmarkData data(state);
+  for (auto s : state) {
+    for (int i = 0; i < kVertexCount; ++i) {
+      PackAttribute(data.type, data.coding_params,
+                    SmallArray<float, 4>(absl::MakeConstSpan(
+                        &data.unpacked_values[i * data.n_components],
+                        data.n_components)),
+                    absl::MakeSpan(&data.packed_data[i * kPackedVertexStride],
+                                   data.packed_size));
+    }
+    benchmark::DoNotOptimize(data.packed_data);
+  }
+}
+BENCHMARK(BM_PackAttribute)->DenseRange(0, kNumAttributeTypes - 1);
+
+void BM_PackAttributeValues(benchmark::State& state) {
+  BenchmarkData data(state);
+  for (auto s : state) {
+    PackAttributeValues(data.type, data.coding_params, data.unpacked_values,
+                        kPackedVertexStride, absl::MakeSpan(data.packed_data));
+    benchmark::DoNotOptimize(data.packed_data);
+  }
+}
+BENCHMARK(BM_PackAttributeValues)->DenseRange(0, kNumAttributeTypes - 1);
+
+void BM_UnpackAttribute(benchmark::State& state) {
+  BenchmarkData data(state);
+  for (auto s : state) {
+    for (int i = 0; i < kVertexCount; ++i) {
+      SmallArray<float, 4> value = UnpackAttribute(
+          data.type, data.coding_params,
+          absl::MakeConstSpan(&data.packed_data[i * kPackedVertexStride],
+                              data.packed_size));
+      benchmark::DoNotOptimize(value);
+    }
+  }
+}
+BENCHMARK(BM_UnpackAttribute)->DenseRange(0, kNumAttributeTypes - 1);
+
+void BM_UnpackAttributeValues(benchmark::State& state) {
+  BenchmarkData data(state);
+  for (auto s : state) {
+    UnpackAttributeValues(data.type, data.coding_params, data.packed_data,
+                          kPackedVertexStride,
+                          absl::MakeSpan(data.unpacked_values));
+    benchmark::DoNotOptimize(data.unpacked_values);
+  }
+}
+BENCHMARK(BM_UnpackAttributeValues)->DenseRange(0, kNumAttributeTypes - 1);
+
+}  // namespace
+}  // namespace ink::mesh_internal
@@ -29,6 +29,7 @@
 #include "absl/log/absl_check.h"
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
+#include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 #include "ink/geometry/mesh_format.h"
 #include "ink/geometry/mesh_packing_types.h"
@@ -1717,6 +1718,144 @@ TEST(MeshPackingTest, ReadUnpackedFloatAttributeFromByteArrayCustomFormat) {
       ElementsAre(0.5, 0.5, 0.5, 0.5));
 }
 
+constexpr AttrType kAllAttributeTypes[] = {
+    AttrType::kFloat1Unpacked,
+    AttrType::kFloat1PackedInOneUnsignedByte,
+    AttrType::kFloat2Unpacked,
+    AttrType::kFloat2PackedInOneFloat,
+    AttrType::kFloat2PackedInThreeUnsignedBytes_XY12,
+    AttrType::kFloat2PackedInFourUnsignedBytes_X12_Y20,
+    AttrType::kFloat3Unpacked,
+    AttrType::kFloat3PackedInOneFloat,
+    AttrType::kFloat3PackedInTwoFloats,
+    AttrType::kFloat3PackedInFourUnsignedBytes_XYZ10,
+    AttrType::kFloat4Unpacked,
+    AttrType::kFloat4PackedInOneFloat,
+    AttrType::kFloat4PackedInTwoFloats,
+    AttrType::kFloat4PackedInThreeFloats,
+};
+
+// Returns `n_values` values of an attribute of type `type`, with the
+// components of each value adjacent, spread over the interval [-3, 4].
+std::vector<float> MakeBulkTestValues(AttrType type, int n_values) {
+  int n_components = MeshFormat::ComponentCount(type);
+  std::vector<float> values(n_values * n_components);
+  for (size_t i = 0; i < values.size(); ++i) {
+    values[i] = -3 + 7 * static_cast<float>((i * 37) % 101) / 100;
+  }
+  return values;
+}
+
+MeshAttributeCodingParams MakeBulkTestCodingParams(AttrType type) {
+  int n_components = MeshFormat::ComponentCount(type);
+  absl::StatusOr<MeshAttributeCodingParams> params = ComputeCodingParams(
+      type, {.minimum = SmallArray<float, 4>(n_components, -3),
+             .maximum = SmallArray<float, 4>(n_components, 4)});
+  ABSL_CHECK_OK(params);
+  return *params;
+}
+
+// The bulk functions are tested with a stride larger than the packed size of
+// the attribute, to check that they leave the bytes in between alone.
+constexpr int kBulkTestPadding = 3;
+constexpr int kBulkTestValueCount = 50;
+
+TEST(MeshPackingTest, PackAttributeValuesMatchesPackAttribute) {
+  for (AttrType type : kAllAttributeTypes) {
+    SCOPED_TRACE(absl::StrCat(type));
+    int n_components = MeshFormat::ComponentCount(type);
+    size_t packed_size = MeshFormat::PackedAttributeSize(type);
+    size_t stride = packed_size + kBulkTestPadding;
+    MeshAttributeCodingParams params = MakeBulkTestCodingParams(type);
+    std::vector<float> values = MakeBulkTestValues(type, kBulkTestValueCount);
+
+    std::vector<std::byte> expected(kBulkTestValueCount * stride);
+    for (int i = 0; i < kBulkTestValueCount; ++i) {
+      PackAttribute(
+          type, params,
+          SmallArray<float, 4>(
+              absl::MakeConstSpan(values).subspan(i * n_components,
+                                                  n_components)),
+          absl::MakeSpan(expected).subspan(i * stride, packed_size));
+    }
+    std::vector<std::byte> packed(kBulkTestValueCount * stride);
+    PackAttributeValues(type, params, values, stride, absl::MakeSpan(packed));
+
+    EXPECT_EQ(packed, expected);
+  }
+}
+
+TEST(MeshPackingTest, UnpackAttributeValuesMatchesUnpackAttribute) {
+  for (AttrType type : kAllAttributeTypes) {
+    SCOPED_TRACE(absl::StrCat(type));
+    int n_components = MeshFormat::ComponentCount(type);
+    size_t packed_size = MeshFormat::PackedAttributeSize(type);
+    size_t stride = packed_size + kBulkTestPadding;
+    MeshAttributeCodingParams params = MakeBulkTestCodingParams(type);
+    std::vector<std::byte> packed(kBulkTestValueCount * stride);
+    PackAttributeValues(type, params,
+                        MakeBulkTestValues(type, kBulkTestValueCount), stride,
+                        absl::MakeSpan(packed));
+
+    std::vector<float> expected;
+    for (int i = 0; i < kBulkTestValueCount; ++i) {
+      SmallArray<float, 4> value = UnpackAttribute(
+          type, params,
+          absl::MakeConstSpan(packed).subspan(i * stride, packed_size));
+      expected.insert(expected.end(), value.Values().begin(),
+                      value.Values().end());
+    }
+    std::vector<float> unpacked(kBulkTestValueCount * n_components);
+    UnpackAttributeValues(type, params, packed, stride,
+                          absl::MakeSpan(unpacked));
+
+    EXPECT_THAT(unpacked, ElementsAreArray(expected));
+  }
+}
+
+TEST(MeshPackingTest, PackedIntegerValuesRoundTrip) {
+  for (AttrType type : kAllAttributeTypes) {
+    if (MeshFormat::IsUnpackedType(type)) continue;
+    SCOPED_TRACE(absl::StrCat(type));
+    int n_components = MeshFormat::ComponentCount(type);
+    size_t packed_size = MeshFormat::PackedAttributeSize(type);
+    size_t stride = packed_size + kBulkTestPadding;
+    std::vector<std::byte> packed(kBulkTestValueCount * stride);
+    PackAttributeValues(type, MakeBulkTestCodingParams(type),
+                        MakeBulkTestValues(type, kBulkTestValueCount), stride,
+                        absl::MakeSpan(packed));
+
+    std::vector<uint32_t> expected;
+    for (int i = 0; i < kBulkTestValueCount; ++i) {
+      SmallArray<uint32_t, 4> value = UnpackIntegersFromPackedAttribute(
+          type, absl::MakeConstSpan(packed).subspan(i * stride, packed_size));
+      expected.insert(expected.end(), value.Values().begin(),
+                      value.Values().end());
+    }
+    std::vector<uint32_t> quantized(kBulkTestValueCount * n_components);
+    UnpackIntegersFromPackedAttributeValues(type, packed, stride,
+                                            absl::MakeSpan(quantized));
+    EXPECT_THAT(quantized, ElementsAreArray(expected));
+
+    std::vector<std::byte> repacked(kBulkTestValueCount * stride);
+    PackQuantizedAttributeValues(type, quantized, stride,
+                                 absl::MakeSpan(repacked));
+    EXPECT_EQ(repacked, packed);
+  }
+}
+
+TEST(MeshPackingTest, BulkPackingWithNoValues) {
+  for (AttrType type : kAllAttributeTypes) {
+    SCOPED_TRACE(absl::StrCat(type));
+    MeshAttributeCodingParams params = MakeBulkTestCodingParams(type);
+    PackAttributeValues(type, params, {}, 0, {});
+    UnpackAttributeValues(type, params, {}, 0, {});
+    if (MeshFormat::IsUnpackedType(type)) continue;
+    PackQuantizedAttributeValues(type, {}, 0, {});
+    UnpackIntegersFromPackedAttributeValues(type, {}, 0, {});
+  }
+}
+
 TEST(MeshPackingTest, PartitionTrianglesOnePartition) {
   std::vector<std::byte> triangle_bytes = AsByteVector<uint32_t>({0, 1, 2,  //
                                                                   3, 4, 5,  //
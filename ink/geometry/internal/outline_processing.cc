@@ -21,6 +21,7 @@
 #include <cstdlib>
 #include <functional>
 #include <limits>
+#include <memory>
 #include <numeric>
 #include <optional>
 #include <queue>
@@ -31,9 +32,11 @@
 #include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/inlined_vector.h"
+#include "absl/functional/function_ref.h"
 #include "absl/log/absl_check.h"
 #include "absl/types/span.h"
 #include "ink/geometry/envelope.h"
+#include "ink/geometry/internal/flat_static_rtree.h"
 #include "ink/geometry/internal/intersects_internal.h"
 #include "ink/geometry/point.h"
 #include "ink/geometry/rect.h"
@@ -603,29 +606,67 @@ uint32_t GetStartIndex(absl::Span<const Point> verts, Point p) {
   return i > 0 ? i - 1 : 0;
 }
 
-// Finds all boundary intersections between the shapes. The result is returned
-// as a pair of vectors, one for each shape, where each vector contains the
-// intersections on each chain in order.
-std::pair<absl::InlinedVector<absl::InlinedVector<ChainIntersection, 2>, 8>,
-          absl::InlinedVector<absl::InlinedVector<ChainIntersection, 2>, 8>>
-FindBoundaryIntersections(const ShapeOutline& shape_a,
-                          const ShapeOutline& shape_b) {
+// The boundary intersections between two shapes, as computed by
+// `FindBoundaryIntersections`.
+struct BoundaryIntersections {
+  // The intersections on each chain of shape_a, in order.
+  absl::InlinedVector<absl::InlinedVector<ChainIntersection, 2>, 8> on_a;
+
+  // The indices of the chains of shape_b whose bounds intersect the bounds of
+  // shape_a, in increasing order. The other chains of shape_b neither
+  // intersect shape_a nor lie inside it, so they can be ignored.
+  absl::InlinedVector<uint32_t, 8> b_indices;
+
+  // The intersections on each chain of shape_b listed in `b_indices`, in
+  // order.
+  absl::InlinedVector<absl::InlinedVector<ChainIntersection, 2>, 8> on_b;
+};
+
+// Finds all boundary intersections between the shapes.
+BoundaryIntersections FindBoundaryIntersections(const ShapeOutline& shape_a,
+                                                const ShapeOutline& shape_b) {
   absl::Span<const MonotoneChain> chains_a = shape_a.Chains();
   absl::Span<const MonotoneChain> chains_b = shape_b.Chains();
 
-  absl::InlinedVector<absl::InlinedVector<ChainIntersection, 2>, 8>
-      intersections_a(chains_a.size());
-  absl::InlinedVector<absl::InlinedVector<ChainIntersection, 2>, 8>
-      intersections_b(chains_b.size());
+  Envelope bounds_a;
+  for (const MonotoneChain& chain_a : chains_a) bounds_a.Add(chain_a.Bounds());
+
+  BoundaryIntersections result;
+  if (bounds_a.IsEmpty()) return result;
+  shape_b.VisitChainsWithIntersectedBounds(
+      *bounds_a.AsRect(), [&result](uint32_t b_idx) {
+        result.b_indices.push_back(b_idx);
+        return true;
+      });
+  absl::c_sort(result.b_indices);
 
+  auto& intersections_a = result.on_a;
+  auto& intersections_b = result.on_b;
+  intersections_a.resize(chains_a.size());
+  intersections_b.resize(result.b_indices.size());
+
+  absl::InlinedVector<uint32_t, 8> candidates_b;
   for (uint32_t a_idx = 0; a_idx < chains_a.size(); ++a_idx) {
     const MonotoneChain& chain_a = chains_a[a_idx];
     absl::Span<const Point> verts_a = chain_a.Vertices();
-    for (uint32_t b_idx = 0; b_idx < chains_b.size(); ++b_idx) {
-      const MonotoneChain& chain_b = chains_b[b_idx];
 
-      if (!IntersectsInternal(chain_a.Bounds(), chain_b.Bounds())) continue;
+    // Only the chains of shape_b whose bounds overlap chain_a can intersect
+    // it. We test them in order, so that the result is the same whether or not
+    // shape_b has an index.
+    candidates_b.clear();
+    shape_b.VisitChainsWithIntersectedBounds(
+        chain_a.Bounds(), [&candidates_b](uint32_t b_idx) {
+          candidates_b.push_back(b_idx);
+          return true;
+        });
+    absl::c_sort(candidates_b);
 
+    for (uint32_t b_idx : candidates_b) {
+      const MonotoneChain& chain_b = chains_b[b_idx];
+      // The position of chain_b in `result.b_indices`, which must contain it
+      // since the bounds of chain_a are inside the bounds of shape_a.
+      uint32_t b_pos = absl::c_lower_bound(result.b_indices, b_idx) -
+                       result.b_indices.begin();
       absl::Span<const Point> verts_b = chain_b.Vertices();
 
       // We sweep across the plane to find intersections between the two
@@ -660,7 +701,7 @@ FindBoundaryIntersections(const ShapeOutline& shape_a,
               int sign =
                   -chain_a.Orientation() * chain_b.Orientation() * uv_sign;
               intersections_a[a_idx].push_back({p, i, sign});
-              intersections_b[b_idx].push_back({p, j, -sign});
+              intersections_b[b_pos].push_back({p, j, -sign});
             } else if (s > 0.0 && s < 1.0) {
               // A vertex on chain_a lies on the current segment of chain_b.
               uint32_t vert_i = (t == 1.0) ? i + 1 : i;
@@ -670,7 +711,7 @@ FindBoundaryIntersections(const ShapeOutline& shape_a,
                          VertexEdgeIntersectionSign(u_in, p, u_out, verts_b[j],
                                                     verts_b[j + 1]);
               intersections_a[a_idx].push_back({p, vert_i, sign});
-              intersections_b[b_idx].push_back({p, j, -sign});
+              intersections_b[b_pos].push_back({p, j, -sign});
             } else if (t > 0.0 && t < 1.0) {
               // A vertex on chain_b lies on the current segment of chain_a.
               uint32_t vert_j = (s == 1.0) ? j + 1 : j;
@@ -680,7 +721,7 @@ FindBoundaryIntersections(const ShapeOutline& shape_a,
                          VertexEdgeIntersectionSign(v_in, p, v_out, verts_a[i],
                                                     verts_a[i + 1]);
               intersections_a[a_idx].push_back({p, i, sign});
-              intersections_b[b_idx].push_back({p, vert_j, -sign});
+              intersections_b[b_pos].push_back({p, vert_j, -sign});
             } else {
               // A vertex on chain_a overlaps a vertex on chain_b.
               uint32_t vert_i = (t == 1.0) ? i + 1 : i;
@@ -691,7 +732,7 @@ FindBoundaryIntersections(const ShapeOutline& shape_a,
               int sign =
                   -VertexVertexIntersectionSign(u_in, p, u_out, v_in, v_out);
               intersections_a[a_idx].push_back({p, vert_i, sign});
-              intersections_b[b_idx].push_back({p, vert_j, -sign});
+              intersections_b[b_pos].push_back({p, vert_j, -sign});
             }
           }
         }
@@ -722,7 +763,7 @@ FindBoundaryIntersections(const ShapeOutline& shape_a,
   for (auto& chain_ints : intersections_a) dedup(chain_ints);
   for (auto& chain_ints : intersections_b) dedup(chain_ints);
 
-  return {intersections_a, intersections_b};
+  return result;
 }
 
 // Helper function to slice the given chain at the given intersection points and
@@ -873,14 +914,15 @@ std::vector<MonotoneChain> StitchIntersectionChains(
 // monotone chains that form the boundary of the difference of the two shapes.
 std::vector<MonotoneChain> SubdivideIntersectionChains(
     const ShapeOutline& shape_a, const ShapeOutline& shape_b,
-    absl::InlinedVector<absl::InlinedVector<ChainIntersection, 2>, 8>& intx_a,
-    absl::InlinedVector<absl::InlinedVector<ChainIntersection, 2>, 8>& intx_b) {
+    BoundaryIntersections& intersections) {
   std::vector<MonotoneChain> raw_chains;
   for (uint32_t i = 0; i < shape_a.Chains().size(); ++i) {
-    SliceChain(shape_a.Chains()[i], intx_a[i], false, shape_b, raw_chains);
+    SliceChain(shape_a.Chains()[i], intersections.on_a[i], false, shape_b,
+               raw_chains);
   }
-  for (uint32_t j = 0; j < shape_b.Chains().size(); ++j) {
-    SliceChain(shape_b.Chains()[j], intx_b[j], true, shape_a, raw_chains);
+  for (uint32_t k = 0; k < intersections.b_indices.size(); ++k) {
+    SliceChain(shape_b.Chains()[intersections.b_indices[k]],
+               intersections.on_b[k], true, shape_a, raw_chains);
   }
 
   return raw_chains;
@@ -924,6 +966,51 @@ std::vector<MonotoneChain> ComputeChains(const Triangle& triangle) {
   return {{{a, b}, 1}, {{a, c, b}, -1}};
 }
 
+// Returns true if `chain` intersects `rect`, whose bounds must intersect the
+// bounds of the chain.
+bool ChainIntersectsRect(const MonotoneChain& chain, const Rect& rect) {
+  absl::Span<const Point> pts = chain.Vertices();
+
+  // To determine if the chain intersects the rect, we find the portion of the
+  // chain with x-coordinates in the range [rect.XMin(), rect.XMax()]. For
+  // vertices in this range, we can check for intersection easily -- there is
+  // no intersection if and only if all vertices are either strictly below
+  // rect.YMin() or strictly above rect.YMax(). Then we also check the
+  // incoming and leaving segments (crossing XMin and XMax) with a standard
+  // segment-box intersection check.
+
+  // Look for the first point with x-coordinate greater than or equal to
+  // rect.XMin().
+  auto left_it = std::lower_bound(pts.begin(), pts.end(), Point{rect.XMin(), 0},
+                                  [](Point a, Point b) { return a.x < b.x; });
+
+  // Iterate through all points with x-coordinates in the range
+  // [rect.XMin(), rect.XMax()].
+  bool above = false, below = false;
+  auto it = left_it;
+  for (; it != pts.end(); ++it) {
+    if (it->x > rect.XMax()) break;
+    if (it->y > rect.YMax())
+      above = true;
+    else if (it->y < rect.YMin())
+      below = true;
+    else
+      return true;
+    if (above && below) return true;
+  }
+
+  // First point to the right of the rect.
+  auto right_it = it;
+
+  // Lastly, check the incoming and leaving segments.
+  if (left_it != pts.begin() &&
+      IntersectsInternal(rect, Segment{*(left_it - 1), *left_it})) {
+    return true;
+  }
+  return right_it != pts.end() && right_it != left_it &&
+         IntersectsInternal(rect, Segment{*(right_it - 1), *right_it});
+}
+
 }  // namespace
 
 MonotoneChain::MonotoneChain(std::vector<Point> vertices, int orientation)
@@ -963,6 +1050,30 @@ ShapeOutline::ShapeOutline(std::vector<MonotoneChain> input_chains)
                       b.Bounds().XMax(), b.Orientation());
   });
   std::tie(prev_index_, next_index_) = GetAdjacentChains(chains_);
+  if (chains_.size() > kMinChainsForIndex) {
+    chain_index_ = std::make_shared<const FlatStaticRTree<uint32_t>>(
+        chains_.size(),
+        [chain_idx = uint32_t{0}]() mutable { return chain_idx++; },
+        [this](uint32_t chain_idx) { return chains_[chain_idx].Bounds(); });
+  }
+}
+
+void ShapeOutline::VisitChainsWithIntersectedBounds(
+    const Rect& bounds, absl::FunctionRef<bool(uint32_t)> visitor) const {
+  if (chain_index_ != nullptr) {
+    chain_index_->VisitIntersectedElements(
+        bounds, [&visitor](uint32_t chain_idx) { return visitor(chain_idx); });
+    return;
+  }
+  for (uint32_t chain_idx = 0; chain_idx < chains_.size(); ++chain_idx) {
+    const Rect& chain_bounds = chains_[chain_idx].Bounds();
+    // Since the chains are sorted, if the bounds are below the lower bound of
+    // this chain, we can safely skip the rest.
+    if (bounds.YMax() < chain_bounds.YMin()) break;
+    if (IntersectsInternal(chain_bounds, bounds) && !visitor(chain_idx)) {
+      return;
+    }
+  }
 }
 
 ShapeOutline::ShapeOutline(const std::vector<std::vector<Point>>& loops)
@@ -1048,56 +1159,14 @@ bool Intersects(const ShapeOutline& shape, const Rect& rect) {
 
   // Check if the boundary of shape intersects the boundary of rect, or is
   // contained in rect.
-  for (const MonotoneChain& chain : shape.Chains()) {
-    // Since the chains in the shape are sorted, if the point is below the
-    // lower bound of this chain, we can safely skip the rest.
-    if (rect.YMax() < chain.Bounds().YMin()) break;
-    if (!IntersectsInternal(chain.Bounds(), rect)) continue;
-
-    absl::Span<const Point> pts = chain.Vertices();
-
-    // To determine if the chain intersects the rect, we find the portion of the
-    // chain with x-coordinates in the range [rect.XMin(), rect.XMax()]. For
-    // vertices in this range, we can check for intersection easily -- there is
-    // no intersection if and only if all vertices are either strictly below
-    // rect.YMin() or strictly above rect.YMax(). Then we also check the
-    // incoming and leaving segments (crossing XMin and XMax) with a standard
-    // segment-box intersection check.
-
-    // Look for the first point with x-coordinate greater than or equal to
-    // rect.XMin().
-    auto left_it =
-        std::lower_bound(pts.begin(), pts.end(), Point{rect.XMin(), 0},
-                         [](Point a, Point b) { return a.x < b.x; });
-
-    // Iterate through all points with x-coordinates in the range
-    // [rect.XMin(), rect.XMax()].
-    bool above = false, below = false;
-    auto it = left_it;
-    for (; it != pts.end(); ++it) {
-      if (it->x > rect.XMax()) break;
-      if (it->y > rect.YMax())
-        above = true;
-      else if (it->y < rect.YMin())
-        below = true;
-      else
-        return true;
-      if (above && below) return true;
-    }
-
-    // First point to the right of the rect.
-    auto right_it = it;
-
-    // Lastly, check the incoming and leaving segments.
-    if (left_it != pts.begin() &&
-        IntersectsInternal(rect, Segment{*(left_it - 1), *left_it})) {
-      return true;
-    }
-    if (right_it != pts.end() && right_it != left_it &&
-        IntersectsInternal(rect, Segment{*(right_it - 1), *right_it})) {
-      return true;
-    }
-  }
+  bool boundary_intersects = false;
+  shape.VisitChainsWithIntersectedBounds(
+      rect, [&shape, &rect, &boundary_intersects](uint32_t chain_idx) {
+        boundary_intersects =
+            ChainIntersectsRect(shape.Chains()[chain_idx], rect);
+        return !boundary_intersects;
+      });
+  if (boundary_intersects) return true;
 
   // If no intersections, check if rect is contained in shape.
   return Intersects(shape, rect.Center());
@@ -1211,9 +1280,10 @@ ShapeOutline ComputeSubtraction(const ShapeOutline& shape_a,
   // that lie on the boundary of (shape_a - shape_b). Finally, we stitch the
   // fragments back together to form the chains of the final result.
 
-  auto [intx_a, intx_b] = FindBoundaryIntersections(shape_a, shape_b);
+  BoundaryIntersections intersections =
+      FindBoundaryIntersections(shape_a, shape_b);
   std::vector<MonotoneChain> raw_chains =
-      SubdivideIntersectionChains(shape_a, shape_b, intx_a, intx_b);
+      SubdivideIntersectionChains(shape_a, shape_b, intersections);
   return ShapeOutline(StitchIntersectionChains(std::move(raw_chains)));
 }
 
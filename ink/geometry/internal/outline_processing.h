@@ -16,9 +16,12 @@
 #define INK_GEOMETRY_INTERNAL_OUTLINE_PROCESSING_H_
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
+#include "absl/functional/function_ref.h"
 #include "absl/types/span.h"
+#include "ink/geometry/internal/flat_static_rtree.h"
 #include "ink/geometry/point.h"
 #include "ink/geometry/rect.h"
 #include "ink/geometry/triangle.h"
@@ -114,7 +117,25 @@ class ShapeOutline {
     return next_index_[chain_idx];
   }
 
-  bool operator==(const ShapeOutline& other) const = default;
+  // Calls `visitor` with the index of each chain whose bounds intersect
+  // `bounds`, until it returns false. The visitation order should be assumed
+  // to be arbitrary.
+  //
+  // Shapes with more than `kMinChainsForIndex` chains keep an R-Tree over the
+  // chain bounds, so this only touches the chains near `bounds`; smaller
+  // shapes scan the chains in order.
+  void VisitChainsWithIntersectedBounds(
+      const Rect& bounds, absl::FunctionRef<bool(uint32_t)> visitor) const;
+
+  bool operator==(const ShapeOutline& other) const {
+    return chains_ == other.chains_ && prev_index_ == other.prev_index_ &&
+           next_index_ == other.next_index_;
+  }
+
+  // The number of chains above which a shape builds an index over its chains.
+  // Below this, scanning the (sorted) chains is about as fast as querying the
+  // index, and many of the shapes made during subtraction are this small.
+  static constexpr uint32_t kMinChainsForIndex = 64;
 
  private:
   // The list of chains, ordered by their lower y-bounds.
@@ -124,6 +145,12 @@ class ShapeOutline {
   // walk along the boundary.
   std::vector<uint32_t> prev_index_;
   std::vector<uint32_t> next_index_;
+
+  // An R-Tree of the indices of `chains_`, keyed on their bounds, or null if
+  // there are no more than `kMinChainsForIndex` chains. This is built eagerly
+  // and never modified, so that a `ShapeOutline` can be queried from several
+  // threads at once, and copies of it can share the index.
+  std::shared_ptr<const FlatStaticRTree<uint32_t>> chain_index_;
 };
 
 // Intersection of a shape with a point.
@@ -0,0 +1,332 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "absl/log/absl_log.h"
+#include "ink/geometry/angle.h"
+#include "ink/geometry/envelope.h"
+#include "ink/geometry/internal/outline_processing.h"
+#include "ink/geometry/point.h"
+#include "ink/geometry/rect.h"
+#include "ink/geometry/triangle.h"
+#include "ink/geometry/vec.h"
+
+namespace {
+
+// The number of heap allocations made so far by this binary. This is updated
+// by the replacement `operator new` below, so that the benchmarks can report
+// how many allocations each operation makes; the outline algorithms build many
+// small vectors, and an extra one per chain or per vertex shows up here before
+// it shows up in the timings.
+std::atomic<int64_t> allocation_count = 0;
+
+}  // namespace
+
+// Only the scalar forms of `operator new` and `operator delete` are replaced.
+// The default array and `std::nothrow_t` forms call these, so their allocations
+// are counted too, but the `std::align_val_t` forms for over-aligned types are
+// not counted. None of the benchmarked code allocates over-aligned types.
+void* operator new(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  // `malloc(0)` may return null, which `operator new` must not.
+  if (void* ptr = std::malloc(size == 0 ? 1 : size)) return ptr;
+  // This can't throw `std::bad_alloc`, since exceptions may be disabled.
+  ABSL_LOG(FATAL) << "Failed to allocate " << size << " bytes";
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+namespace ink::geometry_internal {
+namespace {
+
+using ::benchmark::internal::Benchmark;
+
+int64_t AllocationCount() {
+  return allocation_count.load(std::memory_order_relaxed);
+}
+
+// Reports the average number of allocations per iteration of the benchmark,
+// given the `AllocationCount()` from before the benchmark loop started.
+void ReportAllocations(benchmark::State& state, int64_t count_before_loop) {
+  state.counters["allocs"] =
+      benchmark::Counter(AllocationCount() - count_before_loop,
+                         benchmark::Counter::kAvgIterations);
+}
+
+// The horizontal extent of the scribble.
+constexpr float kScribbleWidth = 100;
+
+// Returns the outline of a scribbled eraser stroke that sweeps back and forth
+// horizontally `n_sweeps` times: a comb with `n_sweeps` teeth that are
+// `kScribbleWidth` long and 0.5 units tall, spaced 1 unit apart, and joined
+// along the left side. Each tooth adds two monotone chains, so this is about
+// as complex as an eraser outline gets, per vertex.
+std::vector<std::vector<Point>> MakeScribbleLoops(int n_sweeps) {
+  std::vector<Point> loop;
+  loop.reserve(4 * n_sweeps + 2);
+  for (int i = 0; i < n_sweeps; ++i) {
+    float y = i;
+    loop.push_back({i == 0 ? 0 : 1, y});
+    loop.push_back({kScribbleWidth, y});
+    loop.push_back({kScribbleWidth, y + 0.5f});
+    if (i + 1 < n_sweeps) loop.push_back({1, y + 0.5f});
+  }
+  loop.push_back({0, n_sweeps - 0.5f});
+  return {loop};
+}
+
+// Returns `n` small triangles along the diagonal of the scribble's bounds, as
+// for a stroke drawn across it.
+std::vector<Triangle> MakeTrianglesAcrossScribble(int n_sweeps, int n) {
+  std::vector<Triangle> triangles;
+  triangles.reserve(n);
+  for (int i = 0; i < n; ++i) {
+    float t = (i + 0.5f) / n;
+    Point p = {-10 + t * (kScribbleWidth + 20), -10 + t * (n_sweeps + 20)};
+    triangles.push_back({p, p + Vec{1, 0.25f}, p + Vec{0.25f, 1}});
+  }
+  return triangles;
+}
+
+// Returns `n` random points in the scribble's bounds.
+std::vector<Point> MakeQueryPoints(int n_sweeps, int n) {
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> x(0, kScribbleWidth);
+  std::uniform_real_distribution<float> y(0, n_sweeps);
+  std::vector<Point> points;
+  points.reserve(n);
+  for (int i = 0; i < n; ++i) points.push_back({x(rng), y(rng)});
+  return points;
+}
+
+void BM_ConstructScribble(benchmark::State& state) {
+  std::vector<std::vector<Point>> loops = MakeScribbleLoops(state.range(0));
+  for (auto s : state) {
+    benchmark::DoNotOptimize(ShapeOutline(loops));
+  }
+}
+BENCHMARK(BM_ConstructScribble)->RangeMultiplier(4)->Range(4, 1024);
+
+void BM_IntersectsPointWithScribble(benchmark::State& state) {
+  ShapeOutline scribble(MakeScribbleLoops(state.range(0)));
+  std::vector<Point> points = MakeQueryPoints(state.range(0), 1024);
+  size_t i = 0;
+  for (auto s : state) {
+    benchmark::DoNotOptimize(
+        Intersects(scribble, points[i++ % points.size()]));
+  }
+}
+BENCHMARK(BM_IntersectsPointWithScribble)->RangeMultiplier(4)->Range(4, 1024);
+
+// Tests the bounds of small triangles against the scribble, as is done for
+// each triangle of a stroke before subtracting the scribble from it.
+void BM_IntersectsRectWithScribble(benchmark::State& state) {
+  ShapeOutline scribble(MakeScribbleLoops(state.range(0)));
+  std::vector<Point> points = MakeQueryPoints(state.range(0), 1024);
+  size_t i = 0;
+  for (auto s : state) {
+    benchmark::DoNotOptimize(Intersects(
+        scribble,
+        Rect::FromCenterAndDimensions(points[i++ % points.size()], 1, 1)));
+  }
+}
+BENCHMARK(BM_IntersectsRectWithScribble)->RangeMultiplier(4)->Range(4, 1024);
+
+// Subtracts the scribble from 256 small triangles that cross it, skipping
+// those whose bounds don't intersect it, as `SubtractMeshes` does.
+void BM_SubtractScribbleFromTriangles(benchmark::State& state) {
+  ShapeOutline scribble(MakeScribbleLoops(state.range(0)));
+  std::vector<Triangle> triangles =
+      MakeTrianglesAcrossScribble(state.range(0), 256);
+  for (auto s : state) {
+    for (const Triangle& triangle : triangles) {
+      if (!Intersects(scribble, Envelope(triangle).AsRect().value())) {
+        continue;
+      }
+      benchmark::DoNotOptimize(
+          ComputeSubtraction(ShapeOutline(triangle), scribble));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * triangles.size());
+}
+BENCHMARK(BM_SubtractScribbleFromTriangles)
+    ->RangeMultiplier(4)
+    ->Range(4, 1024);
+
+// The shapes used to measure how the outline algorithms scale with vertex
+// count, from simple to pathological.
+enum class ShapeKind {
+  // A regular polygon, which has just two monotone chains.
+  kConvex,
+  // A star, whose points alternate between two radii, so that it has a
+  // monotone chain for about every other vertex.
+  kStar,
+  // The scribble from `MakeScribbleLoops`, which has about one monotone chain
+  // per two vertices, all of them long and stacked on top of each other.
+  kScribble,
+  // A regular polygon with a vertex added near the middle of each edge, just
+  // off of it, so that every three consecutive vertices are nearly collinear.
+  kNearDegenerate,
+};
+
+constexpr ShapeKind kAllShapeKinds[] = {ShapeKind::kConvex, ShapeKind::kStar,
+                                        ShapeKind::kScribble,
+                                        ShapeKind::kNearDegenerate};
+
+const char* ShapeKindName(ShapeKind kind) {
+  switch (kind) {
+    case ShapeKind::kConvex:
+      return "convex";
+    case ShapeKind::kStar:
+      return "star";
+    case ShapeKind::kScribble:
+      return "scribble";
+    case ShapeKind::kNearDegenerate:
+      return "near-degenerate";
+  }
+  ABSL_LOG(FATAL) << "Invalid `ShapeKind` value: " << static_cast<int>(kind);
+}
+
+// Returns the counter-clockwise loop of a shape of the given kind with about
+// `n_vertices` vertices, which fits in the rect from (-50, -50) to (50, 50),
+// except for the scribble, which is `kScribbleWidth` wide.
+std::vector<std::vector<Point>> MakeShapeLoops(ShapeKind kind,
+                                               int n_vertices) {
+  if (kind == ShapeKind::kScribble) {
+    return MakeScribbleLoops(n_vertices / 4);
+  }
+  std::vector<Point> loop;
+  loop.reserve(n_vertices);
+  for (int i = 0; i < n_vertices; ++i) {
+    Angle theta = kFullTurn * i / n_vertices;
+    float radius = 50;
+    if (kind == ShapeKind::kStar && i % 2 == 1) {
+      radius = 25;
+    } else if (kind == ShapeKind::kNearDegenerate && i % 2 == 1) {
+      // The distance from the center to the middle of the edge between the
+      // neighboring vertices, plus or minus a tiny offset.
+      radius = 50 * Cos(kFullTurn / n_vertices) + (i % 4 == 1 ? 1e-4 : -1e-4);
+    }
+    loop.push_back({radius * Cos(theta), radius * Sin(theta)});
+  }
+  return {loop};
+}
+
+// Returns `loops` rotated by `angle` about the origin and then translated by
+// `offset`.
+std::vector<std::vector<Point>> Move(std::vector<std::vector<Point>> loops,
+                                     Angle angle, Vec offset) {
+  for (std::vector<Point>& loop : loops) {
+    for (Point& p : loop) {
+      p = Point{p.x * Cos(angle) - p.y * Sin(angle),
+                p.x * Sin(angle) + p.y * Cos(angle)} +
+          offset;
+    }
+  }
+  return loops;
+}
+
+// Adds the arguments for each `ShapeKind` with from 16 to `max_vertices`
+// vertices.
+void ShapeKindsByVertexCount(Benchmark* b, int max_vertices) {
+  for (ShapeKind kind : kAllShapeKinds) {
+    for (int n_vertices = 16; n_vertices <= max_vertices; n_vertices *= 4) {
+      b->Args({static_cast<int>(kind), n_vertices});
+    }
+  }
+}
+
+// Takes the `ShapeKind` and the number of vertices.
+void BM_ComputeBoundaryLoops(benchmark::State& state) {
+  ShapeKind kind = static_cast<ShapeKind>(state.range(0));
+  ShapeOutline shape(MakeShapeLoops(kind, state.range(1)));
+  state.SetLabel(ShapeKindName(kind));
+  int64_t allocations_before_loop = AllocationCount();
+  for (auto s : state) {
+    benchmark::DoNotOptimize(ComputeBoundaryLoops(shape));
+  }
+  ReportAllocations(state, allocations_before_loop);
+}
+BENCHMARK(BM_ComputeBoundaryLoops)->Apply([](Benchmark* b) {
+  ShapeKindsByVertexCount(b, 4096);
+});
+
+// Takes the `ShapeKind` and the number of vertices.
+void BM_ComputeTriangulation(benchmark::State& state) {
+  ShapeKind kind = static_cast<ShapeKind>(state.range(0));
+  ShapeOutline shape(MakeShapeLoops(kind, state.range(1)));
+  state.SetLabel(ShapeKindName(kind));
+  int64_t allocations_before_loop = AllocationCount();
+  for (auto s : state) {
+    benchmark::DoNotOptimize(ComputeTriangulation(shape));
+  }
+  ReportAllocations(state, allocations_before_loop);
+}
+BENCHMARK(BM_ComputeTriangulation)->Apply([](Benchmark* b) {
+  ShapeKindsByVertexCount(b, 4096);
+});
+
+// Subtracts a copy of a shape that has been moved a quarter of the way across
+// it, so that the boundaries cross in a few places. Takes the `ShapeKind` and
+// the number of vertices.
+//
+// This only goes up to 1024 vertices, since the star, whose offset copy
+// crosses it at about every vertex, takes minutes at 4096.
+void BM_ComputeSubtractionOfOffsetCopy(benchmark::State& state) {
+  ShapeKind kind = static_cast<ShapeKind>(state.range(0));
+  std::vector<std::vector<Point>> loops = MakeShapeLoops(kind, state.range(1));
+  ShapeOutline shape_a(loops);
+  ShapeOutline shape_b(Move(loops, Angle(), Vec{25, 10}));
+  state.SetLabel(ShapeKindName(kind));
+  int64_t allocations_before_loop = AllocationCount();
+  for (auto s : state) {
+    benchmark::DoNotOptimize(ComputeSubtraction(shape_a, shape_b));
+  }
+  ReportAllocations(state, allocations_before_loop);
+}
+BENCHMARK(BM_ComputeSubtractionOfOffsetCopy)->Apply([](Benchmark* b) {
+  ShapeKindsByVertexCount(b, 1024);
+});
+
+// Subtracts a copy of a shape that has been rotated very slightly about its
+// center, so that the boundaries nearly coincide, and cross about once per
+// edge. Takes the `ShapeKind` and the number of vertices.
+void BM_ComputeSubtractionOfNearlyCoincidentCopy(benchmark::State& state) {
+  ShapeKind kind = static_cast<ShapeKind>(state.range(0));
+  std::vector<std::vector<Point>> loops = MakeShapeLoops(kind, state.range(1));
+  ShapeOutline shape_a(loops);
+  ShapeOutline shape_b(Move(loops, Angle::Degrees(0.01), Vec{}));
+  state.SetLabel(ShapeKindName(kind));
+  int64_t allocations_before_loop = AllocationCount();
+  for (auto s : state) {
+    benchmark::DoNotOptimize(ComputeSubtraction(shape_a, shape_b));
+  }
+  ReportAllocations(state, allocations_before_loop);
+}
+BENCHMARK(BM_ComputeSubtractionOfNearlyCoincidentCopy)->Apply([](Benchmark* b) {
+  ShapeKindsByVertexCount(b, 4096);
+});
+
+}  // namespace
+}  // namespace ink::geometry_internal
@@ -59,6 +59,20 @@ bool HasValidIndices(const std::vector<Point>& points,
                      });
 }
 
+// Helper function for test: returns the loops of an `n` x `n` grid of unit
+// squares, with lower-left corners at (2i, 2j). Each square has two chains,
+// so for n >= 6, the resulting `ShapeOutline` indexes its chains.
+std::vector<std::vector<Point>> MakeSquareGridLoops(int n) {
+  std::vector<std::vector<Point>> loops;
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      float x = 2 * i, y = 2 * j;
+      loops.push_back({{x, y}, {x + 1, y}, {x + 1, y + 1}, {x, y + 1}});
+    }
+  }
+  return loops;
+}
+
 TEST(ComputeOutlineTest, BasicTriangle) {
   //         C
   //        / \
@@ -493,6 +507,73 @@ TEST(IntersectionTests, RectAndPolygonWithHole) {
   EXPECT_TRUE(Intersects(outline, FromTwoPoints({-1, -1}, {15, 13})));
 }
 
+TEST(IntersectionTests, VisitChainsWithIntersectedBounds) {
+  for (int n : {2, 6}) {
+    SCOPED_TRACE(n);
+    ShapeOutline outline(MakeSquareGridLoops(n));
+    ASSERT_THAT(outline.Chains(), SizeIs(2 * n * n));
+
+    // This touches the squares with lower-left corners (2, 0) and (2, 2).
+    Rect query = FromTwoPoints({2.5f, 0.5f}, {2.75f, 2.5f});
+    std::vector<uint32_t> visited;
+    outline.VisitChainsWithIntersectedBounds(
+        query, [&visited](uint32_t chain_idx) {
+          visited.push_back(chain_idx);
+          return true;
+        });
+    EXPECT_THAT(visited, SizeIs(4));
+    for (uint32_t chain_idx : visited) {
+      const Rect& bounds = outline.Chains()[chain_idx].Bounds();
+      EXPECT_EQ(bounds.XMin(), 2);
+      EXPECT_LE(bounds.YMin(), query.YMax());
+      EXPECT_GE(bounds.YMax(), query.YMin());
+    }
+
+    int n_visited = 0;
+    outline.VisitChainsWithIntersectedBounds(query,
+                                             [&n_visited](uint32_t chain_idx) {
+                                               ++n_visited;
+                                               return false;
+                                             });
+    EXPECT_EQ(n_visited, 1);
+  }
+}
+
+TEST(IntersectionTests, PointAndShapeWithManyChains) {
+  ShapeOutline outline(MakeSquareGridLoops(6));
+  ASSERT_GT(outline.Chains().size(), ShapeOutline::kMinChainsForIndex);
+
+  for (float x = 0; x < 12; x += 2) {
+    for (float y = 0; y < 12; y += 2) {
+      // Inside
+      EXPECT_TRUE(Intersects(outline, Point{x + 0.5f, y + 0.5f}));
+      // Boundary
+      EXPECT_TRUE(Intersects(outline, Point{x, y + 0.5f}));
+      EXPECT_TRUE(Intersects(outline, Point{x + 1, y + 1}));
+      // Outside, in the gaps between the squares.
+      EXPECT_FALSE(Intersects(outline, Point{x + 1.5f, y + 0.5f}));
+      EXPECT_FALSE(Intersects(outline, Point{x + 0.5f, y + 1.5f}));
+    }
+  }
+}
+
+TEST(IntersectionTests, RectAndShapeWithManyChains) {
+  ShapeOutline outline(MakeSquareGridLoops(6));
+  ASSERT_GT(outline.Chains().size(), ShapeOutline::kMinChainsForIndex);
+
+  // Inside a square.
+  EXPECT_TRUE(Intersects(outline, FromTwoPoints({4.25f, 6.25f}, {4.75f, 7})));
+  // In the gaps between squares.
+  EXPECT_FALSE(Intersects(outline, FromTwoPoints({5.25f, 6.25f}, {5.75f, 9})));
+  EXPECT_FALSE(Intersects(outline, FromTwoPoints({-1, 1.25f}, {13, 1.75f})));
+  // Crossing a gap into a square.
+  EXPECT_TRUE(Intersects(outline, FromTwoPoints({5.25f, 6.25f}, {6.5f, 7})));
+  // Touching the corner of a square.
+  EXPECT_TRUE(Intersects(outline, FromTwoPoints({9, 9}, {10, 10})));
+  // Outside the grid.
+  EXPECT_FALSE(Intersects(outline, FromTwoPoints({12, 0}, {13, 13})));
+}
+
 TEST(ComputeBoundaryLoopsTest, BasicTriangle) {
   //         C
   //        / \
@@ -868,6 +949,34 @@ TEST(ComputeSubtractionTests, SubtractShapeWithHole) {
                                        kFloatTolerance));
 }
 
+TEST(ComputeSubtractionTests, SubtractShapeWithManyChains) {
+  // A horizontal strip crossing the bottom row of the grid of squares.
+  ShapeOutline strip(std::vector<std::vector<Point>>{
+      {{-1, 0.25f}, {12, 0.25f}, {12, 0.75f}, {-1, 0.75f}}});
+  ShapeOutline grid(MakeSquareGridLoops(6));
+  ASSERT_GT(grid.Chains().size(), ShapeOutline::kMinChainsForIndex);
+
+  ShapeOutline result = ComputeSubtraction(strip, grid);
+
+  // Only the bottom row of squares touches the strip, so the result should be
+  // the same as for subtracting just that row, which is too small to index.
+  std::vector<std::vector<Point>> bottom_row_loops;
+  for (const std::vector<Point>& loop : MakeSquareGridLoops(6)) {
+    if (loop[0].y == 0) bottom_row_loops.push_back(loop);
+  }
+  ShapeOutline bottom_row(bottom_row_loops);
+  ASSERT_LE(bottom_row.Chains().size(), ShapeOutline::kMinChainsForIndex);
+  EXPECT_EQ(result, ComputeSubtraction(strip, bottom_row));
+
+  // The strip is cut into seven pieces, one on each side of each square.
+  EXPECT_THAT(ComputeBoundaryLoops(result), SizeIs(7));
+  for (float x = 0; x < 12; x += 2) {
+    EXPECT_TRUE(Intersects(result, Point{x - 0.5f, 0.5f}));
+    EXPECT_FALSE(Intersects(result, Point{x + 0.5f, 0.5f}));
+  }
+  EXPECT_TRUE(Intersects(result, Point{11.5f, 0.5f}));
+}
+
 TEST(ComputeSubtractionTests, VertexEdgeTransverse1) {
   //                            G
   //                         / /
@@ -43,31 +43,24 @@ const float kMinTrimmingRatio = 1.8f;
 
 float WalkDistance(PolylineData& polyline, int index, float fractional_index,
                    bool walk_backwards) {
-  int start_idx;
-  int end_idx;
+  const SegmentBundle& segment = polyline.segments[index];
   if (walk_backwards) {
-    fractional_index = 1.0 - fractional_index;
-    start_idx = index + 1;
-    end_idx = polyline.segments.size();
-  } else {
-    start_idx = 0;
-    end_idx = index;
-  }
-
-  float total_distance = polyline.segments[index].length * fractional_index;
-  for (int i = start_idx; i < end_idx; ++i) {
-    total_distance += polyline.segments[i].length;
+    const SegmentBundle& last_segment = polyline.segments.back();
+    float end_walk_distance =
+        last_segment.start_walk_distance + last_segment.length;
+    return end_walk_distance - segment.start_walk_distance -
+           segment.length * fractional_index;
   }
-  return total_distance;
+  return segment.start_walk_distance + segment.length * fractional_index;
 }
 
+// Returns the walk distance between the end of the segment at `start_index`
+// and the start of the segment at `end_index`.
 float IntermediateWalkDistance(PolylineData& polyline, int start_index,
                                int end_index) {
-  float total_distance = 0.0f;
-  for (int i = start_index + 1; i < end_index; ++i) {
-    total_distance += polyline.segments[i].length;
-  }
-  return total_distance;
+  if (end_index <= start_index + 1) return 0.0f;
+  return polyline.segments[end_index].start_walk_distance -
+         polyline.segments[start_index + 1].start_walk_distance;
 }
 
 PolylineData CreateNewPolylineData(absl::Span<const Point> points) {
@@ -75,13 +68,16 @@ PolylineData CreateNewPolylineData(absl::Span<const Point> points) {
 
   Point last_point = points[0];
   int segment_count = 0;
+  float walk_distance = 0.0f;
   polyline.segments.reserve(points.size() - 1);
   for (int i = 1; i < static_cast<int>(points.size()); ++i) {
     if (points[i] != last_point) {
+      float length = Distance(last_point, points[i]);
       polyline.segments.push_back(
-          SegmentBundle{Segment{last_point, points[i]}, segment_count,
-                        Distance(last_point, points[i])});
+          SegmentBundle{Segment{last_point, points[i]}, segment_count, length,
+                        walk_distance});
       ++segment_count;
+      walk_distance += length;
       last_point = points[i];
     }
   }
@@ -96,7 +92,7 @@ auto segment_bounds = [](SegmentBundle segment_data) {
 };
 
 void FindFirstAndLastIntersections(
-    ink::geometry_internal::StaticRTree<SegmentBundle> rtree,
+    const ink::geometry_internal::StaticRTree<SegmentBundle>& rtree,
     PolylineData& polyline) {
   SegmentBundle earliest_intersected_segment;
   std::pair<float, float> earliest_intersection_ratios =
@@ -299,7 +295,7 @@ inline bool BetterFirstIntersection(PolylineData& polyline,
 }
 
 void FindBestEndpointConnections(
-    ink::geometry_internal::StaticRTree<SegmentBundle> rtree,
+    const ink::geometry_internal::StaticRTree<SegmentBundle>& rtree,
     PolylineData& polyline) {
   Intersection best_first_point_connection;
   float best_first_point_connection_length =
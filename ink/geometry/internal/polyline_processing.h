@@ -30,6 +30,11 @@ struct SegmentBundle {
   Segment segment;
   int index;
   float length;
+  // The walk distance from the start of the polyline to the start of this
+  // segment, i.e. the sum of the lengths of the preceding segments. This lets
+  // walk distances be computed in constant time, rather than by summing the
+  // lengths of the segments walked over.
+  float start_walk_distance = 0.0f;
 };
 
 struct Intersection {
@@ -58,13 +63,13 @@ struct PolylineData {
 // Finds the first and last intersections in the polyline and updates the input
 // PolylineData with the results.
 void FindFirstAndLastIntersections(
-    ink::geometry_internal::StaticRTree<SegmentBundle> rtree,
+    const ink::geometry_internal::StaticRTree<SegmentBundle>& rtree,
     PolylineData& polyline);
 
 // Finds the best connections for the first and last points of the polyline and
 // updates the input PolylineData with the results.
 void FindBestEndpointConnections(
-    ink::geometry_internal::StaticRTree<SegmentBundle> rtree,
+    const ink::geometry_internal::StaticRTree<SegmentBundle>& rtree,
     PolylineData& polyline);
 
 PolylineData CreateNewPolylineData(absl::Span<const Point> points);
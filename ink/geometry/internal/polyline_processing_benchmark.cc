@@ -0,0 +1,91 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "ink/geometry/angle.h"
+#include "ink/geometry/internal/polyline_processing.h"
+#include "ink/geometry/point.h"
+
+namespace ink::geometry_internal {
+namespace {
+
+// Returns a lasso gesture of `n_points` points, which goes around a wobbly
+// circle `n_turns` times. With `n_turns` a little greater than 1, the end of
+// the lasso crosses its start, as when a user circles a selection.
+std::vector<Point> MakeLasso(int n_points, float n_turns) {
+  std::vector<Point> points;
+  points.reserve(n_points);
+  for (int i = 0; i < n_points; ++i) {
+    Angle theta = kFullTurn * n_turns * i / n_points;
+    float radius = 100 + 2 * Sin(37 * theta);
+    points.push_back({radius * Cos(theta), radius * Sin(theta)});
+  }
+  return points;
+}
+
+// Returns a scribble of `n_points` points, which makes `n_loops` overlapping
+// loops while moving to the right, so that it crosses itself many times.
+std::vector<Point> MakeScribble(int n_points, int n_loops) {
+  std::vector<Point> points;
+  points.reserve(n_points);
+  for (int i = 0; i < n_points; ++i) {
+    float t = static_cast<float>(i) / n_points;
+    Angle theta = kFullTurn * n_loops * t;
+    points.push_back({400 * t + 50 * Cos(theta), 50 * Sin(theta)});
+  }
+  return points;
+}
+
+// A lasso whose ends overlap. Takes the number of points.
+void BM_CreateClosedShapeFromClosedLasso(benchmark::State& state) {
+  std::vector<Point> points = MakeLasso(state.range(0), 1.1);
+  for (auto s : state) {
+    benchmark::DoNotOptimize(CreateClosedShape(points));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CreateClosedShapeFromClosedLasso)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 1 << 16);
+
+// A lasso whose ends don't meet, so that there is no intersection to find.
+// Takes the number of points.
+void BM_CreateClosedShapeFromOpenLasso(benchmark::State& state) {
+  std::vector<Point> points = MakeLasso(state.range(0), 0.95);
+  for (auto s : state) {
+    benchmark::DoNotOptimize(CreateClosedShape(points));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CreateClosedShapeFromOpenLasso)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 1 << 16);
+
+// A scribble with 16 loops, which crosses itself many times. Takes the number
+// of points.
+void BM_CreateClosedShapeFromScribble(benchmark::State& state) {
+  std::vector<Point> points = MakeScribble(state.range(0), 16);
+  for (auto s : state) {
+    benchmark::DoNotOptimize(CreateClosedShape(points));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CreateClosedShapeFromScribble)
+    ->RangeMultiplier(4)
+    ->Range(1 << 10, 1 << 16);
+
+}  // namespace
+}  // namespace ink::geometry_internal
@@ -116,21 +116,25 @@ TEST(PolylineProcessingTest,
 
   EXPECT_EQ(walking_polyline.segments[0].index, 0);
   EXPECT_EQ(walking_polyline.segments[0].length, 7);
+  EXPECT_EQ(walking_polyline.segments[0].start_walk_distance, 0);
   EXPECT_THAT(walking_polyline.segments[0].segment,
               SegmentEq(Segment{{3, 3}, {3, 10}}));
 
   EXPECT_EQ(walking_polyline.segments[3].index, 3);
   EXPECT_EQ(walking_polyline.segments[3].length, 5);
+  EXPECT_EQ(walking_polyline.segments[3].start_walk_distance, 24);
   EXPECT_THAT(walking_polyline.segments[3].segment,
               SegmentEq(Segment{{10, 20}, {10, 15}}));
 
   EXPECT_EQ(walking_polyline.segments[5].index, 5);
   EXPECT_EQ(walking_polyline.segments[5].length, 15);
+  EXPECT_EQ(walking_polyline.segments[5].start_walk_distance, 34);
   EXPECT_THAT(walking_polyline.segments[5].segment,
               SegmentEq(Segment{{5, 15}, {5, 0}}));
 
   EXPECT_EQ(walking_polyline.segments[6].index, 6);
   EXPECT_EQ(walking_polyline.segments[6].length, 3);
+  EXPECT_EQ(walking_polyline.segments[6].start_walk_distance, 49);
   EXPECT_THAT(walking_polyline.segments[6].segment,
               SegmentEq(Segment{{5, 0}, {2, 0}}));
 }
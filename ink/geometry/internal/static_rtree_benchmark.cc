@@ -12,12 +12,23 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <random>
 #include <vector>
 
 #include "benchmark/benchmark.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/log/absl_check.h"
+#include "absl/status/statusor.h"
 #include "absl/types/span.h"
+#include "ink/geometry/envelope.h"
+#include "ink/geometry/internal/flat_static_rtree.h"
 #include "ink/geometry/internal/static_rtree.h"
+#include "ink/geometry/mesh.h"
+#include "ink/geometry/mutable_mesh.h"
+#include "ink/geometry/point.h"
 #include "ink/geometry/rect.h"
 
 namespace ink::geometry_internal {
@@ -79,5 +90,169 @@ void BM_VisitAllIntersectingRects(benchmark::State& state) {
 }
 BENCHMARK(BM_VisitAllIntersectingRects)->Range(8, 16384);
 
+void BM_FlatVisitAllIntersectingRects(benchmark::State& state) {
+  std::vector<Rect> rects = MakeVectorOfRandomRects(state.range(0));
+  FlatStaticRTree<Rect> rtree(rects, rect_bounds);
+  std::vector<Rect> output;
+  output.reserve(rects.size());
+  for (auto s : state) {
+    state.PauseTiming();
+    output.clear();
+    state.ResumeTiming();
+    rtree.VisitIntersectedElements(Rect::FromTwoPoints({-25, -25}, {75, 75}),
+                                   [&output](const Rect& r) {
+                                     output.push_back(r);
+                                     return true;
+                                   });
+  }
+}
+BENCHMARK(BM_FlatVisitAllIntersectingRects)->Range(8, 16384);
+
+// Returns a `Mesh` shaped like a long, wavy stroke, made of a triangle strip
+// with `n_triangles` triangles.
+Mesh MakeWavyStripMesh(uint32_t n_triangles) {
+  MutableMesh mutable_mesh;
+  uint32_t n_vertex_pairs = n_triangles / 2 + 1;
+  for (uint32_t i = 0; i < n_vertex_pairs; ++i) {
+    float x = 0.1f * i;
+    float y = 10 * std::sin(0.05f * i);
+    mutable_mesh.AppendVertex({x, y - 0.5f});
+    mutable_mesh.AppendVertex({x, y + 0.5f});
+  }
+  for (uint32_t i = 0; i < n_triangles; ++i) {
+    uint32_t v = i / 2 * 2;
+    if (i % 2 == 0) {
+      mutable_mesh.AppendTriangleIndices({v, v + 1, v + 2});
+    } else {
+      mutable_mesh.AppendTriangleIndices({v + 1, v + 3, v + 2});
+    }
+  }
+  absl::StatusOr<absl::InlinedVector<Mesh, 1>> meshes =
+      mutable_mesh.AsMeshes();
+  ABSL_CHECK_OK(meshes);
+  ABSL_CHECK_EQ(meshes->size(), 1u);
+  return (*meshes)[0];
+}
+
+// Returns `n_queries` pseudo-randomly generated query `Rect`s, each about the
+// size of the width of the mesh from `MakeWavyStripMesh`, placed near it.
+std::vector<Rect> MakeWavyStripQueries(const Mesh& mesh, int n_queries) {
+  std::mt19937_64 rng(0);
+  Rect bounds = *mesh.Bounds().AsRect();
+  std::uniform_real_distribution<float> x_dist(bounds.XMin(), bounds.XMax());
+  std::vector<Rect> queries(n_queries);
+  for (Rect& query : queries) {
+    float x = x_dist(rng);
+    float y = 10 * std::sin(0.5f * x);
+    query = Rect::FromCenterAndDimensions({x, y}, 1, 1);
+  }
+  return queries;
+}
+
+// Stores a triangle index in the R-Tree, the way that `PartitionedMesh` does.
+template <typename RTree>
+RTree MakeTriangleRTree(const Mesh& mesh) {
+  return RTree(
+      mesh.TriangleCount(), [i = 0u]() mutable { return i++; },
+      [&mesh](uint32_t i) { return *Envelope(mesh.GetTriangle(i)).AsRect(); });
+}
+
+template <typename RTree>
+void BM_ConstructFromTriangleMesh(benchmark::State& state) {
+  Mesh mesh = MakeWavyStripMesh(state.range(0));
+  for (auto s : state) {
+    benchmark::DoNotOptimize(MakeTriangleRTree<RTree>(mesh));
+  }
+}
+BENCHMARK(BM_ConstructFromTriangleMesh<StaticRTree<uint32_t>>)
+    ->Range(64, 32768);
+BENCHMARK(BM_ConstructFromTriangleMesh<FlatStaticRTree<uint32_t>>)
+    ->Range(64, 32768);
+
+// Runs a batch of small queries along the mesh, counting the triangles whose
+// bounds are hit.
+template <typename RTree>
+void BM_VisitTrianglesIntersectingSmallRects(benchmark::State& state) {
+  Mesh mesh = MakeWavyStripMesh(state.range(0));
+  RTree rtree = MakeTriangleRTree<RTree>(mesh);
+  std::vector<Rect> queries = MakeWavyStripQueries(mesh, 64);
+  for (auto s : state) {
+    int n_hits = 0;
+    for (const Rect& query : queries) {
+      rtree.VisitIntersectedElements(query, [&n_hits](uint32_t) {
+        ++n_hits;
+        return true;
+      });
+    }
+    benchmark::DoNotOptimize(n_hits);
+  }
+}
+BENCHMARK(BM_VisitTrianglesIntersectingSmallRects<StaticRTree<uint32_t>>)
+    ->Range(64, 32768);
+BENCHMARK(BM_VisitTrianglesIntersectingSmallRects<FlatStaticRTree<uint32_t>>)
+    ->Range(64, 32768);
+
+// Returns `n_queries` overlapping query `Rect`s, following the mesh from
+// `MakeWavyStripMesh` for 5 units, as the samples of an eraser's path would.
+std::vector<Rect> MakeEraserPathQueries(int n_queries) {
+  std::vector<Rect> queries(n_queries);
+  for (int i = 0; i < n_queries; ++i) {
+    float x = 1 + 5.f * i / n_queries;
+    float y = 10 * std::sin(0.5f * x);
+    queries[i] = Rect::FromCenterAndDimensions({x, y}, 0.5, 0.5);
+  }
+  return queries;
+}
+
+void BM_VisitTrianglesIntersectingEraserPath(benchmark::State& state) {
+  Mesh mesh = MakeWavyStripMesh(state.range(0));
+  auto rtree = MakeTriangleRTree<FlatStaticRTree<uint32_t>>(mesh);
+  std::vector<Rect> queries = MakeEraserPathQueries(64);
+  for (auto s : state) {
+    int n_hits = 0;
+    for (const Rect& query : queries) {
+      rtree.VisitIntersectedElements(query, [&n_hits](uint32_t) {
+        ++n_hits;
+        return true;
+      });
+    }
+    benchmark::DoNotOptimize(n_hits);
+  }
+}
+BENCHMARK(BM_VisitTrianglesIntersectingEraserPath)->Range(64, 32768);
+
+void BM_VisitTrianglesIntersectingEraserPathBatch(benchmark::State& state) {
+  Mesh mesh = MakeWavyStripMesh(state.range(0));
+  auto rtree = MakeTriangleRTree<FlatStaticRTree<uint32_t>>(mesh);
+  std::vector<Rect> queries = MakeEraserPathQueries(64);
+  for (auto s : state) {
+    int n_hits = 0;
+    rtree.VisitIntersectedElementsBatch(queries, [&n_hits](size_t, uint32_t) {
+      ++n_hits;
+      return true;
+    });
+    benchmark::DoNotOptimize(n_hits);
+  }
+}
+BENCHMARK(BM_VisitTrianglesIntersectingEraserPathBatch)->Range(64, 32768);
+
+// Visits every triangle, as e.g. a coverage query of a large region would.
+template <typename RTree>
+void BM_VisitAllTriangles(benchmark::State& state) {
+  Mesh mesh = MakeWavyStripMesh(state.range(0));
+  RTree rtree = MakeTriangleRTree<RTree>(mesh);
+  Rect query = *mesh.Bounds().AsRect();
+  for (auto s : state) {
+    int n_hits = 0;
+    rtree.VisitIntersectedElements(query, [&n_hits](uint32_t) {
+      ++n_hits;
+      return true;
+    });
+    benchmark::DoNotOptimize(n_hits);
+  }
+}
+BENCHMARK(BM_VisitAllTriangles<StaticRTree<uint32_t>>)->Range(64, 32768);
+BENCHMARK(BM_VisitAllTriangles<FlatStaticRTree<uint32_t>>)->Range(64, 32768);
+
 }  // namespace
 }  // namespace ink::geometry_internal
@@ -25,11 +25,13 @@
 #include <vector>
 
 #include "absl/algorithm/container.h"
+#include "absl/functional/function_ref.h"
 #include "absl/log/absl_check.h"
 #include "absl/status/status.h"
 #include "absl/status/status_macros.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/substitute.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "ink/geometry/internal/mesh_packing.h"
 #include "ink/geometry/mesh_format.h"
@@ -41,6 +43,10 @@
 namespace ink {
 namespace {
 
+// The number of vertices whose attribute values are gathered and packed
+// together when creating a mesh.
+constexpr size_t kVerticesPerPackingBlock = 256;
+
 // Returns bounds for vertex attributes given in quantized form, by decoding
 // the min/max quantized values of each component using `coding_params`.
 std::optional<mesh_internal::AttributeBoundsArray> ComputeAttributeBounds(
@@ -123,7 +129,7 @@ mesh_internal::CodingParamsArray MakeCodingParamsArrayForEmptyMesh(
 template <typename T>
 absl::Status ValidateCreateMeshParameters(
     const MeshFormat& format, absl::Span<const absl::Span<T>> vertex_attributes,
-    absl::Span<const uint32_t> triangle_indices, int bytes_per_index) {
+    absl::Span<const uint32_t> triangle_indices) {
   size_t total_attr_components = format.TotalComponentCount();
   if (total_attr_components != vertex_attributes.size()) {
     return absl::InvalidArgumentError(
@@ -133,7 +139,7 @@ absl::Status ValidateCreateMeshParameters(
   }
   // The check above should ensure that `vertex_attributes` is not empty.
   ABSL_DCHECK_GT(vertex_attributes.size(), 0);
-  const int kMaxVertices = 1 << (8 * bytes_per_index);
+  const uint64_t kMaxVertices = uint64_t{1} << (8 * format.PackedIndexStride());
   size_t n_vertices = vertex_attributes[0].size();
   if (n_vertices > kMaxVertices) {
     return absl::InvalidArgumentError(
@@ -223,22 +229,30 @@ std::vector<std::byte> PackQuantizedVertexByteData(
   size_t n_vertices = vertex_attributes[0].size();
   std::vector<std::byte> vertex_data(n_vertices * format.PackedVertexStride());
 
-  int n_attrs = format.Attributes().size();
-  for (size_t vertex_idx = 0; vertex_idx < n_vertices; ++vertex_idx) {
-    size_t vertex_offset = vertex_idx * format.PackedVertexStride();
+  // Each attribute is packed separately, in blocks of vertices that are small
+  // enough to interleave their components into a buffer on the stack.
+  std::array<uint32_t, 4 * kVerticesPerPackingBlock> quantized;
+  for (size_t block_start = 0; block_start < n_vertices;
+       block_start += kVerticesPerPackingBlock) {
+    size_t block_size =
+        std::min(kVerticesPerPackingBlock, n_vertices - block_start);
     int span_idx = 0;
-    for (int attr_idx = 0; attr_idx < n_attrs; ++attr_idx) {
-      const MeshFormat::Attribute attr = format.Attributes()[attr_idx];
+    for (const MeshFormat::Attribute& attr : format.Attributes()) {
       int n_components = MeshFormat::ComponentCount(attr.type);
-      SmallArray<uint32_t, 4> quantized(n_components);
       for (int component_idx = 0; component_idx < n_components;
            ++component_idx, ++span_idx) {
-        quantized[component_idx] = vertex_attributes[span_idx][vertex_idx];
+        for (size_t i = 0; i < block_size; ++i) {
+          quantized[i * n_components + component_idx] =
+              vertex_attributes[span_idx][block_start + i];
+        }
       }
-      absl::Span<std::byte> packed_value = absl::MakeSpan(
-          &vertex_data[vertex_offset + attr.packed_offset], attr.packed_width);
-
-      mesh_internal::PackQuantizedAttribute(attr.type, quantized, packed_value);
+      mesh_internal::PackQuantizedAttributeValues(
+          attr.type,
+          absl::MakeConstSpan(quantized.data(), block_size * n_components),
+          format.PackedVertexStride(),
+          absl::MakeSpan(vertex_data)
+              .subspan(block_start * format.PackedVertexStride() +
+                       attr.packed_offset));
     }
   }
 
@@ -252,7 +266,7 @@ absl::StatusOr<Mesh> Mesh::CreateFromQuantizedData(
     absl::Span<const uint32_t> triangle_indices,
     absl::Span<const MeshAttributeCodingParams> coding_params) {
   ABSL_RETURN_IF_ERROR(ValidateCreateMeshParameters(
-      format, vertex_attributes, triangle_indices, kBytesPerIndex));
+      format, vertex_attributes, triangle_indices));
 
   size_t num_attrs = format.Attributes().size();
   if (coding_params.size() != num_attrs) {
@@ -270,7 +284,7 @@ absl::StatusOr<Mesh> Mesh::CreateFromQuantizedData(
   std::vector<std::byte> vertex_data =
       PackQuantizedVertexByteData(format, vertex_attributes);
   std::vector<std::byte> index_data =
-      PackIndexByteData(triangle_indices, kBytesPerIndex);
+      PackIndexByteData(triangle_indices, format.PackedIndexStride());
 
   return Mesh(format, coding_params_array, attribute_bounds,
               std::move(vertex_data), std::move(index_data));
@@ -282,7 +296,7 @@ absl::StatusOr<Mesh> Mesh::Create(
     absl::Span<const uint32_t> triangle_indices,
     absl::Span<const std::optional<MeshAttributeCodingParams>> packing_params) {
   ABSL_RETURN_IF_ERROR(ValidateCreateMeshParameters(
-      format, vertex_attributes, triangle_indices, kBytesPerIndex));
+      format, vertex_attributes, triangle_indices));
 
   std::optional<mesh_internal::AttributeBoundsArray> attribute_bounds =
       ComputeAttributeBounds(format, vertex_attributes);
@@ -298,7 +312,7 @@ absl::StatusOr<Mesh> Mesh::Create(
   std::vector<std::byte> vertex_data =
       PackVertexByteData(format, vertex_attributes, coding_params_array);
   std::vector<std::byte> index_data =
-      PackIndexByteData(triangle_indices, kBytesPerIndex);
+      PackIndexByteData(triangle_indices, format.PackedIndexStride());
 
   return Mesh(format, std::move(coding_params_array),
               std::move(attribute_bounds), std::move(vertex_data),
@@ -325,6 +339,39 @@ SmallArray<uint32_t, 4> Mesh::PackedIntegersForFloatVertexAttribute(
       Format().Attributes()[attribute_index].type, packed_value);
 }
 
+void Mesh::FloatVertexAttributes(uint32_t first_vertex,
+                                 uint32_t attribute_index,
+                                 absl::Span<float> values) const {
+  ABSL_DCHECK_LT(attribute_index, Format().Attributes().size());
+  ABSL_DCHECK_LT(attribute_index, data_->unpacking_params.Size());
+  if (values.empty()) return;
+  const MeshFormat::Attribute& attr = Format().Attributes()[attribute_index];
+  ABSL_DCHECK_LE(first_vertex + values.size() /
+                                    MeshFormat::ComponentCount(attr.type),
+                 VertexCount());
+  mesh_internal::UnpackAttributeValues(
+      attr.type, data_->unpacking_params[attribute_index],
+      RawVertexData().subspan(first_vertex * VertexStride() +
+                              attr.packed_offset),
+      VertexStride(), values);
+}
+
+void Mesh::PackedIntegersForFloatVertexAttributes(
+    uint32_t first_vertex, uint32_t attribute_index,
+    absl::Span<uint32_t> values) const {
+  ABSL_DCHECK_LT(attribute_index, Format().Attributes().size());
+  if (values.empty()) return;
+  const MeshFormat::Attribute& attr = Format().Attributes()[attribute_index];
+  ABSL_DCHECK_LE(first_vertex + values.size() /
+                                    MeshFormat::ComponentCount(attr.type),
+                 VertexCount());
+  mesh_internal::UnpackIntegersFromPackedAttributeValues(
+      attr.type,
+      RawVertexData().subspan(first_vertex * VertexStride() +
+                              attr.packed_offset),
+      VertexStride(), values);
+}
+
 absl::Span<const std::byte> Mesh::PackedVertexAttribute(
     uint32_t vertex_index, uint32_t attribute_index) const {
   ABSL_DCHECK_LT(vertex_index, VertexCount());
@@ -336,6 +383,38 @@ absl::Span<const std::byte> Mesh::PackedVertexAttribute(
       attr.packed_width);
 }
 
+void Mesh::InitializeVertexPositionCache() const {
+  data_->vertex_position_cache.InitializeIfNeeded([this]() {
+    uint32_t n_vertices = VertexCount();
+    DecodedVertexPositions decoded = {.x = std::vector<float>(n_vertices),
+                                      .y = std::vector<float>(n_vertices)};
+    // Decode in blocks via an interleaved buffer, to use the bulk unpacking
+    // path without allocating a second full-size array.
+    std::array<float, 2 * kVerticesPerPackingBlock> block;
+    for (uint32_t block_start = 0; block_start < n_vertices;
+         block_start += kVerticesPerPackingBlock) {
+      uint32_t block_size = std::min<uint32_t>(kVerticesPerPackingBlock,
+                                               n_vertices - block_start);
+      FloatVertexAttributes(block_start, VertexPositionAttributeIndex(),
+                            absl::MakeSpan(block.data(), 2 * block_size));
+      for (uint32_t i = 0; i < block_size; ++i) {
+        decoded.x[block_start + i] = block[2 * i];
+        decoded.y[block_start + i] = block[2 * i + 1];
+      }
+    }
+    return decoded;
+  });
+}
+
+void Mesh::VertexPositionCache::InitializeIfNeeded(
+    absl::FunctionRef<DecodedVertexPositions()> decode) {
+  if (Get() != nullptr) return;
+  absl::MutexLock lock(&init_mutex_);
+  if (decoded_.load(std::memory_order_relaxed) != nullptr) return;
+  decoded_.store(new DecodedVertexPositions(decode()),
+                 std::memory_order_release);
+}
+
 Triangle Mesh::GetTriangle(uint32_t index) const {
   std::array<uint32_t, 3> vertex_indices = TriangleIndices(index);
   return {.p0 = VertexPosition(vertex_indices[0]),
@@ -350,23 +429,31 @@ std::vector<std::byte> Mesh::PackVertexByteData(
   size_t n_vertices = vertex_attributes[0].size();
   std::vector<std::byte> vertex_data(n_vertices * format.PackedVertexStride());
 
+  // See `PackQuantizedVertexByteData` for why this is done in blocks.
+  std::array<float, 4 * kVerticesPerPackingBlock> unpacked;
   int n_attrs = format.Attributes().size();
-  for (size_t vertex_idx = 0; vertex_idx < n_vertices; ++vertex_idx) {
-    size_t vertex_offset = vertex_idx * format.PackedVertexStride();
+  for (size_t block_start = 0; block_start < n_vertices;
+       block_start += kVerticesPerPackingBlock) {
+    size_t block_size =
+        std::min(kVerticesPerPackingBlock, n_vertices - block_start);
     int span_idx = 0;
     for (int attr_idx = 0; attr_idx < n_attrs; ++attr_idx) {
       const MeshFormat::Attribute attr = format.Attributes()[attr_idx];
       int n_components = MeshFormat::ComponentCount(attr.type);
-      SmallArray<float, 4> unpacked(n_components);
       for (int component_idx = 0; component_idx < n_components;
            ++component_idx, ++span_idx) {
-        unpacked[component_idx] = vertex_attributes[span_idx][vertex_idx];
+        for (size_t i = 0; i < block_size; ++i) {
+          unpacked[i * n_components + component_idx] =
+              vertex_attributes[span_idx][block_start + i];
+        }
       }
-      absl::Span<std::byte> packed_value = absl::MakeSpan(
-          &vertex_data[vertex_offset + attr.packed_offset], attr.packed_width);
-
-      mesh_internal::PackAttribute(attr.type, packing_params_array[attr_idx],
-                                   unpacked, packed_value);
+      mesh_internal::PackAttributeValues(
+          attr.type, packing_params_array[attr_idx],
+          absl::MakeConstSpan(unpacked.data(), block_size * n_components),
+          format.PackedVertexStride(),
+          absl::MakeSpan(vertex_data)
+              .subspan(block_start * format.PackedVertexStride() +
+                       attr.packed_offset));
     }
   }
 
@@ -17,6 +17,7 @@
 
 #include <any>
 #include <array>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -25,8 +26,10 @@
 #include <vector>
 
 #include "absl/base/nullability.h"
+#include "absl/functional/function_ref.h"
 #include "absl/log/absl_check.h"
 #include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "ink/geometry/envelope.h"
 #include "ink/geometry/internal/mesh_packing.h"
@@ -75,7 +78,8 @@ class Mesh {
   // - Any attribute value is non-finite
   // - The range of values for any attribute (i.e. max - min) is larger than
   //   std::numeric_limits<float>::max()
-  // - More than 2^16 (65536) vertices are given
+  // - More vertices are given than can be referenced by the packed indices of
+  //   `format`, i.e. more than 2^16 (65536) vertices for 16-bit packed indices
   // - `triangle_indices.size()` is not divisible by 3
   // - `triangle_indices` contains any element >=
   //   `vertex_attributes[0].size`
@@ -141,11 +145,32 @@ class Mesh {
   // Returns the position of the vertex at the given index. This DCHECK-fails if
   // `index` >= `VertexCount()`.
   Point VertexPosition(uint32_t index) const {
+    if (const DecodedVertexPositions* decoded =
+            data_->vertex_position_cache.Get()) {
+      ABSL_DCHECK_LT(index, VertexCount());
+      return {decoded->x[index], decoded->y[index]};
+    }
     SmallArray<float, 4> value =
         FloatVertexAttribute(index, VertexPositionAttributeIndex());
     return {value[0], value[1]};
   }
 
+  // Decodes the positions of all of the mesh's vertices into a cache, which
+  // `VertexPosition` and `GetTriangle` (and in turn, the geometric queries on
+  // `PartitionedMesh`) then read from instead of unpacking the position
+  // attribute on every call. The cache is built at most once, costs an extra 8
+  // bytes per vertex, and is shared by all copies of the mesh.
+  //
+  // Note that this is treated as const because it only mutates an explicitly
+  // mutable cache field (i.e. it does not affect behavior, only performance).
+  // It is safe to call concurrently with itself and with other const methods.
+  void InitializeVertexPositionCache() const;
+
+  // Returns true if the vertex position cache has been initialized.
+  bool IsVertexPositionCacheInitialized() const {
+    return data_->vertex_position_cache.Get() != nullptr;
+  }
+
   // Returns the index of the vertex attribute that contains the vertex's
   // position.
   uint32_t VertexPositionAttributeIndex() const {
@@ -168,10 +193,27 @@ class Mesh {
   SmallArray<uint32_t, 4> PackedIntegersForFloatVertexAttribute(
       uint32_t vertex_index, uint32_t attribute_index) const;
 
+  // Bulk versions of `FloatVertexAttribute` and
+  // `PackedIntegersForFloatVertexAttribute`, which write the values of the
+  // attribute at index `attribute_index` on the n vertices starting at
+  // `first_vertex` to `values`, with the components of each vertex adjacent.
+  // n is given by `values.size()` divided by the number of components of the
+  // attribute. These are equivalent to, but faster than, calling the
+  // single-vertex functions in a loop.
+  //
+  // These DCHECK-fail under the same conditions as the single-vertex
+  // functions, or if `values.size()` is not a multiple of the number of
+  // components, or if `first_vertex` + n > `VertexCount()`.
+  void FloatVertexAttributes(uint32_t first_vertex, uint32_t attribute_index,
+                             absl::Span<float> values) const;
+  void PackedIntegersForFloatVertexAttributes(
+      uint32_t first_vertex, uint32_t attribute_index,
+      absl::Span<uint32_t> values) const;
+
   // Returns the number of triangles in the mesh.
   uint32_t TriangleCount() const {
-    ABSL_DCHECK_EQ(data_->index_data.size() % (3 * kBytesPerIndex), 0u);
-    ABSL_DCHECK_EQ(data_->index_data.size() / (3 * kBytesPerIndex),
+    ABSL_DCHECK_EQ(data_->index_data.size() % (3 * IndexStride()), 0u);
+    ABSL_DCHECK_EQ(data_->index_data.size() / (3 * IndexStride()),
                    data_->triangle_count);
     return data_->triangle_count;
   }
@@ -180,7 +222,7 @@ class Mesh {
   // index. This DCHECK-fails if `index` >= `TriangleCount()`.
   std::array<uint32_t, 3> TriangleIndices(uint32_t index) const {
     return mesh_internal::ReadTriangleIndicesFromByteArray(
-        index, kBytesPerIndex, data_->index_data);
+        index, IndexStride(), data_->index_data);
   }
 
   // Returns the (position-only) triangle at the given index. This DCHECK-fails
@@ -256,14 +298,50 @@ class Mesh {
   uint32_t VertexStride() const { return Format().PackedVertexStride(); }
 
   // Returns the raw data of the mesh's triangle indices. These are stored
-  // unsigned using 2 bytes per index (i.e. as uint16_t).
+  // unsigned using `IndexStride()` bytes per index (i.e. as uint16_t or
+  // uint32_t).
   absl::Span<const std::byte> RawIndexData() const { return data_->index_data; }
 
   // Returns the number of bytes used to represent a triangle index in this
-  // mesh, which is always two bytes (i.e. sizeof(uint16_t)).
-  uint32_t IndexStride() const { return kBytesPerIndex; }
+  // mesh. This is equivalent to:
+  //   mesh.Format().PackedIndexStride();
+  // which is two bytes (i.e. sizeof(uint16_t)) unless the format's index format
+  // is `MeshFormat::IndexFormat::k32BitUnpacked32BitPacked`.
+  uint32_t IndexStride() const { return Format().PackedIndexStride(); }
 
  private:
+  // The decoded vertex positions, stored as separate arrays of x- and
+  // y-coordinates.
+  struct DecodedVertexPositions {
+    std::vector<float> x;
+    std::vector<float> y;
+  };
+
+  // Holds the `DecodedVertexPositions` once they have been initialized. Copies
+  // of this start out empty, so that `Data` can still be constructed as an
+  // aggregate.
+  class VertexPositionCache {
+   public:
+    VertexPositionCache() = default;
+    VertexPositionCache(const VertexPositionCache&) {}
+    VertexPositionCache& operator=(const VertexPositionCache&) = delete;
+    ~VertexPositionCache() { delete decoded_.load(std::memory_order_relaxed); }
+
+    // Returns the decoded positions, or nullptr if they have not been
+    // initialized.
+    const DecodedVertexPositions* Get() const {
+      return decoded_.load(std::memory_order_acquire);
+    }
+
+    // Sets the decoded positions to the result of `decode`, unless they have
+    // already been initialized. `decode` is called at most once.
+    void InitializeIfNeeded(absl::FunctionRef<DecodedVertexPositions()> decode);
+
+   private:
+    absl::Mutex init_mutex_;
+    std::atomic<const DecodedVertexPositions*> decoded_ = nullptr;
+  };
+
   struct Data {
     MeshFormat format;
     mesh_internal::CodingParamsArray unpacking_params;
@@ -273,6 +351,7 @@ class Mesh {
     uint32_t vertex_count = 0;
     uint32_t triangle_count = 0;
     mutable std::any cached_rendering_data;
+    mutable VertexPositionCache vertex_position_cache;
   };
 
   // `MutableMesh::AsMeshes` requires access to the private ctor, to avoid
@@ -280,9 +359,6 @@ class Mesh {
   // partition.
   friend class MutableMesh;
 
-  // `Mesh` always uses 16-bit indices.
-  static constexpr uint8_t kBytesPerIndex = sizeof(uint16_t);
-
   Mesh(const MeshFormat& format,
        mesh_internal::CodingParamsArray unpacking_transforms,
        std::optional<mesh_internal::AttributeBoundsArray> attribute_bounds,
@@ -306,7 +382,8 @@ class Mesh {
       std::optional<mesh_internal::AttributeBoundsArray> attribute_bounds,
       std::vector<std::byte> vertex_data, std::vector<std::byte> index_data) {
     uint32_t vertex_count = vertex_data.size() / format.PackedVertexStride();
-    uint32_t triangle_count = index_data.size() / (3 * kBytesPerIndex);
+    uint32_t triangle_count =
+        index_data.size() / (3 * format.PackedIndexStride());
     return std::make_shared<const Data>(Data{
         .format = format,
         .unpacking_params = std::move(unpacking_transforms),
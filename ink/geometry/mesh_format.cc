@@ -302,6 +302,19 @@ uint8_t MeshFormat::UnpackedIndexSize(IndexFormat index_format) {
     case IndexFormat::k16BitUnpacked16BitPacked:
       return 2;
     case IndexFormat::k32BitUnpacked16BitPacked:
+    case IndexFormat::k32BitUnpacked32BitPacked:
+      return 4;
+  }
+  ABSL_LOG(FATAL) << "Unrecognized IndexFormat "
+                  << static_cast<int>(index_format);
+}
+
+uint8_t MeshFormat::PackedIndexSize(IndexFormat index_format) {
+  switch (index_format) {
+    case IndexFormat::k16BitUnpacked16BitPacked:
+    case IndexFormat::k32BitUnpacked16BitPacked:
+      return 2;
+    case IndexFormat::k32BitUnpacked32BitPacked:
       return 4;
   }
   ABSL_LOG(FATAL) << "Unrecognized IndexFormat "
@@ -322,6 +335,7 @@ void MeshFormat::PopulateOffsetWidthAndStride() {
   unpacked_vertex_stride_ = current_unpacked_offset;
   packed_vertex_stride_ = current_packed_offset;
   unpacked_index_stride_ = UnpackedIndexSize(index_format_);
+  packed_index_stride_ = PackedIndexSize(index_format_);
 }
 
 bool MeshFormat::IsPackedEquivalent(const MeshFormat& first,
@@ -482,6 +496,8 @@ std::string ToFormattedString(MeshFormat::IndexFormat index_format) {
       return "k16BitUnpacked16BitPacked";
     case MeshFormat::IndexFormat::k32BitUnpacked16BitPacked:
       return "k32BitUnpacked16BitPacked";
+    case MeshFormat::IndexFormat::k32BitUnpacked32BitPacked:
+      return "k32BitUnpacked32BitPacked";
   }
   return absl::StrCat("Invalid(", static_cast<int>(index_format), ")");
 }
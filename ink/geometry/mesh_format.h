@@ -203,11 +203,19 @@ class MeshFormat {
   // Indicates how the triangle index is stored, in `MutableMesh` and `Mesh`,
   // e.g. `k32BitUnpacked16BitPacked` means that `MutableMesh` uses 32-bit
   // indices and `Mesh` uses 16-bit indices.
+  //
+  // Meshes with 16-bit packed indices are limited to 2^16 vertices, so larger
+  // `MutableMesh`es are split into multiple partitions when converted to
+  // `Mesh`es. `k32BitUnpacked32BitPacked` avoids this, at the cost of twice the
+  // index storage. It is only supported for standalone `Mesh`es: no renderer
+  // in this library supports 32-bit index buffers, so `PartitionedMesh` (and
+  // therefore `Stroke`) rejects meshes with this format.
   // TODO: b/295166196 - Delete this once `MutableMesh` uses 16-bit indices.
   // LINT.IfChange(index_formats)
   enum class IndexFormat : uint8_t {
     k16BitUnpacked16BitPacked,
     k32BitUnpacked16BitPacked,
+    k32BitUnpacked32BitPacked,
   };
   // LINT.ThenChange(fuzz_domains.cc:index_formats)
 
@@ -265,6 +273,10 @@ class MeshFormat {
   // TODO: b/295166196 - Delete this once `MutableMesh` uses 16-bit indices.
   uint8_t UnpackedIndexStride() const { return unpacked_index_stride_; }
 
+  // Returns the number of bytes used to represent a single triangle index for
+  // a packed mesh.
+  uint8_t PackedIndexStride() const { return packed_index_stride_; }
+
   // Returns whether two mesh formats have the same packed representation
   // and same packing scheme such that they can be passed to the same shader
   // that accepts packed attribute values.
@@ -304,6 +316,9 @@ class MeshFormat {
   // TODO: b/295166196 - Delete this once `MutableMesh` uses 16-bit indices.
   static uint8_t UnpackedIndexSize(IndexFormat index_format);
 
+  // Returns the size in bytes of a single vertex index in a packed mesh.
+  static uint8_t PackedIndexSize(IndexFormat index_format);
+
   // Returns the maximum supported number of vertex attributes.
   static uint8_t MaxAttributes() { return mesh_internal::kMaxVertexAttributes; }
 
@@ -328,6 +343,7 @@ class MeshFormat {
   uint16_t packed_vertex_stride_;
   // TODO: b/295166196 - Delete this once `MutableMesh` uses 16-bit indices.
   uint8_t unpacked_index_stride_;
+  uint8_t packed_index_stride_;
 };
 
 // Attribute equivalence is more complicated than equality on the underlying
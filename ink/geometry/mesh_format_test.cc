@@ -90,6 +90,8 @@ TEST(MeshFormatTest, StringifyIndexFormat) {
             "k16BitUnpacked16BitPacked");
   EXPECT_EQ(absl::StrCat(MeshFormat::IndexFormat::k32BitUnpacked16BitPacked),
             "k32BitUnpacked16BitPacked");
+  EXPECT_EQ(absl::StrCat(MeshFormat::IndexFormat::k32BitUnpacked32BitPacked),
+            "k32BitUnpacked32BitPacked");
   EXPECT_EQ(absl::StrCat(static_cast<MeshFormat::IndexFormat>(91)),
             "Invalid(91)");
 }
@@ -124,6 +126,7 @@ TEST(MeshFormatTest, DefaultCtor) {
   EXPECT_EQ(format.GetIndexFormat(),
             MeshFormat::IndexFormat::k32BitUnpacked16BitPacked);
   EXPECT_EQ(format.UnpackedIndexStride(), 4);
+  EXPECT_EQ(format.PackedIndexStride(), 2);
 }
 
 TEST(MeshFormatTest, ConstructWithOneAttribute) {
@@ -141,6 +144,19 @@ TEST(MeshFormatTest, ConstructWithOneAttribute) {
   EXPECT_EQ(format->GetIndexFormat(),
             MeshFormat::IndexFormat::k16BitUnpacked16BitPacked);
   EXPECT_EQ(format->UnpackedIndexStride(), 2);
+  EXPECT_EQ(format->PackedIndexStride(), 2);
+}
+
+TEST(MeshFormatTest, ConstructWith32BitPackedIndices) {
+  absl::StatusOr<MeshFormat> format = MeshFormat::Create(
+      {{AttrType::kFloat2PackedInOneFloat, AttrId::kPosition}},
+      MeshFormat::IndexFormat::k32BitUnpacked32BitPacked);
+  ASSERT_THAT(format, IsOk());
+
+  EXPECT_EQ(format->GetIndexFormat(),
+            MeshFormat::IndexFormat::k32BitUnpacked32BitPacked);
+  EXPECT_EQ(format->UnpackedIndexStride(), 4);
+  EXPECT_EQ(format->PackedIndexStride(), 4);
 }
 
 TEST(MeshFormatTest, ConstructWithMultipleAttributes) {
@@ -433,6 +449,21 @@ TEST(MeshFormatTest, UnpackedIndexSize) {
   EXPECT_EQ(MeshFormat::UnpackedIndexSize(
                 MeshFormat::IndexFormat::k32BitUnpacked16BitPacked),
             4);
+  EXPECT_EQ(MeshFormat::UnpackedIndexSize(
+                MeshFormat::IndexFormat::k32BitUnpacked32BitPacked),
+            4);
+}
+
+TEST(MeshFormatTest, PackedIndexSize) {
+  EXPECT_EQ(MeshFormat::PackedIndexSize(
+                MeshFormat::IndexFormat::k16BitUnpacked16BitPacked),
+            2);
+  EXPECT_EQ(MeshFormat::PackedIndexSize(
+                MeshFormat::IndexFormat::k32BitUnpacked16BitPacked),
+            2);
+  EXPECT_EQ(MeshFormat::PackedIndexSize(
+                MeshFormat::IndexFormat::k32BitUnpacked32BitPacked),
+            4);
 }
 
 TEST(MeshFormatTest, MaxAttributes) {
@@ -20,12 +20,15 @@
 #include <cstring>
 #include <limits>
 #include <optional>
+#include <thread>
 #include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/container/inlined_vector.h"
 #include "absl/hash/hash.h"
 #include "absl/hash/hash_testing.h"
+#include "absl/log/absl_check.h"
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
 #include "absl/status/statusor.h"
@@ -34,6 +37,7 @@
 #include "ink/geometry/mesh_format.h"
 #include "ink/geometry/mesh_packing_types.h"
 #include "ink/geometry/mesh_test_helpers.h"
+#include "ink/geometry/mutable_mesh.h"
 #include "ink/geometry/point.h"
 #include "ink/geometry/rect.h"
 #include "ink/geometry/type_matchers.h"
@@ -198,6 +202,59 @@ TEST(MeshTest, CreateWithCustomFormat) {
               TriangleNear({{17, 123}, {-12, 456}, {5, 789}}, 0.082));
 }
 
+TEST(MeshTest, BulkVertexAttributeReadsMatchSingleVertexReads) {
+  absl::StatusOr<MeshFormat> format = MeshFormat::Create(
+      {{AttrType::kFloat3PackedInTwoFloats, AttrId::kCustom0},
+       {AttrType::kFloat1PackedInOneUnsignedByte, AttrId::kOpacityShift},
+       {AttrType::kFloat2PackedInOneFloat, AttrId::kPosition}},
+      MeshFormat::IndexFormat::k32BitUnpacked16BitPacked);
+  ASSERT_THAT(format, IsOk());
+  // Use enough vertices that they are packed in more than one block.
+  constexpr uint32_t kVertexCount = 600;
+  std::vector<std::vector<float>> components(6,
+                                             std::vector<float>(kVertexCount));
+  for (size_t c = 0; c < components.size(); ++c) {
+    for (uint32_t v = 0; v < kVertexCount; ++v) {
+      components[c][v] = std::sin(0.1f * v + c);
+    }
+  }
+  absl::StatusOr<Mesh> m =
+      Mesh::Create(*format,
+                   {components[0], components[1], components[2], components[3],
+                    components[4], components[5]},
+                   {0, 1, 2});
+  ASSERT_THAT(m, IsOk());
+
+  for (uint32_t attr_idx = 0; attr_idx < 3; ++attr_idx) {
+    int n_components =
+        MeshFormat::ComponentCount(format->Attributes()[attr_idx].type);
+    for (uint32_t first_vertex : {0, 1, 300}) {
+      std::vector<float> expected_floats;
+      std::vector<uint32_t> expected_integers;
+      for (uint32_t v = first_vertex; v < kVertexCount; ++v) {
+        for (float f : m->FloatVertexAttribute(v, attr_idx).Values()) {
+          expected_floats.push_back(f);
+        }
+        for (uint32_t i :
+             m->PackedIntegersForFloatVertexAttribute(v, attr_idx).Values()) {
+          expected_integers.push_back(i);
+        }
+      }
+
+      std::vector<float> floats((kVertexCount - first_vertex) * n_components);
+      m->FloatVertexAttributes(first_vertex, attr_idx, absl::MakeSpan(floats));
+      EXPECT_THAT(floats, ElementsAreArray(expected_floats))
+          << "attribute " << attr_idx << ", first vertex " << first_vertex;
+
+      std::vector<uint32_t> integers(floats.size());
+      m->PackedIntegersForFloatVertexAttributes(first_vertex, attr_idx,
+                                                absl::MakeSpan(integers));
+      EXPECT_THAT(integers, ElementsAreArray(expected_integers))
+          << "attribute " << attr_idx << ", first vertex " << first_vertex;
+    }
+  }
+}
+
 TEST(MeshTest, CreateEmptyMeshWithDefaultFormat) {
   absl::StatusOr<Mesh> m = Mesh::Create(MeshFormat(), {{}, {}}, {});
   ASSERT_THAT(m, IsOk());
@@ -1046,5 +1103,86 @@ TEST(MeshTest, SetCachedRenderingData) {
   EXPECT_TRUE(mesh.HasCachedRenderingData<float>());
 }
 
+
+// Returns the single `Mesh` made from a coiled ring with `format`.
+Mesh MakeCoiledRingMesh(const MeshFormat& format) {
+  absl::StatusOr<absl::InlinedVector<Mesh, 1>> meshes =
+      MakeCoiledRingMutableMesh(600, 20, format).AsMeshes();
+  ABSL_CHECK_OK(meshes);
+  ABSL_CHECK_EQ(meshes->size(), 1u);
+  return (*meshes)[0];
+}
+
+TEST(MeshTest, VertexPositionCacheMatchesUnpackedPositions) {
+  absl::StatusOr<MeshFormat> unpacked_format = MeshFormat::Create(
+      {{AttrType::kFloat2Unpacked, AttrId::kPosition}},
+      MeshFormat::IndexFormat::k32BitUnpacked16BitPacked);
+  ASSERT_THAT(unpacked_format, IsOk());
+  for (const MeshFormat& format :
+       {MeshFormat(), MakeSinglePackedPositionFormat(), *unpacked_format}) {
+    Mesh uncached = MakeCoiledRingMesh(format);
+    Mesh cached = MakeCoiledRingMesh(format);
+    EXPECT_FALSE(cached.IsVertexPositionCacheInitialized());
+
+    cached.InitializeVertexPositionCache();
+
+    EXPECT_TRUE(cached.IsVertexPositionCacheInitialized());
+    EXPECT_FALSE(uncached.IsVertexPositionCacheInitialized());
+    ASSERT_EQ(cached.VertexCount(), uncached.VertexCount());
+    for (uint32_t i = 0; i < cached.VertexCount(); ++i) {
+      EXPECT_THAT(cached.VertexPosition(i),
+                  PointEq(uncached.VertexPosition(i)))
+          << "vertex " << i;
+    }
+    for (uint32_t i = 0; i < cached.TriangleCount(); ++i) {
+      EXPECT_THAT(cached.GetTriangle(i), TriangleEq(uncached.GetTriangle(i)))
+          << "triangle " << i;
+    }
+  }
+}
+
+TEST(MeshTest, VertexPositionCacheIsSharedBetweenCopies) {
+  Mesh mesh = MakeCoiledRingMesh(MeshFormat());
+  Mesh copy = mesh;
+
+  copy.InitializeVertexPositionCache();
+
+  EXPECT_TRUE(mesh.IsVertexPositionCacheInitialized());
+  EXPECT_TRUE(copy.IsVertexPositionCacheInitialized());
+}
+
+TEST(MeshTest, InitializeVertexPositionCacheForEmptyMesh) {
+  Mesh mesh;
+
+  mesh.InitializeVertexPositionCache();
+
+  EXPECT_TRUE(mesh.IsVertexPositionCacheInitialized());
+  EXPECT_EQ(mesh.VertexCount(), 0);
+}
+
+TEST(MeshTest, InitializeVertexPositionCacheConcurrently) {
+  Mesh mesh = MakeCoiledRingMesh(MeshFormat());
+  std::vector<Point> expected_positions;
+  for (uint32_t i = 0; i < mesh.VertexCount(); ++i) {
+    expected_positions.push_back(mesh.VertexPosition(i));
+  }
+
+  std::vector<std::vector<Point>> positions(4);
+  std::vector<std::thread> threads;
+  for (std::vector<Point>& thread_positions : positions) {
+    threads.emplace_back([&mesh, &thread_positions]() {
+      mesh.InitializeVertexPositionCache();
+      for (uint32_t i = 0; i < mesh.VertexCount(); ++i) {
+        thread_positions.push_back(mesh.VertexPosition(i));
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  for (const std::vector<Point>& thread_positions : positions) {
+    EXPECT_EQ(thread_positions, expected_positions);
+  }
+}
+
 }  // namespace
 }  // namespace ink
@@ -16,6 +16,7 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
@@ -48,6 +49,7 @@
 #include "ink/geometry/rect.h"
 #include "ink/geometry/triangle.h"
 #include "ink/geometry/vec.h"
+#include "ink/types/executor.h"
 #include "ink/types/internal/float.h"
 #include "ink/types/small_array.h"
 
@@ -73,12 +75,11 @@ MutableMesh MutableMesh::FromMesh(const Mesh& mesh) {
           mesh.FloatVertexAttribute(vertex_idx, attr_idx));
     }
   }
-  if (mesh.Format().GetIndexFormat() ==
-      MeshFormat::IndexFormat::k16BitUnpacked16BitPacked) {
+  if (mesh.IndexStride() == mutable_mesh.IndexStride()) {
     // The indices are stored in the same format in both meshes, we can just
     // copy them over directly, which is much faster.
     std::memcpy(mutable_mesh.index_data_.data(), mesh.RawIndexData().data(),
-                3 * Mesh::kBytesPerIndex * mesh.TriangleCount());
+                3 * mesh.IndexStride() * mesh.TriangleCount());
   } else {
     for (uint32_t tri_idx = 0; tri_idx < mesh.TriangleCount(); ++tri_idx) {
       mutable_mesh.SetTriangleIndices(tri_idx, mesh.TriangleIndices(tri_idx));
@@ -147,12 +148,36 @@ absl::Status MutableMesh::ValidateTriangles() const {
 
 namespace {
 
-mesh_internal::AttributeBoundsArray ComputeAttributeBoundsForPartition(
-    const MutableMesh& mesh, const mesh_internal::PartitionInfo& partition,
+// The maximum number of vertices or triangles handled by a single task when
+// running a pass of `MutableMesh::AsMeshes` on an `Executor`. This is large
+// enough that the overhead of scheduling a task is negligible in comparison.
+constexpr uint32_t kElementsPerTask = 8192;
+
+// Returns the index of the first vertex in [`begin`, `end`) that has a
+// non-finite value for any attribute not in `omit_set`, if any.
+std::optional<uint32_t> FindFirstNonFiniteVertex(
+    const MutableMesh& mesh, uint32_t begin, uint32_t end,
+    const absl::flat_hash_set<MeshFormat::AttributeId>& omit_set) {
+  absl::Span<const MeshFormat::Attribute> attributes =
+      mesh.Format().Attributes();
+  for (uint32_t vertex_idx = begin; vertex_idx < end; ++vertex_idx) {
+    for (uint32_t attr_idx = 0; attr_idx < attributes.size(); ++attr_idx) {
+      if (omit_set.contains(attributes[attr_idx].id)) continue;
+      SmallArray<float, 4> value =
+          mesh.FloatVertexAttribute(vertex_idx, attr_idx);
+      if (!absl::c_all_of(value.Values(), ink_internal::IsFinite)) {
+        return vertex_idx;
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+mesh_internal::AttributeBoundsArray ComputeAttributeBoundsForVertices(
+    const MutableMesh& mesh, absl::Span<const uint32_t> vertex_indices,
     const absl::flat_hash_set<MeshFormat::AttributeId>& omit_set) {
   constexpr float kInf = std::numeric_limits<float>::infinity();
 
-  ABSL_CHECK_GE(partition.vertex_indices.size(), 0u);
   absl::Span<const MeshFormat::Attribute> old_attributes =
       mesh.Format().Attributes();
   size_t n_old_attrs = old_attributes.size();
@@ -167,7 +192,7 @@ mesh_internal::AttributeBoundsArray ComputeAttributeBoundsForPartition(
     MeshAttributeBounds& bounds = bounds_array[new_attr_idx];
     bounds.minimum = SmallArray<float, 4>(n_components, kInf);
     bounds.maximum = SmallArray<float, 4>(n_components, -kInf);
-    for (uint32_t vertex_idx : partition.vertex_indices) {
+    for (uint32_t vertex_idx : vertex_indices) {
       SmallArray<float, 4> value =
           mesh.FloatVertexAttribute(vertex_idx, old_attr_idx);
       for (int component_idx = 0; component_idx < n_components;
@@ -298,36 +323,51 @@ Point QuantizePoint(Point p, const MeshAttributeCodingParams& packing_params) {
           quantize(packing_params.components[1], p.y)};
 }
 
-void PopulateQuantizedVertexPositions(FlippedTriangleCorrectionData& data) {
+void PopulateQuantizedVertexPositions(FlippedTriangleCorrectionData& data,
+                                      Executor& executor) {
   uint32_t n_vertices = data.mesh->VertexCount();
   data.quantized_vertex_positions.resize(n_vertices);
-  for (uint32_t i = 0; i < n_vertices; ++i) {
-    data.quantized_vertex_positions[i] =
-        QuantizePoint(data.mesh->VertexPosition(i), *data.packing_params);
-  }
+  ParallelForRanges(
+      n_vertices, kElementsPerTask, executor,
+      [&data](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+          data.quantized_vertex_positions[i] =
+              QuantizePoint(data.mesh->VertexPosition(i), *data.packing_params);
+        }
+      });
 }
 
-void PopulateFlippedTris(FlippedTriangleCorrectionData& data) {
+void PopulateFlippedTris(FlippedTriangleCorrectionData& data,
+                         Executor& executor) {
   uint32_t n_triangles = data.mesh->TriangleCount();
   data.tri_flip_states.resize(n_triangles);
+  ParallelForRanges(
+      n_triangles, kElementsPerTask, executor,
+      [&data](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+          std::array<uint32_t, 3> indices = data.mesh->TriangleIndices(i);
+          Triangle t{data.quantized_vertex_positions[indices[0]],
+                     data.quantized_vertex_positions[indices[1]],
+                     data.quantized_vertex_positions[indices[2]]};
+          // Because `MutableMesh::AsMeshes` has already checked that the
+          // pre-quantization triangles all has non-negative area, we only need
+          // to check the post-quantization triangles here.
+          data.tri_flip_states[i] = t.SignedArea() < 0
+                                        ? TriFlipState::kFlipped
+                                        : TriFlipState::kNotFlipped;
+        }
+      });
+  // The queue is filled afterwards, so that it is in order of increasing
+  // triangle index regardless of how the tasks above were run.
   for (uint32_t i = 0; i < n_triangles; ++i) {
-    std::array<uint32_t, 3> indices = data.mesh->TriangleIndices(i);
-    Triangle t{data.quantized_vertex_positions[indices[0]],
-               data.quantized_vertex_positions[indices[1]],
-               data.quantized_vertex_positions[indices[2]]};
-    // Because `MutableMesh::AsMeshes` has already checked that the
-    // pre-quantization triangles all has non-negative area, we only need to
-    // check the post-quantization triangles here.
-    if (t.SignedArea() < 0) {
+    if (data.tri_flip_states[i] == TriFlipState::kFlipped) {
       data.flipped_tri_queue.push_back(i);
-      data.tri_flip_states[i] = TriFlipState::kFlipped;
-    } else {
-      data.tri_flip_states[i] = TriFlipState::kNotFlipped;
     }
   }
 }
 
-void PopulateAdjacentTriangleMap(FlippedTriangleCorrectionData& data) {
+void PopulateAdjacentTriangleMap(FlippedTriangleCorrectionData& data,
+                                 Executor& executor) {
   uint32_t n_vertices = data.mesh->VertexCount();
   uint32_t n_triangles = data.mesh->TriangleCount();
   std::vector<absl::InlinedVector<uint32_t, 3>> vertex_to_tris;
@@ -338,16 +378,22 @@ void PopulateAdjacentTriangleMap(FlippedTriangleCorrectionData& data) {
     }
   }
   data.adjacent_triangles.resize(n_triangles);
-  for (uint32_t tri_idx = 0; tri_idx < n_triangles; ++tri_idx) {
-    auto inserter = std::inserter(data.adjacent_triangles[tri_idx],
-                                  data.adjacent_triangles[tri_idx].end());
-    for (uint32_t vtx_idx : data.mesh->TriangleIndices(tri_idx)) {
-      absl::c_copy(vertex_to_tris[vtx_idx], inserter);
-    }
-
-    // We don't consider a triangle to be adjacent to itself.
-    data.adjacent_triangles[tri_idx].erase(tri_idx);
-  }
+  // Each set is built by a single task, with the same sequence of insertions
+  // as when run serially.
+  ParallelForRanges(
+      n_triangles, kElementsPerTask, executor,
+      [&data, &vertex_to_tris](uint32_t begin, uint32_t end) {
+        for (uint32_t tri_idx = begin; tri_idx < end; ++tri_idx) {
+          auto inserter = std::inserter(data.adjacent_triangles[tri_idx],
+                                        data.adjacent_triangles[tri_idx].end());
+          for (uint32_t vtx_idx : data.mesh->TriangleIndices(tri_idx)) {
+            absl::c_copy(vertex_to_tris[vtx_idx], inserter);
+          }
+
+          // We don't consider a triangle to be adjacent to itself.
+          data.adjacent_triangles[tri_idx].erase(tri_idx);
+        }
+      });
 }
 
 Rect CalculateQuantizationBounds(const FlippedTriangleCorrectionData& data,
@@ -596,7 +642,8 @@ void RecordCorrectionAndAddNewFlippedTrisToQueue(
 // no correction can be found, this will return an empty map, allowing
 // `MutableMesh::AsMeshes` to continue.
 absl::flat_hash_map<uint32_t, Point> GetCorrectedPackedVertexPositions(
-    const MutableMesh& mesh, const MeshAttributeCodingParams packing_params) {
+    const MutableMesh& mesh, const MeshAttributeCodingParams packing_params,
+    Executor& executor) {
   std::optional<SmallArray<uint8_t, 4>> bits_per_component =
       MeshFormat::PackedBitsPerComponent(
           mesh.Format().Attributes()[mesh.VertexPositionAttributeIndex()].type);
@@ -606,23 +653,30 @@ absl::flat_hash_map<uint32_t, Point> GetCorrectedPackedVertexPositions(
 
   // If the mesh already has triangles with negative area, we don't attempt to
   // correct quantization errors.
-  for (uint32_t tri_idx = 0; tri_idx < mesh.TriangleCount(); ++tri_idx) {
-    if (mesh.GetTriangle(tri_idx).SignedArea() < 0) {
-      return {};
-    }
-  }
+  std::atomic<bool> has_negative_area = false;
+  ParallelForRanges(
+      mesh.TriangleCount(), kElementsPerTask, executor,
+      [&mesh, &has_negative_area](uint32_t begin, uint32_t end) {
+        for (uint32_t tri_idx = begin; tri_idx < end; ++tri_idx) {
+          if (mesh.GetTriangle(tri_idx).SignedArea() < 0) {
+            has_negative_area = true;
+            return;
+          }
+        }
+      });
+  if (has_negative_area) return {};
 
   FlippedTriangleCorrectionData data = {
       .mesh = &mesh,
       .packing_params = &packing_params,
   };
-  PopulateQuantizedVertexPositions(data);
-  PopulateFlippedTris(data);
+  PopulateQuantizedVertexPositions(data, executor);
+  PopulateFlippedTris(data, executor);
 
   // If no triangles were flipped, then we don't need to correct any vertices.
   if (data.flipped_tri_queue.empty()) return {};
 
-  PopulateAdjacentTriangleMap(data);
+  PopulateAdjacentTriangleMap(data, executor);
   data.quantization_bounds =
       CalculateQuantizationBounds(data, *bits_per_component);
 
@@ -690,7 +744,8 @@ absl::flat_hash_map<uint32_t, Point> GetCorrectedPackedVertexPositions(
 
 absl::StatusOr<absl::InlinedVector<Mesh, 1>> MutableMesh::AsMeshes(
     absl::Span<const std::optional<MeshAttributeCodingParams>> packing_params,
-    absl::Span<const MeshFormat::AttributeId> omit_attributes) const {
+    absl::Span<const MeshFormat::AttributeId> omit_attributes,
+    Executor& executor) const {
   uint32_t n_triangles = TriangleCount();
   if (n_triangles == 0) {
     // There's nothing to partition, just return an empty list.
@@ -706,8 +761,27 @@ absl::StatusOr<absl::InlinedVector<Mesh, 1>> MutableMesh::AsMeshes(
 
   uint32_t n_vertices = VertexCount();
   uint32_t n_attrs = format_.Attributes().size();
-  for (uint32_t vertex_idx = 0; vertex_idx < n_vertices; ++vertex_idx) {
-    for (uint32_t attr_idx = 0; attr_idx < n_attrs; ++attr_idx) {
+  {
+    // Each task finds the first non-finite vertex in its range; the error is
+    // reported for the first of those, as it would be by a serial search.
+    std::vector<uint32_t> first_non_finite_vertices(
+        (uint64_t{n_vertices} + kElementsPerTask - 1) / kElementsPerTask,
+        n_vertices);
+    ParallelForRanges(
+        n_vertices, kElementsPerTask, executor,
+        [this, &omit_set, &first_non_finite_vertices](uint32_t begin,
+                                                      uint32_t end) {
+          if (std::optional<uint32_t> vertex_idx =
+                  FindFirstNonFiniteVertex(*this, begin, end, omit_set)) {
+            first_non_finite_vertices[begin / kElementsPerTask] = *vertex_idx;
+          }
+        });
+    uint32_t vertex_idx = n_vertices;
+    if (!first_non_finite_vertices.empty()) {
+      vertex_idx = *absl::c_min_element(first_non_finite_vertices);
+    }
+    for (uint32_t attr_idx = 0; vertex_idx < n_vertices && attr_idx < n_attrs;
+         ++attr_idx) {
       if (omit_set.contains(format_.Attributes()[attr_idx].id)) continue;
       SmallArray<float, 4> value = FloatVertexAttribute(vertex_idx, attr_idx);
       if (!absl::c_all_of(value.Values(), ink_internal::IsFinite)) {
@@ -723,15 +797,47 @@ absl::StatusOr<absl::InlinedVector<Mesh, 1>> MutableMesh::AsMeshes(
   // we have vertices.
   ABSL_DCHECK_GT(n_vertices, 0);
 
-  constexpr uint32_t kMaxVerticesPerPartition = 1 << 8 * Mesh::kBytesPerIndex;
+  const uint64_t max_vertices_per_partition =
+      uint64_t{1} << (8 * format_.PackedIndexStride());
   absl::InlinedVector<mesh_internal::PartitionInfo, 1> partitions =
       mesh_internal::PartitionTriangles(index_data_, format_.GetIndexFormat(),
-                                        kMaxVerticesPerPartition);
+                                        max_vertices_per_partition);
+
+  // The per-vertex passes below are split into chunks of at most
+  // `kElementsPerTask` vertices of a single partition.
+  struct VertexChunk {
+    size_t partition_idx;
+    absl::Span<const uint32_t> vertex_indices;
+  };
+  std::vector<VertexChunk> vertex_chunks;
+  absl::InlinedVector<size_t, 1> first_chunk_of_partition;
+  first_chunk_of_partition.reserve(partitions.size() + 1);
+  for (size_t i = 0; i < partitions.size(); ++i) {
+    first_chunk_of_partition.push_back(vertex_chunks.size());
+    absl::Span<const uint32_t> vertex_indices = partitions[i].vertex_indices;
+    for (size_t begin = 0; begin < vertex_indices.size();
+         begin += kElementsPerTask) {
+      vertex_chunks.push_back(
+          {.partition_idx = i,
+           .vertex_indices = vertex_indices.subspan(begin, kElementsPerTask)});
+    }
+  }
+  first_chunk_of_partition.push_back(vertex_chunks.size());
+
+  std::vector<mesh_internal::AttributeBoundsArray> chunk_attribute_bounds(
+      vertex_chunks.size());
+  executor.ParallelFor(vertex_chunks.size(), [&](size_t chunk_idx) {
+    chunk_attribute_bounds[chunk_idx] = ComputeAttributeBoundsForVertices(
+        *this, vertex_chunks[chunk_idx].vertex_indices, omit_set);
+  });
   absl::InlinedVector<mesh_internal::AttributeBoundsArray, 1>
       partition_attribute_bounds(partitions.size());
   for (size_t i = 0; i < partitions.size(); ++i) {
-    partition_attribute_bounds[i] =
-        ComputeAttributeBoundsForPartition(*this, partitions[i], omit_set);
+    size_t n_chunks =
+        first_chunk_of_partition[i + 1] - first_chunk_of_partition[i];
+    partition_attribute_bounds[i] = ComputeTotalAttributeBounds(
+        absl::MakeConstSpan(chunk_attribute_bounds)
+            .subspan(first_chunk_of_partition[i], n_chunks));
   }
 
   // We use the total bounds to compute the packing params for all partitions so
@@ -746,30 +852,53 @@ absl::StatusOr<absl::InlinedVector<Mesh, 1>> MutableMesh::AsMeshes(
   // for flipped triangles by retrying with a different scaling factor.
   absl::flat_hash_map<uint32_t, Point> corrected_vertex_positions =
       GetCorrectedPackedVertexPositions(
-          *this, packing_params_array[new_format.PositionAttributeIndex()]);
-
-  absl::InlinedVector<Mesh, 1> meshes;
-  for (size_t partition_idx = 0; partition_idx < partitions.size();
-       ++partition_idx) {
+          *this, packing_params_array[new_format.PositionAttributeIndex()],
+          executor);
+
+  // Packed vertices are contiguous, so the packed data for a partition is the
+  // concatenation of the packed data for its chunks.
+  std::vector<std::vector<std::byte>> chunk_vertex_data(vertex_chunks.size());
+  executor.ParallelFor(vertex_chunks.size(), [&](size_t chunk_idx) {
+    chunk_vertex_data[chunk_idx] = mesh_internal::CopyAndPackPartitionVertices(
+        vertex_data_, vertex_chunks[chunk_idx].vertex_indices, format_,
+        omit_set, packing_params_array, corrected_vertex_positions);
+  });
+
+  std::vector<std::vector<std::byte>> partition_vertex_data(partitions.size());
+  std::vector<std::vector<std::byte>> partition_index_data(partitions.size());
+  executor.ParallelFor(partitions.size(), [&](size_t partition_idx) {
     const mesh_internal::PartitionInfo& partition = partitions[partition_idx];
-    std::vector<std::byte> partition_vertex_data =
-        mesh_internal::CopyAndPackPartitionVertices(
-            vertex_data_, partition.vertex_indices, format_, omit_set,
-            packing_params_array, corrected_vertex_positions);
+    std::vector<std::byte>& vertex_data = partition_vertex_data[partition_idx];
+    for (size_t chunk_idx = first_chunk_of_partition[partition_idx];
+         chunk_idx < first_chunk_of_partition[partition_idx + 1];
+         ++chunk_idx) {
+      if (vertex_data.empty()) {
+        vertex_data = std::move(chunk_vertex_data[chunk_idx]);
+      } else {
+        vertex_data.insert(vertex_data.end(),
+                           chunk_vertex_data[chunk_idx].begin(),
+                           chunk_vertex_data[chunk_idx].end());
+      }
+    }
 
-    std::vector<std::byte> partition_index_data(3 * partition.triangles.size() *
-                                                Mesh::kBytesPerIndex);
+    std::vector<std::byte>& index_data = partition_index_data[partition_idx];
+    index_data.resize(3 * partition.triangles.size() *
+                      new_format.PackedIndexStride());
     for (uint32_t tri_idx = 0; tri_idx < partition.triangles.size();
          ++tri_idx) {
       mesh_internal::WriteTriangleIndicesToByteArray(
-          tri_idx, Mesh::kBytesPerIndex, partition.triangles[tri_idx],
-          partition_index_data);
+          tri_idx, new_format.PackedIndexStride(), partition.triangles[tri_idx],
+          index_data);
     }
+  });
 
+  absl::InlinedVector<Mesh, 1> meshes;
+  for (size_t partition_idx = 0; partition_idx < partitions.size();
+       ++partition_idx) {
     meshes.push_back(Mesh(new_format, packing_params_array,
                           std::move(partition_attribute_bounds[partition_idx]),
-                          std::move(partition_vertex_data),
-                          std::move(partition_index_data)));
+                          std::move(partition_vertex_data[partition_idx]),
+                          std::move(partition_index_data[partition_idx])));
   }
 
   return meshes;
@@ -34,6 +34,7 @@
 #include "ink/geometry/mesh_packing_types.h"
 #include "ink/geometry/point.h"
 #include "ink/geometry/triangle.h"
+#include "ink/types/executor.h"
 #include "ink/types/small_array.h"
 
 namespace ink {
@@ -278,6 +279,10 @@ class MutableMesh {
   // `MeshFormat::AttributeType`). Note that this does not always succeed, so
   // the result may still contain triangles with negative area.
   //
+  // The per-vertex and per-triangle passes of this conversion are split into
+  // tasks that are run on `executor`. The result does not depend on which
+  // `Executor` is used.
+  //
   // Returns an error if:
   // - `ValidateTriangleIndices` fails
   // - Any attribute value is non-finite
@@ -293,7 +298,8 @@ class MutableMesh {
   absl::StatusOr<absl::InlinedVector<Mesh, 1>> AsMeshes(
       absl::Span<const std::optional<MeshAttributeCodingParams>>
           packing_params = {},
-      absl::Span<const MeshFormat::AttributeId> omit_attributes = {}) const;
+      absl::Span<const MeshFormat::AttributeId> omit_attributes = {},
+      Executor& executor = SerialExecutor()) const;
 
   // Returns the format of the mesh.
   const MeshFormat& Format() const { return format_; }
@@ -13,7 +13,9 @@
 // limitations under the License.
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
+#include <utility>
 #include <vector>
 
 #include "benchmark/benchmark.h"
@@ -22,9 +24,13 @@
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
 #include "ink/geometry/mesh.h"
+#include "ink/geometry/mesh_format.h"
 #include "ink/geometry/mesh_test_helpers.h"
 #include "ink/geometry/mutable_mesh.h"
 #include "ink/geometry/point.h"
+#include "ink/geometry/rect.h"
+#include "ink/geometry/vec.h"
+#include "ink/types/executor.h"
 #include "ink/types/small_array.h"
 
 namespace ink {
@@ -115,5 +121,108 @@ void BM_CreateMeshIncrementally(benchmark::State& state) {
 }
 BENCHMARK(BM_CreateMeshIncrementally)->DenseRange(0, kTestMeshFiles.size() - 1);
 
+// Returns a `MutableMesh` with the given index format, containing
+// `repeat_count` copies of the test mesh `filename` laid end to end, to stand
+// in for a long stroke.
+MutableMesh MakeLongMutableMesh(absl::string_view filename,
+                                uint32_t repeat_count,
+                                MeshFormat::IndexFormat index_format) {
+  absl::StatusOr<Mesh> mesh = LoadMesh(filename);
+  ABSL_CHECK_OK(mesh);
+  std::vector<std::pair<MeshFormat::AttributeType, MeshFormat::AttributeId>>
+      attributes;
+  for (const MeshFormat::Attribute& attribute : mesh->Format().Attributes()) {
+    attributes.push_back({attribute.type, attribute.id});
+  }
+  absl::StatusOr<MeshFormat> format =
+      MeshFormat::Create(attributes, index_format);
+  ABSL_CHECK_OK(format);
+
+  MutableMesh mutable_mesh(*format);
+  uint32_t n_attrs = attributes.size();
+  uint32_t position_index = format->PositionAttributeIndex();
+  float width = mesh->Bounds().AsRect()->Width();
+  for (uint32_t copy = 0; copy < repeat_count; ++copy) {
+    uint32_t first_vertex = mutable_mesh.VertexCount();
+    Vec offset = {copy * width, 0};
+    for (uint32_t v = 0; v < mesh->VertexCount(); ++v) {
+      mutable_mesh.AppendVertex(mesh->VertexPosition(v) + offset);
+      for (uint32_t a = 0; a < n_attrs; ++a) {
+        if (a == position_index) continue;
+        mutable_mesh.SetFloatVertexAttribute(first_vertex + v, a,
+                                             mesh->FloatVertexAttribute(v, a));
+      }
+    }
+    for (uint32_t t = 0; t < mesh->TriangleCount(); ++t) {
+      std::array<uint32_t, 3> indices = mesh->TriangleIndices(t);
+      mutable_mesh.AppendTriangleIndices({first_vertex + indices[0],
+                                          first_vertex + indices[1],
+                                          first_vertex + indices[2]});
+    }
+  }
+  return mutable_mesh;
+}
+
+// Compares converting a long mesh to 16-bit indexed `Mesh`es, which requires
+// splitting it into partitions with duplicated vertices, to converting it to a
+// single 32-bit indexed `Mesh`.
+void BM_AsMeshesForLongMesh(benchmark::State& state) {
+  absl::string_view filename = kTestMeshFiles[state.range(0)];
+  uint32_t repeat_count = state.range(1);
+  MeshFormat::IndexFormat index_format =
+      state.range(2) == 32 ? MeshFormat::IndexFormat::k32BitUnpacked32BitPacked
+                           : MeshFormat::IndexFormat::k32BitUnpacked16BitPacked;
+  state.SetLabel(absl::StrFormat("mesh: %s x %d, %d-bit indices", filename,
+                                 repeat_count, state.range(2)));
+  MutableMesh mutable_mesh =
+      MakeLongMutableMesh(filename, repeat_count, index_format);
+
+  size_t partition_count = 0;
+  size_t packed_vertex_count = 0;
+  for (auto s : state) {
+    auto meshes = mutable_mesh.AsMeshes();
+    ABSL_CHECK_OK(meshes);
+    partition_count = meshes->size();
+    packed_vertex_count = 0;
+    for (const Mesh& mesh : *meshes) packed_vertex_count += mesh.VertexCount();
+    benchmark::DoNotOptimize(meshes);
+  }
+  state.counters["vertices"] = mutable_mesh.VertexCount();
+  state.counters["partitions"] = partition_count;
+  state.counters["packed_vertices"] = packed_vertex_count;
+}
+BENCHMARK(BM_AsMeshesForLongMesh)
+    ->ArgsProduct({benchmark::CreateDenseRange(0, kTestMeshFiles.size() - 1,
+                                               /*step=*/1),
+                   {1, 64, 256},
+                   {16, 32}});
+
+// Measures converting a long mesh on a `ThreadExecutor` with the given maximum
+// number of threads.
+void BM_AsMeshesWithThreadExecutor(benchmark::State& state) {
+  absl::string_view filename = kTestMeshFiles[state.range(0)];
+  uint32_t repeat_count = state.range(1);
+  int max_threads = state.range(2);
+  state.SetLabel(absl::StrFormat("mesh: %s x %d, %d threads", filename,
+                                 repeat_count, max_threads));
+  MutableMesh mutable_mesh = MakeLongMutableMesh(
+      filename, repeat_count,
+      MeshFormat::IndexFormat::k32BitUnpacked16BitPacked);
+
+  ThreadExecutor executor(max_threads);
+  for (auto s : state) {
+    auto meshes = mutable_mesh.AsMeshes({}, {}, executor);
+    ABSL_CHECK_OK(meshes);
+    benchmark::DoNotOptimize(meshes);
+  }
+  state.counters["vertices"] = mutable_mesh.VertexCount();
+}
+BENCHMARK(BM_AsMeshesWithThreadExecutor)
+    ->ArgsProduct({benchmark::CreateDenseRange(0, kTestMeshFiles.size() - 1,
+                                               /*step=*/1),
+                   {16, 256},
+                   {1, 2, 4}})
+    ->UseRealTime();
+
 }  // namespace
 }  // namespace ink
@@ -42,6 +42,7 @@
 #include "ink/geometry/rect.h"
 #include "ink/geometry/triangle.h"
 #include "ink/geometry/type_matchers.h"
+#include "ink/types/executor.h"
 #include "ink/types/small_array.h"
 
 namespace ink {
@@ -1998,6 +1999,70 @@ FUZZ_TEST(MutableMeshTest, AsMeshesDoesNotFailForValidMutableMesh)
     .WithDomains(ValidPackableNonEmptyPositionOnlyMutableMesh(
         MeshFormat::AttributeType::kFloat2PackedInOneFloat));
 
+void AsMeshesWithThreadExecutorMatchesSerial(const MutableMesh& mesh) {
+  absl::StatusOr<absl::InlinedVector<Mesh, 1>> serial_meshes =
+      mesh.AsMeshes();
+  ASSERT_THAT(serial_meshes, IsOk());
+  ThreadExecutor executor(4);
+  absl::StatusOr<absl::InlinedVector<Mesh, 1>> parallel_meshes =
+      mesh.AsMeshes({}, {}, executor);
+  ASSERT_THAT(parallel_meshes, IsOk());
+  ASSERT_EQ(parallel_meshes->size(), serial_meshes->size());
+  for (size_t i = 0; i < serial_meshes->size(); ++i) {
+    EXPECT_THAT((*parallel_meshes)[i], MeshEq((*serial_meshes)[i]))
+        << "mesh " << i;
+    EXPECT_THAT((*parallel_meshes)[i].RawVertexData(),
+                ElementsAreArray((*serial_meshes)[i].RawVertexData()))
+        << "mesh " << i;
+  }
+}
+FUZZ_TEST(MutableMeshTest, AsMeshesWithThreadExecutorMatchesSerial)
+    .WithDomains(ValidPackableNonEmptyPositionOnlyMutableMesh(
+        MeshFormat::AttributeType::kFloat2PackedInOneFloat));
+
+TEST(MutableMeshTest, AsMeshesWithThreadExecutorMatchesSerialForLargeMesh) {
+  // This is large enough to be split into multiple partitions, each of which
+  // is split into multiple tasks.
+  AsMeshesWithThreadExecutorMatchesSerial(
+      MakeStraightLineMutableMesh(1e5, MakeSinglePackedPositionFormat()));
+}
+
+TEST(MutableMeshTest,
+     AsMeshesWithThreadExecutorMatchesSerialWithFlippedTriangles) {
+  // This contains many copies of the flipped triangle from
+  // AsMeshesCorrectsSingleFlippedTriangle, each with their own vertices.
+  MutableMesh mesh(MakeSinglePackedPositionFormat());
+  mesh.AppendVertex({0, 0});
+  mesh.AppendVertex({4095, 0});
+  mesh.AppendVertex({4095, 4095});
+  mesh.AppendTriangleIndices({0, 1, 2});
+  for (uint32_t i = 0; i < 10000; ++i) {
+    uint32_t first_vertex = mesh.VertexCount();
+    mesh.AppendVertex({0.4, 0.6});
+    mesh.AppendVertex({3967.4, 4094.6});
+    mesh.AppendVertex({793.73, 819.47});
+    mesh.AppendTriangleIndices(
+        {first_vertex, first_vertex + 1, first_vertex + 2});
+  }
+  AsMeshesWithThreadExecutorMatchesSerial(mesh);
+
+  absl::StatusOr<absl::InlinedVector<Mesh, 1>> meshes = mesh.AsMeshes();
+  ASSERT_THAT(meshes, IsOkAndHolds(SizeIs(1)));
+  EXPECT_THAT((*meshes)[0], MeshTrianglesHaveNonNegativeArea());
+}
+
+TEST(MutableMeshTest, AsMeshesWithThreadExecutorReportsFirstNonFiniteVertex) {
+  MutableMesh mesh =
+      MakeStraightLineMutableMesh(1e5, MakeSinglePackedPositionFormat());
+  mesh.SetVertexPosition(90000, {std::nanf(""), 0});
+  mesh.SetVertexPosition(20000, {std::nanf(""), 0});
+
+  ThreadExecutor executor(4);
+  EXPECT_THAT(mesh.AsMeshes({}, {}, executor),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("vertex 20000 has non-finite value")));
+}
+
 TEST(MutableMeshDeathTest, VertexIndexOutOfBounds) {
   // There is no EXPECT_DEBUG_DEATH_IF_SUPPORTED, so we only run these when
   // compiled in debug mode.
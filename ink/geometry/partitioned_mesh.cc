@@ -14,6 +14,8 @@
 
 #include "ink/geometry/partitioned_mesh.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
@@ -23,6 +25,7 @@
 #include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/base/nullability.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/inlined_vector.h"
@@ -37,9 +40,10 @@
 #include "ink/geometry/affine_transform.h"
 #include "ink/geometry/envelope.h"
 #include "ink/geometry/internal/algorithms.h"
+#include "ink/geometry/internal/flat_static_rtree.h"
+#include "ink/geometry/internal/index_pair_packing.h"
 #include "ink/geometry/internal/intersects_internal.h"
 #include "ink/geometry/internal/mesh_packing.h"
-#include "ink/geometry/internal/static_rtree.h"
 #include "ink/geometry/mesh.h"
 #include "ink/geometry/mesh_format.h"
 #include "ink/geometry/mesh_index_types.h"
@@ -50,11 +54,31 @@
 #include "ink/geometry/rect.h"
 #include "ink/geometry/segment.h"
 #include "ink/geometry/triangle.h"
+#include "ink/types/executor.h"
 
 namespace ink {
 
+using ::ink::geometry_internal::PackTriangleIndexPair;
+using ::ink::geometry_internal::UnpackTriangleIndexPair;
+
 // Convenience alias for the R-Tree.
-using RTree = geometry_internal::StaticRTree<TriangleIndexPair>;
+using RTree = geometry_internal::FlatStaticRTree<uint32_t>;
+
+namespace {
+
+// `PartitionedMesh` identifies vertices and triangles with 16-bit indices, as
+// do the renderers that draw it, so it can't hold meshes with 32-bit packed
+// indices.
+absl::Status ValidateIndexFormat(const MeshFormat& format) {
+  if (format.GetIndexFormat() ==
+      MeshFormat::IndexFormat::k32BitUnpacked32BitPacked) {
+    return absl::InvalidArgumentError(
+        "PartitionedMesh does not support meshes with 32-bit packed indices");
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
 
 PartitionedMesh PartitionedMesh::WithEmptyGroups(uint32_t num_groups) {
   return *PartitionedMesh::FromMeshGroups(std::vector<MeshGroup>(num_groups));
@@ -64,39 +88,30 @@ absl::StatusOr<PartitionedMesh> PartitionedMesh::FromMutableMesh(
     const MutableMesh& mesh,
     absl::Span<const absl::Span<const uint32_t>> outlines,
     absl::Span<const MeshFormat::AttributeId> omit_attributes,
-    absl::Span<const std::optional<MeshAttributeCodingParams>> packing_params) {
+    absl::Span<const std::optional<MeshAttributeCodingParams>> packing_params,
+    Executor& executor) {
   MutableMeshGroup group = {
       .mesh = &mesh,
       .outlines = outlines,
       .omit_attributes = omit_attributes,
       .packing_params = packing_params,
   };
-  return PartitionedMesh::FromMutableMeshGroups(absl::MakeConstSpan(&group, 1));
+  return PartitionedMesh::FromMutableMeshGroups(absl::MakeConstSpan(&group, 1),
+                                                executor);
 }
 
 absl::StatusOr<PartitionedMesh> PartitionedMesh::FromMutableMeshGroups(
-    absl::Span<const MutableMeshGroup> groups) {
-  std::vector<std::vector<std::vector<VertexIndexPair>>>
-      all_partitioned_outlines;
-  all_partitioned_outlines.reserve(groups.size());
-
-  std::vector<std::vector<absl::Span<const VertexIndexPair>>>
-      all_partitioned_outline_spans;
-  all_partitioned_outline_spans.reserve(groups.size());
-
+    absl::Span<const MutableMeshGroup> groups, Executor& executor) {
   std::vector<absl::InlinedVector<Mesh, 1>> all_meshes;
   all_meshes.reserve(groups.size());
 
-  std::vector<MeshGroup> mesh_groups;
-  mesh_groups.reserve(groups.size());
-
+  // The groups are validated and converted in order, so that the returned
+  // error, if any, is for the first invalid group.
   for (const MutableMeshGroup& group : groups) {
     const MutableMesh& mesh = *group.mesh;
     absl::Span<const absl::Span<const uint32_t>> outlines = group.outlines;
 
-    all_partitioned_outlines.emplace_back();
-    std::vector<std::vector<VertexIndexPair>>& group_partitioned_outlines =
-        all_partitioned_outlines.back();
+    ABSL_RETURN_IF_ERROR(ValidateIndexFormat(mesh.Format()));
 
     uint32_t n_vertices = mesh.VertexCount();
     for (uint32_t o_idx = 0; o_idx < outlines.size(); ++o_idx) {
@@ -112,70 +127,88 @@ absl::StatusOr<PartitionedMesh> PartitionedMesh::FromMutableMeshGroups(
 
     ABSL_ASSIGN_OR_RETURN(
         auto group_meshes,
-        mesh.AsMeshes(group.packing_params, group.omit_attributes));
+        mesh.AsMeshes(group.packing_params, group.omit_attributes, executor));
     all_meshes.push_back(std::move(group_meshes));
+  }
 
-    // There's a bit of performance that we're leaving on the table here:
-    // - we're computing the partitions twice (once here, once in
-    //   `MutableMesh::AsMeshes`)
-    // - we're copying the `VertexIndexPair`s into `FromMeshes`, when we could
-    //   be moving them
-    // - we're constructing the partition map even when everything fits in one
-    //   partition
-    // However, this code is already destined for the trash bin: once
-    // `MutableMesh` is changed to always use 16-bit indices (b/295166196),
-    // there will be no need to do partitioning, and this code can be deleted.
-    if (!outlines.empty()) {
-      constexpr uint32_t kMaxVerticesPerPartition = 1 << (8 * sizeof(uint16_t));
-      absl::InlinedVector<mesh_internal::PartitionInfo, 1> partitions =
-          mesh_internal::PartitionTriangles(mesh.RawIndexData(),
-                                            mesh.Format().GetIndexFormat(),
-                                            kMaxVerticesPerPartition);
-      absl::flat_hash_map<uint32_t, VertexIndexPair> partition_map;
-      partition_map.reserve(mesh.VertexCount());
-      for (size_t p_idx = 0; p_idx < partitions.size(); ++p_idx) {
-        const std::vector<uint32_t>& vertex_indices =
-            partitions[p_idx].vertex_indices;
-        for (size_t v_idx = 0; v_idx < vertex_indices.size(); ++v_idx) {
-          // This insertion may fail, since some vertices will exist in multiple
-          // partitions, but that's fine -- this just causes the outline to use
-          // the first vertex it finds.
-          partition_map.insert(
-              {vertex_indices[v_idx],
-               {.mesh_index = static_cast<uint16_t>(p_idx),
-                .vertex_index = static_cast<uint16_t>(v_idx)}});
-        }
+  // There's a bit of performance that we're leaving on the table here:
+  // - we're computing the partitions twice (once here, once in
+  //   `MutableMesh::AsMeshes`)
+  // - we're copying the `VertexIndexPair`s into `FromMeshes`, when we could
+  //   be moving them
+  // - we're constructing the partition map even when everything fits in one
+  //   partition
+  // However, this code is already destined for the trash bin: once
+  // `MutableMesh` is changed to always use 16-bit indices (b/295166196),
+  // there will be no need to do partitioning, and this code can be deleted.
+  std::vector<std::vector<std::vector<VertexIndexPair>>>
+      all_partitioned_outlines(groups.size());
+  auto partition_outlines = [&groups,
+                             &all_partitioned_outlines](size_t group_idx) {
+    const MutableMesh& mesh = *groups[group_idx].mesh;
+    absl::Span<const absl::Span<const uint32_t>> outlines =
+        groups[group_idx].outlines;
+    if (outlines.empty()) return;
+
+    std::vector<std::vector<VertexIndexPair>>& group_partitioned_outlines =
+        all_partitioned_outlines[group_idx];
+    constexpr uint32_t kMaxVerticesPerPartition = 1 << (8 * sizeof(uint16_t));
+    absl::InlinedVector<mesh_internal::PartitionInfo, 1> partitions =
+        mesh_internal::PartitionTriangles(mesh.RawIndexData(),
+                                          mesh.Format().GetIndexFormat(),
+                                          kMaxVerticesPerPartition);
+    absl::flat_hash_map<uint32_t, VertexIndexPair> partition_map;
+    partition_map.reserve(mesh.VertexCount());
+    for (size_t p_idx = 0; p_idx < partitions.size(); ++p_idx) {
+      const std::vector<uint32_t>& vertex_indices =
+          partitions[p_idx].vertex_indices;
+      for (size_t v_idx = 0; v_idx < vertex_indices.size(); ++v_idx) {
+        // This insertion may fail, since some vertices will exist in multiple
+        // partitions, but that's fine -- this just causes the outline to use
+        // the first vertex it finds.
+        partition_map.insert(
+            {vertex_indices[v_idx],
+             {.mesh_index = static_cast<uint16_t>(p_idx),
+              .vertex_index = static_cast<uint16_t>(v_idx)}});
       }
+    }
 
-      for (size_t o_idx = 0; o_idx < outlines.size(); ++o_idx) {
-        if (outlines[o_idx].empty()) continue;
-        std::vector<VertexIndexPair> outline_index_pairs;
-        outline_index_pairs.reserve(outlines[o_idx].size());
-        for (uint32_t index : outlines[o_idx]) {
-          auto it = partition_map.find(index);
-          if (it != partition_map.end()) {
-            outline_index_pairs.push_back(it->second);
-          }
-        }
-        if (outline_index_pairs.size() >= 3) {
-          group_partitioned_outlines.emplace_back(
-              std::move(outline_index_pairs));
+    for (size_t o_idx = 0; o_idx < outlines.size(); ++o_idx) {
+      if (outlines[o_idx].empty()) continue;
+      std::vector<VertexIndexPair> outline_index_pairs;
+      outline_index_pairs.reserve(outlines[o_idx].size());
+      for (uint32_t index : outlines[o_idx]) {
+        auto it = partition_map.find(index);
+        if (it != partition_map.end()) {
+          outline_index_pairs.push_back(it->second);
         }
       }
+      if (outline_index_pairs.size() >= 3) {
+        group_partitioned_outlines.emplace_back(
+            std::move(outline_index_pairs));
+      }
     }
+  };
+  executor.ParallelFor(groups.size(), partition_outlines);
 
-    std::vector<absl::Span<const VertexIndexPair>>
-        group_partitioned_outline_spans(group_partitioned_outlines.size());
+  std::vector<std::vector<absl::Span<const VertexIndexPair>>>
+      all_partitioned_outline_spans(groups.size());
+  std::vector<MeshGroup> mesh_groups;
+  mesh_groups.reserve(groups.size());
+  for (size_t g_idx = 0; g_idx < groups.size(); ++g_idx) {
+    const std::vector<std::vector<VertexIndexPair>>&
+        group_partitioned_outlines = all_partitioned_outlines[g_idx];
+    std::vector<absl::Span<const VertexIndexPair>>&
+        group_partitioned_outline_spans = all_partitioned_outline_spans[g_idx];
+    group_partitioned_outline_spans.resize(group_partitioned_outlines.size());
     for (size_t o_idx = 0; o_idx < group_partitioned_outlines.size(); ++o_idx) {
       group_partitioned_outline_spans[o_idx] =
           absl::MakeConstSpan(group_partitioned_outlines[o_idx]);
     }
-    all_partitioned_outline_spans.push_back(
-        std::move(group_partitioned_outline_spans));
 
     mesh_groups.push_back(MeshGroup{
-        .meshes = absl::MakeConstSpan(all_meshes.back()),
-        .outlines = absl::MakeConstSpan(all_partitioned_outline_spans.back()),
+        .meshes = absl::MakeConstSpan(all_meshes[g_idx]),
+        .outlines = absl::MakeConstSpan(group_partitioned_outline_spans),
     });
   }
   return FromMeshGroups(absl::MakeConstSpan(mesh_groups));
@@ -226,6 +259,7 @@ PartitionedMesh::Data::FromMeshGroups(absl::Span<const MeshGroup> groups) {
                                format, i, group.meshes[i].Format()));
         }
       }
+      ABSL_RETURN_IF_ERROR(ValidateIndexFormat(format));
       group_formats.push_back(format);
     }
 
@@ -310,7 +344,8 @@ void VisitIntersectedTrianglesHelper(
   // `AffineTransform::Apply` returns a `Quad`, not a `Rect`.
   auto transformed_query = query_to_this.Apply(query);
   auto visitor_wrapper = [transformed_query, visitor,
-                          &meshes](TriangleIndexPair index) {
+                          &meshes](uint32_t packed_index) {
+    TriangleIndexPair index = UnpackTriangleIndexPair(packed_index);
     if (!geometry_internal::IntersectsInternal(
             transformed_query,
             meshes[index.mesh_index].GetTriangle(index.triangle_index))) {
@@ -375,9 +410,100 @@ void PartitionedMesh::VisitIntersectedTriangles(
 
 namespace {
 
+// This is a helper function for `VisitIntersectedTrianglesBatch` that handles
+// the type-independent logic.
+template <typename QueryType>
+void VisitIntersectedTrianglesBatchHelper(
+    absl::Span<const QueryType> queries,
+    absl::FunctionRef<PartitionedMesh::FlowControl(size_t, TriangleIndexPair)>
+        visitor,
+    const AffineTransform& query_to_this, absl::Span<const Mesh> meshes,
+    const RTree& rtree) {
+  // As in `VisitIntersectedTrianglesHelper`, the transformed type may differ
+  // from `QueryType`.
+  using TransformedQueryType =
+      decltype(query_to_this.Apply(std::declval<const QueryType&>()));
+  std::vector<TransformedQueryType> transformed_queries;
+  transformed_queries.reserve(queries.size());
+  std::vector<Rect> query_bounds;
+  query_bounds.reserve(queries.size());
+  for (const QueryType& query : queries) {
+    transformed_queries.push_back(query_to_this.Apply(query));
+    query_bounds.push_back(*Envelope(transformed_queries.back()).AsRect());
+  }
+  auto visitor_wrapper = [&transformed_queries, visitor, &meshes](
+                             size_t query_index, uint32_t packed_index) {
+    TriangleIndexPair index = UnpackTriangleIndexPair(packed_index);
+    if (!geometry_internal::IntersectsInternal(
+            transformed_queries[query_index],
+            meshes[index.mesh_index].GetTriangle(index.triangle_index))) {
+      return true;
+    }
+    return visitor(query_index, index) ==
+           PartitionedMesh::FlowControl::kContinue;
+  };
+  rtree.VisitIntersectedElementsBatch(query_bounds, visitor_wrapper);
+}
+
+}  // namespace
+
+void PartitionedMesh::VisitIntersectedTrianglesBatch(
+    absl::Span<const Point> queries,
+    absl::FunctionRef<FlowControl(size_t, TriangleIndexPair)> visitor,
+    const AffineTransform& query_to_this) const {
+  if (!data_ || queries.empty()) return;
+
+  VisitIntersectedTrianglesBatchHelper(queries, visitor, query_to_this,
+                                       data_->Meshes(), data_->SpatialIndex());
+}
+
+void PartitionedMesh::VisitIntersectedTrianglesBatch(
+    absl::Span<const Segment> queries,
+    absl::FunctionRef<FlowControl(size_t, TriangleIndexPair)> visitor,
+    const AffineTransform& query_to_this) const {
+  if (!data_ || queries.empty()) return;
+
+  VisitIntersectedTrianglesBatchHelper(queries, visitor, query_to_this,
+                                       data_->Meshes(), data_->SpatialIndex());
+}
+
+void PartitionedMesh::VisitIntersectedTrianglesBatch(
+    absl::Span<const Triangle> queries,
+    absl::FunctionRef<FlowControl(size_t, TriangleIndexPair)> visitor,
+    const AffineTransform& query_to_this) const {
+  if (!data_ || queries.empty()) return;
+
+  VisitIntersectedTrianglesBatchHelper(queries, visitor, query_to_this,
+                                       data_->Meshes(), data_->SpatialIndex());
+}
+
+void PartitionedMesh::VisitIntersectedTrianglesBatch(
+    absl::Span<const Rect> queries,
+    absl::FunctionRef<FlowControl(size_t, TriangleIndexPair)> visitor,
+    const AffineTransform& query_to_this) const {
+  if (!data_ || queries.empty()) return;
+
+  VisitIntersectedTrianglesBatchHelper(queries, visitor, query_to_this,
+                                       data_->Meshes(), data_->SpatialIndex());
+}
+
+void PartitionedMesh::VisitIntersectedTrianglesBatch(
+    absl::Span<const Quad> queries,
+    absl::FunctionRef<FlowControl(size_t, TriangleIndexPair)> visitor,
+    const AffineTransform& query_to_this) const {
+  if (!data_ || queries.empty()) return;
+
+  VisitIntersectedTrianglesBatchHelper(queries, visitor, query_to_this,
+                                       data_->Meshes(), data_->SpatialIndex());
+}
+
+namespace {
+
 // This is a helper function for the `PartitionedMesh` overload of
 // `VisitIntersectedTriangles`, that handles the case in which the given
-// transform is invertible.
+// transform is invertible. This searches the query's R-Tree from the root for
+// each candidate triangle, so that finding the first intersection (e.g. for
+// `Intersects`) is cheap.
 void VisitIntersectedTrianglesWithPartitionedMeshWithInvertibleTransform(
     absl::Span<const Mesh> meshes, const RTree& rtree,
     const PartitionedMesh& query, const AffineTransform& query_to_target,
@@ -391,7 +517,8 @@ void VisitIntersectedTrianglesWithPartitionedMeshWithInvertibleTransform(
       *Envelope(query_to_target.Apply(*query.Bounds().AsRect())).AsRect();
 
   auto visitor_wrapper = [&meshes, &query, &target_to_query,
-                          visitor](TriangleIndexPair index) {
+                          visitor](uint32_t packed_index) {
+    TriangleIndexPair index = UnpackTriangleIndexPair(packed_index);
     // This triangle hits the bounding box of `query`, now we need to check
     // that it actually hits `query` itself. Note that we can't call
     // `IntersectsInternal` here, because it would result in a circular
@@ -416,6 +543,78 @@ void VisitIntersectedTrianglesWithPartitionedMeshWithInvertibleTransform(
   rtree.VisitIntersectedElements(query_bounds, visitor_wrapper);
 }
 
+// Like `VisitIntersectedTrianglesWithPartitionedMeshWithInvertibleTransform`,
+// but meant for visiting all or most of the intersected triangles, as e.g.
+// `Coverage` needs. This traverses both R-Trees at once, which is much faster
+// when many triangles are visited, but has a higher startup cost before the
+// first one is found.
+void VisitAllIntersectedTrianglesWithPartitionedMeshWithInvertibleTransform(
+    absl::Span<const Mesh> meshes, const RTree& rtree,
+    const PartitionedMesh& query, const RTree& query_rtree,
+    const AffineTransform& query_to_target,
+    const AffineTransform& target_to_query,
+    absl::FunctionRef<PartitionedMesh::FlowControl(TriangleIndexPair)>
+        visitor) {
+  // To find the intersected triangles, we traverse both R-Trees at once, in
+  // the query's coordinate space, to find pairs of triangles whose bounds
+  // intersect, and then test those pairs exactly. Only triangles that
+  // intersect the bounds of `query` are considered, so the checks are the
+  // same as if we had queried the target's R-Tree with the bounds of `query`,
+  // and then the query's R-Tree with each of the triangles found.
+  Rect query_bounds =
+      *Envelope(query_to_target.Apply(*query.Bounds().AsRect())).AsRect();
+
+  // This maps bounds by transforming their corners. Because floating-point
+  // rounding is monotonic, the result contains every point inside the bounds
+  // transformed with `AffineTransform::Apply`, so no pairs are missed.
+  auto target_bounds_to_query = [&target_to_query](const Rect& bounds) {
+    Envelope envelope;
+    for (Point corner : bounds.Corners()) {
+      envelope.Add(target_to_query.Apply(corner));
+    }
+    return *envelope.AsRect();
+  };
+
+  // All of the pairs for a target triangle are visited consecutively, so we
+  // only need to fetch and transform it when it changes.
+  std::optional<uint32_t> current_index;
+  TriangleIndexPair index;
+  Triangle transformed_triangle;
+  Rect transformed_triangle_bounds;
+  auto pair_visitor = [&meshes, &query, &target_to_query, &current_index,
+                       &index, &transformed_triangle,
+                       &transformed_triangle_bounds,
+                       visitor](uint32_t packed_index,
+                                uint32_t packed_query_index) {
+    if (current_index != packed_index) {
+      current_index = packed_index;
+      index = UnpackTriangleIndexPair(packed_index);
+      transformed_triangle = target_to_query.Apply(
+          meshes[index.mesh_index].GetTriangle(index.triangle_index));
+      transformed_triangle_bounds = *Envelope(transformed_triangle).AsRect();
+    }
+    TriangleIndexPair query_index = UnpackTriangleIndexPair(packed_query_index);
+    Triangle query_triangle =
+        query.Meshes()[query_index.mesh_index].GetTriangle(
+            query_index.triangle_index);
+    if (!geometry_internal::IntersectsInternal(
+            transformed_triangle_bounds, *Envelope(query_triangle).AsRect()) ||
+        !geometry_internal::IntersectsInternal(transformed_triangle,
+                                               query_triangle)) {
+      return RTree::PairFlowControl::kContinue;
+    }
+    // The target triangle should only be visited once, even if it intersects
+    // more than one query triangle.
+    if (visitor(index) == PartitionedMesh::FlowControl::kBreak) {
+      return RTree::PairFlowControl::kBreak;
+    }
+    return RTree::PairFlowControl::kNextElement;
+  };
+
+  rtree.VisitIntersectedElementPairs(query_bounds, query_rtree,
+                                     target_bounds_to_query, pair_visitor);
+}
+
 }  // namespace
 
 void PartitionedMesh::VisitIntersectedTriangles(
@@ -494,35 +693,68 @@ float PartitionedMesh::Coverage(const Quad& query,
 
 float PartitionedMesh::Coverage(const PartitionedMesh& query,
                                 const AffineTransform& query_to_this) const {
-  if (data_ == nullptr) return 0;
-  return ComputeCoverage(query, query_to_this, *this,
-                         data_->TotalAbsoluteArea());
+  if (data_ == nullptr || query.data_ == nullptr) return 0;
+  std::optional<AffineTransform> this_to_query = query_to_this.Inverse();
+  if (!this_to_query.has_value()) {
+    return ComputeCoverage(query, query_to_this, *this,
+                           data_->TotalAbsoluteArea());
+  }
+
+  // Unlike `VisitIntersectedTriangles`, this always visits every intersected
+  // triangle, so it can use the faster traversal for full enumeration.
+  float covered_area = 0;
+  VisitAllIntersectedTrianglesWithPartitionedMeshWithInvertibleTransform(
+      data_->Meshes(), data_->SpatialIndex(), query,
+      query.data_->SpatialIndex(), query_to_this, *this_to_query,
+      [this, &covered_area](TriangleIndexPair index) {
+        covered_area += std::abs(data_->Meshes()[index.mesh_index]
+                                     .GetTriangle(index.triangle_index)
+                                     .SignedArea());
+        return FlowControl::kContinue;
+      });
+  return covered_area / data_->TotalAbsoluteArea();
 }
 
 namespace {
 
 // This is a helper function for `CoverageIsGreaterThan` that contains the
-// type-independent logic for computing the area covered by the query.
+// type-independent logic for the convex query types. Sub-trees of the R-Tree
+// whose bounds are contained in the query are counted using their total area,
+// without visiting their triangles.
 template <typename QueryType>
-float CoverageIsGreaterThanHelper(const QueryType& query,
-                                  const AffineTransform& query_to_target,
-                                  const PartitionedMesh& target,
-                                  float coverage_threshold,
-                                  float total_absolute_area) {
-  float area_threshold = coverage_threshold * total_absolute_area;
-  float covered_area = 0;
-  target.VisitIntersectedTriangles(
-      query,
-      [&target, &covered_area, area_threshold](const TriangleIndexPair index) {
-        covered_area += std::abs(target.Meshes()[index.mesh_index]
-                                     .GetTriangle(index.triangle_index)
-                                     .SignedArea());
-        return covered_area > area_threshold
-                   ? PartitionedMesh::FlowControl::kBreak
-                   : PartitionedMesh::FlowControl::kContinue;
-      },
-      query_to_target);
-  return covered_area > area_threshold;
+bool CoverageIsGreaterThanHelper(const QueryType& query,
+                                 const AffineTransform& query_to_target,
+                                 absl::Span<const Mesh> meshes,
+                                 const RTree& rtree, float coverage_threshold,
+                                 float total_absolute_area) {
+  // As in `VisitIntersectedTrianglesHelper`, this may be a different type
+  // than `QueryType`. It is always convex, so it contains a rectangle iff it
+  // contains all of its corners.
+  auto transformed_query = query_to_target.Apply(query);
+  Rect query_bounds = *Envelope(transformed_query).AsRect();
+  auto bounds_relation = [&transformed_query,
+                          &query_bounds](const Rect& bounds) {
+    if (!geometry_internal::IntersectsInternal(query_bounds, bounds) ||
+        !geometry_internal::IntersectsInternal(transformed_query, bounds)) {
+      return RTree::BoundsRelation::kDisjoint;
+    }
+    for (Point corner : bounds.Corners()) {
+      if (!geometry_internal::IntersectsInternal(transformed_query, corner)) {
+        return RTree::BoundsRelation::kIntersecting;
+      }
+    }
+    return RTree::BoundsRelation::kContained;
+  };
+  auto intersects_triangle = [&transformed_query,
+                              &meshes](uint32_t packed_index) {
+    TriangleIndexPair index = UnpackTriangleIndexPair(packed_index);
+    return geometry_internal::IntersectsInternal(
+        transformed_query,
+        meshes[index.mesh_index].GetTriangle(index.triangle_index));
+  };
+  return rtree.WeightOfIntersectedElementsIsGreaterThan(
+      coverage_threshold * total_absolute_area, bounds_relation,
+      intersects_triangle);
 }
 
 }  // namespace
@@ -531,58 +763,282 @@ bool PartitionedMesh::CoverageIsGreaterThan(
     const Triangle& query, float coverage_threshold,
     const AffineTransform& query_to_this) const {
   if (data_ == nullptr) return false;
-  return CoverageIsGreaterThanHelper(query, query_to_this, *this,
-                                     coverage_threshold,
-                                     data_->TotalAbsoluteArea());
+  return CoverageIsGreaterThanHelper(
+      query, query_to_this, data_->Meshes(), data_->SpatialIndex(),
+      coverage_threshold, data_->TotalAbsoluteArea());
 }
 
 bool PartitionedMesh::CoverageIsGreaterThan(
     const Rect& query, float coverage_threshold,
     const AffineTransform& query_to_this) const {
   if (data_ == nullptr) return false;
-  return CoverageIsGreaterThanHelper(query, query_to_this, *this,
-                                     coverage_threshold,
-                                     data_->TotalAbsoluteArea());
+  return CoverageIsGreaterThanHelper(
+      query, query_to_this, data_->Meshes(), data_->SpatialIndex(),
+      coverage_threshold, data_->TotalAbsoluteArea());
 }
 
 bool PartitionedMesh::CoverageIsGreaterThan(
     const Quad& query, float coverage_threshold,
     const AffineTransform& query_to_this) const {
   if (data_ == nullptr) return false;
-  return CoverageIsGreaterThanHelper(query, query_to_this, *this,
-                                     coverage_threshold,
-                                     data_->TotalAbsoluteArea());
+  return CoverageIsGreaterThanHelper(
+      query, query_to_this, data_->Meshes(), data_->SpatialIndex(),
+      coverage_threshold, data_->TotalAbsoluteArea());
 }
 
 bool PartitionedMesh::CoverageIsGreaterThan(
     const PartitionedMesh& query, float coverage_threshold,
     const AffineTransform& query_to_this) const {
   if (data_ == nullptr) return false;
-  return CoverageIsGreaterThanHelper(query, query_to_this, *this,
-                                     coverage_threshold,
-                                     data_->TotalAbsoluteArea());
+  float area_threshold = coverage_threshold * data_->TotalAbsoluteArea();
+  if (query.data_ == nullptr) return 0 > area_threshold;
+
+  // The triangles that intersect the bounds of `query` give an upper bound on
+  // the covered area, which is cheap to compute using the areas stored in the
+  // R-Tree. If that isn't enough, we don't need to check the triangles.
+  Rect query_bounds =
+      *Envelope(query_to_this.Apply(*query.Bounds().AsRect())).AsRect();
+  if (!data_->SpatialIndex().WeightOfIntersectedElementsIsGreaterThan(
+          area_threshold,
+          [&query_bounds](const Rect& bounds) {
+            if (!geometry_internal::IntersectsInternal(query_bounds, bounds)) {
+              return RTree::BoundsRelation::kDisjoint;
+            }
+            return query_bounds.Contains(bounds)
+                       ? RTree::BoundsRelation::kContained
+                       : RTree::BoundsRelation::kIntersecting;
+          },
+          [](uint32_t) { return true; })) {
+    return false;
+  }
+
+  // Otherwise, a large part of the triangles near `query` usually has to be
+  // visited before the threshold is reached, so this uses the same traversal
+  // as `Coverage`, stopping once the threshold is exceeded.
+  float covered_area = 0;
+  auto visitor = [this, &covered_area,
+                  area_threshold](const TriangleIndexPair index) {
+    covered_area += std::abs(data_->Meshes()[index.mesh_index]
+                                 .GetTriangle(index.triangle_index)
+                                 .SignedArea());
+    return covered_area > area_threshold ? FlowControl::kBreak
+                                         : FlowControl::kContinue;
+  };
+  std::optional<AffineTransform> this_to_query = query_to_this.Inverse();
+  if (this_to_query.has_value()) {
+    VisitAllIntersectedTrianglesWithPartitionedMeshWithInvertibleTransform(
+        data_->Meshes(), data_->SpatialIndex(), query,
+        query.data_->SpatialIndex(), query_to_this, *this_to_query, visitor);
+  } else {
+    VisitIntersectedTriangles(query, visitor, query_to_this);
+  }
+  return covered_area > area_threshold;
+}
+
+namespace {
+
+// Returns the distance from `point` to `segment`.
+float PointSegmentDistance(Point point, const Segment& segment) {
+  std::optional<float> projection = segment.Project(point);
+  if (!projection.has_value()) {
+    // The segment is (nearly) point-like, so the nearest point on it is one
+    // of its endpoints.
+    return std::min((point - segment.start).Magnitude(),
+                    (point - segment.end).Magnitude());
+  }
+  return (point - segment.Lerp(std::clamp(*projection, 0.f, 1.f)))
+      .Magnitude();
+}
+
+// Returns the distance from `point` to `triangle`. This is equivalent to
+// `Distance(point, triangle)`, which can't be used here because the `distance`
+// library depends on this one (via `Intersects`).
+float PointTriangleDistance(Point point, const Triangle& triangle) {
+  if (geometry_internal::IntersectsInternal(point, triangle)) return 0;
+  return std::min({PointSegmentDistance(point, triangle.GetEdge(0)),
+                   PointSegmentDistance(point, triangle.GetEdge(1)),
+                   PointSegmentDistance(point, triangle.GetEdge(2))});
 }
 
+// Returns the distance from `point` to `rect`; this is zero if `rect`
+// contains `point`.
+float PointRectDistance(Point point, const Rect& rect) {
+  float dx = std::max({rect.XMin() - point.x, 0.f, point.x - rect.XMax()});
+  float dy = std::max({rect.YMin() - point.y, 0.f, point.y - rect.YMax()});
+  return std::hypot(dx, dy);
+}
+
+}  // namespace
+
+std::optional<PartitionedMesh::NearestTriangle>
+PartitionedMesh::FindNearestTriangle(
+    Point query, float max_distance,
+    const AffineTransform& query_to_this) const {
+  if (data_ == nullptr) return std::nullopt;
+
+  Point transformed_query = query_to_this.Apply(query);
+  absl::Span<const Mesh> meshes = data_->Meshes();
+  std::optional<RTree::ElementAndDistance> nearest =
+      data_->SpatialIndex().FindNearestElement(
+          max_distance,
+          [transformed_query](const Rect& bounds) {
+            return PointRectDistance(transformed_query, bounds);
+          },
+          [transformed_query, meshes](uint32_t packed_index) {
+            TriangleIndexPair index = UnpackTriangleIndexPair(packed_index);
+            return PointTriangleDistance(
+                transformed_query,
+                meshes[index.mesh_index].GetTriangle(index.triangle_index));
+          });
+  if (!nearest.has_value()) return std::nullopt;
+  return NearestTriangle{.triangle = UnpackTriangleIndexPair(nearest->element),
+                         .distance = nearest->distance};
+}
+
+void PartitionedMesh::VisitTrianglesWithinDistance(
+    Point query, float max_distance,
+    absl::FunctionRef<FlowControl(TriangleIndexPair)> visitor,
+    const AffineTransform& query_to_this) const {
+  if (data_ == nullptr || !(max_distance >= 0)) return;
+
+  Point transformed_query = query_to_this.Apply(query);
+  absl::Span<const Mesh> meshes = data_->Meshes();
+  data_->SpatialIndex().VisitIntersectedElements(
+      Rect::FromCenterAndDimensions(transformed_query, 2 * max_distance,
+                                    2 * max_distance),
+      [transformed_query, max_distance, meshes,
+       visitor](uint32_t packed_index) {
+        TriangleIndexPair index = UnpackTriangleIndexPair(packed_index);
+        if (PointTriangleDistance(
+                transformed_query,
+                meshes[index.mesh_index].GetTriangle(index.triangle_index)) >
+            max_distance) {
+          return true;
+        }
+        return visitor(index) == FlowControl::kContinue;
+      });
+}
+
+PartitionedMesh::SpatialIndexLayout PartitionedMesh::GetSpatialIndexLayout()
+    const {
+  if (Meshes().empty()) return {};
+
+  const RTree& rtree = data_->SpatialIndex();
+  SpatialIndexLayout layout = {.child_counts = rtree.ChildCounts()};
+  layout.triangles.reserve(rtree.Elements().size());
+  for (uint32_t packed_index : rtree.Elements()) {
+    layout.triangles.push_back(UnpackTriangleIndexPair(packed_index));
+  }
+  return layout;
+}
+
+absl::Status PartitionedMesh::InitializeSpatialIndexFromLayout(
+    const SpatialIndexLayout& layout) const {
+  if (Meshes().empty()) {
+    if (!layout.triangles.empty() || !layout.child_counts.empty()) {
+      return absl::InvalidArgumentError(
+          "`SpatialIndexLayout` must be empty for a `PartitionedMesh` with no "
+          "meshes");
+    }
+    return absl::OkStatus();
+  }
+  return data_->InitializeSpatialIndexFromLayout(layout);
+}
+
+namespace {
+
+// The bounds and absolute areas of the triangles of a `PartitionedMesh`. The
+// triangles are numbered consecutively across all of the meshes, starting
+// from `first_triangle_indices[mesh_index]` for each mesh.
+struct TriangleBoundsAndAreas {
+  std::vector<uint32_t> first_triangle_indices;
+  std::vector<Rect> bounds;
+  std::vector<float> areas;
+
+  uint32_t Index(TriangleIndexPair index) const {
+    return first_triangle_indices[index.mesh_index] + index.triangle_index;
+  }
+  uint32_t Index(uint32_t packed_index) const {
+    return Index(UnpackTriangleIndexPair(packed_index));
+  }
+};
+
+TriangleBoundsAndAreas ComputeTriangleBoundsAndAreas(
+    absl::Span<const Mesh> meshes, Executor& executor) {
+  TriangleBoundsAndAreas result;
+  result.first_triangle_indices.reserve(meshes.size());
+  uint32_t n_triangles = 0;
+  for (const Mesh& mesh : meshes) {
+    result.first_triangle_indices.push_back(n_triangles);
+    n_triangles += mesh.TriangleCount();
+  }
+  result.bounds.resize(n_triangles);
+  result.areas.resize(n_triangles);
+
+  // Each task handles a fixed-size run of triangles, which may span several
+  // meshes, so that the work is balanced regardless of how the triangles are
+  // split into meshes.
+  constexpr uint32_t kTrianglesPerTask = 4096;
+  executor.ParallelFor(
+      (n_triangles + kTrianglesPerTask - 1) / kTrianglesPerTask,
+      [&result, meshes, n_triangles](size_t task) {
+        uint32_t begin = task * kTrianglesPerTask;
+        uint32_t end = std::min(begin + kTrianglesPerTask, n_triangles);
+        // The first offset is always zero, so this never returns the
+        // beginning.
+        size_t mesh_index =
+            absl::c_upper_bound(result.first_triangle_indices, begin) -
+            result.first_triangle_indices.begin() - 1;
+        for (uint32_t i = begin; i < end; ++i) {
+          while (i - result.first_triangle_indices[mesh_index] >=
+                 meshes[mesh_index].TriangleCount()) {
+            ++mesh_index;
+          }
+          Triangle triangle = meshes[mesh_index].GetTriangle(
+              i - result.first_triangle_indices[mesh_index]);
+          result.bounds[i] = *Envelope(triangle).AsRect();
+          result.areas[i] = std::abs(triangle.SignedArea());
+        }
+      });
+  return result;
+}
+
+}  // namespace
+
 const RTree& PartitionedMesh::Data::SpatialIndex() const {
   ABSL_CHECK(!meshes_.empty());
 
+  {
+    absl::MutexLock lock(cache_mutex_);
+    // The index is already initialized, there's nothing to do.
+    // NOMUTANTS -- Removing this would not have an observable effect on
+    // behavior (just performance), since recomputating the index would yield
+    // the same result.
+    if (rtree_ != nullptr) return *rtree_;
+  }
+
+  InitializeSpatialIndex(SerialExecutor());
   absl::MutexLock lock(cache_mutex_);
+  return *rtree_;
+}
 
-  // The index is already initialized, there's nothing to do.
-  // NOMUTANTS -- Removing this would not have an observable effect on behavior
-  // (just performance), since recomputating the index would yield the same
-  // result.
-  if (rtree_ != nullptr) return *rtree_;
+void PartitionedMesh::Data::InitializeSpatialIndex(Executor& executor) const {
+  ABSL_CHECK(!meshes_.empty());
 
-  uint32_t n_tris = 0;
-  for (const Mesh& mesh : meshes_) n_tris += mesh.TriangleCount();
+  // If another thread is building the index, this waits for it to finish, and
+  // then finds the index already initialized.
+  absl::MutexLock build_lock(spatial_index_build_mutex_);
+  if (IsSpatialIndexInitialized()) return;
 
-  // This generates each valid `TriangleIndexPair` for this `PartitionedMesh`,
-  // in order of mesh index, then triangle index.
+  TriangleBoundsAndAreas triangles =
+      ComputeTriangleBoundsAndAreas(meshes_, executor);
+
+  // This generates each valid packed `TriangleIndexPair` for this
+  // `PartitionedMesh`, in order of mesh index, then triangle index.
   //
   // We want to start at mesh_index = 0, triangle_index = 0, but since they're
-  // `uint16_t`s, we have to make a copy of the current index, then increment
-  // the current value, then return the copy (analogous to the post-increment
+  // unsigned, we have to make a copy of the current index, then increment the
+  // current value, then return the copy (analogous to the post-increment
   // operator).
   auto triangle_index_pair_generator =
       [this, current_index = TriangleIndexPair{.mesh_index = 0,
@@ -594,18 +1050,83 @@ const RTree& PartitionedMesh::Data::SpatialIndex() const {
           ++current_index.mesh_index;
           current_index.triangle_index = 0;
         }
-        return value_before_increment;
+        return PackTriangleIndexPair(value_before_increment);
       };
-  // This gets the bounds for a `TriangleIndexPair` by looking up the triangle
-  // in this `PartitionedMesh`'s meshes.
-  auto bounds_func = [&meshes = meshes_](TriangleIndexPair idx) {
-    return *Envelope(meshes[idx.mesh_index].GetTriangle(idx.triangle_index))
-                .AsRect();
-  };
-  rtree_ = std::make_unique<RTree>(n_tris, triangle_index_pair_generator,
-                                   bounds_func);
+  auto rtree = std::make_unique<RTree>(
+      triangles.bounds.size(), triangle_index_pair_generator,
+      [&triangles](uint32_t packed_index) {
+        return triangles.bounds[triangles.Index(packed_index)];
+      });
+  // The absolute area of each triangle is stored in the R-Tree, so that
+  // `CoverageIsGreaterThan` can count whole sub-trees at once.
+  rtree->InitializeWeights([&triangles](uint32_t packed_index) {
+    return triangles.areas[triangles.Index(packed_index)];
+  });
+
+  // The total area is summed in the same order as `TotalAbsoluteArea`, so it
+  // can be cached at the same time.
+  float total_abs_area = 0;
+  for (float area : triangles.areas) total_abs_area += area;
 
-  return *rtree_;
+  absl::MutexLock lock(cache_mutex_);
+  rtree_ = std::move(rtree);
+  if (!cached_total_absolute_area_.has_value()) {
+    cached_total_absolute_area_ = total_abs_area;
+  }
+}
+
+absl::Status PartitionedMesh::Data::InitializeSpatialIndexFromLayout(
+    const SpatialIndexLayout& layout) const {
+  ABSL_CHECK(!meshes_.empty());
+
+  absl::MutexLock build_lock(spatial_index_build_mutex_);
+  if (IsSpatialIndexInitialized()) return absl::OkStatus();
+
+  TriangleBoundsAndAreas triangles =
+      ComputeTriangleBoundsAndAreas(meshes_, SerialExecutor());
+  if (layout.triangles.size() != triangles.bounds.size()) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "`SpatialIndexLayout` has $0 triangles, but the `PartitionedMesh` has "
+        "$1",
+        layout.triangles.size(), triangles.bounds.size()));
+  }
+  std::vector<bool> seen(triangles.bounds.size());
+  std::vector<uint32_t> packed_triangles;
+  packed_triangles.reserve(layout.triangles.size());
+  for (TriangleIndexPair idx : layout.triangles) {
+    if (idx.mesh_index >= meshes_.size() ||
+        idx.triangle_index >= meshes_[idx.mesh_index].TriangleCount()) {
+      return absl::InvalidArgumentError(absl::Substitute(
+          "`SpatialIndexLayout` refers to non-existent triangle $0 in mesh $1",
+          idx.triangle_index, idx.mesh_index));
+    }
+    if (seen[triangles.Index(idx)]) {
+      return absl::InvalidArgumentError(absl::Substitute(
+          "`SpatialIndexLayout` contains triangle $0 in mesh $1 more than once",
+          idx.triangle_index, idx.mesh_index));
+    }
+    seen[triangles.Index(idx)] = true;
+    packed_triangles.push_back(PackTriangleIndexPair(idx));
+  }
+
+  std::optional<RTree> rtree = RTree::FromLayout(
+      packed_triangles, layout.child_counts,
+      [&triangles](uint32_t packed_index) {
+        return triangles.bounds[triangles.Index(packed_index)];
+      });
+  if (!rtree.has_value()) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "`SpatialIndexLayout::child_counts` does not describe a valid index "
+        "for $0 triangles",
+        layout.triangles.size()));
+  }
+  rtree->InitializeWeights([&triangles](uint32_t packed_index) {
+    return triangles.areas[triangles.Index(packed_index)];
+  });
+
+  absl::MutexLock lock(cache_mutex_);
+  rtree_ = std::make_unique<const RTree>(*std::move(rtree));
+  return absl::OkStatus();
 }
 
 float PartitionedMesh::Data::TotalAbsoluteArea() const {
@@ -17,22 +17,25 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <memory>
 #include <optional>
 #include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/base/nullability.h"
 #include "absl/base/thread_annotations.h"
 #include "absl/container/inlined_vector.h"
 #include "absl/functional/function_ref.h"
 #include "absl/log/absl_check.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "ink/geometry/affine_transform.h"
 #include "ink/geometry/envelope.h"
-#include "ink/geometry/internal/static_rtree.h"
+#include "ink/geometry/internal/flat_static_rtree.h"
 #include "ink/geometry/mesh.h"
 #include "ink/geometry/mesh_format.h"
 #include "ink/geometry/mesh_index_types.h"
@@ -43,6 +46,7 @@
 #include "ink/geometry/rect.h"
 #include "ink/geometry/segment.h"
 #include "ink/geometry/triangle.h"
+#include "ink/types/executor.h"
 
 namespace ink {
 
@@ -100,9 +104,11 @@ class PartitionedMesh {
   // (non-mutable) `Mesh`es via `mesh.AsMeshes()`. `outlines`, if given, should
   // contain spans of indices into `mesh`, each describing an outline.
   // `packing_params`, if given, will be used instead of the default
-  // MeshAttributeCodingParams. Returns an error if:
+  // MeshAttributeCodingParams. `executor` is used to run the conversion, as
+  // described by `MutableMesh::AsMeshes()`. Returns an error if:
   // - `mesh.AsMeshes()` fails.
   // - `outlines` contains any index >= `mesh.VertexCount()`
+  // - `mesh` uses `MeshFormat::IndexFormat::k32BitUnpacked32BitPacked`.
   // TODO: b/295166196 - Once `MutableMesh` always uses 16-bit indices, this can
   // be replaced with a "FromMutableMeshes" factory method analogous to
   // `FromMeshes`.
@@ -111,16 +117,21 @@ class PartitionedMesh {
       absl::Span<const absl::Span<const uint32_t>> outlines = {},
       absl::Span<const MeshFormat::AttributeId> omit_attributes = {},
       absl::Span<const std::optional<MeshAttributeCodingParams>>
-          packing_params = {});
+          packing_params = {},
+      Executor& executor = SerialExecutor());
 
-  // Constructs a `PartitionedMesh` with zero or more render groups. Returns an
-  // error if:
+  // Constructs a `PartitionedMesh` with zero or more render groups. Each mesh
+  // is converted with `AsMeshes()` using `executor`, which is also used to
+  // partition the outlines of the groups. The result does not depend on which
+  // `Executor` is used. Returns an error if:
   // - `AsMeshes()` fails for any of the meshes.
   // - The total number of `Mesh` objects post-`AsMeshes()` across all groups is
   //   more than 65536 (2^16).
   // - Any outline contains any element that does not correspond to a vertex.
+  // - Any mesh uses `MeshFormat::IndexFormat::k32BitUnpacked32BitPacked`.
   static absl::StatusOr<PartitionedMesh> FromMutableMeshGroups(
-      absl::Span<const MutableMeshGroup> groups);
+      absl::Span<const MutableMeshGroup> groups,
+      Executor& executor = SerialExecutor());
 
   // Constructs a `PartitionedMesh` from a span of `Mesh`es. `outlines`, if
   // given, should contain spans of `VertexIndexPair`s, each describing an
@@ -128,6 +139,7 @@ class PartitionedMesh {
   // - `meshes` contains more than 65536 (2^16) elements
   // - any element of `meshes` is empty
   // - any element of `meshes` has a different `MeshFormat` from the others
+  // - any element of `meshes` has 32-bit packed indices
   // - Any outline is empty.
   // - Any outline contains any element that does not correspond to a mesh or
   //   vertex.
@@ -139,6 +151,7 @@ class PartitionedMesh {
   // error if:
   // - Any group contains a mesh that is empty.
   // - Any group contains two meshes with different `MeshFormat`s.
+  // - Any mesh has 32-bit packed indices.
   // - The total number of meshes across all groups is more than 65536 (2^16).
   // - Any outline is empty.
   // - Any outline contains any element that does not correspond to a mesh or
@@ -232,11 +245,67 @@ class PartitionedMesh {
   // explicitly mutable cache fields (i.e. it does not affect behavior, only
   // performance, and is safe to do when changes to the contents are not
   // expected).
-  void InitializeSpatialIndex() const;
+  //
+  // This always blocks until the index has been built. `executor` is only
+  // used to compute the bounds and areas of the triangles, which is most of
+  // the work of building the index, and this waits for all of its tasks to
+  // finish. The result does not depend on which `Executor` is used.
+  //
+  // This does not start any background work itself. To build the index off of
+  // a performance critical thread, the caller is responsible for calling this
+  // on a thread of its own, e.g. with a copy of the `PartitionedMesh`, which
+  // shares its index, and for polling `IsSpatialIndexInitialized` if needed.
+  // The index is built without holding the lock that guards the
+  // `PartitionedMesh`'s other cached values, so this doesn't block
+  // `IsSpatialIndexInitialized` or queries that don't need the index. Queries
+  // that do need it wait for the build that is in progress to finish, instead
+  // of starting another one.
+  void InitializeSpatialIndex(Executor& executor = SerialExecutor()) const;
 
   // Returns true if the spatial index has already been initialized.
   bool IsSpatialIndexInitialized() const;
 
+  // The structure of the spatial index, which can be stored alongside the
+  // `PartitionedMesh`'s meshes, so that the index can be restored without
+  // being rebuilt from scratch.
+  struct SpatialIndexLayout {
+    // Every triangle in the `PartitionedMesh`, in the order of the leaves of
+    // the index.
+    std::vector<TriangleIndexPair> triangles;
+    // The number of children of each node of the index, in breadth-first
+    // order.
+    std::vector<uint32_t> child_counts;
+  };
+
+  // Returns the layout of the spatial index. This will initialize the index if
+  // it has not already been done. On a `PartitionedMesh` with no meshes, the
+  // layout is empty.
+  SpatialIndexLayout GetSpatialIndexLayout() const;
+
+  // Initializes the spatial index from `layout`, which is expected to have
+  // been returned by `GetSpatialIndexLayout` for a `PartitionedMesh` with the
+  // same meshes. This produces the same index as `InitializeSpatialIndex`,
+  // but skips sorting the triangles. This is a no-op if the spatial index has
+  // already been initialized. Returns an error if `layout` does not contain
+  // every triangle exactly once, or its `child_counts` do not describe a valid
+  // index for that number of triangles.
+  absl::Status InitializeSpatialIndexFromLayout(
+      const SpatialIndexLayout& layout) const;
+
+  // Initializes the vertex position cache of each of the `PartitionedMesh`'s
+  // meshes; see `Mesh::InitializeVertexPositionCache`. This trades an extra 8
+  // bytes per vertex for faster geometric queries (e.g.
+  // `VisitIntersectedTriangles`, `Coverage`, and building the spatial index),
+  // which otherwise unpack each vertex position every time a triangle is
+  // tested. This is a no-op for meshes whose cache has already been
+  // initialized, and is treated as const for the same reason as
+  // `InitializeSpatialIndex`.
+  void InitializeVertexPositionCache() const;
+
+  // Returns true if the vertex position cache of every mesh has been
+  // initialized. This is vacuously true if there are no meshes.
+  bool IsVertexPositionCacheInitialized() const;
+
   // This enumerator is returned by visitor functions, indicating
   // whether the search should continue to the next element, or stop.
   enum class FlowControl : uint8_t { kBreak, kContinue };
@@ -276,6 +345,43 @@ class PartitionedMesh {
       absl::FunctionRef<FlowControl(TriangleIndexPair)> visitor,
       const AffineTransform& query_to_this = {}) const;
 
+  // Visits, for each shape in `queries`, all triangles that intersect it, as
+  // if by calling `VisitIntersectedTriangles` once per query. This is intended
+  // for tools that test many small shapes against the same `PartitionedMesh`
+  // at once (e.g. one per segment of an eraser's path): nearby queries are
+  // grouped together and share a traversal of the index, so most index nodes
+  // are tested once per group rather than once per query.
+  //
+  // `visitor` is called with the index of the query in `queries` and the
+  // intersected triangle. Returning `FlowControl::kBreak` stops the visit for
+  // that query only; the other queries are unaffected. The visitation order,
+  // including how visits for different queries are interleaved, should be
+  // assumed to be arbitrary.
+  //
+  // `query_to_this` is applied to every query, as for
+  // `VisitIntersectedTriangles`. This will initialize the index if it has not
+  // already been done.
+  void VisitIntersectedTrianglesBatch(
+      absl::Span<const Point> queries,
+      absl::FunctionRef<FlowControl(size_t, TriangleIndexPair)> visitor,
+      const AffineTransform& query_to_this = {}) const;
+  void VisitIntersectedTrianglesBatch(
+      absl::Span<const Segment> queries,
+      absl::FunctionRef<FlowControl(size_t, TriangleIndexPair)> visitor,
+      const AffineTransform& query_to_this = {}) const;
+  void VisitIntersectedTrianglesBatch(
+      absl::Span<const Triangle> queries,
+      absl::FunctionRef<FlowControl(size_t, TriangleIndexPair)> visitor,
+      const AffineTransform& query_to_this = {}) const;
+  void VisitIntersectedTrianglesBatch(
+      absl::Span<const Rect> queries,
+      absl::FunctionRef<FlowControl(size_t, TriangleIndexPair)> visitor,
+      const AffineTransform& query_to_this = {}) const;
+  void VisitIntersectedTrianglesBatch(
+      absl::Span<const Quad> queries,
+      absl::FunctionRef<FlowControl(size_t, TriangleIndexPair)> visitor,
+      const AffineTransform& query_to_this = {}) const;
+
   // Computes an approximate measure of what portion of the `PartitionedMesh` is
   // covered by or overlaps with `query`. This is calculated by finding the sum
   // of areas of the triangles that intersect the given object, and dividing
@@ -308,7 +414,10 @@ class PartitionedMesh {
   // Returns true if the approximate portion of the `PartitionedMesh` covered by
   // `query` is greater than `coverage_threshold`. This is equivalent to
   // `partitioned_mesh.Coverage(query, query_to_this) > coverage_threshold`
-  // but may be faster.
+  // (up to floating-point rounding) but may be faster: the spatial index
+  // stores the area of each of its nodes, so regions entirely inside the query
+  // are counted without visiting their triangles, and the search stops as
+  // soon as the result is known.
   //
   // On an empty `PartitionedMesh`, this will always return false.
   //
@@ -330,19 +439,58 @@ class PartitionedMesh {
                              float coverage_threshold,
                              const AffineTransform& query_to_this = {}) const;
 
+  // A triangle in the `PartitionedMesh`, and its distance from a query.
+  struct NearestTriangle {
+    TriangleIndexPair triangle;
+    float distance;
+  };
+
+  // Returns the triangle in the `PartitionedMesh` nearest to `query`, and its
+  // distance from `query`, if that distance is at most `max_distance`;
+  // otherwise, returns `std::nullopt`. Triangles that contain `query` have a
+  // distance of zero. If several triangles are equally near, which one is
+  // returned is unspecified.
+  //
+  // The index is searched nearest-first, and the search stops once the
+  // remaining nodes are farther away than the best triangle found so far or
+  // `max_distance`, so for hit-testing (e.g. hovering or picking with a
+  // tolerance) it only looks at the triangles near `query`.
+  //
+  // Optional argument `query_to_this` contains the transform that maps from
+  // `query`'s coordinate space to this `PartitionedMesh`'s coordinate space,
+  // which defaults to the identity transform. Distances are measured in this
+  // `PartitionedMesh`'s coordinate space.
+  //
+  // On an empty `PartitionedMesh`, this will always return `std::nullopt`.
+  // This will initialize the index if it has not already been done.
+  std::optional<NearestTriangle> FindNearestTriangle(
+      Point query, float max_distance = std::numeric_limits<float>::infinity(),
+      const AffineTransform& query_to_this = {}) const;
+
+  // Visits all triangles in the `PartitionedMesh` whose distance from `query`
+  // is at most `max_distance`, stopping early if `visitor` returns
+  // `FlowControl::kBreak`. The visitation order should be assumed to be
+  // arbitrary. `query_to_this` is as for `FindNearestTriangle`, and distances
+  // are likewise measured in this `PartitionedMesh`'s coordinate space.
+  //
+  // This will initialize the index if it has not already been done.
+  void VisitTrianglesWithinDistance(
+      Point query, float max_distance,
+      absl::FunctionRef<FlowControl(TriangleIndexPair)> visitor,
+      const AffineTransform& query_to_this = {}) const;
+
  private:
-  // Convenience alias for the R-Tree.
-  using RTree = geometry_internal::StaticRTree<TriangleIndexPair>;
+  // Convenience alias for the R-Tree. Its elements are `TriangleIndexPair`s,
+  // packed with `geometry_internal::PackTriangleIndexPair`.
+  using RTree = geometry_internal::FlatStaticRTree<uint32_t>;
 
   // Contains the data that makes up the `PartitionedMesh`, which is shared
   // between instances in order to enable fast copying.
   //
   // Note that we use a shared pointer to a data class, instead of separate
-  // shared pointers to each object, because `rtree` maintains a reference to
-  // `meshes` (via the bounds function for the leaf nodes), and so `meshes`
-  // needs to outlive `rtree`, even if the `PartitionedMesh` is copied. Doing
-  // this also means that copies that refer to the same meshes can share the
-  // cached R-Tree, even if it was initialized after the copy.
+  // shared pointers to each object, so that copies that refer to the same
+  // meshes can share the cached R-Tree, even if it was initialized after the
+  // copy.
   class Data {
    public:
     static absl::StatusOr<absl_nonnull std::unique_ptr<Data>> FromMeshGroups(
@@ -362,6 +510,15 @@ class PartitionedMesh {
     // immutable, so the it never needs to be invalidated.
     const RTree& SpatialIndex() const;
 
+    // Builds the spatial index, if it has not already been initialized. This
+    // CHECK-fails if `Meshes()` is empty.
+    void InitializeSpatialIndex(Executor& executor) const;
+
+    // Builds the spatial index from `layout`, if it has not already been
+    // initialized. This CHECK-fails if `Meshes()` is empty.
+    absl::Status InitializeSpatialIndexFromLayout(
+        const SpatialIndexLayout& layout) const;
+
     // Returns true if the spatial index has already been initialized.
     bool IsSpatialIndexInitialized() const;
 
@@ -387,12 +544,18 @@ class PartitionedMesh {
     // group.
     absl::InlinedVector<MeshFormat, 1> group_formats_;
 
+    // Held while building the spatial index, so that only one thread builds
+    // it. This is separate from `cache_mutex_` so that the other cached values
+    // remain available while the index is being built.
+    mutable absl::Mutex spatial_index_build_mutex_;
+
     mutable absl::Mutex cache_mutex_;
     // Note that the mutex guards the `std::unique_ptr`, not the pointee, and
-    // that the raw pointer is returned by `SpatialIndex()`. This is safe
-    // because:
+    // that the raw pointer is returned by `SpatialIndex()`. The R-Tree is
+    // built before it is assigned here, so the mutex is only held long enough
+    // to check or assign the pointer. This is safe because:
     // - `SpatialIndex()` returns a const pointer
-    // - `StaticRTree` is thread-compatible
+    // - `FlatStaticRTree` is thread-compatible
     // - Once initialized, `rtree_` is not modified until `Data` is destroyed
     // - `SpatialIndex()` is only called from within `PartitionedMesh` methods;
     //   since the `PartitionedMesh` keeps `Data` alive, `rtree_` will not be
@@ -472,16 +635,26 @@ inline uint32_t PartitionedMesh::OutlineVertexCount(
   return Outline(group_index, outline_index).size();
 }
 
-inline void PartitionedMesh::InitializeSpatialIndex() const {
-  if (!data_) return;
+inline void PartitionedMesh::InitializeSpatialIndex(Executor& executor) const {
+  if (Meshes().empty()) return;
 
-  (void)data_->SpatialIndex();
+  data_->InitializeSpatialIndex(executor);
 }
 
 inline bool PartitionedMesh::IsSpatialIndexInitialized() const {
   return data_ && data_->IsSpatialIndexInitialized();
 }
 
+inline void PartitionedMesh::InitializeVertexPositionCache() const {
+  for (const Mesh& mesh : Meshes()) mesh.InitializeVertexPositionCache();
+}
+
+inline bool PartitionedMesh::IsVertexPositionCacheInitialized() const {
+  return absl::c_all_of(Meshes(), [](const Mesh& mesh) {
+    return mesh.IsVertexPositionCacheInitialized();
+  });
+}
+
 inline PartitionedMesh::PartitionedMesh(absl_nonnull std::unique_ptr<Data> data)
     : data_(std::move(data)) {}
 
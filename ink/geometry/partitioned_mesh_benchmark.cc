@@ -0,0 +1,215 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+
+#include "benchmark/benchmark.h"
+#include "ink/geometry/affine_transform.h"
+#include "ink/geometry/angle.h"
+#include "ink/geometry/intersects.h"
+#include "ink/geometry/mesh_format.h"
+#include "ink/geometry/mesh_index_types.h"
+#include "ink/geometry/mesh_test_helpers.h"
+#include "ink/geometry/partitioned_mesh.h"
+#include "ink/geometry/quad.h"
+#include "ink/geometry/rect.h"
+#include "ink/geometry/vec.h"
+#include "ink/types/executor.h"
+
+namespace ink {
+namespace {
+
+// Returns a straight, horizontal stroke-like `PartitionedMesh`, 100 units long
+// and 1 unit wide, made of `n_triangles` triangles. The index is initialized,
+// so that benchmarks only measure queries.
+PartitionedMesh MakeStroke(uint32_t n_triangles) {
+  PartitionedMesh stroke = MakeStraightLinePartitionedMesh(
+      n_triangles, MeshFormat(),
+      AffineTransform::Scale(100.f / n_triangles, 1));
+  stroke.InitializeSpatialIndex();
+  return stroke;
+}
+
+// Transform for an eraser mesh from `MakeStroke`, which crosses the stroke
+// vertically near its midpoint. The offsets keep the edges of the two meshes
+// from lining up exactly.
+AffineTransform CrossingEraserTransform() {
+  return AffineTransform::Translate(Vec{50.5, -50.25}) *
+         AffineTransform::Rotate(kQuarterTurn);
+}
+
+// Transform for an eraser mesh from `MakeStroke`, which lies along the stroke,
+// offset by a fraction of its width, so most triangles overlap.
+AffineTransform OverlappingEraserTransform() {
+  return AffineTransform::Translate(Vec{0.25, 0.25});
+}
+
+void BM_IntersectsCrossingEraser(benchmark::State& state) {
+  PartitionedMesh stroke = MakeStroke(state.range(0));
+  PartitionedMesh eraser = MakeStroke(state.range(0));
+  AffineTransform eraser_transform = CrossingEraserTransform();
+  for (auto s : state) {
+    benchmark::DoNotOptimize(
+        Intersects(stroke, AffineTransform(), eraser, eraser_transform));
+  }
+}
+BENCHMARK(BM_IntersectsCrossingEraser)->RangeMultiplier(4)->Range(256, 65536);
+
+void BM_CoverageCrossingEraser(benchmark::State& state) {
+  PartitionedMesh stroke = MakeStroke(state.range(0));
+  PartitionedMesh eraser = MakeStroke(state.range(0));
+  AffineTransform eraser_transform = CrossingEraserTransform();
+  for (auto s : state) {
+    benchmark::DoNotOptimize(stroke.Coverage(eraser, eraser_transform));
+  }
+}
+BENCHMARK(BM_CoverageCrossingEraser)->RangeMultiplier(4)->Range(256, 65536);
+
+void BM_CoverageOverlappingEraser(benchmark::State& state) {
+  PartitionedMesh stroke = MakeStroke(state.range(0));
+  PartitionedMesh eraser = MakeStroke(state.range(0));
+  AffineTransform eraser_transform = OverlappingEraserTransform();
+  for (auto s : state) {
+    benchmark::DoNotOptimize(stroke.Coverage(eraser, eraser_transform));
+  }
+}
+BENCHMARK(BM_CoverageOverlappingEraser)->RangeMultiplier(4)->Range(256, 65536);
+
+void BM_CoverageIsGreaterThanOverlappingEraser(benchmark::State& state) {
+  PartitionedMesh stroke = MakeStroke(state.range(0));
+  PartitionedMesh eraser = MakeStroke(state.range(0));
+  AffineTransform eraser_transform = OverlappingEraserTransform();
+  for (auto s : state) {
+    benchmark::DoNotOptimize(
+        stroke.CoverageIsGreaterThan(eraser, 0.5, eraser_transform));
+  }
+}
+BENCHMARK(BM_CoverageIsGreaterThanOverlappingEraser)
+    ->RangeMultiplier(4)
+    ->Range(256, 65536);
+
+// The lasso benchmarks take the number of triangles in the stroke, and the
+// coverage threshold as a percentage. This lasso covers 60% of the stroke, so
+// the first threshold passes and the second doesn't.
+void BM_CoverageIsGreaterThanRectLasso(benchmark::State& state) {
+  PartitionedMesh stroke = MakeStroke(state.range(0));
+  Rect lasso = Rect::FromTwoPoints({-5, -5}, {60, 5});
+  float threshold = state.range(1) / 100.f;
+  for (auto s : state) {
+    benchmark::DoNotOptimize(stroke.CoverageIsGreaterThan(lasso, threshold));
+  }
+}
+BENCHMARK(BM_CoverageIsGreaterThanRectLasso)
+    ->ArgsProduct({benchmark::CreateRange(256, 65536, 4), {50, 70}});
+
+// As above, but the lasso is rotated, so its edges cut diagonally across the
+// stroke; it covers about 40% of it.
+void BM_CoverageIsGreaterThanRotatedLasso(benchmark::State& state) {
+  PartitionedMesh stroke = MakeStroke(state.range(0));
+  Quad lasso = Quad::FromCenterDimensionsAndRotation({30, -0.5}, 62, 10,
+                                                     kFullTurn / 24);
+  float threshold = state.range(1) / 100.f;
+  for (auto s : state) {
+    benchmark::DoNotOptimize(stroke.CoverageIsGreaterThan(lasso, threshold));
+  }
+}
+BENCHMARK(BM_CoverageIsGreaterThanRotatedLasso)
+    ->ArgsProduct({benchmark::CreateRange(256, 65536, 4), {30, 50}});
+
+// The hover benchmarks take the number of triangles in the stroke, and query a
+// point just off of it, as when hit-testing with a tolerance.
+void BM_FindNearestTriangleHover(benchmark::State& state) {
+  PartitionedMesh stroke = MakeStroke(state.range(0));
+  for (auto s : state) {
+    benchmark::DoNotOptimize(stroke.FindNearestTriangle({50.3, 0.3}, 0.5));
+  }
+}
+BENCHMARK(BM_FindNearestTriangleHover)->RangeMultiplier(4)->Range(256, 65536);
+
+// As above, but the point is out of range, so no triangle is found.
+void BM_FindNearestTriangleHoverMiss(benchmark::State& state) {
+  PartitionedMesh stroke = MakeStroke(state.range(0));
+  for (auto s : state) {
+    benchmark::DoNotOptimize(stroke.FindNearestTriangle({50.3, 2}, 0.5));
+  }
+}
+BENCHMARK(BM_FindNearestTriangleHoverMiss)
+    ->RangeMultiplier(4)
+    ->Range(256, 65536);
+
+void BM_VisitTrianglesWithinDistanceHover(benchmark::State& state) {
+  PartitionedMesh stroke = MakeStroke(state.range(0));
+  for (auto s : state) {
+    int n_triangles = 0;
+    stroke.VisitTrianglesWithinDistance(
+        {50.3, 0.3}, 0.5, [&n_triangles](TriangleIndexPair) {
+          ++n_triangles;
+          return PartitionedMesh::FlowControl::kContinue;
+        });
+    benchmark::DoNotOptimize(n_triangles);
+  }
+}
+BENCHMARK(BM_VisitTrianglesWithinDistanceHover)
+    ->RangeMultiplier(4)
+    ->Range(256, 65536);
+
+// The index construction benchmarks take the number of triangles in the
+// stroke. Each iteration initializes the index of a fresh copy of the stroke,
+// since the index is cached.
+void BM_InitializeSpatialIndex(benchmark::State& state) {
+  PartitionedMesh stroke = MakeStraightLinePartitionedMesh(
+      state.range(0), MeshFormat(),
+      AffineTransform::Scale(100.f / state.range(0), 1));
+  for (auto s : state) {
+    state.PauseTiming();
+    PartitionedMesh copy = *PartitionedMesh::FromMeshes(stroke.Meshes());
+    state.ResumeTiming();
+    copy.InitializeSpatialIndex();
+  }
+}
+BENCHMARK(BM_InitializeSpatialIndex)->RangeMultiplier(4)->Range(256, 65536);
+
+void BM_InitializeSpatialIndexWithThreadExecutor(benchmark::State& state) {
+  PartitionedMesh stroke = MakeStraightLinePartitionedMesh(
+      state.range(0), MeshFormat(),
+      AffineTransform::Scale(100.f / state.range(0), 1));
+  ThreadExecutor executor(4);
+  for (auto s : state) {
+    state.PauseTiming();
+    PartitionedMesh copy = *PartitionedMesh::FromMeshes(stroke.Meshes());
+    state.ResumeTiming();
+    copy.InitializeSpatialIndex(executor);
+  }
+}
+BENCHMARK(BM_InitializeSpatialIndexWithThreadExecutor)
+    ->RangeMultiplier(4)
+    ->Range(256, 65536)
+    ->UseRealTime();
+
+void BM_InitializeSpatialIndexFromLayout(benchmark::State& state) {
+  PartitionedMesh stroke = MakeStroke(state.range(0));
+  PartitionedMesh::SpatialIndexLayout layout = stroke.GetSpatialIndexLayout();
+  for (auto s : state) {
+    state.PauseTiming();
+    PartitionedMesh copy = *PartitionedMesh::FromMeshes(stroke.Meshes());
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(copy.InitializeSpatialIndexFromLayout(layout));
+  }
+}
+BENCHMARK(BM_InitializeSpatialIndexFromLayout)
+    ->RangeMultiplier(4)
+    ->Range(256, 65536);
+
+}  // namespace
+}  // namespace ink
@@ -14,8 +14,13 @@
 
 #include "ink/geometry/partitioned_mesh.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
+#include <limits>
+#include <optional>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -27,9 +32,11 @@
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 #include "ink/geometry/affine_transform.h"
 #include "ink/geometry/angle.h"
+#include "ink/geometry/distance.h"
 #include "ink/geometry/mesh.h"
 #include "ink/geometry/mesh_format.h"
 #include "ink/geometry/mesh_index_types.h"
@@ -42,6 +49,7 @@
 #include "ink/geometry/segment.h"
 #include "ink/geometry/triangle.h"
 #include "ink/geometry/type_matchers.h"
+#include "ink/types/executor.h"
 
 namespace ink {
 namespace {
@@ -51,9 +59,12 @@ using ::absl_testing::IsOkAndHolds;
 using ::absl_testing::StatusIs;
 using ::testing::AnyOf;
 using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
 using ::testing::FloatNear;
 using ::testing::HasSubstr;
 using ::testing::IsEmpty;
+using ::testing::Matcher;
+using ::testing::Not;
 using ::testing::SizeIs;
 using ::testing::UnorderedElementsAre;
 
@@ -545,6 +556,34 @@ TEST(PartitionedMeshTest, FromMeshesOutlineRefersToNonExistentVertex) {
                        HasSubstr("non-existent vertex")));
 }
 
+TEST(PartitionedMeshTest, FromMeshesWith32BitIndicesIsAnError) {
+  absl::StatusOr<MeshFormat> format =
+      MeshFormat::Create({{MeshFormat::AttributeType::kFloat2Unpacked,
+                           MeshFormat::AttributeId::kPosition}},
+                         MeshFormat::IndexFormat::k32BitUnpacked32BitPacked);
+  ASSERT_THAT(format, IsOk());
+  absl::StatusOr<Mesh> mesh =
+      Mesh::Create(*format, {{0, 1, 0}, {0, 0, 1}}, {0, 1, 2});
+  ASSERT_THAT(mesh, IsOk());
+
+  EXPECT_THAT(PartitionedMesh::FromMeshes({*mesh}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("32-bit packed indices")));
+}
+
+TEST(PartitionedMeshTest, FromMutableMeshWith32BitIndicesIsAnError) {
+  absl::StatusOr<MeshFormat> format =
+      MeshFormat::Create({{MeshFormat::AttributeType::kFloat2Unpacked,
+                           MeshFormat::AttributeId::kPosition}},
+                         MeshFormat::IndexFormat::k32BitUnpacked32BitPacked);
+  ASSERT_THAT(format, IsOk());
+  MutableMesh mutable_mesh = MakeStraightLineMutableMesh(8, *format);
+
+  EXPECT_THAT(PartitionedMesh::FromMutableMesh(mutable_mesh),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("32-bit packed indices")));
+}
+
 TEST(PartitionedMeshTest, FromMultipleMutableMeshGroups) {
   MutableMesh mutable_mesh0 = MakeStraightLineMutableMesh(8);
   absl::StatusOr<absl::InlinedVector<Mesh, 1>> meshes0 =
@@ -582,6 +621,29 @@ TEST(PartitionedMeshTest, FromMultipleMutableMeshGroups) {
   EXPECT_FALSE(shape->IsSpatialIndexInitialized());
 }
 
+TEST(PartitionedMeshTest, FromMutableMeshGroupsWithThreadExecutor) {
+  MutableMesh mutable_mesh0 =
+      MakeStraightLineMutableMesh(1e5, MakeSinglePackedPositionFormat());
+  MutableMesh mutable_mesh1 = MakeStraightLineMutableMesh(20000);
+  std::vector<absl::Span<const uint32_t>> outlines0 = {
+      {0, 1, 99999, 99998}, {2, 3, 99997, 99996}};
+  std::vector<absl::Span<const uint32_t>> outlines1 = {{0, 1, 19999, 19998}};
+  std::vector<PartitionedMesh::MutableMeshGroup> groups = {
+      {.mesh = &mutable_mesh0, .outlines = outlines0},
+      {.mesh = &mutable_mesh1, .outlines = outlines1},
+  };
+
+  absl::StatusOr<PartitionedMesh> serial_shape =
+      PartitionedMesh::FromMutableMeshGroups(groups);
+  ASSERT_THAT(serial_shape, IsOk());
+  ThreadExecutor executor(4);
+  absl::StatusOr<PartitionedMesh> parallel_shape =
+      PartitionedMesh::FromMutableMeshGroups(groups, executor);
+  ASSERT_THAT(parallel_shape, IsOk());
+
+  EXPECT_THAT(*parallel_shape, PartitionedMeshDeepEq(*serial_shape));
+}
+
 TEST(PartitionedMeshTest, FromMultipleMeshGroups) {
   absl::StatusOr<absl::InlinedVector<Mesh, 1>> meshes0 =
       MakeStraightLineMutableMesh(8).AsMeshes();
@@ -672,6 +734,155 @@ TEST(PartitionedMeshTest, InitializeSpatialIndexIsNoOpForEmptyPartitionedMesh) {
   EXPECT_FALSE(shape.IsSpatialIndexInitialized());
 }
 
+// Returns matchers for each of `tri_index_pairs`, in the same order.
+std::vector<Matcher<TriangleIndexPair>> TriangleIndexPairsEq(
+    absl::Span<const TriangleIndexPair> tri_index_pairs) {
+  std::vector<Matcher<TriangleIndexPair>> matchers;
+  for (TriangleIndexPair idx : tri_index_pairs) {
+    matchers.push_back(TriangleIndexPairEq(idx));
+  }
+  return matchers;
+}
+
+TEST(PartitionedMeshTest, InitializeSpatialIndexWithThreadExecutor) {
+  // This is split into several meshes, and has enough triangles that the
+  // bounds are computed in several tasks, some of which span two meshes.
+  absl::StatusOr<PartitionedMesh> serial_shape =
+      PartitionedMesh::FromMutableMesh(MakeStraightLineMutableMesh(
+          150000, MakeSinglePackedPositionFormat()));
+  ASSERT_THAT(serial_shape, IsOk());
+  ASSERT_GT(serial_shape->Meshes().size(), 1);
+  absl::StatusOr<PartitionedMesh> parallel_shape =
+      PartitionedMesh::FromMeshes(serial_shape->Meshes());
+  ASSERT_THAT(parallel_shape, IsOk());
+
+  serial_shape->InitializeSpatialIndex();
+  ThreadExecutor executor(4);
+  parallel_shape->InitializeSpatialIndex(executor);
+
+  ASSERT_TRUE(parallel_shape->IsSpatialIndexInitialized());
+  PartitionedMesh::SpatialIndexLayout serial_layout =
+      serial_shape->GetSpatialIndexLayout();
+  PartitionedMesh::SpatialIndexLayout parallel_layout =
+      parallel_shape->GetSpatialIndexLayout();
+  EXPECT_THAT(parallel_layout.triangles,
+              ElementsAreArray(TriangleIndexPairsEq(serial_layout.triangles)));
+  EXPECT_THAT(parallel_layout.child_counts,
+              ElementsAreArray(serial_layout.child_counts));
+}
+
+TEST(PartitionedMeshTest, QueriesWaitForSpatialIndexBuiltOnAnotherThread) {
+  PartitionedMesh shape = MakeCoiledRingPartitionedMesh(20000, 40);
+  Rect query = Rect::FromTwoPoints({-0.2, -1.2}, {1.2, 0.3});
+  PartitionedMesh reference = MakeCoiledRingPartitionedMesh(20000, 40);
+  float expected_coverage = reference.Coverage(query);
+
+  // The copy shares the index with `shape`, which is queried while the index
+  // may still be in progress.
+  std::thread builder([copy = shape]() { copy.InitializeSpatialIndex(); });
+  EXPECT_FLOAT_EQ(shape.Coverage(query), expected_coverage);
+  builder.join();
+
+  EXPECT_TRUE(shape.IsSpatialIndexInitialized());
+  EXPECT_FLOAT_EQ(shape.Coverage(query), expected_coverage);
+}
+
+TEST(PartitionedMeshTest, InitializeSpatialIndexFromLayout) {
+  PartitionedMesh shape = MakeCoiledRingPartitionedMesh(2000, 40);
+  PartitionedMesh::SpatialIndexLayout layout = shape.GetSpatialIndexLayout();
+  EXPECT_THAT(layout.triangles, SizeIs(2000));
+
+  absl::StatusOr<PartitionedMesh> restored =
+      PartitionedMesh::FromMeshes(shape.Meshes());
+  ASSERT_THAT(restored, IsOk());
+  EXPECT_FALSE(restored->IsSpatialIndexInitialized());
+  EXPECT_THAT(restored->InitializeSpatialIndexFromLayout(layout), IsOk());
+  EXPECT_TRUE(restored->IsSpatialIndexInitialized());
+
+  PartitionedMesh::SpatialIndexLayout restored_layout =
+      restored->GetSpatialIndexLayout();
+  EXPECT_THAT(restored_layout.triangles,
+              ElementsAreArray(TriangleIndexPairsEq(layout.triangles)));
+  EXPECT_THAT(restored_layout.child_counts,
+              ElementsAreArray(layout.child_counts));
+  Quad query = Quad::FromCenterDimensionsAndRotation({0.3, 0.2}, 1.6, 0.9,
+                                                     kFullTurn / 9);
+  EXPECT_FLOAT_EQ(restored->Coverage(query), shape.Coverage(query));
+}
+
+TEST(PartitionedMeshTest, InitializeSpatialIndexFromLayoutForEmptyShape) {
+  PartitionedMesh shape;
+
+  PartitionedMesh::SpatialIndexLayout layout = shape.GetSpatialIndexLayout();
+  EXPECT_THAT(layout.triangles, IsEmpty());
+  EXPECT_THAT(layout.child_counts, IsEmpty());
+  EXPECT_THAT(shape.InitializeSpatialIndexFromLayout(layout), IsOk());
+  EXPECT_THAT(shape.InitializeSpatialIndexFromLayout(
+                  {.triangles = {{.mesh_index = 0, .triangle_index = 0}},
+                   .child_counts = {1}}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(PartitionedMeshTest, InitializeSpatialIndexFromInvalidLayout) {
+  PartitionedMesh shape = MakeStraightLinePartitionedMesh(3);
+  PartitionedMesh::SpatialIndexLayout layout = shape.GetSpatialIndexLayout();
+  ASSERT_THAT(layout.triangles, SizeIs(3));
+  ASSERT_THAT(layout.child_counts, ElementsAre(3));
+
+  PartitionedMesh::SpatialIndexLayout too_few_triangles = layout;
+  too_few_triangles.triangles.pop_back();
+  PartitionedMesh::SpatialIndexLayout repeated_triangle = layout;
+  repeated_triangle.triangles[0] = repeated_triangle.triangles[1];
+  PartitionedMesh::SpatialIndexLayout nonexistent_triangle = layout;
+  nonexistent_triangle.triangles[0].triangle_index = 3;
+  PartitionedMesh::SpatialIndexLayout nonexistent_mesh = layout;
+  nonexistent_mesh.triangles[0].mesh_index = 1;
+  PartitionedMesh::SpatialIndexLayout wrong_child_count = layout;
+  wrong_child_count.child_counts[0] = 2;
+
+  for (const PartitionedMesh::SpatialIndexLayout& invalid_layout :
+       {too_few_triangles, repeated_triangle, nonexistent_triangle,
+        nonexistent_mesh, wrong_child_count}) {
+    absl::StatusOr<PartitionedMesh> restored =
+        PartitionedMesh::FromMeshes(shape.Meshes());
+    ASSERT_THAT(restored, IsOk());
+    EXPECT_THAT(restored->InitializeSpatialIndexFromLayout(invalid_layout),
+                StatusIs(absl::StatusCode::kInvalidArgument));
+    EXPECT_FALSE(restored->IsSpatialIndexInitialized());
+  }
+}
+
+TEST(PartitionedMeshTest, InitializeVertexPositionCache) {
+  absl::StatusOr<absl::InlinedVector<Mesh, 1>> first_mesh =
+      MakeStraightLineMutableMesh(10).AsMeshes();
+  ASSERT_THAT(first_mesh, IsOkAndHolds(SizeIs(1)));
+  absl::StatusOr<absl::InlinedVector<Mesh, 1>> second_mesh =
+      MakeStarMutableMesh(10).AsMeshes();
+  ASSERT_THAT(second_mesh, IsOkAndHolds(SizeIs(1)));
+  Mesh meshes[2] = {std::move((*first_mesh)[0]), std::move((*second_mesh)[0])};
+  absl::StatusOr<PartitionedMesh> shape =
+      PartitionedMesh::FromMeshes(absl::MakeSpan(meshes));
+  ASSERT_THAT(shape, IsOk());
+
+  EXPECT_FALSE(shape->IsVertexPositionCacheInitialized());
+
+  shape->InitializeVertexPositionCache();
+
+  EXPECT_TRUE(shape->IsVertexPositionCacheInitialized());
+  EXPECT_TRUE(shape->Meshes()[0].IsVertexPositionCacheInitialized());
+  EXPECT_TRUE(shape->Meshes()[1].IsVertexPositionCacheInitialized());
+}
+
+TEST(PartitionedMeshTest, VertexPositionCacheForEmptyPartitionedMesh) {
+  PartitionedMesh shape;
+
+  EXPECT_TRUE(shape.IsVertexPositionCacheInitialized());
+
+  shape.InitializeVertexPositionCache();
+
+  EXPECT_TRUE(shape.IsVertexPositionCacheInitialized());
+}
+
 // Helper function, visits all intersected triangles and returns them in a
 // vector.
 template <typename QueryType>
@@ -689,6 +900,41 @@ std::vector<TriangleIndexPair> GetAllIntersectedTriangles(
   return tri_index_pairs;
 }
 
+TEST(PartitionedMeshTest, VertexPositionCacheDoesNotChangeQueryResults) {
+  PartitionedMesh uncached = MakeCoiledRingPartitionedMesh(
+      50, 8, MakeSinglePackedPositionFormat());
+  PartitionedMesh cached = MakeCoiledRingPartitionedMesh(
+      50, 8, MakeSinglePackedPositionFormat());
+  cached.InitializeVertexPositionCache();
+  ASSERT_FALSE(uncached.IsVertexPositionCacheInitialized());
+  ASSERT_TRUE(cached.IsVertexPositionCacheInitialized());
+
+  // Both meshes have a single partition, so the triangle index alone
+  // identifies each result.
+  auto triangle_indices = [](const std::vector<TriangleIndexPair>& pairs) {
+    std::vector<uint32_t> indices;
+    for (TriangleIndexPair pair : pairs) {
+      EXPECT_EQ(pair.mesh_index, 0);
+      indices.push_back(pair.triangle_index);
+    }
+    return indices;
+  };
+  Triangle triangle{{-0.5, -0.5}, {0.8, 0.1}, {0.2, 0.9}};
+  Rect rect = Rect::FromTwoPoints({-0.3, -1}, {0.6, 0.4});
+  AffineTransform transform = AffineTransform::Rotate(kFullTurn / 7);
+  std::vector<uint32_t> cached_triangles = triangle_indices(
+      GetAllIntersectedTriangles(cached, triangle, transform));
+  EXPECT_THAT(cached_triangles, Not(IsEmpty()));
+  EXPECT_EQ(cached_triangles,
+            triangle_indices(
+                GetAllIntersectedTriangles(uncached, triangle, transform)));
+  EXPECT_EQ(triangle_indices(GetAllIntersectedTriangles(cached, rect)),
+            triangle_indices(GetAllIntersectedTriangles(uncached, rect)));
+  EXPECT_EQ(cached.Coverage(triangle, transform),
+            uncached.Coverage(triangle, transform));
+  EXPECT_EQ(cached.Coverage(rect), uncached.Coverage(rect));
+}
+
 TEST(PartitionedMeshTest, VisitIntersectedTrianglesPointQuery) {
   // This mesh will wrap around and partially overlap itself.
   PartitionedMesh shape = MakeCoiledRingPartitionedMesh(14, 6);
@@ -1316,6 +1562,35 @@ TEST(PartitionedMeshTest,
                 TriangleIndexPairEq({.mesh_index = 0, .triangle_index = 1}))));
 }
 
+TEST(PartitionedMeshTest,
+     VisitIntersectedTrianglesPartitionedMeshQueryMatchesTriangleQueries) {
+  // These meshes wrap around and overlap themselves, and are big enough for
+  // their R-Trees to have several levels.
+  PartitionedMesh shape = MakeCoiledRingPartitionedMesh(500, 12);
+  PartitionedMesh query = MakeCoiledRingPartitionedMesh(300, 7);
+  AffineTransform query_to_shape = AffineTransform::Translate({0.3, -0.2}) *
+                                   AffineTransform::Rotate(kFullTurn / 7) *
+                                   AffineTransform::Scale(0.8);
+  std::optional<AffineTransform> shape_to_query = query_to_shape.Inverse();
+  ASSERT_TRUE(shape_to_query.has_value());
+
+  // A triangle of `shape` intersects `query` iff it intersects at least one
+  // of its triangles.
+  std::vector<TriangleIndexPair> expected;
+  for (uint32_t i = 0; i < shape.Meshes()[0].TriangleCount(); ++i) {
+    if (!GetAllIntersectedTriangles(query, shape.Meshes()[0].GetTriangle(i),
+                                    *shape_to_query)
+             .empty()) {
+      expected.push_back({.mesh_index = 0, .triangle_index = i});
+    }
+  }
+  ASSERT_THAT(expected, Not(IsEmpty()));
+  ASSERT_LT(expected.size(), shape.Meshes()[0].TriangleCount());
+
+  EXPECT_THAT(GetAllIntersectedTriangles(shape, query, query_to_shape),
+              UnorderedElementsAreArray(TriangleIndexPairsEq(expected)));
+}
+
 TEST(PartitionedMeshTest,
      VisitIntersectedTrianglesPartitionedMeshQueryInitializesTheSpatialIndex) {
   PartitionedMesh star = MakeStarPartitionedMesh(4);
@@ -1384,6 +1659,72 @@ TEST(PartitionedMeshTest, VisitIntersectedTrianglesWithReentrantVisitor) {
   shape.VisitIntersectedTriangles(query, visitor);
 }
 
+TEST(PartitionedMeshTest, VisitIntersectedTrianglesBatchMatchesSingleQueries) {
+  // This mesh will wrap around and partially overlap itself.
+  PartitionedMesh shape = MakeCoiledRingPartitionedMesh(50, 8);
+  std::vector<Segment> queries = {{{0, 0}, {1, 1}},
+                                  {{-1, 0.5}, {1, 0.5}},
+                                  {{0.9, -0.1}, {0.8, 0.1}},
+                                  {{5, 5}, {6, 6}},
+                                  {{-0.1, -0.9}, {0.1, -0.8}}};
+  AffineTransform transform = AffineTransform::Rotate(kFullTurn / 5);
+
+  std::vector<std::vector<TriangleIndexPair>> batch_results(queries.size());
+  shape.VisitIntersectedTrianglesBatch(
+      queries,
+      [&batch_results](size_t query_index, TriangleIndexPair idx) {
+        batch_results[query_index].push_back(idx);
+        return PartitionedMesh::FlowControl::kContinue;
+      },
+      transform);
+
+  for (size_t i = 0; i < queries.size(); ++i) {
+    EXPECT_THAT(batch_results[i],
+                UnorderedElementsAreArray(TriangleIndexPairsEq(
+                    GetAllIntersectedTriangles(shape, queries[i], transform))))
+        << "query " << i;
+  }
+  EXPECT_THAT(batch_results[3], IsEmpty());
+}
+
+TEST(PartitionedMeshTest, VisitIntersectedTrianglesBatchExitEarly) {
+  PartitionedMesh shape = MakeStraightLinePartitionedMesh(10);
+  std::vector<Rect> queries = {Rect::FromTwoPoints({-10, -10}, {100, 100}),
+                               Rect::FromTwoPoints({-10, -10}, {100, 100})};
+
+  // The first query stops after one triangle, which must not stop the second.
+  std::vector<TriangleIndexPair> first_query_results;
+  std::vector<TriangleIndexPair> second_query_results;
+  shape.VisitIntersectedTrianglesBatch(
+      queries, [&first_query_results, &second_query_results](
+                   size_t query_index, TriangleIndexPair idx) {
+        if (query_index == 0) {
+          first_query_results.push_back(idx);
+          return PartitionedMesh::FlowControl::kBreak;
+        }
+        second_query_results.push_back(idx);
+        return PartitionedMesh::FlowControl::kContinue;
+      });
+
+  EXPECT_THAT(first_query_results, SizeIs(1));
+  EXPECT_THAT(second_query_results, SizeIs(10));
+}
+
+TEST(PartitionedMeshTest, VisitIntersectedTrianglesBatchEmptyShapeOrQueries) {
+  int n_visits = 0;
+  auto visitor = [&n_visits](size_t, TriangleIndexPair) {
+    ++n_visits;
+    return PartitionedMesh::FlowControl::kContinue;
+  };
+  std::vector<Point> queries = {{0, 0}, {1, 1}};
+
+  PartitionedMesh().VisitIntersectedTrianglesBatch(queries, visitor);
+  MakeStraightLinePartitionedMesh(3).VisitIntersectedTrianglesBatch(
+      absl::Span<const Point>(), visitor);
+
+  EXPECT_EQ(n_visits, 0);
+}
+
 // Returns a `PartitionedMesh` with four triangles in a row along the x-axis,
 // each with a base of one unit, and with heights of 1, 2, 3, and 4 units. Each
 // triangle has a different area (to facilitate testing `Coverage` and
@@ -1627,6 +1968,34 @@ TEST(PartitionedMeshTest, CoverageWithPartitionedMeshWithTransform) {
       0);
 }
 
+TEST(PartitionedMeshTest,
+     CoverageWithPartitionedMeshMatchesVisitIntersectedTriangles) {
+  // These meshes wrap around and overlap themselves, and are big enough for
+  // their R-Trees to have several levels.
+  PartitionedMesh shape = MakeCoiledRingPartitionedMesh(500, 12);
+  PartitionedMesh query = MakeCoiledRingPartitionedMesh(300, 7);
+  AffineTransform query_to_shape = AffineTransform::Translate({0.3, -0.2}) *
+                                   AffineTransform::Rotate(kFullTurn / 7) *
+                                   AffineTransform::Scale(0.8);
+
+  float covered_area = 0;
+  float total_area = 0;
+  for (TriangleIndexPair index :
+       GetAllIntersectedTriangles(shape, query, query_to_shape)) {
+    covered_area += std::abs(shape.Meshes()[index.mesh_index]
+                                 .GetTriangle(index.triangle_index)
+                                 .SignedArea());
+  }
+  for (uint32_t i = 0; i < shape.Meshes()[0].TriangleCount(); ++i) {
+    total_area += std::abs(shape.Meshes()[0].GetTriangle(i).SignedArea());
+  }
+  ASSERT_GT(covered_area, 0);
+  ASSERT_LT(covered_area, total_area);
+
+  EXPECT_THAT(shape.Coverage(query, query_to_shape),
+              FloatNear(covered_area / total_area, 1e-5));
+}
+
 TEST(PartitionedMeshTest, CoverageIsGreaterThanWithTriangleMissesShape) {
   PartitionedMesh shape = MakeRisingSawtoothShape();
   Triangle query{{-5, 5}, {-10, 10}, {-10, 0}};
@@ -1748,6 +2117,38 @@ TEST(PartitionedMeshTest, CoverageIsGreaterThanWithQuadWithTransform) {
   EXPECT_FALSE(shape.CoverageIsGreaterThan(query, 0.41, transform));
 }
 
+TEST(PartitionedMeshTest, CoverageIsGreaterThanMatchesCoverageOnLargeShape) {
+  // This mesh wraps around and overlaps itself, and is big enough for its
+  // R-Tree to have sub-trees that are entirely inside the queries below.
+  PartitionedMesh shape = MakeCoiledRingPartitionedMesh(2000, 40);
+  Rect rect_query = Rect::FromTwoPoints({-0.2, -1.2}, {1.2, 0.3});
+  Quad quad_query = Quad::FromCenterDimensionsAndRotation({0.3, 0.2}, 1.6, 0.9,
+                                                          kFullTurn / 9);
+  Triangle triangle_query = {{-1.2, -1}, {1.2, -0.9}, {0.1, 1.1}};
+  AffineTransform transform = AffineTransform::Rotate(kFullTurn / 13);
+
+  float rect_coverage = shape.Coverage(rect_query, transform);
+  float quad_coverage = shape.Coverage(quad_query, transform);
+  float triangle_coverage = shape.Coverage(triangle_query, transform);
+  for (float coverage : {rect_coverage, quad_coverage, triangle_coverage}) {
+    ASSERT_GT(coverage, 0.1);
+    ASSERT_LT(coverage, 0.9);
+  }
+
+  EXPECT_TRUE(
+      shape.CoverageIsGreaterThan(rect_query, rect_coverage - 0.01, transform));
+  EXPECT_FALSE(
+      shape.CoverageIsGreaterThan(rect_query, rect_coverage + 0.01, transform));
+  EXPECT_TRUE(
+      shape.CoverageIsGreaterThan(quad_query, quad_coverage - 0.01, transform));
+  EXPECT_FALSE(
+      shape.CoverageIsGreaterThan(quad_query, quad_coverage + 0.01, transform));
+  EXPECT_TRUE(shape.CoverageIsGreaterThan(
+      triangle_query, triangle_coverage - 0.01, transform));
+  EXPECT_FALSE(shape.CoverageIsGreaterThan(
+      triangle_query, triangle_coverage + 0.01, transform));
+}
+
 TEST(PartitionedMeshTest, CoverageIsGreaterThanWithPartitionedMeshMissesShape) {
   PartitionedMesh target = MakeRisingSawtoothShape();
   PartitionedMesh query = MakeStraightLinePartitionedMesh(
@@ -1801,6 +2202,138 @@ TEST(PartitionedMeshTest,
   EXPECT_FALSE(target.CoverageIsGreaterThan(query, 0.41, transform));
 }
 
+TEST(PartitionedMeshTest, FindNearestTriangleEmptyShape) {
+  PartitionedMesh shape;
+  EXPECT_EQ(shape.FindNearestTriangle({0, 0}), std::nullopt);
+
+  int n_visited = 0;
+  shape.VisitTrianglesWithinDistance(
+      {0, 0}, 100, [&n_visited](TriangleIndexPair) {
+        ++n_visited;
+        return PartitionedMesh::FlowControl::kContinue;
+      });
+  EXPECT_EQ(n_visited, 0);
+}
+
+TEST(PartitionedMeshTest, FindNearestTriangleContainingQuery) {
+  PartitionedMesh shape = MakeRisingSawtoothShape();
+
+  std::optional<PartitionedMesh::NearestTriangle> nearest =
+      shape.FindNearestTriangle({1.5, 0.5});
+  ASSERT_TRUE(nearest.has_value());
+  EXPECT_THAT(nearest->triangle,
+              TriangleIndexPairEq({.mesh_index = 0, .triangle_index = 1}));
+  EXPECT_EQ(nearest->distance, 0);
+}
+
+TEST(PartitionedMeshTest, FindNearestTriangleRespectsMaxDistance) {
+  // The last triangle of this shape has a vertex at (5, -1), which is the
+  // nearest point to the query.
+  PartitionedMesh shape = MakeStraightLinePartitionedMesh(4);
+
+  EXPECT_EQ(shape.FindNearestTriangle({8, -1}, 2.9), std::nullopt);
+  std::optional<PartitionedMesh::NearestTriangle> nearest =
+      shape.FindNearestTriangle({8, -1}, 3.1);
+  ASSERT_TRUE(nearest.has_value());
+  EXPECT_THAT(nearest->triangle,
+              TriangleIndexPairEq({.mesh_index = 0, .triangle_index = 3}));
+  EXPECT_FLOAT_EQ(nearest->distance, 3);
+}
+
+TEST(PartitionedMeshTest, FindNearestTriangleWithTransform) {
+  PartitionedMesh shape = MakeStraightLinePartitionedMesh(4);
+
+  // The query maps to (8, -1), and the distance is measured in the shape's
+  // coordinate space.
+  std::optional<PartitionedMesh::NearestTriangle> nearest =
+      shape.FindNearestTriangle({4, -0.5}, 10, AffineTransform::Scale(2));
+  ASSERT_TRUE(nearest.has_value());
+  EXPECT_THAT(nearest->triangle,
+              TriangleIndexPairEq({.mesh_index = 0, .triangle_index = 3}));
+  EXPECT_FLOAT_EQ(nearest->distance, 3);
+}
+
+TEST(PartitionedMeshTest, FindNearestTriangleMatchesBruteForce) {
+  // This mesh wraps around and overlaps itself, and is big enough for its
+  // R-Tree to have several levels.
+  PartitionedMesh shape = MakeCoiledRingPartitionedMesh(2000, 40);
+  AffineTransform transform = AffineTransform::Rotate(kFullTurn / 13);
+
+  for (float x = -2; x <= 2; x += 0.25) {
+    for (float y = -2; y <= 2; y += 0.25) {
+      Point query = {x, y};
+      Point transformed_query = transform.Apply(query);
+      float expected_distance = std::numeric_limits<float>::infinity();
+      for (const Mesh& mesh : shape.Meshes()) {
+        for (uint32_t i = 0; i < mesh.TriangleCount(); ++i) {
+          expected_distance = std::min(
+              expected_distance,
+              Distance(transformed_query, mesh.GetTriangle(i)));
+        }
+      }
+
+      std::optional<PartitionedMesh::NearestTriangle> nearest =
+          shape.FindNearestTriangle(query, 10, transform);
+      ASSERT_TRUE(nearest.has_value());
+      EXPECT_FLOAT_EQ(nearest->distance, expected_distance)
+          << absl::StrCat("query: ", query);
+      EXPECT_FLOAT_EQ(
+          Distance(transformed_query,
+                   shape.Meshes()[nearest->triangle.mesh_index].GetTriangle(
+                       nearest->triangle.triangle_index)),
+          nearest->distance)
+          << absl::StrCat("query: ", query);
+    }
+  }
+}
+
+TEST(PartitionedMeshTest, VisitTrianglesWithinDistanceMatchesBruteForce) {
+  PartitionedMesh shape = MakeCoiledRingPartitionedMesh(2000, 40);
+  AffineTransform transform = AffineTransform::Rotate(kFullTurn / 13);
+
+  for (Point query : {Point{0, 0}, Point{0.9, 0.3}, Point{-1.5, 1.5}}) {
+    for (float max_distance : {0.f, 0.05f, 0.3f}) {
+      Point transformed_query = transform.Apply(query);
+      std::vector<TriangleIndexPair> expected;
+      for (uint16_t mesh_idx = 0; mesh_idx < shape.Meshes().size();
+           ++mesh_idx) {
+        const Mesh& mesh = shape.Meshes()[mesh_idx];
+        for (uint32_t tri_idx = 0; tri_idx < mesh.TriangleCount(); ++tri_idx) {
+          if (Distance(transformed_query, mesh.GetTriangle(tri_idx)) <=
+              max_distance) {
+            expected.push_back(
+                {.mesh_index = mesh_idx, .triangle_index = tri_idx});
+          }
+        }
+      }
+
+      std::vector<TriangleIndexPair> visited;
+      shape.VisitTrianglesWithinDistance(
+          query, max_distance,
+          [&visited](TriangleIndexPair idx) {
+            visited.push_back(idx);
+            return PartitionedMesh::FlowControl::kContinue;
+          },
+          transform);
+      EXPECT_THAT(visited,
+                  UnorderedElementsAreArray(TriangleIndexPairsEq(expected)))
+          << absl::StrCat("query: ", query, ", max_distance: ", max_distance);
+    }
+  }
+}
+
+TEST(PartitionedMeshTest, VisitTrianglesWithinDistanceStopEarly) {
+  PartitionedMesh shape = MakeStraightLinePartitionedMesh(10);
+
+  int n_visited = 0;
+  shape.VisitTrianglesWithinDistance(
+      {5, -0.5}, 100, [&n_visited](TriangleIndexPair) {
+        ++n_visited;
+        return PartitionedMesh::FlowControl::kBreak;
+      });
+  EXPECT_EQ(n_visited, 1);
+}
+
 TEST(PartitionedMeshTest, QueryAgainstSelf) {
   PartitionedMesh shape = MakeStraightLinePartitionedMesh(4);
 
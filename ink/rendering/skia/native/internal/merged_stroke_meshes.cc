@@ -0,0 +1,216 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ink/rendering/skia/native/internal/merged_stroke_meshes.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
+#include "absl/strings/substitute.h"
+#include "absl/types/span.h"
+#include "ink/geometry/affine_transform.h"
+#include "ink/geometry/envelope.h"
+#include "ink/geometry/mesh.h"
+#include "ink/geometry/point.h"
+#include "ink/geometry/vec.h"
+#include "ink/strokes/internal/stroke_vertex.h"
+#include "ink/types/small_array.h"
+
+namespace ink::skia_native_internal {
+namespace {
+
+using ::ink::strokes_internal::StrokeVertex;
+
+// Applies only the linear component of `transform` to `v`, as is appropriate
+// for the derivative attributes.
+Vec ApplyLinearComponent(const AffineTransform& transform, Vec v) {
+  return {transform.M00() * v.x + transform.M10() * v.y,
+          transform.M01() * v.x + transform.M11() * v.y};
+}
+
+// Returns the vertex at `index` in `mesh`, with its position and derivatives
+// mapped by `transform`. Attributes that are missing from the format of `mesh`
+// get the default values of `StrokeVertex`.
+StrokeVertex ReadTransformedVertex(
+    const Mesh& mesh, uint32_t index,
+    const StrokeVertex::FormatAttributeIndices& attribute_indices,
+    const AffineTransform& transform) {
+  StrokeVertex vertex;
+  vertex.position = transform.Apply(mesh.VertexPosition(index));
+  StrokeVertex::NonPositionAttributes& attributes =
+      vertex.non_position_attributes;
+  if (attribute_indices.opacity_shift >= 0) {
+    attributes.opacity_shift =
+        mesh.FloatVertexAttribute(index, attribute_indices.opacity_shift)[0];
+  }
+  if (attribute_indices.hsl_shift >= 0) {
+    SmallArray<float, 4> hsl_shift =
+        mesh.FloatVertexAttribute(index, attribute_indices.hsl_shift);
+    attributes.hsl_shift = {hsl_shift[0], hsl_shift[1], hsl_shift[2]};
+  }
+  if (attribute_indices.side_derivative >= 0) {
+    SmallArray<float, 4> derivative =
+        mesh.FloatVertexAttribute(index, attribute_indices.side_derivative);
+    attributes.side_derivative =
+        ApplyLinearComponent(transform, {derivative[0], derivative[1]});
+  }
+  if (attribute_indices.side_label >= 0) {
+    attributes.side_label = {
+        mesh.FloatVertexAttribute(index, attribute_indices.side_label)[0]};
+  }
+  if (attribute_indices.forward_derivative >= 0) {
+    SmallArray<float, 4> derivative =
+        mesh.FloatVertexAttribute(index, attribute_indices.forward_derivative);
+    attributes.forward_derivative =
+        ApplyLinearComponent(transform, {derivative[0], derivative[1]});
+  }
+  if (attribute_indices.forward_label >= 0) {
+    attributes.forward_label = {
+        mesh.FloatVertexAttribute(index, attribute_indices.forward_label)[0]};
+  }
+  if (attribute_indices.surface_uv >= 0) {
+    SmallArray<float, 4> uv =
+        mesh.FloatVertexAttribute(index, attribute_indices.surface_uv);
+    attributes.surface_uv = {uv[0], uv[1]};
+  }
+  if (attribute_indices.animation_offset >= 0) {
+    attributes.animation_offset =
+        mesh.FloatVertexAttribute(index, attribute_indices.animation_offset)[0];
+  }
+  return vertex;
+}
+
+}  // namespace
+
+absl::Span<const std::byte> MergedStrokeMeshes::Partition::RawVertexData()
+    const {
+  return absl::MakeConstSpan(
+      reinterpret_cast<const std::byte*>(vertices.data()),
+      vertices.size() * sizeof(StrokeVertex));
+}
+
+absl::Span<const std::byte> MergedStrokeMeshes::Partition::RawIndexData()
+    const {
+  return absl::MakeConstSpan(reinterpret_cast<const std::byte*>(indices.data()),
+                             indices.size() * sizeof(uint16_t));
+}
+
+absl::Status MergedStrokeMeshes::CheckCanAdd(absl::Span<const Mesh> meshes) {
+  uint32_t vertex_count = 0;
+  for (const Mesh& mesh : meshes) vertex_count += mesh.VertexCount();
+  if (vertex_count >= kMaxPartitionVertexCount) {
+    return absl::UnimplementedError(
+        "Strokes requiring at least 2^16 indices are not supported yet.");
+  }
+  return absl::OkStatus();
+}
+
+absl::Status MergedStrokeMeshes::Add(StrokeId id,
+                                     absl::Span<const Mesh> meshes,
+                                     const AffineTransform& transform) {
+  if (strokes_.contains(id)) {
+    return absl::InvalidArgumentError(
+        absl::Substitute("Stroke with id $0 has already been added.", id));
+  }
+  if (absl::Status status = CheckCanAdd(meshes); !status.ok()) return status;
+  uint32_t vertex_count = 0;
+  uint32_t index_count = 0;
+  for (const Mesh& mesh : meshes) {
+    vertex_count += mesh.VertexCount();
+    index_count += 3 * mesh.TriangleCount();
+  }
+
+  // Strokes are only ever appended to the last partition, so that the
+  // partitions stay in the order that the strokes were added.
+  if (partitions_.empty() ||
+      partitions_.back().vertices.size() + vertex_count >
+          kMaxPartitionVertexCount) {
+    partitions_.emplace_back();
+  }
+  Partition& partition = partitions_.back();
+  StrokeRange range = {
+      .partition_index = static_cast<uint32_t>(partitions_.size() - 1),
+      .first_vertex = static_cast<uint32_t>(partition.vertices.size()),
+      .vertex_count = vertex_count,
+      .first_index = static_cast<uint32_t>(partition.indices.size()),
+      .index_count = index_count,
+      .bounds = Envelope(),
+  };
+
+  partition.vertices.reserve(partition.vertices.size() + vertex_count);
+  partition.indices.reserve(partition.indices.size() + index_count);
+  for (const Mesh& mesh : meshes) {
+    StrokeVertex::FormatAttributeIndices attribute_indices =
+        StrokeVertex::FindAttributeIndices(mesh.Format());
+    uint32_t mesh_first_vertex = partition.vertices.size();
+    for (uint32_t i = 0; i < mesh.VertexCount(); ++i) {
+      partition.vertices.push_back(
+          ReadTransformedVertex(mesh, i, attribute_indices, transform));
+      range.bounds.Add(partition.vertices.back().position);
+    }
+    for (uint32_t i = 0; i < mesh.TriangleCount(); ++i) {
+      for (uint32_t index : mesh.TriangleIndices(i)) {
+        partition.indices.push_back(mesh_first_vertex + index);
+      }
+    }
+  }
+  partition.bounds.Add(range.bounds);
+  partition.stroke_ids.push_back(id);
+  ++partition.version;
+  strokes_.emplace(id, range);
+  return absl::OkStatus();
+}
+
+bool MergedStrokeMeshes::Remove(StrokeId id) {
+  auto it = strokes_.find(id);
+  if (it == strokes_.end()) return false;
+  StrokeRange range = it->second;
+  strokes_.erase(it);
+
+  Partition& partition = partitions_[range.partition_index];
+  partition.vertices.erase(
+      partition.vertices.begin() + range.first_vertex,
+      partition.vertices.begin() + range.first_vertex + range.vertex_count);
+  partition.indices.erase(
+      partition.indices.begin() + range.first_index,
+      partition.indices.begin() + range.first_index + range.index_count);
+  // The triangles after the removed stroke now refer to vertices that have
+  // moved down by the size of the removed stroke.
+  for (uint32_t i = range.first_index; i < partition.indices.size(); ++i) {
+    partition.indices[i] -= range.vertex_count;
+  }
+
+  auto id_it = std::find(partition.stroke_ids.begin(),
+                         partition.stroke_ids.end(), id);
+  ABSL_DCHECK(id_it != partition.stroke_ids.end());
+  id_it = partition.stroke_ids.erase(id_it);
+  for (; id_it != partition.stroke_ids.end(); ++id_it) {
+    StrokeRange& moved_range = strokes_.at(*id_it);
+    moved_range.first_vertex -= range.vertex_count;
+    moved_range.first_index -= range.index_count;
+  }
+
+  partition.bounds.Reset();
+  for (StrokeId remaining_id : partition.stroke_ids) {
+    partition.bounds.Add(strokes_.at(remaining_id).bounds);
+  }
+  ++partition.version;
+  return true;
+}
+
+}  // namespace ink::skia_native_internal
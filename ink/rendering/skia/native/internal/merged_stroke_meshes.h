@@ -0,0 +1,125 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INK_RENDERING_SKIA_NATIVE_INTERNAL_MERGED_STROKE_MESHES_H_
+#define INK_RENDERING_SKIA_NATIVE_INTERNAL_MERGED_STROKE_MESHES_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/types/span.h"
+#include "ink/geometry/affine_transform.h"
+#include "ink/geometry/envelope.h"
+#include "ink/geometry/mesh.h"
+#include "ink/strokes/internal/stroke_vertex.h"
+
+namespace ink::skia_native_internal {
+
+// Vertex and index data for the meshes of many strokes, merged so that they
+// can be uploaded to shared GPU buffers and drawn with a few draw calls.
+//
+// Each added stroke mesh is unpacked into the layout of
+// `StrokeVertex::FullMeshFormat()`, i.e. the format of an `InProgressStroke`,
+// with the stroke's transform applied to its positions and derivatives. This
+// means that strokes with different packed formats, coding parameters, and
+// transforms can share buffers, at the cost of the larger unpacked vertices.
+//
+// The data is split into partitions of fewer than 2^16 vertices each, so that
+// every partition can be drawn by `SkMesh` with 16-bit indices. The vertices of
+// one stroke are always in a single partition, and strokes are stored in the
+// order that they were added, so drawing the partitions in order draws the
+// strokes in the order that they were added.
+class MergedStrokeMeshes {
+ public:
+  // Identifies an added stroke. The values are chosen by the caller.
+  using StrokeId = uint32_t;
+
+  // The maximum number of vertices in one partition, which is also the maximum
+  // number of vertices in one added stroke.
+  static constexpr uint32_t kMaxPartitionVertexCount =
+      std::numeric_limits<uint16_t>::max();
+
+  struct Partition {
+    // Returns the vertices as raw bytes, in the layout of
+    // `StrokeVertex::FullMeshFormat()`.
+    absl::Span<const std::byte> RawVertexData() const;
+    // Returns the triangle indices as raw bytes.
+    absl::Span<const std::byte> RawIndexData() const;
+
+    std::vector<strokes_internal::StrokeVertex> vertices;
+    std::vector<uint16_t> indices;
+    Envelope bounds;
+    // Incremented every time that the partition is modified, so that GPU
+    // buffers created from it can be recreated only when it changes.
+    uint32_t version = 0;
+    // The strokes in the partition, in the order of their data.
+    std::vector<StrokeId> stroke_ids;
+  };
+
+  MergedStrokeMeshes() = default;
+  MergedStrokeMeshes(const MergedStrokeMeshes&) = default;
+  MergedStrokeMeshes(MergedStrokeMeshes&&) = default;
+  MergedStrokeMeshes& operator=(const MergedStrokeMeshes&) = default;
+  MergedStrokeMeshes& operator=(MergedStrokeMeshes&&) = default;
+  ~MergedStrokeMeshes() = default;
+
+  // Returns an unimplemented error if `meshes` have `kMaxPartitionVertexCount`
+  // or more vertices in total, and so can't be added.
+  static absl::Status CheckCanAdd(absl::Span<const Mesh> meshes);
+
+  // Appends the vertices and triangles of `meshes`, which should be the meshes
+  // of one render group of a stroke's `PartitionedMesh`, after applying
+  // `transform` to them.
+  //
+  // Returns an invalid-argument error if `id` has already been added, and the
+  // error from `CheckCanAdd` if `meshes` can't be added. The meshes are not
+  // added in either case.
+  absl::Status Add(StrokeId id, absl::Span<const Mesh> meshes,
+                   const AffineTransform& transform);
+
+  // Removes the data for the stroke with `id`, if it has been added. Returns
+  // true if it was found.
+  bool Remove(StrokeId id);
+
+  bool Contains(StrokeId id) const { return strokes_.contains(id); }
+
+  // Returns the number of added strokes that have not been removed.
+  uint32_t StrokeCount() const { return strokes_.size(); }
+
+  // Returns the partitions in drawing order. Removing strokes may leave some
+  // partitions empty.
+  absl::Span<const Partition> Partitions() const { return partitions_; }
+
+ private:
+  // The location of the data of one stroke.
+  struct StrokeRange {
+    uint32_t partition_index;
+    uint32_t first_vertex;
+    uint32_t vertex_count;
+    uint32_t first_index;
+    uint32_t index_count;
+    Envelope bounds;
+  };
+
+  std::vector<Partition> partitions_;
+  absl::flat_hash_map<StrokeId, StrokeRange> strokes_;
+};
+
+}  // namespace ink::skia_native_internal
+
+#endif  // INK_RENDERING_SKIA_NATIVE_INTERNAL_MERGED_STROKE_MESHES_H_
@@ -0,0 +1,289 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ink/rendering/skia/native/internal/merged_stroke_meshes.h"
+
+#include <cstdint>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "ink/geometry/affine_transform.h"
+#include "ink/geometry/envelope.h"
+#include "ink/geometry/mesh.h"
+#include "ink/geometry/mesh_test_helpers.h"
+#include "ink/geometry/mutable_mesh.h"
+#include "ink/geometry/partitioned_mesh.h"
+#include "ink/geometry/point.h"
+#include "ink/geometry/rect.h"
+#include "ink/geometry/type_matchers.h"
+#include "ink/strokes/internal/stroke_vertex.h"
+
+namespace ink::skia_native_internal {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+using ::ink::strokes_internal::StrokeVertex;
+using ::testing::ElementsAre;
+using ::testing::FloatEq;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::Optional;
+
+using Partition = MergedStrokeMeshes::Partition;
+
+// Expects that `partition` holds the vertices and triangles of `mesh`, mapped
+// by `transform`, starting at `first_vertex` and `first_index`.
+void ExpectPartitionHoldsMesh(const Partition& partition, const Mesh& mesh,
+                              const AffineTransform& transform,
+                              uint32_t first_vertex, uint32_t first_index) {
+  ASSERT_GE(partition.vertices.size(), first_vertex + mesh.VertexCount());
+  ASSERT_GE(partition.indices.size(), first_index + 3 * mesh.TriangleCount());
+  for (uint32_t i = 0; i < mesh.VertexCount(); ++i) {
+    EXPECT_THAT(partition.vertices[first_vertex + i].position,
+                PointNear(transform.Apply(mesh.VertexPosition(i)), 1e-5))
+        << "at vertex " << i;
+  }
+  for (uint32_t i = 0; i < mesh.TriangleCount(); ++i) {
+    for (uint32_t j = 0; j < 3; ++j) {
+      EXPECT_EQ(partition.indices[first_index + 3 * i + j],
+                first_vertex + mesh.TriangleIndices(i)[j])
+          << "at triangle " << i;
+    }
+  }
+}
+
+TEST(MergedStrokeMeshesTest, DefaultConstructedIsEmpty) {
+  MergedStrokeMeshes merged;
+  EXPECT_EQ(merged.StrokeCount(), 0u);
+  EXPECT_THAT(merged.Partitions(), IsEmpty());
+  EXPECT_FALSE(merged.Contains(0));
+  EXPECT_FALSE(merged.Remove(0));
+}
+
+TEST(MergedStrokeMeshesTest, AddAppliesTransform) {
+  PartitionedMesh shape = MakeStraightLinePartitionedMesh(4);
+  AffineTransform transform = AffineTransform::Translate({5, -3}) *
+                              AffineTransform::Scale(2);
+  MergedStrokeMeshes merged;
+  ASSERT_THAT(merged.Add(7, shape.Meshes(), transform), IsOk());
+
+  EXPECT_TRUE(merged.Contains(7));
+  EXPECT_EQ(merged.StrokeCount(), 1u);
+  ASSERT_EQ(merged.Partitions().size(), 1u);
+  const Partition& partition = merged.Partitions()[0];
+  EXPECT_EQ(partition.vertices.size(), shape.Meshes()[0].VertexCount());
+  EXPECT_EQ(partition.indices.size(), 12u);
+  ExpectPartitionHoldsMesh(partition, shape.Meshes()[0], transform, 0, 0);
+  Envelope expected_bounds(transform.Apply(*shape.Bounds().AsRect()));
+  EXPECT_THAT(partition.bounds.AsRect(),
+              Optional(RectNear(*expected_bounds.AsRect(), 1e-5)));
+  EXPECT_THAT(partition.stroke_ids, ElementsAre(7));
+  EXPECT_EQ(partition.RawVertexData().size(),
+            partition.vertices.size() *
+                StrokeVertex::FullMeshFormat().UnpackedVertexStride());
+  EXPECT_EQ(partition.RawIndexData().size(), 2 * partition.indices.size());
+}
+
+TEST(MergedStrokeMeshesTest, AddOffsetsIndicesOfLaterStrokes) {
+  PartitionedMesh first = MakeStraightLinePartitionedMesh(3);
+  PartitionedMesh second = MakeStraightLinePartitionedMesh(5);
+  AffineTransform offset = AffineTransform::Translate({0, 10});
+  MergedStrokeMeshes merged;
+  ASSERT_THAT(merged.Add(1, first.Meshes(), AffineTransform()), IsOk());
+  ASSERT_THAT(merged.Add(2, second.Meshes(), offset), IsOk());
+
+  ASSERT_EQ(merged.Partitions().size(), 1u);
+  const Partition& partition = merged.Partitions()[0];
+  EXPECT_THAT(partition.stroke_ids, ElementsAre(1, 2));
+  ExpectPartitionHoldsMesh(partition, first.Meshes()[0], AffineTransform(), 0,
+                           0);
+  ExpectPartitionHoldsMesh(partition, second.Meshes()[0], offset,
+                           first.Meshes()[0].VertexCount(), 9);
+}
+
+TEST(MergedStrokeMeshesTest, AddReadsAndTransformsStrokeAttributes) {
+  MutableMesh mutable_mesh(StrokeVertex::FullMeshFormat());
+  StrokeVertex vertex = {
+      .position = {1, 2},
+      .non_position_attributes = {
+          .opacity_shift = 0.5,
+          .hsl_shift = {0.1, 0.2, 0.3},
+          .side_derivative = {1, 0},
+          .side_label = StrokeVertex::kExteriorLeftLabel,
+          .forward_derivative = {0, 1},
+          .forward_label = StrokeVertex::kExteriorFrontLabel,
+          .surface_uv = {0.25, 0.75},
+          .animation_offset = 0.5,
+      }};
+  StrokeVertex::AppendToMesh(mutable_mesh, vertex);
+  StrokeVertex::AppendToMesh(mutable_mesh, {.position = {3, 2}});
+  StrokeVertex::AppendToMesh(mutable_mesh, {.position = {2, 4}});
+  mutable_mesh.AppendTriangleIndices({0, 1, 2});
+  absl::StatusOr<PartitionedMesh> shape =
+      PartitionedMesh::FromMutableMesh(mutable_mesh);
+  ASSERT_THAT(shape, IsOk());
+
+  MergedStrokeMeshes merged;
+  ASSERT_THAT(merged.Add(0, shape->Meshes(), AffineTransform::Scale(2, 3)),
+              IsOk());
+
+  ASSERT_EQ(merged.Partitions().size(), 1u);
+  ASSERT_EQ(merged.Partitions()[0].vertices.size(), 3u);
+  const StrokeVertex& merged_vertex = merged.Partitions()[0].vertices[0];
+  const StrokeVertex::NonPositionAttributes& attributes =
+      merged_vertex.non_position_attributes;
+  EXPECT_THAT(merged_vertex.position, PointNear({2, 6}, 1e-5));
+  EXPECT_FLOAT_EQ(attributes.opacity_shift, 0.5);
+  EXPECT_THAT(attributes.hsl_shift,
+              ElementsAre(FloatEq(0.1), FloatEq(0.2), FloatEq(0.3)));
+  EXPECT_THAT(attributes.side_derivative, VecNear({2, 0}, 1e-5));
+  EXPECT_EQ(attributes.side_label, StrokeVertex::kExteriorLeftLabel);
+  EXPECT_THAT(attributes.forward_derivative, VecNear({0, 3}, 1e-5));
+  EXPECT_EQ(attributes.forward_label, StrokeVertex::kExteriorFrontLabel);
+  EXPECT_THAT(attributes.surface_uv, PointNear({0.25, 0.75}, 1e-5));
+  EXPECT_FLOAT_EQ(attributes.animation_offset, 0.5);
+}
+
+TEST(MergedStrokeMeshesTest, AddUsesDefaultsForMissingAttributes) {
+  // The default format has only positions.
+  PartitionedMesh shape = MakeStraightLinePartitionedMesh(2);
+  MergedStrokeMeshes merged;
+  ASSERT_THAT(merged.Add(0, shape.Meshes(), AffineTransform()), IsOk());
+
+  ASSERT_EQ(merged.Partitions().size(), 1u);
+  for (const StrokeVertex& vertex : merged.Partitions()[0].vertices) {
+    EXPECT_EQ(vertex.non_position_attributes,
+              StrokeVertex::NonPositionAttributes{});
+  }
+}
+
+TEST(MergedStrokeMeshesTest, AddExistingIdIsAnError) {
+  PartitionedMesh shape = MakeStraightLinePartitionedMesh(2);
+  MergedStrokeMeshes merged;
+  ASSERT_THAT(merged.Add(3, shape.Meshes(), AffineTransform()), IsOk());
+  uint32_t version = merged.Partitions()[0].version;
+
+  EXPECT_THAT(merged.Add(3, shape.Meshes(), AffineTransform()),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("already been added")));
+  EXPECT_EQ(merged.StrokeCount(), 1u);
+  EXPECT_EQ(merged.Partitions()[0].vertices.size(), 4u);
+  EXPECT_EQ(merged.Partitions()[0].version, version);
+}
+
+TEST(MergedStrokeMeshesTest, AddTooManyVerticesIsAnError) {
+  PartitionedMesh shape = MakeStraightLinePartitionedMesh(
+      MergedStrokeMeshes::kMaxPartitionVertexCount);
+  EXPECT_THAT(MergedStrokeMeshes::CheckCanAdd(shape.Meshes()),
+              StatusIs(absl::StatusCode::kUnimplemented, HasSubstr("2^16")));
+  MergedStrokeMeshes merged;
+  EXPECT_THAT(merged.Add(0, shape.Meshes(), AffineTransform()),
+              StatusIs(absl::StatusCode::kUnimplemented, HasSubstr("2^16")));
+  EXPECT_FALSE(merged.Contains(0));
+  EXPECT_THAT(merged.Partitions(), IsEmpty());
+}
+
+TEST(MergedStrokeMeshesTest, AddStartsNewPartitionWhenFull) {
+  // Each of these has 32002 vertices, so only two fit into one partition.
+  PartitionedMesh shape = MakeStraightLinePartitionedMesh(32000);
+  MergedStrokeMeshes merged;
+  for (uint32_t id = 0; id < 3; ++id) {
+    ASSERT_THAT(merged.Add(id, shape.Meshes(), AffineTransform()), IsOk());
+  }
+
+  ASSERT_EQ(merged.Partitions().size(), 2u);
+  EXPECT_THAT(merged.Partitions()[0].stroke_ids, ElementsAre(0, 1));
+  EXPECT_THAT(merged.Partitions()[1].stroke_ids, ElementsAre(2));
+  ExpectPartitionHoldsMesh(merged.Partitions()[1], shape.Meshes()[0],
+                           AffineTransform(), 0, 0);
+}
+
+TEST(MergedStrokeMeshesTest, RemoveShiftsLaterStrokesInPartition) {
+  PartitionedMesh first = MakeStraightLinePartitionedMesh(3);
+  PartitionedMesh second = MakeStraightLinePartitionedMesh(5);
+  PartitionedMesh third = MakeStraightLinePartitionedMesh(2);
+  AffineTransform third_transform = AffineTransform::Translate({0, 20});
+  MergedStrokeMeshes merged;
+  ASSERT_THAT(merged.Add(1, first.Meshes(), AffineTransform()), IsOk());
+  ASSERT_THAT(merged.Add(2, second.Meshes(),
+                         AffineTransform::Translate({0, 10})),
+              IsOk());
+  ASSERT_THAT(merged.Add(3, third.Meshes(), third_transform), IsOk());
+  uint32_t version = merged.Partitions()[0].version;
+
+  EXPECT_TRUE(merged.Remove(2));
+
+  EXPECT_FALSE(merged.Contains(2));
+  EXPECT_EQ(merged.StrokeCount(), 2u);
+  ASSERT_EQ(merged.Partitions().size(), 1u);
+  const Partition& partition = merged.Partitions()[0];
+  EXPECT_NE(partition.version, version);
+  EXPECT_THAT(partition.stroke_ids, ElementsAre(1, 3));
+  EXPECT_EQ(partition.vertices.size(),
+            first.Meshes()[0].VertexCount() + third.Meshes()[0].VertexCount());
+  EXPECT_EQ(partition.indices.size(), 15u);
+  ExpectPartitionHoldsMesh(partition, first.Meshes()[0], AffineTransform(), 0,
+                           0);
+  ExpectPartitionHoldsMesh(partition, third.Meshes()[0], third_transform,
+                           first.Meshes()[0].VertexCount(), 9);
+  EXPECT_FALSE(merged.Remove(2));
+
+  // Removing the first stroke should shift the third stroke again, which
+  // checks that its range was updated by the first removal.
+  EXPECT_TRUE(merged.Remove(1));
+  ExpectPartitionHoldsMesh(merged.Partitions()[0], third.Meshes()[0],
+                           third_transform, 0, 0);
+}
+
+TEST(MergedStrokeMeshesTest, RemoveRecomputesBounds) {
+  PartitionedMesh shape = MakeStraightLinePartitionedMesh(2);
+  MergedStrokeMeshes merged;
+  ASSERT_THAT(merged.Add(1, shape.Meshes(), AffineTransform()), IsOk());
+  ASSERT_THAT(
+      merged.Add(2, shape.Meshes(), AffineTransform::Translate({100, 100})),
+      IsOk());
+
+  EXPECT_TRUE(merged.Remove(2));
+  EXPECT_THAT(merged.Partitions()[0].bounds.AsRect(),
+              Optional(RectEq(*shape.Bounds().AsRect())));
+
+  EXPECT_TRUE(merged.Remove(1));
+  EXPECT_FALSE(merged.Partitions()[0].bounds.AsRect().has_value());
+  EXPECT_THAT(merged.Partitions()[0].vertices, IsEmpty());
+  EXPECT_THAT(merged.Partitions()[0].indices, IsEmpty());
+}
+
+TEST(MergedStrokeMeshesTest, ReaddAfterRemove) {
+  PartitionedMesh shape = MakeStraightLinePartitionedMesh(2);
+  MergedStrokeMeshes merged;
+  ASSERT_THAT(merged.Add(1, shape.Meshes(), AffineTransform()), IsOk());
+  ASSERT_THAT(merged.Add(2, shape.Meshes(), AffineTransform()), IsOk());
+  ASSERT_TRUE(merged.Remove(1));
+
+  AffineTransform transform = AffineTransform::Translate({-4, 0});
+  ASSERT_THAT(merged.Add(1, shape.Meshes(), transform), IsOk());
+
+  // The re-added stroke is drawn after the stroke that was added before it.
+  ASSERT_EQ(merged.Partitions().size(), 1u);
+  EXPECT_THAT(merged.Partitions()[0].stroke_ids, ElementsAre(2, 1));
+  ExpectPartitionHoldsMesh(merged.Partitions()[0], shape.Meshes()[0],
+                           transform, shape.Meshes()[0].VertexCount(), 6);
+}
+
+}  // namespace
+}  // namespace ink::skia_native_internal
@@ -39,7 +39,11 @@ absl::StatusOr<sk_sp<SkMeshSpecification>> MeshSpecificationCache::GetFor(
   if (stroke.GetBrush() == nullptr) {
     return absl::InvalidArgumentError("`stroke.Start()` has not been called.");
   }
+  return GetForInProgressStrokeFormat();
+}
 
+sk_sp<SkMeshSpecification>
+MeshSpecificationCache::GetForInProgressStrokeFormat() {
   if (in_progress_stroke_specification_ == nullptr) {
     absl::StatusOr<sk_sp<SkMeshSpecification>> specification =
         CreateMeshSpecification(
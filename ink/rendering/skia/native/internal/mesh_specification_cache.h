@@ -51,6 +51,10 @@ class MeshSpecificationCache {
   absl::StatusOr<sk_sp<SkMeshSpecification>> GetFor(
       const InProgressStroke& stroke);
 
+  // Returns the specification for vertices in the unpacked layout of an
+  // `InProgressStroke` mesh, i.e. that of `StrokeVertex::FullMeshFormat()`.
+  sk_sp<SkMeshSpecification> GetForInProgressStrokeFormat();
+
   // Returns the specification for a `PartitionedMesh` created for a `Stroke`.
   //
   // An invalid-argument error is returned if `stroke_shape` either has no
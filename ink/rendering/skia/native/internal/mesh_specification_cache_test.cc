@@ -99,6 +99,18 @@ TEST(MeshSpecificationCacheTest, GetForStartedInProgressStrokeWithEmptyMesh) {
   EXPECT_THAT(cache.GetFor(stroke), IsOkAndHolds(Pointer(NotNull())));
 }
 
+TEST(MeshSpecificationCacheTest, GetForInProgressStrokeFormat) {
+  MeshSpecificationCache cache;
+  sk_sp<SkMeshSpecification> specification =
+      cache.GetForInProgressStrokeFormat();
+  EXPECT_THAT(specification, Pointer(NotNull()));
+
+  // The specification should be shared with in-progress strokes.
+  InProgressStroke stroke;
+  stroke.Start(GetTestBrush());
+  EXPECT_THAT(cache.GetFor(stroke), IsOkAndHolds(Eq(specification)));
+}
+
 TEST(MeshSpecificationCacheTest, GetForUnstartedInProgressStroke) {
   MeshSpecificationCache cache;
   InProgressStroke stroke;
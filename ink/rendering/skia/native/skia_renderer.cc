@@ -25,6 +25,7 @@
 #include <vector>
 
 #include "absl/base/nullability.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/container/inlined_vector.h"
 #include "absl/functional/overload.h"
@@ -32,6 +33,7 @@
 #include "absl/status/status.h"
 #include "absl/status/status_macros.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/substitute.h"
 #include "absl/types/span.h"
 #include "ink/brush/brush.h"
 #include "ink/brush/brush_coat.h"
@@ -45,6 +47,7 @@
 #include "ink/geometry/mutable_mesh.h"
 #include "ink/geometry/partitioned_mesh.h"
 #include "ink/geometry/rect.h"
+#include "ink/rendering/skia/native/internal/merged_stroke_meshes.h"
 #include "ink/rendering/skia/native/internal/mesh_drawable.h"
 #include "ink/rendering/skia/native/internal/mesh_uniform_data.h"
 #include "ink/rendering/skia/native/internal/path_drawable.h"
@@ -65,6 +68,7 @@
 namespace ink {
 namespace {
 
+using ::ink::skia_native_internal::MergedStrokeMeshes;
 using ::ink::skia_native_internal::MeshDrawable;
 using ::ink::skia_native_internal::MeshUniformData;
 using ::ink::skia_native_internal::PathDrawable;
@@ -106,15 +110,21 @@ bool MeshFormatSupports(const MeshFormat& mesh_format,
   return required_attribute_ids.empty();
 }
 
+// Returns whether mesh rendering with a non-null `GrDirectContext` is
+// supported for the given `paint` and `mesh_format`.
+bool IsMeshRenderingSupported(const BrushPaint& paint,
+                              const MeshFormat& mesh_format) {
+  return brush_internal::AllowsSelfOverlapMode(
+             paint, BrushPaint::SelfOverlap::kAccumulate) &&
+         MeshFormatSupports(mesh_format, paint);
+}
+
 // Returns whether mesh rendering is supported for the given `paint`, `tip` and
 // `mesh_format`.
 bool IsMeshRenderingSupported(GrDirectContext* const absl_nullable context,
                               const BrushPaint& paint,
                               const MeshFormat& mesh_format) {
-  return context != nullptr &&
-         brush_internal::AllowsSelfOverlapMode(
-             paint, BrushPaint::SelfOverlap::kAccumulate) &&
-         MeshFormatSupports(mesh_format, paint);
+  return context != nullptr && IsMeshRenderingSupported(paint, mesh_format);
 }
 
 // Returns whether path rendering is supported for the given `paint`.
@@ -128,21 +138,44 @@ bool IsPathRenderingSupported(const BrushPaint& paint) {
              paint, BrushPaint::SelfOverlap::kDiscard);
 }
 
+// Returns the paint preference of `coat` that a stroke coat with `mesh_format`
+// would be drawn with, if that paint can be drawn as part of a `StrokeBatch`.
+// Returns an invalid-argument error otherwise.
+absl::StatusOr<const BrushPaint*> GetBatchablePaint(
+    const BrushCoat& coat, const MeshFormat& mesh_format) {
+  // This follows the choice of paint in `CreateDrawableImpl()` when given a
+  // non-null `GrDirectContext`.
+  for (const BrushPaint& paint : coat.paint_preferences) {
+    if (IsMeshRenderingSupported(paint, mesh_format)) {
+      if (!paint.texture_layers.empty()) {
+        return absl::InvalidArgumentError(
+            "Brush coats with texture layers can not be batched.");
+      }
+      return &paint;
+    } else if (IsPathRenderingSupported(paint)) {
+      return absl::InvalidArgumentError(
+          "Brush coats that are drawn as paths can not be batched.");
+    }
+  }
+  return absl::InvalidArgumentError(
+      "No supported paint preferences for this brush coat.");
+}
+
 absl::StatusOr<MeshDrawable> CreateAndInitializeMeshDrawable(
-    const StrokeInputBatch& inputs, const Brush& brush,
+    const StrokeInputBatch& inputs, float brush_size, const Color& brush_color,
     const BrushPaint& brush_paint,
     skia_native_internal::ShaderCache& shader_cache,
     MeshUniformData&& uniform_data, sk_sp<SkMeshSpecification> specification,
     absl::InlinedVector<MeshDrawable::Partition, 1>&& partitions) {
   ABSL_ASSIGN_OR_RETURN(
       sk_sp<SkShader> shader,
-      shader_cache.GetShaderForPaint(brush_paint, brush.GetSize(), inputs));
+      shader_cache.GetShaderForPaint(brush_paint, brush_size, inputs));
   ABSL_ASSIGN_OR_RETURN(
       MeshDrawable mesh_drawable,
       MeshDrawable::Create(
           specification, shader_cache.GetBlenderForPaint(brush_paint), shader,
           brush_paint.color_functions, partitions, std::move(uniform_data)));
-  mesh_drawable.SetBrushColor(brush.GetColor());
+  mesh_drawable.SetBrushColor(brush_color);
   // Currently, validation enforces that these values are all the same for all
   // texture layers in a given paint. If there are no texture layers, use the
   // default "tiling" behavior. When there is no animation, the default of 1 for
@@ -233,8 +266,8 @@ absl::StatusOr<MeshDrawable> SkiaRenderer::CreateMeshDrawable(
 
   MeshUniformData uniform_data(*specification);
   return CreateAndInitializeMeshDrawable(
-      stroke.GetInputs(), brush, brush_paint, shader_cache_,
-      std::move(uniform_data), std::move(specification),
+      stroke.GetInputs(), brush.GetSize(), brush.GetColor(), brush_paint,
+      shader_cache_, std::move(uniform_data), std::move(specification),
       {{
           .vertex_buffer = SkMeshes::MakeVertexBuffer(
               context, vertex_data.data(), vertex_data.size()),
@@ -355,9 +388,58 @@ absl::StatusOr<MeshDrawable> SkiaRenderer::CreateMeshDrawable(
   MeshUniformData uniform_data(*specification, first_mesh.Format().Attributes(),
                                get_attribute_unpacking_transform);
 
+  const Brush& brush = stroke.GetBrush();
   return CreateAndInitializeMeshDrawable(
-      stroke.GetInputs(), stroke.GetBrush(), brush_paint, shader_cache_,
-      std::move(uniform_data), std::move(specification), std::move(partitions));
+      stroke.GetInputs(), brush.GetSize(), brush.GetColor(), brush_paint,
+      shader_cache_, std::move(uniform_data), std::move(specification),
+      std::move(partitions));
+}
+
+absl::StatusOr<MeshDrawable> SkiaRenderer::CreateMeshDrawable(
+    GrDirectContext* const absl_nonnull context, StrokeBatch::Group& group) {
+  absl::Span<const MergedStrokeMeshes::Partition> merged_partitions =
+      group.meshes.Partitions();
+  group.uploaded_partitions.resize(merged_partitions.size());
+
+  absl::InlinedVector<MeshDrawable::Partition, 1> partitions;
+  for (size_t i = 0; i < merged_partitions.size(); ++i) {
+    const MergedStrokeMeshes::Partition& merged = merged_partitions[i];
+    if (merged.indices.empty()) continue;
+
+    // Only re-upload the partitions that have changed since the last draw.
+    StrokeBatch::UploadedPartition& uploaded = group.uploaded_partitions[i];
+    if (uploaded.vertex_buffer == nullptr ||
+        uploaded.version != merged.version) {
+      absl::Span<const std::byte> vertex_data = merged.RawVertexData();
+      absl::Span<const std::byte> index_data = merged.RawIndexData();
+      uploaded = {
+          .version = merged.version,
+          .vertex_buffer = SkMeshes::MakeVertexBuffer(
+              context, vertex_data.data(), vertex_data.size()),
+          .index_buffer = SkMeshes::MakeIndexBuffer(context, index_data.data(),
+                                                    index_data.size()),
+      };
+    }
+    partitions.push_back({
+        .vertex_buffer = uploaded.vertex_buffer,
+        .index_buffer = uploaded.index_buffer,
+        .vertex_count = static_cast<int32_t>(merged.vertices.size()),
+        .index_count = static_cast<int32_t>(merged.indices.size()),
+        .bounds = ToSkiaRect(*merged.bounds.AsRect()),
+    });
+  }
+
+  // The merged vertices are unpacked, so they use the same specification as
+  // an `InProgressStroke`, without any unpacking transforms.
+  sk_sp<SkMeshSpecification> specification =
+      specification_cache_.GetForInProgressStrokeFormat();
+  MeshUniformData uniform_data(*specification);
+  // Batched paints have no texture layers, so the shader doesn't depend on the
+  // size or the inputs of any stroke.
+  return CreateAndInitializeMeshDrawable(
+      StrokeInputBatch(), /* brush_size = */ 0, group.brush_color, group.paint,
+      shader_cache_, std::move(uniform_data), std::move(specification),
+      std::move(partitions));
 }
 
 absl::Status SkiaRenderer::Draw(GrDirectContext* absl_nullable context,
@@ -384,6 +466,153 @@ absl::Status SkiaRenderer::Draw(GrDirectContext* absl_nullable context,
   return absl::OkStatus();
 }
 
+absl::Status SkiaRenderer::Draw(GrDirectContext* absl_nullable context,
+                                StrokeBatch& batch,
+                                const AffineTransform& batch_to_canvas,
+                                SkCanvas& canvas) {
+  if (context == nullptr) {
+    return absl::InvalidArgumentError(
+        "Drawing a `StrokeBatch` requires a `GrDirectContext`.");
+  }
+  if (batch.context_ != context) {
+    for (StrokeBatch::Group& group : batch.groups_) {
+      group.uploaded_partitions.clear();
+    }
+    batch.context_ = context;
+  }
+
+  absl::InlinedVector<Drawable::Implementation, 1> drawables;
+  for (size_t group_index : batch.draw_order_) {
+    ABSL_ASSIGN_OR_RETURN(
+        MeshDrawable drawable,
+        CreateMeshDrawable(context, batch.groups_[group_index]));
+    drawables.push_back(std::move(drawable));
+  }
+  Drawable(batch_to_canvas, std::move(drawables)).Draw(canvas);
+  return absl::OkStatus();
+}
+
+absl::Status SkiaRenderer::StrokeBatch::Add(
+    StrokeId id, const Stroke& stroke, const AffineTransform& stroke_to_batch) {
+  if (stroke_groups_.contains(id)) {
+    return absl::InvalidArgumentError(
+        absl::Substitute("Stroke with id $0 is already in the batch.", id));
+  }
+
+  // Choose the paint for every coat before adding any of them, so that the
+  // batch is left unchanged if one of the coats can't be batched.
+  const PartitionedMesh& shape = stroke.GetShape();
+  const Brush& brush = stroke.GetBrush();
+  absl::InlinedVector<const BrushPaint*, 1> coat_paints(
+      shape.RenderGroupCount(), nullptr);
+  for (uint32_t coat_index = 0; coat_index < shape.RenderGroupCount();
+       ++coat_index) {
+    if (shape.RenderGroupMeshes(coat_index).empty()) continue;
+    ABSL_ASSIGN_OR_RETURN(
+        coat_paints[coat_index],
+        GetBatchablePaint(brush.GetCoats()[coat_index],
+                          shape.RenderGroupFormat(coat_index)));
+  }
+
+  // Check that every coat can be added before creating any groups.
+  for (uint32_t coat_index = 0; coat_index < shape.RenderGroupCount();
+       ++coat_index) {
+    if (coat_paints[coat_index] == nullptr) continue;
+    ABSL_RETURN_IF_ERROR(
+        MergedStrokeMeshes::CheckCanAdd(shape.RenderGroupMeshes(coat_index)));
+  }
+
+  absl::InlinedVector<size_t, 1>& stroke_groups = stroke_groups_[id];
+  for (uint32_t coat_index = 0; coat_index < shape.RenderGroupCount();
+       ++coat_index) {
+    const BrushPaint* paint = coat_paints[coat_index];
+    if (paint == nullptr) continue;
+    size_t group_index =
+        FindOrCreateGroup(coat_index, *paint, brush.GetColor());
+    // This can't fail, since `id` is not in any group yet, and the meshes have
+    // been checked above.
+    ABSL_CHECK_OK(groups_[group_index].meshes.Add(
+        id, shape.RenderGroupMeshes(coat_index), stroke_to_batch));
+    stroke_groups.push_back(group_index);
+  }
+  return absl::OkStatus();
+}
+
+size_t SkiaRenderer::StrokeBatch::FindOrCreateGroup(uint32_t coat_index,
+                                                    const BrushPaint& paint,
+                                                    const Color& brush_color) {
+  auto [it, inserted] =
+      group_indices_.try_emplace(GroupKey(coat_index, paint, brush_color), 0);
+  if (!inserted) return it->second;
+
+  size_t group_index;
+  if (free_group_indices_.empty()) {
+    group_index = groups_.size();
+    groups_.emplace_back();
+  } else {
+    group_index = free_group_indices_.back();
+    free_group_indices_.pop_back();
+  }
+  it->second = group_index;
+  Group& group = groups_[group_index];
+  group.coat_index = coat_index;
+  group.paint = paint;
+  group.brush_color = brush_color;
+
+  // Draw the new group after every group for the same or an earlier coat, so
+  // that it is drawn after the earlier coats of any stroke added to it.
+  draw_order_.insert(
+      std::upper_bound(draw_order_.begin(), draw_order_.end(), coat_index,
+                       [this](uint32_t coat_index, size_t group_index) {
+                         return coat_index < groups_[group_index].coat_index;
+                       }),
+      group_index);
+  return group_index;
+}
+
+bool SkiaRenderer::StrokeBatch::Remove(StrokeId id) {
+  auto it = stroke_groups_.find(id);
+  if (it == stroke_groups_.end()) return false;
+  for (size_t group_index : it->second) {
+    Group& group = groups_[group_index];
+    group.meshes.Remove(id);
+    if (group.meshes.StrokeCount() > 0) continue;
+
+    group_indices_.erase(
+        GroupKey(group.coat_index, group.paint, group.brush_color));
+    draw_order_.erase(
+        std::find(draw_order_.begin(), draw_order_.end(), group_index));
+    group = Group();
+    free_group_indices_.push_back(group_index);
+  }
+  stroke_groups_.erase(it);
+  return true;
+}
+
+std::vector<size_t> SkiaRenderer::StrokeBatch::DebugGroupDrawOrder(
+    StrokeId id) const {
+  std::vector<size_t> positions;
+  auto it = stroke_groups_.find(id);
+  if (it == stroke_groups_.end()) return positions;
+  for (size_t group_index : it->second) {
+    positions.push_back(
+        std::find(draw_order_.begin(), draw_order_.end(), group_index) -
+        draw_order_.begin());
+  }
+  return positions;
+}
+
+int SkiaRenderer::StrokeBatch::DrawCallCount() const {
+  int count = 0;
+  for (const Group& group : groups_) {
+    for (const MergedStrokeMeshes::Partition& partition :
+         group.meshes.Partitions()) {
+      if (!partition.indices.empty()) ++count;
+    }
+  }
+  return count;
+}
+
 namespace {
 
 SkM44 ToSkiaM44(const AffineTransform& t) {
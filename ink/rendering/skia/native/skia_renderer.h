@@ -15,12 +15,16 @@
 #ifndef INK_RENDERING_SKIA_NATIVE_SKIA_RENDERER_H_
 #define INK_RENDERING_SKIA_NATIVE_SKIA_RENDERER_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <tuple>
+#include <utility>
 #include <variant>
 #include <vector>
 
 #include "absl/base/nullability.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/inlined_vector.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -28,6 +32,7 @@
 #include "ink/brush/brush_paint.h"
 #include "ink/color/color.h"
 #include "ink/geometry/affine_transform.h"
+#include "ink/rendering/skia/native/internal/merged_stroke_meshes.h"
 #include "ink/rendering/skia/native/internal/mesh_drawable.h"
 #include "ink/rendering/skia/native/internal/mesh_specification_cache.h"
 #include "ink/rendering/skia/native/internal/path_drawable.h"
@@ -141,6 +146,116 @@ class SkiaRenderer {
     absl::InlinedVector<Implementation, 1> drawable_implementations_;
   };
 
+  // A set of `Stroke`s that are drawn together with few draw calls.
+  //
+  // Drawing strokes one at a time takes at least one draw call per coat of
+  // every stroke, which dominates the cost of drawing documents made of many
+  // small strokes, such as handwriting. A batch instead merges the coat meshes
+  // of compatible strokes into shared vertex and index buffers, and draws each
+  // buffer with a single draw call. Coats are compatible if they have the same
+  // index in their brushes and are drawn with the same `BrushPaint` and brush
+  // color. The transform of each stroke is applied to its vertices as it is
+  // added, so strokes with different transforms can share buffers.
+  //
+  // Strokes can be added and removed as they change, and only the buffers
+  // holding modified strokes are re-uploaded on the next draw. Within a group
+  // of compatible coats, strokes are drawn in the order that they were added,
+  // but the groups are drawn one after the other. Groups are drawn in order of
+  // coat index, so the coats of each stroke are drawn in order. Strokes that
+  // overlap and must be drawn in a particular order relative to strokes of a
+  // different color, paint, or number of coats should be put into separate
+  // batches.
+  //
+  // Only coats that would be drawn as meshes, and whose paint has no texture
+  // layers, can be batched, because the textures of a coat depend on the size
+  // and inputs of its stroke. Strokes that can't be batched should be drawn
+  // individually.
+  //
+  // This type is thread-compatible, but *not* thread-safe. A batch should
+  // always be drawn with the same `GrDirectContext`; its buffers are
+  // re-uploaded whenever the context changes.
+  class StrokeBatch {
+   public:
+    // Identifies a stroke in the batch. The values are chosen by the caller.
+    using StrokeId = skia_native_internal::MergedStrokeMeshes::StrokeId;
+
+    StrokeBatch() = default;
+    StrokeBatch(const StrokeBatch&) = default;
+    StrokeBatch(StrokeBatch&&) = default;
+    StrokeBatch& operator=(const StrokeBatch&) = default;
+    StrokeBatch& operator=(StrokeBatch&&) = default;
+    ~StrokeBatch() = default;
+
+    // Adds `stroke` to the batch with the given `id`, mapping its vertices by
+    // `stroke_to_batch`.
+    //
+    // Returns an invalid-argument error if `id` is already in the batch, or if
+    // any coat of `stroke` can't be batched, and an unimplemented error if a
+    // coat has 2^16 or more vertices. The batch is unchanged in either case.
+    absl::Status Add(StrokeId id, const Stroke& stroke,
+                     const AffineTransform& stroke_to_batch = {});
+
+    // Removes the stroke with `id` from the batch, if present. Returns true if
+    // it was found.
+    bool Remove(StrokeId id);
+
+    bool Contains(StrokeId id) const { return stroke_groups_.contains(id); }
+
+    // Returns the number of draw calls that drawing the batch will take.
+    int DrawCallCount() const;
+
+    // For testing only: Returns the position in the draw order of the group
+    // holding each non-empty coat of the stroke with `id`, in order of coat
+    // index. Returns an empty vector if `id` is not in the batch.
+    std::vector<size_t> DebugGroupDrawOrder(StrokeId id) const;
+
+   private:
+    friend SkiaRenderer;
+
+    // GPU buffers created from a `MergedStrokeMeshes::Partition`.
+    struct UploadedPartition {
+      // The `MergedStrokeMeshes::Partition::version` that the buffers hold.
+      uint32_t version = 0;
+      sk_sp<SkMesh::VertexBuffer> vertex_buffer;
+      sk_sp<SkMesh::IndexBuffer> index_buffer;
+    };
+
+    // The merged coats at `coat_index` that are drawn with one `paint` and
+    // `brush_color`.
+    struct Group {
+      uint32_t coat_index = 0;
+      BrushPaint paint;
+      Color brush_color;
+      skia_native_internal::MergedStrokeMeshes meshes;
+      // Parallel to `meshes.Partitions()`, but only updated on draw.
+      std::vector<UploadedPartition> uploaded_partitions;
+    };
+
+    using GroupKey = std::tuple<uint32_t, BrushPaint, Color>;
+
+    // Returns the index into `groups_` of the group for the given coat index,
+    // paint, and brush color, creating it if necessary.
+    size_t FindOrCreateGroup(uint32_t coat_index, const BrushPaint& paint,
+                             const Color& brush_color);
+
+    // Groups that are emptied by `Remove()` are reset, and their indices are
+    // reused by the next groups to be created.
+    std::vector<Group> groups_;
+    std::vector<size_t> free_group_indices_;
+    // Indices into `groups_` of every non-empty group, in the order that they
+    // are drawn. This is sorted by coat index, and groups with the same coat
+    // index are drawn in the order that they were created.
+    std::vector<size_t> draw_order_;
+    // Index into `groups_` for each coat index, paint, and brush color.
+    absl::flat_hash_map<GroupKey, size_t> group_indices_;
+    // Indices into `groups_` of the groups holding the coats of each stroke, in
+    // order of coat index.
+    absl::flat_hash_map<StrokeId, absl::InlinedVector<size_t, 1>>
+        stroke_groups_;
+    // The context that the buffers in `groups_` were uploaded with.
+    GrDirectContext* absl_nullable context_ = nullptr;
+  };
+
   explicit SkiaRenderer(absl_nullable std::shared_ptr<TextureBitmapStore>
                             texture_provider = nullptr);
 
@@ -169,6 +284,19 @@ class SkiaRenderer {
                     const Stroke& stroke,
                     const AffineTransform& object_to_canvas, SkCanvas& canvas);
 
+  // Draws every stroke in the `batch` into the `canvas`, with `batch_to_canvas`
+  // mapping the coordinates that the strokes were added to the batch in to
+  // those of the canvas.
+  //
+  // This uploads any parts of the batch that have changed since it was last
+  // drawn, and so must be called from the `GrDirectContext` thread. Returns an
+  // invalid-argument error if `context` is null, because batched strokes are
+  // only drawn as meshes.
+  //
+  // NOTE: Like the functions above, this function calls `canvas.setMatrix()`.
+  absl::Status Draw(GrDirectContext* absl_nullable context, StrokeBatch& batch,
+                    const AffineTransform& batch_to_canvas, SkCanvas& canvas);
+
   // Return a new `Drawable` created from an `InProgressStroke`.
   //
   // The returned drawable will have its transform set to `object_to_canvas` and
@@ -235,6 +363,9 @@ class SkiaRenderer {
   absl::StatusOr<skia_native_internal::PathDrawable> CreatePathDrawable(
       const Stroke& stroke, uint32_t coat_index, const BrushPaint& brush_paint,
       const Brush& brush);
+
+  absl::StatusOr<skia_native_internal::MeshDrawable> CreateMeshDrawable(
+      GrDirectContext* const absl_nonnull context, StrokeBatch::Group& group);
 };
 
 }  // namespace ink
@@ -14,16 +14,44 @@
 
 #include "ink/rendering/skia/native/skia_renderer.h"
 
+#include <string>
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "ink/brush/brush.h"
+#include "ink/brush/brush_coat.h"
+#include "ink/brush/brush_family.h"
+#include "ink/brush/brush_paint.h"
+#include "ink/brush/brush_tip.h"
 #include "ink/color/color.h"
 #include "ink/geometry/affine_transform.h"
 #include "ink/geometry/angle.h"
+#include "ink/geometry/mesh_test_helpers.h"
+#include "ink/geometry/mutable_mesh.h"
+#include "ink/geometry/partitioned_mesh.h"
+#include "ink/geometry/point.h"
 #include "ink/geometry/type_matchers.h"
+#include "ink/geometry/vec.h"
+#include "ink/strokes/input/stroke_input.h"
+#include "ink/strokes/input/stroke_input_batch.h"
+#include "ink/strokes/stroke.h"
+#include "ink/types/duration.h"
 
 namespace ink {
 namespace {
 
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+
 // This test contains the cases that do not require a `GrDirectContext`.
 
 TEST(SkiaRendererDrawableTest, SetObjectToCanvas) {
@@ -37,5 +65,208 @@ TEST(SkiaRendererDrawableTest, SetObjectToCanvas) {
   EXPECT_THAT(drawable.ObjectToCanvas(), AffineTransformEq(transform));
 }
 
+Brush MakeBrush(absl::Span<const BrushCoat> coats,
+               const Color& color = Color::Black()) {
+  absl::StatusOr<BrushFamily> family = BrushFamily::Create(coats);
+  ABSL_CHECK_OK(family);
+  absl::StatusOr<Brush> brush = Brush::Create(*family, color, 1, 0.1);
+  ABSL_CHECK_OK(brush);
+  return *brush;
+}
+
+Brush MakeBrush(const BrushPaint& paint, const Color& color = Color::Black()) {
+  return MakeBrush({BrushCoat{.tip = BrushTip{}, .paint_preferences = {paint}}},
+                   color);
+}
+
+// Returns a short straight stroke starting at `start`.
+Stroke MakeStroke(const Brush& brush, Point start = {0, 0}) {
+  std::vector<StrokeInput> inputs;
+  for (int i = 0; i < 3; ++i) {
+    inputs.push_back({.position = start + Vec{2.f * i, 0},
+                      .elapsed_time = Duration32::Seconds(0.01f * i)});
+  }
+  absl::StatusOr<StrokeInputBatch> batch = StrokeInputBatch::Create(inputs);
+  ABSL_CHECK_OK(batch);
+  return Stroke(brush, *batch);
+}
+
+TEST(SkiaRendererStrokeBatchTest, DefaultConstructedIsEmpty) {
+  SkiaRenderer::StrokeBatch batch;
+  EXPECT_EQ(batch.DrawCallCount(), 0);
+  EXPECT_FALSE(batch.Contains(0));
+  EXPECT_FALSE(batch.Remove(0));
+}
+
+TEST(SkiaRendererStrokeBatchTest, MergesStrokesWithSamePaintAndColor) {
+  Brush brush = MakeBrush(BrushPaint{});
+  SkiaRenderer::StrokeBatch batch;
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_THAT(batch.Add(i, MakeStroke(brush, {0, 5.f * i}),
+                          AffineTransform::Translate({-3, 0})),
+                IsOk());
+  }
+  EXPECT_EQ(batch.DrawCallCount(), 1);
+
+  // A stroke of another color needs another draw call.
+  ASSERT_THAT(batch.Add(10, MakeStroke(MakeBrush(BrushPaint{}, Color::Red()))),
+              IsOk());
+  EXPECT_EQ(batch.DrawCallCount(), 2);
+
+  // So does a stroke with another paint.
+  BrushPaint accumulate_paint = {
+      .self_overlap = BrushPaint::SelfOverlap::kAccumulate};
+  ASSERT_THAT(batch.Add(11, MakeStroke(MakeBrush(accumulate_paint))), IsOk());
+  EXPECT_EQ(batch.DrawCallCount(), 3);
+}
+
+TEST(SkiaRendererStrokeBatchTest, AddAndRemove) {
+  Brush brush = MakeBrush(BrushPaint{});
+  SkiaRenderer::StrokeBatch batch;
+  ASSERT_THAT(batch.Add(1, MakeStroke(brush)), IsOk());
+  ASSERT_THAT(batch.Add(2, MakeStroke(brush, {0, 10})), IsOk());
+  ASSERT_THAT(batch.Add(3, MakeStroke(MakeBrush(BrushPaint{}, Color::Blue()))),
+              IsOk());
+  EXPECT_TRUE(batch.Contains(2));
+  EXPECT_EQ(batch.DrawCallCount(), 2);
+
+  EXPECT_TRUE(batch.Remove(2));
+  EXPECT_FALSE(batch.Contains(2));
+  EXPECT_FALSE(batch.Remove(2));
+  EXPECT_EQ(batch.DrawCallCount(), 2);
+
+  EXPECT_TRUE(batch.Remove(3));
+  EXPECT_EQ(batch.DrawCallCount(), 1);
+  EXPECT_TRUE(batch.Remove(1));
+  EXPECT_EQ(batch.DrawCallCount(), 0);
+
+  // A removed id can be added again.
+  EXPECT_THAT(batch.Add(2, MakeStroke(brush)), IsOk());
+  EXPECT_EQ(batch.DrawCallCount(), 1);
+}
+
+TEST(SkiaRendererStrokeBatchTest, AddExistingIdIsAnError) {
+  Brush brush = MakeBrush(BrushPaint{});
+  SkiaRenderer::StrokeBatch batch;
+  ASSERT_THAT(batch.Add(1, MakeStroke(brush)), IsOk());
+  EXPECT_THAT(batch.Add(1, MakeStroke(brush)),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("already in the batch")));
+  EXPECT_EQ(batch.DrawCallCount(), 1);
+}
+
+TEST(SkiaRendererStrokeBatchTest, CoatsWithSamePaintAreDrawnInOrder) {
+  BrushCoat coat = {.tip = BrushTip{}, .paint_preferences = {BrushPaint{}}};
+  SkiaRenderer::StrokeBatch batch;
+  ASSERT_THAT(batch.Add(1, MakeStroke(MakeBrush({coat, coat}))), IsOk());
+  EXPECT_EQ(batch.DrawCallCount(), 2);
+  EXPECT_THAT(batch.DebugGroupDrawOrder(1), ElementsAre(0, 1));
+
+  // Coats at the same index of other strokes share their draw calls.
+  ASSERT_THAT(batch.Add(2, MakeStroke(MakeBrush({coat, coat}), {0, 10})),
+              IsOk());
+  EXPECT_EQ(batch.DrawCallCount(), 2);
+  EXPECT_THAT(batch.DebugGroupDrawOrder(2), ElementsAre(0, 1));
+
+  EXPECT_TRUE(batch.Remove(1));
+  EXPECT_TRUE(batch.Remove(2));
+  EXPECT_EQ(batch.DrawCallCount(), 0);
+}
+
+TEST(SkiaRendererStrokeBatchTest, CoatsOfLaterStrokeAreDrawnInOrder) {
+  BrushPaint paint_0 = {.self_overlap = BrushPaint::SelfOverlap::kAccumulate};
+  BrushPaint paint_1 = {};
+  SkiaRenderer::StrokeBatch batch;
+  // The first stroke creates a group for `paint_1` before there is one for
+  // `paint_0`.
+  ASSERT_THAT(batch.Add(1, MakeStroke(MakeBrush(paint_1))), IsOk());
+  ASSERT_THAT(
+      batch.Add(2, MakeStroke(MakeBrush(
+                       {BrushCoat{.tip = BrushTip{},
+                                  .paint_preferences = {paint_0}},
+                        BrushCoat{.tip = BrushTip{},
+                                  .paint_preferences = {paint_1}}}))),
+      IsOk());
+
+  // The second coat of the second stroke must still be drawn after its first
+  // coat.
+  EXPECT_EQ(batch.DrawCallCount(), 3);
+  EXPECT_THAT(batch.DebugGroupDrawOrder(1), ElementsAre(0));
+  EXPECT_THAT(batch.DebugGroupDrawOrder(2), ElementsAre(1, 2));
+}
+
+TEST(SkiaRendererStrokeBatchTest, RemoveErasesEmptyGroups) {
+  SkiaRenderer::StrokeBatch batch;
+  ASSERT_THAT(batch.Add(1, MakeStroke(MakeBrush(BrushPaint{}, Color::Red()))),
+              IsOk());
+  ASSERT_THAT(batch.Add(2, MakeStroke(MakeBrush(BrushPaint{}, Color::Blue()))),
+              IsOk());
+  EXPECT_THAT(batch.DebugGroupDrawOrder(2), ElementsAre(1));
+
+  EXPECT_TRUE(batch.Remove(1));
+  EXPECT_THAT(batch.DebugGroupDrawOrder(1), IsEmpty());
+  EXPECT_THAT(batch.DebugGroupDrawOrder(2), ElementsAre(0));
+
+  // A new group is drawn after the existing one.
+  ASSERT_THAT(batch.Add(3, MakeStroke(MakeBrush(BrushPaint{}, Color::Red()))),
+              IsOk());
+  EXPECT_THAT(batch.DebugGroupDrawOrder(3), ElementsAre(1));
+  EXPECT_EQ(batch.DrawCallCount(), 2);
+}
+
+TEST(SkiaRendererStrokeBatchTest, AddTexturedStrokeIsAnError) {
+  BrushPaint textured_paint = {.texture_layers = {BrushPaint::TilingTexture{
+                                   .client_texture_id = "test-texture"}}};
+  BrushCoat plain_coat = {.tip = BrushTip{},
+                          .paint_preferences = {BrushPaint{}}};
+  BrushCoat textured_coat = {.tip = BrushTip{},
+                             .paint_preferences = {textured_paint}};
+  SkiaRenderer::StrokeBatch batch;
+  EXPECT_THAT(
+      batch.Add(1, MakeStroke(MakeBrush({plain_coat, textured_coat}))),
+      StatusIs(absl::StatusCode::kInvalidArgument, HasSubstr("texture")));
+
+  // The batch should be unchanged, even though the first coat could have been
+  // batched.
+  EXPECT_FALSE(batch.Contains(1));
+  EXPECT_EQ(batch.DrawCallCount(), 0);
+}
+
+TEST(SkiaRendererStrokeBatchTest, AddCoatWithTooManyVerticesIsAnError) {
+  BrushPaint accumulate_paint = {
+      .self_overlap = BrushPaint::SelfOverlap::kAccumulate};
+  Brush brush = MakeBrush(
+      {BrushCoat{.tip = BrushTip{}, .paint_preferences = {BrushPaint{}}},
+       BrushCoat{.tip = BrushTip{}, .paint_preferences = {accumulate_paint}}});
+  // The first coat is small, but the second has more than 2^16 vertices.
+  MutableMesh small_coat = MakeStraightLineMutableMesh(10);
+  MutableMesh large_coat = MakeStraightLineMutableMesh(70000);
+  absl::StatusOr<PartitionedMesh> shape =
+      PartitionedMesh::FromMutableMeshGroups(
+          {{.mesh = &small_coat}, {.mesh = &large_coat}});
+  ASSERT_THAT(shape, IsOk());
+
+  SkiaRenderer::StrokeBatch batch;
+  EXPECT_THAT(batch.Add(1, Stroke(brush, StrokeInputBatch(), *shape)),
+              StatusIs(absl::StatusCode::kUnimplemented, HasSubstr("2^16")));
+  EXPECT_FALSE(batch.Contains(1));
+  EXPECT_EQ(batch.DrawCallCount(), 0);
+
+  // The batch is still usable with either paint.
+  ASSERT_THAT(batch.Add(2, MakeStroke(MakeBrush(accumulate_paint))), IsOk());
+  ASSERT_THAT(batch.Add(3, MakeStroke(MakeBrush(BrushPaint{}))), IsOk());
+  EXPECT_EQ(batch.DrawCallCount(), 2);
+}
+
+TEST(SkiaRendererStrokeBatchTest, AddStrokeDrawnAsPathIsAnError) {
+  BrushPaint discard_paint = {.self_overlap =
+                                  BrushPaint::SelfOverlap::kDiscard};
+  SkiaRenderer::StrokeBatch batch;
+  EXPECT_THAT(batch.Add(1, MakeStroke(MakeBrush(discard_paint))),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("drawn as paths")));
+  EXPECT_FALSE(batch.Contains(1));
+}
+
 }  // namespace
 }  // namespace ink
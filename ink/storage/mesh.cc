@@ -14,6 +14,8 @@
 
 #include "ink/storage/mesh.h"
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <limits>
@@ -49,6 +51,10 @@ using ::ink::proto::CodedNumericRun;
 constexpr uint8_t kBitsPerUnpackedComponent =
     std::numeric_limits<float>::digits;
 
+// The number of vertices whose attribute values are read from a `Mesh` at a
+// time when encoding it.
+constexpr uint32_t kVerticesPerEncodingBlock = 256;
+
 CodedNumericRun* InitCodedAttributeComponent(
     uint8_t component_index, const MeshAttributeCodingParams& coding_params,
     uint32_t vertex_count, CodedNumericRun* coded_component) {
@@ -91,12 +97,21 @@ void EncodePackedMeshAttribute(const Mesh& mesh, uint32_t attribute_index,
           attribute.id, mesh.VertexAttributeUnpackingParams(attribute_index),
           vertex_count, coded_mesh);
   SmallArray<int, 4> previous_integers(component_count, 0);
-  for (uint32_t v = 0; v < vertex_count; ++v) {
-    SmallArray<uint32_t, 4> next_integers =
-        mesh.PackedIntegersForFloatVertexAttribute(v, attribute_index);
-    for (uint8_t c = 0; c < component_count; ++c) {
-      coded_components[c]->add_deltas(next_integers[c] - previous_integers[c]);
-      previous_integers[c] = next_integers[c];
+  std::array<uint32_t, 4 * kVerticesPerEncodingBlock> block_integers;
+  for (uint32_t block_start = 0; block_start < vertex_count;
+       block_start += kVerticesPerEncodingBlock) {
+    uint32_t block_size =
+        std::min(kVerticesPerEncodingBlock, vertex_count - block_start);
+    absl::Span<uint32_t> next_integers =
+        absl::MakeSpan(block_integers.data(), block_size * component_count);
+    mesh.PackedIntegersForFloatVertexAttributes(block_start, attribute_index,
+                                                next_integers);
+    for (uint32_t i = 0; i < next_integers.size(); i += component_count) {
+      for (uint8_t c = 0; c < component_count; ++c) {
+        coded_components[c]->add_deltas(next_integers[i + c] -
+                                        previous_integers[c]);
+        previous_integers[c] = next_integers[i + c];
+      }
     }
   }
 }
@@ -129,14 +144,21 @@ void EncodeUnpackedMeshAttribute(const Mesh& mesh, uint32_t attribute_index,
       InitCodedAttributeComponents(attribute.id, *coding_params, vertex_count,
                                    coded_mesh);
   SmallArray<int, 4> previous_integers(component_count, 0);
-  for (uint32_t v = 0; v < vertex_count; ++v) {
-    SmallArray<float, 4> next_floats =
-        mesh.FloatVertexAttribute(v, attribute_index);
-    for (uint8_t c = 0; c < component_count; ++c) {
-      int next_integer = mesh_internal::PackSingleFloat(
-          coding_params->components[c], next_floats[c]);
-      coded_components[c]->add_deltas(next_integer - previous_integers[c]);
-      previous_integers[c] = next_integer;
+  std::array<float, 4 * kVerticesPerEncodingBlock> block_floats;
+  for (uint32_t block_start = 0; block_start < vertex_count;
+       block_start += kVerticesPerEncodingBlock) {
+    uint32_t block_size =
+        std::min(kVerticesPerEncodingBlock, vertex_count - block_start);
+    absl::Span<float> next_floats =
+        absl::MakeSpan(block_floats.data(), block_size * component_count);
+    mesh.FloatVertexAttributes(block_start, attribute_index, next_floats);
+    for (uint32_t i = 0; i < next_floats.size(); i += component_count) {
+      for (uint8_t c = 0; c < component_count; ++c) {
+        int next_integer = mesh_internal::PackSingleFloat(
+            coding_params->components[c], next_floats[i + c]);
+        coded_components[c]->add_deltas(next_integer - previous_integers[c]);
+        previous_integers[c] = next_integer;
+      }
     }
   }
 }
@@ -14,6 +14,7 @@
 
 #include "ink/storage/mesh_format.h"
 
+#include <cstdint>
 #include <utility>
 
 #include "absl/log/absl_log.h"
@@ -198,6 +199,28 @@ absl::StatusOr<MeshFormat::AttributeId> DecodeMeshAttributeId(
   }
 }
 
+// Returns the `IndexFormat` with the packed index size given by
+// `index_format_proto`, and with the unpacked index size of
+// `default_index_format` where possible.
+absl::StatusOr<MeshFormat::IndexFormat> DecodeMeshIndexFormat(
+    proto::MeshFormat::IndexFormat index_format_proto,
+    MeshFormat::IndexFormat default_index_format) {
+  switch (index_format_proto) {
+    case proto::MeshFormat::INDEX_FORMAT_UNSPECIFIED:
+    case proto::MeshFormat::INDEX_FORMAT_16_BIT:
+      return default_index_format ==
+                     MeshFormat::IndexFormat::k32BitUnpacked32BitPacked
+                 ? MeshFormat::IndexFormat::k32BitUnpacked16BitPacked
+                 : default_index_format;
+    case proto::MeshFormat::INDEX_FORMAT_32_BIT:
+      return MeshFormat::IndexFormat::k32BitUnpacked32BitPacked;
+    default:
+      return absl::InvalidArgumentError(
+          absl::StrCat("invalid ink.proto.MeshFormat.IndexFormat value: ",
+                       index_format_proto));
+  }
+}
+
 }  // namespace
 
 void EncodeMeshFormat(const MeshFormat& format,
@@ -210,6 +233,13 @@ void EncodeMeshFormat(const MeshFormat& format,
     format_proto.add_attribute_types(EncodeMeshAttributeType(attribute.type));
     format_proto.add_attribute_ids(EncodeMeshAttributeId(attribute.id));
   }
+  // The field is left unset for 16-bit indices, so that existing encodings are
+  // unchanged.
+  if (format.PackedIndexStride() == sizeof(uint32_t)) {
+    format_proto.set_index_format(proto::MeshFormat::INDEX_FORMAT_32_BIT);
+  } else {
+    format_proto.clear_index_format();
+  }
 }
 
 absl::StatusOr<MeshFormat> DecodeMeshFormat(
@@ -242,7 +272,10 @@ absl::StatusOr<MeshFormat> DecodeMeshFormat(
                           DecodeMeshAttributeId(format_proto.attribute_ids(i)));
     attributes[i] = {attr_type, attr_id};
   }
-  return MeshFormat::Create(attributes.Values(), index_format);
+  ABSL_ASSIGN_OR_RETURN(
+      MeshFormat::IndexFormat decoded_index_format,
+      DecodeMeshIndexFormat(format_proto.index_format(), index_format));
+  return MeshFormat::Create(attributes.Values(), decoded_index_format);
 }
 
 }  // namespace ink
@@ -29,7 +29,10 @@ void EncodeMeshFormat(const MeshFormat& format,
                       proto::MeshFormat& format_proto);
 
 // Decodes the proto into a MeshFormat object with the given
-// IndexFormat. Returns an error if the proto is invalid.
+// IndexFormat. If the proto specifies 32-bit indices, the decoded format will
+// instead use `MeshFormat::IndexFormat::k32BitUnpacked32BitPacked`; otherwise,
+// the decoded format will use 16-bit packed indices. Returns an error if the
+// proto is invalid.
 absl::StatusOr<MeshFormat> DecodeMeshFormat(
     const proto::MeshFormat& format_proto,
     MeshFormat::IndexFormat index_format);
@@ -117,6 +117,50 @@ TEST(MeshTest, EncodeMeshFormatClearsExistingProto) {
   EXPECT_THAT(format_proto, EqualsProto(expected_proto));
 }
 
+TEST(MeshTest, EncodeMeshFormatWith32BitPackedIndices) {
+  absl::StatusOr<MeshFormat> format =
+      MeshFormat::Create({{MeshFormat::AttributeType::kFloat2PackedInOneFloat,
+                           MeshFormat::AttributeId::kPosition}},
+                         MeshFormat::IndexFormat::k32BitUnpacked32BitPacked);
+  ASSERT_THAT(format, IsOk());
+  proto::MeshFormat format_proto;
+  EncodeMeshFormat(*format, format_proto);
+
+  proto::MeshFormat expected_proto;
+  expected_proto.add_attribute_types(
+      proto::MeshFormat::ATTR_TYPE_FLOAT2_PACKED_IN_ONE_FLOAT);
+  expected_proto.add_attribute_ids(proto::MeshFormat::ATTR_ID_POSITION);
+  expected_proto.set_index_format(proto::MeshFormat::INDEX_FORMAT_32_BIT);
+  EXPECT_THAT(format_proto, EqualsProto(expected_proto));
+}
+
+TEST(MeshTest, DecodeMeshFormatWith32BitIndices) {
+  proto::MeshFormat format_proto;
+  format_proto.add_attribute_types(
+      proto::MeshFormat::ATTR_TYPE_FLOAT2_UNPACKED);
+  format_proto.add_attribute_ids(proto::MeshFormat::ATTR_ID_POSITION);
+  format_proto.set_index_format(proto::MeshFormat::INDEX_FORMAT_32_BIT);
+
+  absl::StatusOr<MeshFormat> format = DecodeMeshFormat(
+      format_proto, MeshFormat::IndexFormat::k16BitUnpacked16BitPacked);
+  ASSERT_THAT(format, IsOk());
+  EXPECT_EQ(format->GetIndexFormat(),
+            MeshFormat::IndexFormat::k32BitUnpacked32BitPacked);
+}
+
+TEST(MeshTest, DecodeMeshFormatWithout32BitIndices) {
+  proto::MeshFormat format_proto;
+  format_proto.add_attribute_types(
+      proto::MeshFormat::ATTR_TYPE_FLOAT2_UNPACKED);
+  format_proto.add_attribute_ids(proto::MeshFormat::ATTR_ID_POSITION);
+
+  absl::StatusOr<MeshFormat> format = DecodeMeshFormat(
+      format_proto, MeshFormat::IndexFormat::k32BitUnpacked32BitPacked);
+  ASSERT_THAT(format, IsOk());
+  EXPECT_EQ(format->GetIndexFormat(),
+            MeshFormat::IndexFormat::k32BitUnpacked16BitPacked);
+}
+
 void DecodeMeshFormatDoesNotCrashOnArbitraryInput(
     const proto::MeshFormat& format_proto,
     MeshFormat::IndexFormat index_format) {
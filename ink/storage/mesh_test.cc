@@ -256,6 +256,47 @@ TEST(MeshTest, EncodeAndDecodeFullyPackedMesh) {
             mesh->FloatVertexAttribute(2, 2));
 }
 
+TEST(MeshTest, EncodeAndDecodeMeshWith32BitIndices) {
+  absl::StatusOr<MeshFormat> format =
+      MeshFormat::Create({{AttrType::kFloat2Unpacked, AttrId::kPosition}},
+                         MeshFormat::IndexFormat::k32BitUnpacked32BitPacked);
+  ASSERT_THAT(format, IsOk());
+
+  // Create a triangle strip with more vertices than can be referenced by
+  // 16-bit indices.
+  constexpr uint32_t kVertexCount = 70000;
+  std::vector<float> position_x;
+  std::vector<float> position_y;
+  for (uint32_t i = 0; i < kVertexCount; ++i) {
+    position_x.push_back(i / 2);
+    position_y.push_back(i % 2);
+  }
+  std::vector<uint32_t> triangles;
+  for (uint32_t i = 0; i + 2 < kVertexCount; ++i) {
+    triangles.insert(triangles.end(), {i, i + 1, i + 2});
+  }
+  absl::StatusOr<Mesh> mesh =
+      Mesh::Create(*format, {position_x, position_y}, triangles);
+  ASSERT_THAT(mesh, IsOk());
+
+  CodedMesh coded_mesh;
+  EncodeMesh(*mesh, coded_mesh);
+  EXPECT_EQ(coded_mesh.format().index_format(),
+            proto::MeshFormat::INDEX_FORMAT_32_BIT);
+
+  absl::StatusOr<Mesh> decoded = DecodeMesh(coded_mesh);
+  ASSERT_THAT(decoded, IsOk());
+  ASSERT_THAT(decoded->Format(), MeshFormatEq(*format));
+  EXPECT_EQ(decoded->IndexStride(), 4);
+  EXPECT_EQ(decoded->VertexCount(), kVertexCount);
+  ASSERT_EQ(decoded->TriangleCount(), kVertexCount - 2);
+  EXPECT_THAT(decoded->TriangleIndices(kVertexCount - 3),
+              ElementsAre(kVertexCount - 3, kVertexCount - 2,
+                          kVertexCount - 1));
+  EXPECT_EQ(decoded->VertexPosition(kVertexCount - 1),
+            mesh->VertexPosition(kVertexCount - 1));
+}
+
 TEST(MeshTest, DecodeEmptyMesh) {
   CodedMesh coded_mesh;
   absl::StatusOr<Mesh> mesh = DecodeMesh(coded_mesh);
@@ -18,6 +18,7 @@
 #include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/status/status.h"
 #include "absl/status/status_macros.h"
 #include "absl/status/statusor.h"
@@ -63,6 +64,71 @@ absl::StatusOr<std::vector<VertexIndexPair>> DecodeOutline(
   return outline;
 }
 
+// Returns the total number of triangles in the meshes before each mesh in
+// `meshes`. These are used to encode the triangles of the spatial index.
+std::vector<uint32_t> FirstTriangleOffsets(absl::Span<const Mesh> meshes) {
+  std::vector<uint32_t> offsets;
+  offsets.reserve(meshes.size());
+  uint32_t offset = 0;
+  for (const Mesh& mesh : meshes) {
+    offsets.push_back(offset);
+    offset += mesh.TriangleCount();
+  }
+  return offsets;
+}
+
+void EncodeSpatialIndex(const PartitionedMesh& shape,
+                        ink::proto::CodedSpatialIndex& index_proto) {
+  PartitionedMesh::SpatialIndexLayout layout = shape.GetSpatialIndexLayout();
+  const std::vector<uint32_t> first_triangle_offsets =
+      FirstTriangleOffsets(shape.Meshes());
+  std::vector<uint32_t> triangles;
+  triangles.reserve(layout.triangles.size());
+  for (TriangleIndexPair pair : layout.triangles) {
+    triangles.push_back(first_triangle_offsets[pair.mesh_index] +
+                        pair.triangle_index);
+  }
+  EncodeIntNumericRun(triangles.begin(), triangles.end(),
+                      index_proto.mutable_triangles());
+  index_proto.mutable_child_counts()->Assign(layout.child_counts.begin(),
+                                             layout.child_counts.end());
+}
+
+absl::Status DecodeSpatialIndex(
+    const ink::proto::CodedSpatialIndex& index_proto,
+    const PartitionedMesh& shape) {
+  const std::vector<uint32_t> first_triangle_offsets =
+      FirstTriangleOffsets(shape.Meshes());
+  const int64_t num_triangles =
+      shape.Meshes().empty() ? 0
+                             : first_triangle_offsets.back() +
+                                   shape.Meshes().back().TriangleCount();
+  ABSL_ASSIGN_OR_RETURN(auto range,
+                        DecodeIntNumericRun(index_proto.triangles()));
+
+  PartitionedMesh::SpatialIndexLayout layout;
+  layout.triangles.reserve(index_proto.triangles().deltas_size());
+  for (int32_t index : range) {
+    if (index < 0 || index >= num_triangles) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("`CodedSpatialIndex.triangles` contains ", index,
+                       ", but the shape has ", num_triangles, " triangles"));
+    }
+    // The first offset is always zero, so this never returns the beginning.
+    auto it = absl::c_upper_bound(first_triangle_offsets,
+                                  static_cast<uint32_t>(index));
+    uint16_t mesh_index = (it - first_triangle_offsets.begin()) - 1;
+    layout.triangles.push_back(TriangleIndexPair{
+        .mesh_index = mesh_index,
+        .triangle_index =
+            static_cast<uint16_t>(index - first_triangle_offsets[mesh_index]),
+    });
+  }
+  layout.child_counts.assign(index_proto.child_counts().begin(),
+                             index_proto.child_counts().end());
+  return shape.InitializeSpatialIndexFromLayout(layout);
+}
+
 // Decodes a CodedModeledShape proto using the deprecated schema (that is,
 // specifying the `format` field for a single-group `PartitionedMesh`, rather
 // than using the `group_*` fields).
@@ -96,43 +162,9 @@ absl::StatusOr<PartitionedMesh> DecodePartitionedMeshGroupless(
   return PartitionedMesh::FromMeshes(absl::MakeSpan(meshes), outline_spans);
 }
 
-}  // namespace
-
-void EncodePartitionedMesh(const PartitionedMesh& shape,
-                           ink::proto::CodedModeledShape& shape_proto) {
-  uint32_t num_groups = shape.RenderGroupCount();
-
-  uint32_t total_meshes = 0;
-  uint32_t total_outlines = 0;
-  for (uint32_t group_index = 0; group_index < num_groups; ++group_index) {
-    total_meshes += shape.RenderGroupMeshes(group_index).size();
-    total_outlines += shape.OutlineCount(group_index);
-  }
-
-  shape_proto.Clear();
-  shape_proto.mutable_meshes()->Reserve(total_meshes);
-  shape_proto.mutable_outlines()->Reserve(total_outlines);
-  shape_proto.mutable_group_formats()->Reserve(num_groups);
-  shape_proto.mutable_group_first_mesh_indices()->Reserve(num_groups);
-  shape_proto.mutable_group_first_outline_indices()->Reserve(num_groups);
-  for (uint32_t group_index = 0; group_index < num_groups; ++group_index) {
-    shape_proto.add_group_first_mesh_indices(shape_proto.meshes_size());
-    shape_proto.add_group_first_outline_indices(shape_proto.outlines_size());
-    EncodeMeshFormat(shape.RenderGroupFormat(group_index),
-                     *shape_proto.add_group_formats());
-    for (const Mesh& mesh : shape.RenderGroupMeshes(group_index)) {
-      EncodeMeshOmittingFormat(mesh, *shape_proto.add_meshes());
-    }
-    const uint32_t num_outlines = shape.OutlineCount(group_index);
-    for (uint32_t outline_index = 0; outline_index < num_outlines;
-         ++outline_index) {
-      EncodeOutline(shape.Outline(group_index, outline_index),
-                    shape_proto.add_outlines());
-    }
-  }
-}
-
-absl::StatusOr<PartitionedMesh> DecodePartitionedMesh(
+// Decodes the meshes and outlines of a CodedModeledShape proto, ignoring its
+// `spatial_index` field.
+absl::StatusOr<PartitionedMesh> DecodePartitionedMeshWithoutSpatialIndex(
     const ink::proto::CodedModeledShape& shape_proto) {
   const int num_groups = shape_proto.group_formats_size();
   const int num_meshes = shape_proto.meshes_size();
@@ -243,4 +275,57 @@ absl::StatusOr<PartitionedMesh> DecodePartitionedMesh(
   return PartitionedMesh::FromMeshGroups(absl::MakeConstSpan(groups));
 }
 
+}  // namespace
+
+void EncodePartitionedMesh(const PartitionedMesh& shape,
+                           ink::proto::CodedModeledShape& shape_proto) {
+  uint32_t num_groups = shape.RenderGroupCount();
+
+  uint32_t total_meshes = 0;
+  uint32_t total_outlines = 0;
+  for (uint32_t group_index = 0; group_index < num_groups; ++group_index) {
+    total_meshes += shape.RenderGroupMeshes(group_index).size();
+    total_outlines += shape.OutlineCount(group_index);
+  }
+
+  shape_proto.Clear();
+  shape_proto.mutable_meshes()->Reserve(total_meshes);
+  shape_proto.mutable_outlines()->Reserve(total_outlines);
+  shape_proto.mutable_group_formats()->Reserve(num_groups);
+  shape_proto.mutable_group_first_mesh_indices()->Reserve(num_groups);
+  shape_proto.mutable_group_first_outline_indices()->Reserve(num_groups);
+  for (uint32_t group_index = 0; group_index < num_groups; ++group_index) {
+    shape_proto.add_group_first_mesh_indices(shape_proto.meshes_size());
+    shape_proto.add_group_first_outline_indices(shape_proto.outlines_size());
+    EncodeMeshFormat(shape.RenderGroupFormat(group_index),
+                     *shape_proto.add_group_formats());
+    for (const Mesh& mesh : shape.RenderGroupMeshes(group_index)) {
+      EncodeMeshOmittingFormat(mesh, *shape_proto.add_meshes());
+    }
+    const uint32_t num_outlines = shape.OutlineCount(group_index);
+    for (uint32_t outline_index = 0; outline_index < num_outlines;
+         ++outline_index) {
+      EncodeOutline(shape.Outline(group_index, outline_index),
+                    shape_proto.add_outlines());
+    }
+  }
+}
+
+void EncodePartitionedMeshWithSpatialIndex(
+    const PartitionedMesh& shape, ink::proto::CodedModeledShape& shape_proto) {
+  EncodePartitionedMesh(shape, shape_proto);
+  EncodeSpatialIndex(shape, *shape_proto.mutable_spatial_index());
+}
+
+absl::StatusOr<PartitionedMesh> DecodePartitionedMesh(
+    const ink::proto::CodedModeledShape& shape_proto) {
+  ABSL_ASSIGN_OR_RETURN(PartitionedMesh shape,
+                        DecodePartitionedMeshWithoutSpatialIndex(shape_proto));
+  if (shape_proto.has_spatial_index()) {
+    ABSL_RETURN_IF_ERROR(
+        DecodeSpatialIndex(shape_proto.spatial_index(), shape));
+  }
+  return shape;
+}
+
 }  // namespace ink
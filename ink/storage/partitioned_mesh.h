@@ -29,8 +29,16 @@ namespace ink {
 void EncodePartitionedMesh(const PartitionedMesh& shape,
                            ink::proto::CodedModeledShape& shape_proto);
 
-// Decodes the `CodedModeledShape` proto into a `PartitionedMesh`. Returns an
-// error if the proto is invalid.
+// As `EncodePartitionedMesh`, but also encodes the layout of the shape's
+// spatial index (initializing it if it has not already been done), so that
+// `DecodePartitionedMesh` can restore the index without rebuilding it. This
+// makes the proto larger by about one to two bytes per triangle.
+void EncodePartitionedMeshWithSpatialIndex(
+    const PartitionedMesh& shape, ink::proto::CodedModeledShape& shape_proto);
+
+// Decodes the `CodedModeledShape` proto into a `PartitionedMesh`. If the proto
+// contains a spatial index, the decoded `PartitionedMesh`'s index is
+// initialized from it. Returns an error if the proto is invalid.
 absl::StatusOr<PartitionedMesh> DecodePartitionedMesh(
     const ink::proto::CodedModeledShape& shape_proto);
 
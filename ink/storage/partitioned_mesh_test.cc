@@ -14,12 +14,15 @@
 
 #include "ink/geometry/partitioned_mesh.h"
 
+#include <cstdint>
 #include <utility>
 #include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "fuzztest/fuzztest.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/log/absl_check.h"
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
 #include "absl/status/statusor.h"
@@ -27,10 +30,12 @@
 #include "ink/geometry/mesh.h"
 #include "ink/geometry/mesh_format.h"
 #include "ink/geometry/mesh_index_types.h"
+#include "ink/geometry/mesh_test_helpers.h"
 #include "ink/geometry/type_matchers.h"
 #include "ink/storage/mesh_format.h"
 #include "ink/storage/numeric_run.h"
 #include "ink/storage/partitioned_mesh.h"
+#include "ink/storage/proto/coded_numeric_run.pb.h"
 #include "ink/storage/proto/mesh.pb.h"
 #include "ink/types/iterator_range.h"
 #include "google/protobuf/text_format.h"
@@ -43,8 +48,10 @@ using ::absl_testing::StatusIs;
 using ::ink::proto::CodedModeledShape;
 using ::google::protobuf::TextFormat;
 using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
 using ::testing::HasSubstr;
 using ::testing::IsEmpty;
+using ::testing::Matcher;
 using ::testing::SizeIs;
 
 TEST(PartitionedMeshTest, DecodePartitionedMeshWithGroupCountMismatch) {
@@ -392,6 +399,105 @@ TEST(PartitionedMeshTest, DecodePartitionedMeshWithTwoGroups) {
                           VertexIndexPairEq({0, 1})));
 }
 
+std::vector<Matcher<TriangleIndexPair>> TriangleIndexPairsEq(
+    absl::Span<const TriangleIndexPair> tri_index_pairs) {
+  std::vector<Matcher<TriangleIndexPair>> matchers;
+  for (TriangleIndexPair idx : tri_index_pairs) {
+    matchers.push_back(TriangleIndexPairEq(idx));
+  }
+  return matchers;
+}
+
+// Returns a `PartitionedMesh` made of two straight-line meshes, with 40 and 60
+// triangles, so that its spatial index has more than one level.
+PartitionedMesh MakeTwoMeshShape() {
+  std::vector<Mesh> meshes;
+  for (uint32_t n_triangles : {40, 60}) {
+    absl::StatusOr<absl::InlinedVector<Mesh, 1>> mesh =
+        MakeStraightLineMutableMesh(n_triangles).AsMeshes();
+    ABSL_CHECK_OK(mesh);
+    ABSL_CHECK_EQ(mesh->size(), 1u);
+    meshes.push_back((*mesh)[0]);
+  }
+  absl::StatusOr<PartitionedMesh> shape =
+      PartitionedMesh::FromMeshes(absl::MakeSpan(meshes));
+  ABSL_CHECK_OK(shape);
+  return *std::move(shape);
+}
+
+TEST(PartitionedMeshTest, EncodePartitionedMeshOmitsSpatialIndex) {
+  PartitionedMesh shape = MakeTwoMeshShape();
+  shape.InitializeSpatialIndex();
+
+  CodedModeledShape shape_proto;
+  EncodePartitionedMesh(shape, shape_proto);
+  EXPECT_FALSE(shape_proto.has_spatial_index());
+
+  absl::StatusOr<PartitionedMesh> decoded = DecodePartitionedMesh(shape_proto);
+  ASSERT_THAT(decoded, IsOk());
+  EXPECT_FALSE(decoded->IsSpatialIndexInitialized());
+}
+
+TEST(PartitionedMeshTest, EncodeAndDecodePartitionedMeshWithSpatialIndex) {
+  PartitionedMesh shape = MakeTwoMeshShape();
+
+  CodedModeledShape shape_proto;
+  EncodePartitionedMeshWithSpatialIndex(shape, shape_proto);
+  EXPECT_TRUE(shape.IsSpatialIndexInitialized());
+  ASSERT_TRUE(shape_proto.has_spatial_index());
+  EXPECT_EQ(shape_proto.spatial_index().triangles().deltas_size(), 100);
+
+  absl::StatusOr<PartitionedMesh> decoded = DecodePartitionedMesh(shape_proto);
+  ASSERT_THAT(decoded, IsOk());
+  EXPECT_TRUE(decoded->IsSpatialIndexInitialized());
+  PartitionedMesh::SpatialIndexLayout expected = shape.GetSpatialIndexLayout();
+  PartitionedMesh::SpatialIndexLayout actual = decoded->GetSpatialIndexLayout();
+  EXPECT_THAT(actual.triangles,
+              ElementsAreArray(TriangleIndexPairsEq(expected.triangles)));
+  EXPECT_THAT(actual.child_counts, ElementsAreArray(expected.child_counts));
+}
+
+TEST(PartitionedMeshTest, EncodeAndDecodeEmptyPartitionedMeshWithSpatialIndex) {
+  CodedModeledShape shape_proto;
+  EncodePartitionedMeshWithSpatialIndex(PartitionedMesh(), shape_proto);
+  ASSERT_TRUE(shape_proto.has_spatial_index());
+
+  absl::StatusOr<PartitionedMesh> decoded = DecodePartitionedMesh(shape_proto);
+  ASSERT_THAT(decoded, IsOk());
+  EXPECT_THAT(decoded->Meshes(), IsEmpty());
+}
+
+TEST(PartitionedMeshTest, DecodePartitionedMeshWithOutOfBoundsSpatialIndex) {
+  CodedModeledShape shape_proto;
+  EncodePartitionedMeshWithSpatialIndex(MakeTwoMeshShape(), shape_proto);
+  // Replace the first triangle with one past the end of the last mesh.
+  proto::CodedNumericRun& triangles =
+      *shape_proto.mutable_spatial_index()->mutable_triangles();
+  triangles.set_deltas(1, triangles.deltas(1) + triangles.deltas(0) - 100);
+  triangles.set_deltas(0, 100);
+
+  EXPECT_THAT(DecodePartitionedMesh(shape_proto),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("the shape has 100 triangles")));
+}
+
+TEST(PartitionedMeshTest, DecodePartitionedMeshWithInvalidSpatialIndex) {
+  CodedModeledShape shape_proto;
+  EncodePartitionedMeshWithSpatialIndex(MakeTwoMeshShape(), shape_proto);
+  CodedModeledShape missing_triangle = shape_proto;
+  missing_triangle.mutable_spatial_index()
+      ->mutable_triangles()
+      ->mutable_deltas()
+      ->RemoveLast();
+  EXPECT_THAT(DecodePartitionedMesh(missing_triangle),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  CodedModeledShape bad_child_counts = shape_proto;
+  bad_child_counts.mutable_spatial_index()->set_child_counts(0, 0);
+  EXPECT_THAT(DecodePartitionedMesh(bad_child_counts),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 void DecodePartitionedMeshDoesNotCrashOnArbitraryInput(
     const CodedModeledShape& shape_proto) {
   DecodePartitionedMesh(shape_proto).IgnoreError();
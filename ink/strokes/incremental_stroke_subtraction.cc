@@ -0,0 +1,109 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ink/strokes/incremental_stroke_subtraction.h"
+
+#include <memory>
+#include <optional>
+#include <utility>
+
+#include "absl/status/statusor.h"
+#include "ink/geometry/affine_transform.h"
+#include "ink/geometry/internal/outline_processing.h"
+#include "ink/geometry/intersects.h"
+#include "ink/geometry/partitioned_mesh.h"
+#include "ink/geometry/rect.h"
+#include "ink/strokes/internal/stroke_subtraction.h"
+#include "ink/strokes/stroke.h"
+#include "ink/types/executor.h"
+
+namespace ink {
+
+using ::ink::geometry_internal::ShapeOutline;
+using ::ink::strokes_internal::IncrementalSubtraction;
+
+IncrementalStrokeSubtraction::IncrementalStrokeSubtraction(
+    const Stroke& stroke, const AffineTransform& stroke_transform)
+    : stroke_transform_(stroke_transform),
+      subtraction_(std::make_unique<IncrementalSubtraction>(
+          stroke.GetShape(), stroke.GetBrush().GetEpsilon())),
+      stroke_(stroke) {}
+
+IncrementalStrokeSubtraction::IncrementalStrokeSubtraction(
+    const IncrementalStrokeSubtraction& other)
+    : stroke_transform_(other.stroke_transform_),
+      subtraction_(other.subtraction_ == nullptr
+                       ? nullptr
+                       : std::make_unique<IncrementalSubtraction>(
+                             *other.subtraction_)),
+      stroke_(other.stroke_),
+      is_stroke_up_to_date_(other.is_stroke_up_to_date_) {}
+
+IncrementalStrokeSubtraction::IncrementalStrokeSubtraction(
+    IncrementalStrokeSubtraction&&) = default;
+
+IncrementalStrokeSubtraction& IncrementalStrokeSubtraction::operator=(
+    const IncrementalStrokeSubtraction& other) {
+  if (this != &other) *this = IncrementalStrokeSubtraction(other);
+  return *this;
+}
+
+IncrementalStrokeSubtraction& IncrementalStrokeSubtraction::operator=(
+    IncrementalStrokeSubtraction&&) = default;
+
+IncrementalStrokeSubtraction::~IncrementalStrokeSubtraction() = default;
+
+void IncrementalStrokeSubtraction::Subtract(
+    const PartitionedMesh& segment_shape,
+    const AffineTransform& segment_transform, Executor& executor) {
+  // Most segments of an eraser gesture don't come near any given stroke, so
+  // check the bounds first, which is much cheaper than preparing the outline
+  // of the segment for subtraction. Erasing only shrinks the stroke, so the
+  // bounds of the stroke from before any erasure will do.
+  std::optional<Rect> stroke_bounds = stroke_.GetShape().Bounds().AsRect();
+  std::optional<Rect> segment_bounds = segment_shape.Bounds().AsRect();
+  if (!stroke_bounds.has_value() || !segment_bounds.has_value() ||
+      !Intersects(stroke_transform_.Apply(*stroke_bounds),
+                  segment_transform.Apply(*segment_bounds))) {
+    return;
+  }
+
+  // The segment is subtracted in the coordinates of the stroke, so that the
+  // spatial index of the stroke's shape can be used to find the triangles
+  // near it.
+  std::optional<AffineTransform> inverse_stroke_transform =
+      stroke_transform_.Inverse();
+  if (!inverse_stroke_transform.has_value()) return;
+  absl::StatusOr<ShapeOutline> mask = strokes_internal::ComputeMaskOutline(
+      segment_shape, *inverse_stroke_transform * segment_transform,
+      stroke_.GetBrush().GetEpsilon());
+  if (!mask.ok()) return;
+
+  if (subtraction_->Subtract(*mask, executor)) is_stroke_up_to_date_ = false;
+}
+
+const Stroke& IncrementalStrokeSubtraction::GetStroke() {
+  if (is_stroke_up_to_date_) return stroke_;
+  absl::StatusOr<PartitionedMesh> shape = subtraction_->BuildMesh();
+  // Leave the stroke as it was if the erased mesh can't be built, as
+  // `Stroke::Subtract` does.
+  if (shape.ok()) {
+    stroke_ =
+        Stroke(stroke_.GetBrush(), stroke_.GetInputs(), *std::move(shape));
+  }
+  is_stroke_up_to_date_ = true;
+  return stroke_;
+}
+
+}  // namespace ink
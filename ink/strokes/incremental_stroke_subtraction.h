@@ -0,0 +1,106 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INK_STROKES_INCREMENTAL_STROKE_SUBTRACTION_H_
+#define INK_STROKES_INCREMENTAL_STROKE_SUBTRACTION_H_
+
+#include <memory>
+
+#include "ink/geometry/affine_transform.h"
+#include "ink/geometry/partitioned_mesh.h"
+#include "ink/strokes/stroke.h"
+#include "ink/types/executor.h"
+
+namespace ink {
+
+namespace strokes_internal {
+class IncrementalSubtraction;
+}  // namespace strokes_internal
+
+// Erases from a `Stroke` along the path of a moving eraser, one segment at a
+// time, as for a "partial eraser" gesture.
+//
+// Calling `Stroke::Subtract` with the whole eraser shape on every frame redoes
+// the work of all of the previous frames, so the cost of a frame grows with
+// the length of the gesture. Instead, this holds the partially erased stroke,
+// and each call to `Subtract` removes only the newest segment of the eraser,
+// i.e. the part of its shape that was added since the previous call. The
+// state of the erasure is kept between calls, and the spatial index of the
+// original stroke is used to find the triangles near each segment, so the cost
+// of `Subtract` depends on the size of the segment rather than on the size of
+// the stroke. The erased stroke is only assembled when `GetStroke` is called,
+// which takes time proportional to the size of the stroke.
+//
+// Since erasing the segments one at a time removes their union, the final
+// stroke covers the same region as a single `Stroke::Subtract` of the whole
+// eraser. It may be triangulated differently, and new vertices may differ by
+// up to the brush epsilon, since each subtraction snaps vertices to within
+// that distance of the triangles it splits. Segments may overlap each other.
+class IncrementalStrokeSubtraction {
+ public:
+  // Starts erasing from `stroke`, where `stroke_transform` maps the stroke to
+  // the coordinates that the eraser segments are given in (typically, those of
+  // the document).
+  //
+  // `stroke_transform` is expected to be non-degenerate; otherwise, `Subtract`
+  // leaves the stroke as is.
+  IncrementalStrokeSubtraction(const Stroke& stroke,
+                               const AffineTransform& stroke_transform);
+
+  IncrementalStrokeSubtraction(const IncrementalStrokeSubtraction& other);
+  IncrementalStrokeSubtraction(IncrementalStrokeSubtraction&&);
+  IncrementalStrokeSubtraction& operator=(
+      const IncrementalStrokeSubtraction& other);
+  IncrementalStrokeSubtraction& operator=(IncrementalStrokeSubtraction&&);
+  ~IncrementalStrokeSubtraction();
+
+  // Erases `segment_shape`, as mapped by `segment_transform`, from the stroke.
+  // As with `Stroke::Subtract`, the triangles of the stroke are subtracted in
+  // chunks on `executor`.
+  //
+  // `segment_transform` is expected to be non-degenerate; otherwise, the
+  // stroke is left as is.
+  void Subtract(const PartitionedMesh& segment_shape,
+                const AffineTransform& segment_transform,
+                Executor& executor = SerialExecutor());
+
+  // Returns the stroke with all of the segments so far erased from it. The
+  // brush and inputs of the stroke are unchanged.
+  //
+  // If any segment has changed the stroke since the last call, this assembles
+  // the new stroke mesh, which takes time proportional to the size of the
+  // stroke, so it should be called only when the erased stroke is needed
+  // (e.g. once per rendered frame), not after every segment. The result is
+  // cached until the next call to `Subtract` changes the stroke; since this
+  // may update that cache, it is non-const.
+  const Stroke& GetStroke();
+
+  const AffineTransform& GetStrokeTransform() const {
+    return stroke_transform_;
+  }
+
+ private:
+  AffineTransform stroke_transform_;
+  // The state of the erasure, in the coordinates of the original stroke.
+  std::unique_ptr<strokes_internal::IncrementalSubtraction> subtraction_;
+  // The erased stroke as of the last call to `GetStroke`. Its shape is stale
+  // if `is_stroke_up_to_date_` is false, but its brush and inputs are always
+  // those of the original stroke.
+  Stroke stroke_;
+  bool is_stroke_up_to_date_ = true;
+};
+
+}  // namespace ink
+
+#endif  // INK_STROKES_INCREMENTAL_STROKE_SUBTRACTION_H_
@@ -0,0 +1,144 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "absl/log/absl_check.h"
+#include "absl/status/statusor.h"
+#include "ink/brush/brush.h"
+#include "ink/brush/brush_family.h"
+#include "ink/brush/stock_brushes_test_params.h"
+#include "ink/color/color.h"
+#include "ink/geometry/affine_transform.h"
+#include "ink/geometry/angle.h"
+#include "ink/geometry/partitioned_mesh.h"
+#include "ink/geometry/point.h"
+#include "ink/strokes/incremental_stroke_subtraction.h"
+#include "ink/strokes/input/recorded_test_inputs.h"
+#include "ink/strokes/input/stroke_input_batch.h"
+#include "ink/strokes/stroke.h"
+
+namespace ink {
+namespace {
+
+Brush MakeBrush(const BrushFamily& family, float brush_size) {
+  absl::StatusOr<Brush> brush =
+      Brush::Create(family, Color::Black(), brush_size, kTestBrushEpsilon);
+  ABSL_CHECK_OK(brush);
+  return *brush;
+}
+
+Stroke MakeStroke(const Brush& brush, const StrokeInputBatch& inputs,
+                  int start_index, int end_index) {
+  StrokeInputBatch batch;
+  ABSL_CHECK_OK(batch.Append(inputs, start_index, end_index));
+  return Stroke(brush, batch);
+}
+
+// A partial eraser gesture across a highlighter stroke, split into `n_frames`
+// frames. For each frame, this holds the shape of the whole eraser so far,
+// and the shape of just the part of it that was added during that frame.
+struct EraserGesture {
+  Stroke stroke;
+  AffineTransform eraser_transform;
+  std::vector<PartitionedMesh> cumulative_shapes;
+  std::vector<PartitionedMesh> segment_shapes;
+};
+
+EraserGesture MakeEraserGesture(int n_frames) {
+  const BrushFamily highlighter = stock_brushes::GetParams()[2].second;
+  const BrushFamily marker = stock_brushes::GetParams()[0].second;
+  auto inputs = LoadCompleteStrokeInputs(kTestDataFiles[0]);
+  ABSL_CHECK_OK(inputs);
+  Stroke stroke(MakeBrush(highlighter, 8), *inputs);
+  Point center = stroke.GetShape().Bounds().AsRect()->Center();
+  Brush eraser_brush = MakeBrush(marker, 16);
+  EraserGesture gesture = {
+      .stroke = stroke,
+      // Rotate the eraser about the center of the stroke, so that it crosses
+      // the stroke in many places.
+      .eraser_transform =
+          AffineTransform::RotateAboutPoint(kQuarterTurn, center),
+      .cumulative_shapes = {},
+      .segment_shapes = {},
+  };
+  int n_inputs = inputs->Size();
+  int previous_end = 1;
+  for (int frame = 1; frame <= n_frames; ++frame) {
+    int end = std::max(previous_end + 1, n_inputs * frame / n_frames);
+    gesture.cumulative_shapes.push_back(
+        MakeStroke(eraser_brush, *inputs, 0, end).GetShape());
+    // Each segment starts at the last input of the previous one, so that
+    // consecutive segments overlap.
+    gesture.segment_shapes.push_back(
+        MakeStroke(eraser_brush, *inputs, previous_end - 1, end).GetShape());
+    previous_end = end;
+  }
+  return gesture;
+}
+
+// Subtracts the whole eraser so far from the original stroke on each frame.
+// Takes the number of frames.
+void BM_EraseGestureWithCumulativeEraser(benchmark::State& state) {
+  EraserGesture gesture = MakeEraserGesture(state.range(0));
+  for (auto s : state) {
+    for (const PartitionedMesh& eraser_shape : gesture.cumulative_shapes) {
+      benchmark::DoNotOptimize(gesture.stroke.Subtract(
+          eraser_shape, gesture.eraser_transform, AffineTransform()));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EraseGestureWithCumulativeEraser)
+    ->RangeMultiplier(4)
+    ->Range(4, 64);
+
+// Subtracts only the newest segment of the eraser on each frame.
+// Takes the number of frames.
+void BM_EraseGestureIncrementally(benchmark::State& state) {
+  EraserGesture gesture = MakeEraserGesture(state.range(0));
+  for (auto s : state) {
+    IncrementalStrokeSubtraction subtraction(gesture.stroke,
+                                             AffineTransform());
+    for (const PartitionedMesh& segment_shape : gesture.segment_shapes) {
+      subtraction.Subtract(segment_shape, gesture.eraser_transform);
+      benchmark::DoNotOptimize(subtraction.GetStroke());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EraseGestureIncrementally)->RangeMultiplier(4)->Range(4, 64);
+
+// As above, but only gets the erased stroke at the end of the gesture, as when
+// the stroke isn't rendered on every frame. Takes the number of frames.
+void BM_EraseGestureIncrementallyGettingStrokeAtEnd(benchmark::State& state) {
+  EraserGesture gesture = MakeEraserGesture(state.range(0));
+  for (auto s : state) {
+    IncrementalStrokeSubtraction subtraction(gesture.stroke,
+                                             AffineTransform());
+    for (const PartitionedMesh& segment_shape : gesture.segment_shapes) {
+      subtraction.Subtract(segment_shape, gesture.eraser_transform);
+    }
+    benchmark::DoNotOptimize(subtraction.GetStroke());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EraseGestureIncrementallyGettingStrokeAtEnd)
+    ->RangeMultiplier(4)
+    ->Range(4, 64);
+
+}  // namespace
+}  // namespace ink
@@ -0,0 +1,262 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ink/strokes/incremental_stroke_subtraction.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/log/absl_check.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "ink/brush/brush.h"
+#include "ink/geometry/affine_transform.h"
+#include "ink/geometry/angle.h"
+#include "ink/geometry/intersects.h"
+#include "ink/geometry/mesh.h"
+#include "ink/geometry/mesh_format.h"
+#include "ink/geometry/mesh_test_helpers.h"
+#include "ink/geometry/mutable_mesh.h"
+#include "ink/geometry/partitioned_mesh.h"
+#include "ink/geometry/point.h"
+#include "ink/geometry/rect.h"
+#include "ink/geometry/type_matchers.h"
+#include "ink/geometry/vec.h"
+#include "ink/strokes/input/stroke_input_batch.h"
+#include "ink/strokes/stroke.h"
+#include "ink/types/executor.h"
+
+namespace ink {
+namespace {
+
+using ::absl_testing::IsOk;
+
+// Returns a stroke whose shape is a strip of 20 triangles, covering the
+// parallelogram with corners (0, 0), (20, 0), (21, -1), and (1, -1), which has
+// an area of 20.
+Stroke MakeStroke() {
+  return Stroke(Brush(), StrokeInputBatch(),
+                MakeStraightLinePartitionedMesh(20));
+}
+
+// Returns a single-coat `PartitionedMesh` covering `rect`, with an outline.
+PartitionedMesh MakeRectPartitionedMesh(const Rect& rect) {
+  MutableMesh mesh(MeshFormat{});
+  for (Point p : rect.Corners()) mesh.AppendVertex(p);
+  mesh.AppendTriangleIndices({0, 1, 2});
+  mesh.AppendTriangleIndices({0, 2, 3});
+  std::vector<uint32_t> outline = {0, 3, 2, 1};
+  absl::StatusOr<PartitionedMesh> partitioned_mesh =
+      PartitionedMesh::FromMutableMesh(mesh, {{outline}});
+  ABSL_CHECK_OK(partitioned_mesh);
+  return *std::move(partitioned_mesh);
+}
+
+float TotalArea(const PartitionedMesh& partitioned_mesh) {
+  float area = 0;
+  for (const Mesh& mesh : partitioned_mesh.Meshes()) {
+    for (uint32_t i = 0; i < mesh.TriangleCount(); ++i) {
+      area += mesh.GetTriangle(i).SignedArea();
+    }
+  }
+  return area;
+}
+
+TEST(IncrementalStrokeSubtractionTest, NoSegments) {
+  Stroke stroke = MakeStroke();
+  IncrementalStrokeSubtraction subtraction(stroke, AffineTransform());
+
+  EXPECT_THAT(subtraction.GetStroke().GetShape(),
+              PartitionedMeshShallowEq(stroke.GetShape()));
+}
+
+// Erases a band across the stroke with four overlapping segments, and checks
+// that the result covers the same region as erasing the whole band at once.
+TEST(IncrementalStrokeSubtractionTest, MatchesSubtractingWholeEraser) {
+  Stroke stroke = MakeStroke();
+  IncrementalStrokeSubtraction subtraction(stroke, AffineTransform());
+  PartitionedMesh segment =
+      MakeRectPartitionedMesh(Rect::FromTwoPoints({0, -2}, {1, 1}));
+  for (int i = 0; i < 4; ++i) {
+    subtraction.Subtract(segment,
+                         AffineTransform::Translate({4 + 0.5f * i, 0}));
+  }
+  Stroke expected = stroke.Subtract(
+      MakeRectPartitionedMesh(Rect::FromTwoPoints({4, -2}, {6.5, 1})),
+      AffineTransform(), AffineTransform());
+
+  const PartitionedMesh& actual_shape = subtraction.GetStroke().GetShape();
+  EXPECT_NEAR(TotalArea(actual_shape), 17.5, 1e-3);
+  EXPECT_NEAR(TotalArea(expected.GetShape()), 17.5, 1e-3);
+  for (float x = 0.25; x < 21; x += 0.5) {
+    for (float y : {-0.7f, -0.3f}) {
+      EXPECT_EQ(Intersects(actual_shape, AffineTransform(), Point{x, y}),
+                Intersects(expected.GetShape(), AffineTransform(), Point{x, y}))
+          << "at (" << x << ", " << y << ")";
+    }
+  }
+}
+
+// Erases along a zigzag path that crosses the stroke several times, with each
+// segment overlapping the previous one at the turns, and checks that the
+// result has the same area and covers the same region as a single
+// `Stroke::Subtract` of the whole path.
+TEST(IncrementalStrokeSubtractionTest, ZigzagMatchesSubtractingWholeEraser) {
+  Stroke stroke(Brush(), StrokeInputBatch(),
+                MakeStraightLinePartitionedMesh(40));
+  IncrementalStrokeSubtraction subtraction(stroke, AffineTransform());
+  std::vector<Point> path = {{2, 2},   {6, -3},  {10, 2}, {15, -3},
+                             {21, 2}, {28, -3}, {35, 2}};
+
+  // Each segment is a rectangle of width 0.5 around the line from one point of
+  // the path to the next, extended by 0.25 at both ends so that consecutive
+  // segments overlap. The whole eraser has one such rectangle per segment.
+  MutableMesh whole_mesh(MeshFormat{});
+  std::vector<std::vector<uint32_t>> whole_outlines;
+  for (size_t i = 0; i + 1 < path.size(); ++i) {
+    Vec direction = path[i + 1] - path[i];
+    float length = direction.Magnitude();
+    AffineTransform segment_transform =
+        AffineTransform::Translate(path[i] - Point{0, 0}) *
+        AffineTransform::Rotate(direction.Direction());
+    Rect rect = Rect::FromTwoPoints({-0.25, -0.25}, {length + 0.25, 0.25});
+    subtraction.Subtract(MakeRectPartitionedMesh(rect), segment_transform);
+
+    uint32_t first_vertex = whole_mesh.VertexCount();
+    for (Point p : rect.Corners()) {
+      whole_mesh.AppendVertex(segment_transform.Apply(p));
+    }
+    whole_mesh.AppendTriangleIndices(
+        {first_vertex, first_vertex + 1, first_vertex + 2});
+    whole_mesh.AppendTriangleIndices(
+        {first_vertex, first_vertex + 2, first_vertex + 3});
+    whole_outlines.push_back({first_vertex, first_vertex + 3,
+                              first_vertex + 2, first_vertex + 1});
+  }
+  std::vector<absl::Span<const uint32_t>> whole_outline_spans(
+      whole_outlines.begin(), whole_outlines.end());
+  absl::StatusOr<PartitionedMesh> whole_eraser =
+      PartitionedMesh::FromMutableMesh(whole_mesh, whole_outline_spans);
+  ASSERT_THAT(whole_eraser, IsOk());
+  Stroke expected =
+      stroke.Subtract(*whole_eraser, AffineTransform(), AffineTransform());
+
+  const PartitionedMesh& actual_shape = subtraction.GetStroke().GetShape();
+  const PartitionedMesh& expected_shape = expected.GetShape();
+  float expected_area = TotalArea(expected_shape);
+  EXPECT_LT(expected_area, 40 - 1);
+  EXPECT_NEAR(TotalArea(actual_shape), expected_area, 1e-3);
+  // Every triangle of each result touches the other, so neither has any part
+  // left that the other erased.
+  EXPECT_NEAR(actual_shape.Coverage(expected_shape), 1, 1e-5);
+  EXPECT_NEAR(expected_shape.Coverage(actual_shape), 1, 1e-5);
+}
+
+TEST(IncrementalStrokeSubtractionTest, SegmentsInOtherCoordinates) {
+  // The stroke is rotated a quarter turn about the origin, so that it extends
+  // from x = 0 to x = 1, and from y = 0 to y = 21.
+  IncrementalStrokeSubtraction subtraction(
+      MakeStroke(), AffineTransform::Rotate(kQuarterTurn));
+  PartitionedMesh segment =
+      MakeRectPartitionedMesh(Rect::FromTwoPoints({-1, 0}, {2, 1}));
+  subtraction.Subtract(segment, AffineTransform::Translate({0, 5}));
+  subtraction.Subtract(segment, AffineTransform::Translate({0, 10}));
+
+  const PartitionedMesh& shape = subtraction.GetStroke().GetShape();
+  EXPECT_NEAR(TotalArea(shape), 18, 1e-3);
+  EXPECT_FALSE(Intersects(shape, AffineTransform(), Point{5.5, -0.5}));
+  EXPECT_FALSE(Intersects(shape, AffineTransform(), Point{10.5, -0.5}));
+  EXPECT_TRUE(Intersects(shape, AffineTransform(), Point{8, -0.5}));
+}
+
+TEST(IncrementalStrokeSubtractionTest, GetStrokeBetweenSegments) {
+  IncrementalStrokeSubtraction subtraction(MakeStroke(), AffineTransform());
+  PartitionedMesh segment =
+      MakeRectPartitionedMesh(Rect::FromTwoPoints({0, -2}, {1, 1}));
+  subtraction.Subtract(segment, AffineTransform::Translate({4, 0}));
+  EXPECT_NEAR(TotalArea(subtraction.GetStroke().GetShape()), 19, 1e-3);
+  subtraction.Subtract(segment, AffineTransform::Translate({10, 0}));
+  EXPECT_NEAR(TotalArea(subtraction.GetStroke().GetShape()), 18, 1e-3);
+}
+
+TEST(IncrementalStrokeSubtractionTest, CopyIsIndependent) {
+  IncrementalStrokeSubtraction subtraction(MakeStroke(), AffineTransform());
+  PartitionedMesh segment =
+      MakeRectPartitionedMesh(Rect::FromTwoPoints({0, -2}, {1, 1}));
+  subtraction.Subtract(segment, AffineTransform::Translate({4, 0}));
+
+  IncrementalStrokeSubtraction copy = subtraction;
+  copy.Subtract(segment, AffineTransform::Translate({10, 0}));
+  EXPECT_NEAR(TotalArea(subtraction.GetStroke().GetShape()), 19, 1e-3);
+  EXPECT_NEAR(TotalArea(copy.GetStroke().GetShape()), 18, 1e-3);
+
+  subtraction = copy;
+  EXPECT_NEAR(TotalArea(subtraction.GetStroke().GetShape()), 18, 1e-3);
+}
+
+TEST(IncrementalStrokeSubtractionTest, SegmentAwayFromStrokeLeavesStrokeAsIs) {
+  Stroke stroke = MakeStroke();
+  IncrementalStrokeSubtraction subtraction(stroke, AffineTransform());
+  PartitionedMesh segment =
+      MakeRectPartitionedMesh(Rect::FromTwoPoints({0, 0}, {1, 1}));
+
+  // Outside the bounds of the stroke.
+  subtraction.Subtract(segment, AffineTransform::Translate({5, 2}));
+  EXPECT_THAT(subtraction.GetStroke().GetShape(),
+              PartitionedMeshShallowEq(stroke.GetShape()));
+
+  // Inside the axis-aligned bounds of the rotated stroke, but away from it.
+  IncrementalStrokeSubtraction rotated_subtraction(
+      stroke, AffineTransform::Rotate(kFullTurn / 8));
+  rotated_subtraction.Subtract(segment, AffineTransform::Translate({12, 1}));
+  EXPECT_THAT(rotated_subtraction.GetStroke().GetShape(),
+              PartitionedMeshShallowEq(stroke.GetShape()));
+}
+
+TEST(IncrementalStrokeSubtractionTest, DegenerateTransformLeavesStrokeAsIs) {
+  Stroke stroke = MakeStroke();
+  IncrementalStrokeSubtraction subtraction(stroke, AffineTransform());
+  subtraction.Subtract(
+      MakeRectPartitionedMesh(Rect::FromTwoPoints({4, -2}, {5, 1})),
+      AffineTransform::Scale(1, 0));
+
+  EXPECT_THAT(subtraction.GetStroke().GetShape(),
+              PartitionedMeshShallowEq(stroke.GetShape()));
+}
+
+TEST(IncrementalStrokeSubtractionTest, ThreadExecutorMatchesSerialExecutor) {
+  Stroke stroke(Brush(), StrokeInputBatch(),
+                MakeStraightLinePartitionedMesh(5000));
+  IncrementalStrokeSubtraction serial(stroke, AffineTransform());
+  IncrementalStrokeSubtraction threaded(stroke, AffineTransform());
+  ThreadExecutor executor(4);
+  PartitionedMesh segment =
+      MakeRectPartitionedMesh(Rect::FromTwoPoints({0, -2}, {1.5, 1}));
+  for (int i = 0; i < 10; ++i) {
+    AffineTransform transform = AffineTransform::Translate({i * 400.f, 0});
+    serial.Subtract(segment, transform);
+    threaded.Subtract(segment, transform, executor);
+  }
+
+  EXPECT_THAT(threaded.GetStroke().GetShape(),
+              PartitionedMeshDeepEq(serial.GetStroke().GetShape()));
+}
+
+}  // namespace
+}  // namespace ink
@@ -19,6 +19,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <iterator>
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -27,11 +28,13 @@
 #include "absl/types/span.h"
 #include "ink/geometry/affine_transform.h"
 #include "ink/geometry/envelope.h"
+#include "ink/geometry/mesh_format.h"
 #include "ink/geometry/mutable_mesh.h"
 #include "ink/geometry/point.h"
 #include "ink/strokes/internal/brush_tip_extruder/geometry.h"
 #include "ink/strokes/internal/brush_tip_extruder/mutable_mesh_view.h"
 #include "ink/strokes/internal/brush_tip_extruder/side.h"
+#include "ink/strokes/internal/brush_tip_extruder/typed_mesh.h"
 #include "ink/strokes/internal/brush_tip_extrusion.h"
 #include "ink/strokes/internal/brush_tip_shape.h"
 #include "ink/strokes/internal/brush_tip_state.h"
@@ -39,6 +42,7 @@
 #include "ink/strokes/internal/extrusion_points.h"
 #include "ink/strokes/internal/stroke_outline.h"
 #include "ink/strokes/internal/stroke_shape_update.h"
+#include "ink/strokes/internal/stroke_vertex.h"
 
 namespace ink::strokes_internal {
 namespace {
@@ -46,6 +50,7 @@ namespace {
 using ::ink::brush_tip_extruder_internal::Geometry;
 using ::ink::brush_tip_extruder_internal::MutableMeshView;
 using ::ink::brush_tip_extruder_internal::Side;
+using ::ink::brush_tip_extruder_internal::TypedMesh;
 
 // TODO: b/289230108 - Define a clear relationship between brush epsilon and the
 // max chord height / simplification threshold values. Probably at least one of
@@ -62,7 +67,16 @@ void BrushTipExtruder::StartStroke(float brush_epsilon, bool is_particle_brush,
   max_chord_height_ = GetMaxChordHeight(brush_epsilon);
   simplification_threshold_ = GetSimplificationThreshold(brush_epsilon);
   is_particle_brush_ = is_particle_brush;
-  geometry_.Reset(MutableMeshView(mesh));
+  ABSL_CHECK(MeshFormat::IsUnpackedEquivalent(mesh.Format(),
+                                              StrokeVertex::FullMeshFormat()));
+  mesh_ = &mesh;
+  mesh_->Clear();
+  if (typed_mesh_ == nullptr) {
+    typed_mesh_ = std::make_unique<TypedMesh>();
+  } else {
+    typed_mesh_->Clear();
+  }
+  geometry_.Reset(MutableMeshView(*typed_mesh_));
   RestartStroke();
 }
 
@@ -121,6 +135,7 @@ StrokeShapeUpdate BrushTipExtruder::ExtendStroke(
   ExtrudeBreakPoint();
   geometry_.UpdateMeshDerivatives();
   UpdateCurrentBounds();
+  typed_mesh_->CopyChangesToMesh(*mesh_);
   return ConstructUpdate(geometry_, triangle_count_before_update,
                          vertex_count_before_update);
 }
@@ -141,6 +156,7 @@ void BrushTipExtruder::RestartStroke() {
   for (StrokeOutline& outline : outlines_) {
     outline.TruncateIndices({0, 0});
   }
+  typed_mesh_->CopyChangesToMesh(*mesh_);
 }
 
 void BrushTipExtruder::ClearCachedPartialBounds() {
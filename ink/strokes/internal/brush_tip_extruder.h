@@ -17,6 +17,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 #include "absl/container/inlined_vector.h"
@@ -24,6 +25,7 @@
 #include "ink/geometry/envelope.h"
 #include "ink/geometry/mutable_mesh.h"
 #include "ink/strokes/internal/brush_tip_extruder/geometry.h"
+#include "ink/strokes/internal/brush_tip_extruder/typed_mesh.h"
 #include "ink/strokes/internal/brush_tip_extrusion.h"
 #include "ink/strokes/internal/brush_tip_state.h"
 #include "ink/strokes/internal/extrusion_points.h"
@@ -79,7 +81,10 @@ class BrushTipExtruder {
   //
   // Extruded mesh data will be added to the target `mesh`, the lifetime of
   // which must extend for all subsequent calls to `ExtendStroke()`
-  // until this object is destroyed or `StartStroke()` is called again.
+  // until this object is destroyed or `StartStroke()` is called again. The
+  // geometry is built in separate typed storage, and only the changed parts
+  // are copied into `mesh` before this function, `ExtendStroke()`, and
+  // `RestartStroke()` return.
   //
   // This function must be called at least once after construction before
   // calling `ExtendStroke()`. Any previously extruded stroke data is cleared.
@@ -232,6 +237,15 @@ class BrushTipExtruder {
   bool is_particle_brush_;
 
   ExtrusionPoints current_extrusion_points_;
+  // The mesh modified by `geometry_`, which is copied to `mesh_` at the end of
+  // every update, so that the many intermediate writes to vertex attributes
+  // during extrusion are plain struct stores.
+  //
+  // This is heap-allocated because `geometry_` holds a view that points to it,
+  // which must stay valid when this object is moved. It is allocated by the
+  // first call to `StartStroke()`.
+  std::unique_ptr<brush_tip_extruder_internal::TypedMesh> typed_mesh_;
+  MutableMesh* mesh_ = nullptr;
   brush_tip_extruder_internal::Geometry geometry_;
   Bounds bounds_;
 
@@ -67,29 +67,49 @@ void DerivativeCalculator::UpdateMesh(
   }
   ABSL_CHECK(mesh.HasMeshData());
 
-  ResetTrackedValues(left_indices_to_update, right_indices_to_update, mesh);
+  absl::Span<const uint32_t> index_runs[] = {left_indices_to_update,
+                                             right_indices_to_update};
+  ResetTrackedValues(index_runs, std::nullopt, mesh);
+  UpdateTrackedVertices(index_runs, mesh);
+}
 
+void DerivativeCalculator::UpdateMesh(
+    absl::Span<const absl::Span<const uint32_t>> index_runs,
+    uint32_t first_triangle, MutableMeshView& mesh) {
+  if (absl::c_all_of(index_runs, [](absl::Span<const uint32_t> run) {
+        return run.empty();
+      })) {
+    return;
+  }
+  ABSL_CHECK(mesh.HasMeshData());
+
+  ResetTrackedValues(index_runs, first_triangle, mesh);
+  UpdateTrackedVertices(index_runs, mesh);
+}
+
+void DerivativeCalculator::UpdateTrackedVertices(
+    absl::Span<const absl::Span<const uint32_t>> index_runs,
+    MutableMeshView& mesh) {
   AccumulateDerivatives(mesh);
-  UpdateMeshDerivatives(left_indices_to_update, mesh);
-  UpdateMeshDerivatives(right_indices_to_update, mesh);
+  for (absl::Span<const uint32_t> run : index_runs) {
+    UpdateMeshDerivatives(run, mesh);
+  }
 
   AccumulateMargins(mesh);
-  UpdateMeshMargins(left_indices_to_update, mesh);
-  UpdateMeshMargins(right_indices_to_update, mesh);
+  for (absl::Span<const uint32_t> run : index_runs) {
+    UpdateMeshMargins(run, mesh);
+  }
 }
 
 void DerivativeCalculator::ResetTrackedValues(
-    absl::Span<const uint32_t> left_indices_to_update,
-    absl::Span<const uint32_t> right_indices_to_update,
-    const MutableMeshView& mesh) {
-  if (!left_indices_to_update.empty() && !right_indices_to_update.empty()) {
-    minimum_tracked_index_ = std::min(left_indices_to_update.front(),
-                                      right_indices_to_update.front());
-  } else if (!left_indices_to_update.empty()) {
-    minimum_tracked_index_ = left_indices_to_update.front();
-  } else {
-    ABSL_DCHECK(!right_indices_to_update.empty());
-    minimum_tracked_index_ = right_indices_to_update.front();
+    absl::Span<const absl::Span<const uint32_t>> index_runs,
+    std::optional<uint32_t> first_triangle, const MutableMeshView& mesh) {
+  first_tracked_triangle_ = first_triangle;
+  minimum_tracked_index_ = mesh.VertexCount();
+  for (absl::Span<const uint32_t> run : index_runs) {
+    if (!run.empty()) {
+      minimum_tracked_index_ = std::min(minimum_tracked_index_, run.front());
+    }
   }
 
   ABSL_CHECK_LT(minimum_tracked_index_, mesh.VertexCount());
@@ -101,6 +121,33 @@ void DerivativeCalculator::ResetTrackedValues(
   tracked_side_margin_upper_bounds_.clear();
   tracked_side_margin_upper_bounds_.resize(tracked_vertex_count,
                                            StrokeVertex::kMaximumMargin);
+
+  tracked_vertex_is_updated_.clear();
+  tracked_vertex_is_updated_.resize(tracked_vertex_count, false);
+  tracked_vertex_is_changed_.clear();
+  tracked_vertex_is_changed_.resize(tracked_vertex_count, false);
+  for (absl::Span<const uint32_t> run : index_runs) {
+    for (uint32_t index : run) {
+      tracked_vertex_is_updated_[index - minimum_tracked_index_] = true;
+    }
+  }
+}
+
+bool DerivativeCalculator::LastUpdateChangedVertex(uint32_t index) const {
+  return index >= minimum_tracked_index_ &&
+         index - minimum_tracked_index_ < tracked_vertex_is_changed_.size() &&
+         tracked_vertex_is_changed_[index - minimum_tracked_index_];
+}
+
+bool DerivativeCalculator::IsUpdatedVertex(uint32_t index) const {
+  return index >= minimum_tracked_index_ &&
+         tracked_vertex_is_updated_[index - minimum_tracked_index_];
+}
+
+bool DerivativeCalculator::IncludesUpdatedVertex(
+    const std::array<uint32_t, 3>& indices) const {
+  return IsUpdatedVertex(indices[0]) || IsUpdatedVertex(indices[1]) ||
+         IsUpdatedVertex(indices[2]);
 }
 
 void DerivativeCalculator::SaveSideDerivative(
@@ -132,7 +179,15 @@ namespace {
 template <typename Function>
 void ForEachTriangleWithTrackedIndices(const MutableMeshView& mesh,
                                        uint32_t minimum_tracked_index,
+                                       std::optional<uint32_t> first_triangle,
                                        Function&& f) {
+  if (first_triangle.has_value()) {
+    for (uint32_t i = mesh.TriangleCount(); i > *first_triangle; --i) {
+      f(mesh, mesh.GetTriangleIndices(i - 1));
+    }
+    return;
+  }
+
   for (uint32_t i = mesh.TriangleCount(); i > 0; --i) {
     std::array<uint32_t, 3> triangle_indices = mesh.GetTriangleIndices(i - 1);
 
@@ -152,10 +207,13 @@ void ForEachTriangleWithTrackedIndices(const MutableMeshView& mesh,
 }  // namespace
 
 void DerivativeCalculator::AccumulateDerivatives(const MutableMeshView& mesh) {
+  tracked_triangle_indices_.clear();
   ForEachTriangleWithTrackedIndices(
-      mesh, minimum_tracked_index_,
+      mesh, minimum_tracked_index_, first_tracked_triangle_,
       [&](const MutableMeshView& mesh,
           const std::array<uint32_t, 3>& triangle_indices) {
+        if (!IncludesUpdatedVertex(triangle_indices)) return;
+        tracked_triangle_indices_.push_back(triangle_indices);
         AddDerivativesForTriangle(mesh, triangle_indices);
       });
 }
@@ -332,20 +390,26 @@ void DerivativeCalculator::UpdateMeshDerivatives(
                           minimum_tracked_index_);
 
     for (uint32_t index : coincident_indices) {
-      mesh.SetSideDerivative(index, averages.side);
-      mesh.SetForwardDerivative(index, averages.forward);
+      if (mesh.GetSideDerivative(index) != averages.side) {
+        mesh.SetSideDerivative(index, averages.side);
+        tracked_vertex_is_changed_[index - minimum_tracked_index_] = true;
+      }
+      if (mesh.GetForwardDerivative(index) != averages.forward) {
+        mesh.SetForwardDerivative(index, averages.forward);
+        tracked_vertex_is_changed_[index - minimum_tracked_index_] = true;
+      }
     }
     indices_to_update.remove_prefix(count);
   }
 }
 
 void DerivativeCalculator::AccumulateMargins(const MutableMeshView& mesh) {
-  ForEachTriangleWithTrackedIndices(
-      mesh, minimum_tracked_index_,
-      [&](const MutableMeshView& mesh,
-          const std::array<uint32_t, 3>& triangle_indices) {
-        AddMarginUpperBoundsForTriangle(mesh, triangle_indices);
-      });
+  // The triangles that include an updated vertex were already found by
+  // `AccumulateDerivatives()`.
+  for (const std::array<uint32_t, 3>& triangle_indices :
+       tracked_triangle_indices_) {
+    AddMarginUpperBoundsForTriangle(mesh, triangle_indices);
+  }
 }
 
 void DerivativeCalculator::SaveSideMarginUpperBound(uint32_t index,
@@ -569,8 +633,12 @@ void DerivativeCalculator::UpdateMeshMargins(
                                             tracked_side_margin_upper_bounds_,
                                             minimum_tracked_index_);
     for (uint32_t index : coincident_indices) {
-      mesh.SetSideLabel(index,
-                        mesh.GetSideLabel(index).WithMargin(side_margin));
+      StrokeVertex::Label label = mesh.GetSideLabel(index);
+      StrokeVertex::Label new_label = label.WithMargin(side_margin);
+      if (new_label != label) {
+        mesh.SetSideLabel(index, new_label);
+        tracked_vertex_is_changed_[index - minimum_tracked_index_] = true;
+      }
     }
     indices_to_update.remove_prefix(count);
   }
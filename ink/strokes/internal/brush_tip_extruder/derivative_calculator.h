@@ -17,6 +17,7 @@
 
 #include <array>
 #include <cstdint>
+#include <optional>
 #include <vector>
 
 #include "absl/types/span.h"
@@ -82,13 +83,42 @@ class DerivativeCalculator {
                   absl::Span<const uint32_t> right_indices_to_update,
                   MutableMeshView& mesh);
 
+  // Updates values of vertex derivative attributes in the stroke `mesh` for
+  // only the vertices in `index_runs`.
+  //
+  // Each run is expected to be a subrange of
+  // `brush_tip_extruder_internal::Side::indices` for either side of the stroke
+  // that begins and ends at the boundaries of a range of coincident vertices.
+  // Every mesh triangle that includes one of these vertices is expected to be
+  // at or after `first_triangle`. Only those triangles are used in the
+  // calculation, and attributes are only written if their values change.
+  void UpdateMesh(absl::Span<const absl::Span<const uint32_t>> index_runs,
+                  uint32_t first_triangle, MutableMeshView& mesh);
+
+  // Returns true if the last call to `UpdateMesh()` wrote a new value for any
+  // attribute of the vertex at `index`.
+  bool LastUpdateChangedVertex(uint32_t index) const;
+
  private:
   // Prepares the tracked average derivatives and minimum margins for
   // calculating new values. The derivatives are zeroed out, and the margins are
   // set to `StrokeVertex::kMaximumMargin`.
-  void ResetTrackedValues(absl::Span<const uint32_t> left_indices_to_update,
-                          absl::Span<const uint32_t> right_indices_to_update,
-                          const MutableMeshView& mesh);
+  void ResetTrackedValues(
+      absl::Span<const absl::Span<const uint32_t>> index_runs,
+      std::optional<uint32_t> first_triangle, const MutableMeshView& mesh);
+
+  // Calculates and writes new values for the vertices in `index_runs` after a
+  // call to `ResetTrackedValues()`.
+  void UpdateTrackedVertices(
+      absl::Span<const absl::Span<const uint32_t>> index_runs,
+      MutableMeshView& mesh);
+
+  // Returns true if `index` is in one of the runs passed to `UpdateMesh()`.
+  bool IsUpdatedVertex(uint32_t index) const;
+
+  // Returns true if any of the `indices` is in one of the runs passed to
+  // `UpdateMesh()`.
+  bool IncludesUpdatedVertex(const std::array<uint32_t, 3>& indices) const;
 
   // The following helper functions update the relevant values in
   // `tracked_average_derivatives_` for the given `indices` of the current mesh.
@@ -146,6 +176,18 @@ class DerivativeCalculator {
   // each vertex, and there can up to two of these segments per vertex.
   std::vector<AverageVertexDerivatives> tracked_average_derivatives_;
   std::vector<float> tracked_side_margin_upper_bounds_;
+  // Whether each vertex starting at `minimum_tracked_index_` is being updated,
+  // and whether any of its attributes were given a new value.
+  std::vector<bool> tracked_vertex_is_updated_;
+  std::vector<bool> tracked_vertex_is_changed_;
+  // The indices of each triangle that includes an updated vertex, in the order
+  // visited by `AccumulateDerivatives()`, so that `AccumulateMargins()` can
+  // visit the same triangles without searching the mesh again.
+  std::vector<std::array<uint32_t, 3>> tracked_triangle_indices_;
+  // The first mesh triangle that can include a tracked vertex, if known.
+  // Otherwise, triangles are visited backwards from the end of the mesh until
+  // reaching one with all indices below `minimum_tracked_index_`.
+  std::optional<uint32_t> first_tracked_triangle_;
 };
 
 }  // namespace ink::brush_tip_extruder_internal
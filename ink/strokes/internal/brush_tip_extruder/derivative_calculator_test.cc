@@ -229,6 +229,42 @@ TEST_F(DerivativeCalculatorTest, UpdateForRectangularMeshWithEmptyIndices) {
   EXPECT_THAT(GetForwardDerivativeValues(), Each(VecEq({0, 0})));
 }
 
+TEST_F(DerivativeCalculatorTest, UpdateForRectangularMeshWithIndexRuns) {
+  AppendRectangularMesh({.width = 2, .length = 5});
+
+  // Update only the middle vertices, which are first used by triangle 0.
+  std::vector<uint32_t> left_run = {2};
+  std::vector<uint32_t> right_run = {3};
+  std::vector<absl::Span<const uint32_t>> index_runs = {left_run, right_run};
+  calculator_.UpdateMesh(index_runs, 0, mesh_view_);
+
+  EXPECT_THAT(GetSideDerivativeValues(), ElementsAreArray({
+                                             VecEq({0, 0}),
+                                             VecEq({0, 0}),
+                                             VecNear({0, -2}, 0.0001),
+                                             VecNear({0, -2}, 0.0001),
+                                             VecEq({0, 0}),
+                                             VecEq({0, 0}),
+                                         }));
+  EXPECT_THAT(GetForwardDerivativeValues(), ElementsAreArray({
+                                                VecEq({0, 0}),
+                                                VecEq({0, 0}),
+                                                VecNear({2.5, 0}, 0.0001),
+                                                VecNear({2.5, 0}, 0.0001),
+                                                VecEq({0, 0}),
+                                                VecEq({0, 0}),
+                                            }));
+  EXPECT_FALSE(calculator_.LastUpdateChangedVertex(1));
+  EXPECT_TRUE(calculator_.LastUpdateChangedVertex(2));
+  EXPECT_TRUE(calculator_.LastUpdateChangedVertex(3));
+  EXPECT_FALSE(calculator_.LastUpdateChangedVertex(4));
+
+  // Repeating the update calculates the same values, so nothing is changed.
+  calculator_.UpdateMesh(index_runs, 0, mesh_view_);
+  EXPECT_FALSE(calculator_.LastUpdateChangedVertex(2));
+  EXPECT_FALSE(calculator_.LastUpdateChangedVertex(3));
+}
+
 TEST_F(DerivativeCalculatorTest, VaryingWidthMesh) {
   // Fill with a mesh consisting of 6 vertices and 4 triangles that has
   // non-uniform separation between vertices:
@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <iterator>
 #include <limits>
@@ -77,6 +78,66 @@ Geometry::Geometry() {
 
 Geometry::Geometry(const MutableMeshView& mesh) : Geometry() { Reset(mesh); }
 
+namespace {
+
+// Starts a new journal for `save_point_state`, so that all indices before
+// `n_mesh_vertices` and `n_mesh_triangles` are considered not yet journaled.
+void StartNewSaveId(GeometrySavePointState& save_point_state) {
+  ++save_point_state.save_id;
+  if (save_point_state.save_id == 0) {
+    // The ID wrapped around, so stale values in the `*_save_ids` could match.
+    save_point_state.vertex_save_ids.clear();
+    save_point_state.triangle_save_ids.clear();
+    save_point_state.opposite_side_offset_save_ids.clear();
+    save_point_state.save_id = 1;
+  }
+  // Any new elements are zero, which is never a current `save_id`.
+  save_point_state.vertex_save_ids.resize(save_point_state.n_mesh_vertices);
+  save_point_state.triangle_save_ids.resize(save_point_state.n_mesh_triangles);
+  save_point_state.opposite_side_offset_save_ids.resize(
+      save_point_state.n_mesh_vertices);
+}
+
+// Returns true if the value at `index` has not yet been journaled for the
+// current save point, and marks it as journaled. `index` must be less than the
+// corresponding `n_mesh_vertices` or `n_mesh_triangles`.
+bool MarkForJournal(uint32_t save_id, uint32_t index,
+                    std::vector<uint32_t>& save_ids) {
+  ABSL_DCHECK_LT(index, save_ids.size());
+  if (save_ids[index] == save_id) return false;
+  save_ids[index] = save_id;
+  return true;
+}
+
+void JournalVertex(MutableMeshView::IndexType index,
+                   const ExtrudedVertex& vertex,
+                   GeometrySavePointState& save_point_state) {
+  if (MarkForJournal(save_point_state.save_id, index,
+                     save_point_state.vertex_save_ids)) {
+    save_point_state.saved_vertices.emplace_back(index, vertex);
+  }
+}
+
+void JournalTriangleIndices(
+    uint32_t triangle, const std::array<MutableMeshView::IndexType, 3>& indices,
+    GeometrySavePointState& save_point_state) {
+  if (MarkForJournal(save_point_state.save_id, triangle,
+                     save_point_state.triangle_save_ids)) {
+    save_point_state.saved_triangle_indices.emplace_back(triangle, indices);
+  }
+}
+
+void JournalOppositeSideOffset(MutableMeshView::IndexType index,
+                               uint32_t offset,
+                               GeometrySavePointState& save_point_state) {
+  if (MarkForJournal(save_point_state.save_id, index,
+                     save_point_state.opposite_side_offset_save_ids)) {
+    save_point_state.saved_opposite_side_offsets.emplace_back(index, offset);
+  }
+}
+
+}  // namespace
+
 void Geometry::SetSavePoint() {
   if (!mesh_.HasMeshData()) return;
 
@@ -106,6 +167,7 @@ void Geometry::SetSavePoint() {
   save_point_state_.saved_vertices.clear();
   save_point_state_.saved_triangle_indices.clear();
   save_point_state_.saved_opposite_side_offsets.clear();
+  StartNewSaveId(save_point_state_);
   set_side_state(left_side_, save_point_state_.left_side_state);
   set_side_state(right_side_, save_point_state_.right_side_state);
   save_point_state_.saved_last_extrusion_break = last_extrusion_break_;
@@ -200,6 +262,7 @@ void Geometry::RevertToSavePoint() {
   // If we're shrinking the mesh, truncate any extra triangles/vertices. (If
   // we're growing the mesh, the missing vertices/triangles will be added by the
   // for-loops below.)
+  MarkTrianglesForDerivativeUpdate(save_point_state_.n_mesh_triangles);
   mesh_.TruncateTriangles(save_point_state_.n_mesh_triangles);
   mesh_.TruncateVertices(save_point_state_.n_mesh_vertices);
 
@@ -208,29 +271,49 @@ void Geometry::RevertToSavePoint() {
   vertex_side_ids_.resize(save_point_state_.n_mesh_vertices);
   side_offsets_.resize(save_point_state_.n_mesh_vertices);
   opposite_side_offsets_.resize(save_point_state_.n_mesh_vertices);
+  first_triangle_lower_bounds_.resize(save_point_state_.n_mesh_vertices,
+                                      mesh_.TriangleCount());
 
-  // Revert mutated/removed vertices. Note that `saved_vertices` is an ordered
-  // map, so any new vertices will get appended in order.
+  // Re-add any removed vertices and triangles as placeholders. All of them
+  // were journaled when they were removed, so they are overwritten below.
+  while (mesh_.VertexCount() < save_point_state_.n_mesh_vertices) {
+    MarkVertexForDerivativeUpdate(mesh_.VertexCount());
+    mesh_.AppendVertex({});
+  }
+  while (mesh_.TriangleCount() < save_point_state_.n_mesh_triangles) {
+    mesh_.AppendTriangleIndices({0, 0, 0});
+  }
+
+  // Revert mutated/removed vertices and triangles.
+  [[maybe_unused]] uint32_t n_restored_vertices = 0;
   for (const auto& [index, vertex] : save_point_state_.saved_vertices) {
     if (index < old_vertex_count) {
       SetVertex(index, vertex, /* update_save_state = */ false,
                 /* update_envelope_of_removed_geometry = */ true);
     } else {
-      ABSL_DCHECK_EQ(index, mesh_.VertexCount());
-      mesh_.AppendVertex(vertex);
+      mesh_.SetVertex(index, vertex);
+      ++n_restored_vertices;
     }
   }
-  // Revert mutated/removed triangles. Note that `saved_triangle_indices` is an
-  // ordered map, so any new triangles will get appended in order.
+  ABSL_DCHECK_EQ(n_restored_vertices,
+                 save_point_state_.n_mesh_vertices -
+                     std::min(old_vertex_count,
+                              save_point_state_.n_mesh_vertices));
+  [[maybe_unused]] uint32_t n_restored_triangles = 0;
   for (const auto& [triangle, indices] :
        save_point_state_.saved_triangle_indices) {
     if (triangle < old_triangle_count) {
-      mesh_.SetTriangleIndices(triangle, indices);
+      MarkTriangleForDerivativeUpdate(mesh_.GetTriangleIndices(triangle));
     } else {
-      ABSL_DCHECK_EQ(triangle, mesh_.TriangleCount());
-      mesh_.AppendTriangleIndices(indices);
+      ++n_restored_triangles;
     }
+    MarkNewTriangleForDerivativeUpdate(triangle, indices);
+    mesh_.SetTriangleIndices(triangle, indices);
   }
+  ABSL_DCHECK_EQ(n_restored_triangles,
+                 save_point_state_.n_mesh_triangles -
+                     std::min(old_triangle_count,
+                              save_point_state_.n_mesh_triangles));
 
   for (const auto& index_offset_pair :
        save_point_state_.saved_opposite_side_offsets) {
@@ -273,6 +356,13 @@ void Geometry::RevertToSavePoint() {
   revert_side(right_side_,
               first_mutated_right_index_offset_in_current_partition_,
               save_point_state_.right_side_state);
+  // The last vertex on each side may have lost coincident neighbors.
+  if (!left_side_.indices.empty()) {
+    MarkVertexForDerivativeUpdate(left_side_.indices.back());
+  }
+  if (!right_side_.indices.empty()) {
+    MarkVertexForDerivativeUpdate(right_side_.indices.back());
+  }
   last_extrusion_break_ = save_point_state_.saved_last_extrusion_break;
 
   save_point_state_.is_active = false;
@@ -297,6 +387,8 @@ void Geometry::ResetMutationTracking() {
       left_side_.indices.size();
   first_mutated_right_index_offset_in_current_partition_ =
       right_side_.indices.size();
+  ClearVerticesNeedingDerivativeUpdate();
+  vertices_with_changed_geometry_.clear();
 }
 
 namespace {
@@ -480,14 +572,14 @@ void CaptureGeometrySinceLastExtrusionBreak(
 
   for (uint32_t t_idx = last_extrusion_break.triangle_count;
        t_idx < save_point_state.n_mesh_triangles; ++t_idx) {
-    save_point_state.saved_triangle_indices.emplace(
-        t_idx, mesh.GetTriangleIndices(t_idx));
+    JournalTriangleIndices(t_idx, mesh.GetTriangleIndices(t_idx),
+                           save_point_state);
   }
   for (uint32_t v_idx = last_extrusion_break.vertex_count;
        v_idx < save_point_state.n_mesh_vertices; ++v_idx) {
-    save_point_state.saved_vertices.emplace(v_idx, mesh.GetVertex(v_idx));
-    save_point_state.saved_opposite_side_offsets.emplace(
-        v_idx, opposite_side_offsets[v_idx]);
+    JournalVertex(v_idx, mesh.GetVertex(v_idx), save_point_state);
+    JournalOppositeSideOffset(v_idx, opposite_side_offsets[v_idx],
+                              save_point_state);
   }
 
   using SideInfo = GeometryLastExtrusionBreakMetadata::SideInfo;
@@ -553,16 +645,24 @@ void Geometry::ClearSinceLastExtrusionBreak() {
 
   delete_side_geometry(last_extrusion_break_.left_side_info, left_side_);
   delete_side_geometry(last_extrusion_break_.right_side_info, right_side_);
+  if (!left_side_.indices.empty()) {
+    MarkVertexForDerivativeUpdate(left_side_.indices.back());
+  }
+  if (!right_side_.indices.empty()) {
+    MarkVertexForDerivativeUpdate(right_side_.indices.back());
+  }
 
   ABSL_DCHECK_LE(last_extrusion_break_.triangle_count, mesh_.TriangleCount());
   ABSL_DCHECK_LE(last_extrusion_break_.vertex_count, mesh_.VertexCount());
 
+  MarkTrianglesForDerivativeUpdate(last_extrusion_break_.triangle_count);
   mesh_.TruncateTriangles(last_extrusion_break_.triangle_count);
   mesh_.TruncateVertices(last_extrusion_break_.vertex_count);
 
   vertex_side_ids_.resize(last_extrusion_break_.vertex_count);
   side_offsets_.resize(last_extrusion_break_.vertex_count);
   opposite_side_offsets_.resize(last_extrusion_break_.vertex_count);
+  first_triangle_lower_bounds_.resize(last_extrusion_break_.vertex_count);
 
   first_mutated_left_index_offset_in_current_partition_ =
       std::min<uint32_t>(first_mutated_left_index_offset_in_current_partition_,
@@ -592,7 +692,128 @@ void UpdateFirstMutatedSideIndexValue(
 
 }  // namespace
 
+void Geometry::MarkVertexForDerivativeUpdate(MutableMeshView::IndexType index) {
+  if (index >= vertex_needs_derivative_update_.size()) {
+    vertex_needs_derivative_update_.resize(index + 1, false);
+  }
+  if (vertex_needs_derivative_update_[index]) return;
+  vertex_needs_derivative_update_[index] = true;
+  vertices_needing_derivative_update_.push_back(index);
+}
+
+void Geometry::MarkTriangleForDerivativeUpdate(
+    const std::array<MutableMeshView::IndexType, 3>& indices) {
+  for (MutableMeshView::IndexType index : indices) {
+    MarkVertexForDerivativeUpdate(index);
+  }
+}
+
+void Geometry::ClearVerticesNeedingDerivativeUpdate() {
+  for (MutableMeshView::IndexType index : vertices_needing_derivative_update_) {
+    vertex_needs_derivative_update_[index] = false;
+  }
+  vertices_needing_derivative_update_.clear();
+}
+
+void Geometry::MarkNewTriangleForDerivativeUpdate(
+    uint32_t triangle,
+    const std::array<MutableMeshView::IndexType, 3>& indices) {
+  MarkTriangleForDerivativeUpdate(indices);
+  for (MutableMeshView::IndexType index : indices) {
+    first_triangle_lower_bounds_[index] =
+        std::min(first_triangle_lower_bounds_[index], triangle);
+  }
+}
+
+void Geometry::MarkTrianglesForDerivativeUpdate(uint32_t first_triangle) {
+  for (uint32_t i = first_triangle; i < mesh_.TriangleCount(); ++i) {
+    MarkTriangleForDerivativeUpdate(mesh_.GetTriangleIndices(i));
+  }
+}
+
+void Geometry::MarkTrianglesWithChangedGeometryForDerivativeUpdate() {
+  if (vertices_with_changed_geometry_.empty()) return;
+
+  uint32_t vertex_count = mesh_.VertexCount();
+  uint32_t first_triangle = mesh_.TriangleCount();
+  vertex_has_changed_geometry_.clear();
+  vertex_has_changed_geometry_.resize(vertex_count, false);
+  for (MutableMeshView::IndexType index : vertices_with_changed_geometry_) {
+    if (index >= vertex_count) continue;
+    vertex_has_changed_geometry_[index] = true;
+    first_triangle =
+        std::min(first_triangle, first_triangle_lower_bounds_[index]);
+    MarkVertexForDerivativeUpdate(index);
+
+    // Moving the vertex can also change which of its neighbors on the same
+    // side are coincident with it.
+    const Side& side = vertex_side_ids_[index] == SideId::kLeft ? left_side_
+                                                                : right_side_;
+    uint32_t offset = side_offsets_[index];
+    if (offset >= side.indices.size() || side.indices[offset] != index) {
+      continue;
+    }
+    if (offset > 0) MarkVertexForDerivativeUpdate(side.indices[offset - 1]);
+    if (offset + 1 < side.indices.size()) {
+      MarkVertexForDerivativeUpdate(side.indices[offset + 1]);
+    }
+  }
+  vertices_with_changed_geometry_.clear();
+
+  for (uint32_t i = first_triangle; i < mesh_.TriangleCount(); ++i) {
+    std::array<MutableMeshView::IndexType, 3> indices =
+        mesh_.GetTriangleIndices(i);
+    if (vertex_has_changed_geometry_[indices[0]] ||
+        vertex_has_changed_geometry_[indices[1]] ||
+        vertex_has_changed_geometry_[indices[2]]) {
+      MarkTriangleForDerivativeUpdate(indices);
+    }
+  }
+}
+
+namespace {
+
+// Appends runs of `side_indices` to `index_runs` that cover each of the
+// `sorted_offsets` along with the rest of their coincident vertex ranges.
+void AppendCoincidentIndexRuns(
+    const MutableMeshView& mesh,
+    absl::Span<const MutableMeshView::IndexType> side_indices,
+    absl::Span<const uint32_t> sorted_offsets,
+    std::vector<absl::Span<const MutableMeshView::IndexType>>& index_runs) {
+  uint32_t run_begin = 0;
+  uint32_t run_end = 0;
+  for (uint32_t offset : sorted_offsets) {
+    if (offset < run_end) continue;
+
+    uint32_t begin = StartingOffsetForCoincidentConnectedVertices(
+        mesh, side_indices, offset);
+    uint32_t end = offset + 1;
+    Point position = mesh.GetPosition(side_indices[offset]);
+    while (end < side_indices.size() &&
+           mesh.GetPosition(side_indices[end]) == position) {
+      ++end;
+    }
+
+    if (begin > run_end || run_begin == run_end) {
+      if (run_begin != run_end) {
+        index_runs.push_back(
+            side_indices.subspan(run_begin, run_end - run_begin));
+      }
+      run_begin = begin;
+    }
+    run_end = end;
+  }
+  if (run_begin != run_end) {
+    index_runs.push_back(side_indices.subspan(run_begin, run_end - run_begin));
+  }
+}
+
+}  // namespace
+
 void Geometry::UpdateMeshDerivatives() {
+  MarkTrianglesWithChangedGeometryForDerivativeUpdate();
+  if (vertices_needing_derivative_update_.empty()) return;
+
   absl::Span<const MutableMeshView::IndexType> left_indices_to_update;
   absl::Span<const MutableMeshView::IndexType> right_indices_to_update;
 
@@ -626,6 +847,17 @@ void Geometry::UpdateMeshDerivatives() {
     }
   }
 
+  // The marked vertices are used instead if the range is large, or if it is
+  // empty, since some vertices are known to need an update.
+  size_t vertex_count =
+      left_indices_to_update.size() + right_indices_to_update.size();
+  if (vertex_count == 0 ||
+      vertex_count > max_full_derivative_update_vertex_count_) {
+    UpdateMarkedMeshDerivatives();
+    return;
+  }
+
+  ClearVerticesNeedingDerivativeUpdate();
   if (!left_indices_to_update.empty()) {
     UpdateFirstMutatedSideIndexValue(left_indices_to_update.front(),
                                      first_mutated_left_index_);
@@ -639,6 +871,62 @@ void Geometry::UpdateMeshDerivatives() {
                                     right_indices_to_update, mesh_);
 }
 
+void Geometry::UpdateMarkedMeshDerivatives() {
+  left_offsets_needing_derivative_update_.clear();
+  right_offsets_needing_derivative_update_.clear();
+  for (MutableMeshView::IndexType index : vertices_needing_derivative_update_) {
+    // Skip vertices that have since been removed from the mesh or that belong
+    // to a previous partition.
+    if (index >= mesh_.VertexCount()) continue;
+    bool is_left = vertex_side_ids_[index] == SideId::kLeft;
+    const Side& side = is_left ? left_side_ : right_side_;
+    uint32_t offset = side_offsets_[index];
+    if (offset >= side.indices.size() || side.indices[offset] != index) {
+      continue;
+    }
+    (is_left ? left_offsets_needing_derivative_update_
+             : right_offsets_needing_derivative_update_)
+        .push_back(offset);
+  }
+  ClearVerticesNeedingDerivativeUpdate();
+
+  index_runs_needing_derivative_update_.clear();
+  absl::c_sort(left_offsets_needing_derivative_update_);
+  AppendCoincidentIndexRuns(mesh_, left_side_.indices,
+                            left_offsets_needing_derivative_update_,
+                            index_runs_needing_derivative_update_);
+  size_t left_run_count = index_runs_needing_derivative_update_.size();
+  absl::c_sort(right_offsets_needing_derivative_update_);
+  AppendCoincidentIndexRuns(mesh_, right_side_.indices,
+                            right_offsets_needing_derivative_update_,
+                            index_runs_needing_derivative_update_);
+
+  uint32_t first_triangle = mesh_.TriangleCount();
+  for (absl::Span<const MutableMeshView::IndexType> run :
+       index_runs_needing_derivative_update_) {
+    for (MutableMeshView::IndexType index : run) {
+      first_triangle =
+          std::min(first_triangle, first_triangle_lower_bounds_[index]);
+    }
+  }
+  derivative_calculator_.UpdateMesh(index_runs_needing_derivative_update_,
+                                    first_triangle, mesh_);
+
+  // Only vertices that were given new values count as mutated, since many of
+  // the updated vertices are expected to keep their previous values.
+  for (size_t i = 0; i < index_runs_needing_derivative_update_.size(); ++i) {
+    std::optional<MutableMeshView::IndexType>& first_mutated_index =
+        i < left_run_count ? first_mutated_left_index_
+                           : first_mutated_right_index_;
+    for (MutableMeshView::IndexType index :
+         index_runs_needing_derivative_update_[i]) {
+      if (derivative_calculator_.LastUpdateChangedVertex(index)) {
+        UpdateFirstMutatedSideIndexValue(index, first_mutated_index);
+      }
+    }
+  }
+}
+
 void Geometry::DebugMakeMeshAfterSavePoint(MutableMeshView mesh_out) const {
   ABSL_CHECK(mesh_out.HasMeshData());
   mesh_out.Clear();
@@ -718,9 +1006,12 @@ void ClearSide(Side& side) {
 void Geometry::Reset(const MutableMeshView& mesh) {
   mesh_ = mesh;
   mesh_.Clear();
+  ClearVerticesNeedingDerivativeUpdate();
+  vertices_with_changed_geometry_.clear();
   vertex_side_ids_.clear();
   side_offsets_.clear();
   opposite_side_offsets_.clear();
+  first_triangle_lower_bounds_.clear();
   // We do this instead of just typing e.g. `left_side_ = {};` to re-use the
   // capacity allocated in `Side::indices`.
   ClearSide(left_side_);
@@ -843,9 +1134,11 @@ const Side& Geometry::OpposingSide(const Side& side) const {
 
 void Geometry::AppendVertexToMesh(Side& side, const ExtrudedVertex& vertex) {
   MutableMeshView::IndexType new_index = mesh_.VertexCount();
+  MarkVertexForDerivativeUpdate(new_index);
   mesh_.AppendVertex(vertex);
   vertex_side_ids_.push_back(side.self_id);
   side_offsets_.push_back(side.indices.size());
+  first_triangle_lower_bounds_.push_back(mesh_.TriangleCount());
   side.indices.push_back(new_index);
 
   Side& opposite_side = OpposingSide(side);
@@ -866,6 +1159,8 @@ void Geometry::TryAppendVertexAndTriangleToMesh(Side& side,
   MutableMeshView::IndexType last_left = left_side_.indices.back();
   MutableMeshView::IndexType last_right = right_side_.indices.back();
   AppendVertexToMesh(side, vertex);
+  MarkNewTriangleForDerivativeUpdate(
+      mesh_.TriangleCount(), {last_left, last_right, side.indices.back()});
   mesh_.AppendTriangleIndices({last_left, last_right, side.indices.back()});
 }
 
@@ -1278,7 +1573,7 @@ bool Geometry::TryBeginIntersectionRetriangulation(
     // insert a new triangle after this loop.
     if (save_point_state_.is_active &&
         i - 1 < save_point_state_.n_mesh_triangles) {
-      save_point_state_.saved_triangle_indices.emplace(i - 1, mesh_indices);
+      JournalTriangleIndices(i - 1, mesh_indices, save_point_state_);
     }
 
     if (i <= intersecting_side.intersection->undo_stack_starting_triangle) {
@@ -1312,6 +1607,9 @@ bool Geometry::TryBeginIntersectionRetriangulation(
   // which we append a new triangle.
 
   // Before:
+  MarkNewTriangleForDerivativeUpdate(
+      intersection_vertex_triangle,
+      {saved_left, saved_right, *(intersection_start_index + 1)});
   mesh_.InsertTriangleIndices(
       intersection_vertex_triangle,
       {saved_left, saved_right, *(intersection_start_index + 1)});
@@ -1331,6 +1629,8 @@ bool Geometry::TryBeginIntersectionRetriangulation(
     // pushed back to the adjacent side with subsequent extrusions as this part
     // of the line is overwritten by the outgoing triangles.
     intersection_indices[2] = *intersection_start_index;
+    MarkNewTriangleForDerivativeUpdate(mesh_.TriangleCount(),
+                                       intersection_indices);
     mesh_.AppendTriangleIndices(intersection_indices);
 
     // We add to the `outline_reposition_budget` since we are about to
@@ -2395,6 +2695,9 @@ void Geometry::TriangleBuilder::TryAppend(Side& new_vertex_side) {
     MutableMeshView::IndexType last_right =
         geometry_->right_side_.indices.back();
     geometry_->AppendVertexToMesh(new_vertex_side, next_vertex);
+    geometry_->MarkNewTriangleForDerivativeUpdate(
+        geometry_->mesh_.TriangleCount(),
+        {last_left, last_right, new_vertex_side.indices.back()});
     geometry_->mesh_.AppendTriangleIndices(
         {last_left, last_right, new_vertex_side.indices.back()});
     return;
@@ -3005,7 +3308,7 @@ void Geometry::SetVertex(MutableMeshView::IndexType index,
                          bool update_envelope_of_removed_geometry) {
   if (update_save_state && save_point_state_.is_active &&
       index < save_point_state_.n_mesh_vertices) {
-    save_point_state_.saved_vertices.emplace(index, mesh_.GetVertex(index));
+    JournalVertex(index, mesh_.GetVertex(index), save_point_state_);
   }
 
   if (update_envelope_of_removed_geometry) {
@@ -3018,6 +3321,27 @@ void Geometry::SetVertex(MutableMeshView::IndexType index,
     UpdateFirstMutatedSideIndexValue(index, first_mutated_right_index_);
   }
 
+  ExtrudedVertex old_vertex = mesh_.GetVertex(index);
+  const StrokeVertex::NonPositionAttributes& old_attributes =
+      old_vertex.new_non_position_attributes;
+  const StrokeVertex::NonPositionAttributes& new_attributes =
+      new_vertex.new_non_position_attributes;
+  if (new_vertex.position != old_vertex.position ||
+      new_attributes.side_label.DecodeSideCategory() !=
+          old_attributes.side_label.DecodeSideCategory() ||
+      new_attributes.forward_label.DecodeForwardCategory() !=
+          old_attributes.forward_label.DecodeForwardCategory()) {
+    vertices_with_changed_geometry_.push_back(index);
+  } else if (new_attributes.side_label != old_attributes.side_label ||
+             new_attributes.forward_label != old_attributes.forward_label ||
+             new_attributes.side_derivative != old_attributes.side_derivative ||
+             new_attributes.forward_derivative !=
+                 old_attributes.forward_derivative) {
+    // Only the values calculated by `UpdateMeshDerivatives()` are being
+    // overwritten, so they need to be calculated again.
+    MarkVertexForDerivativeUpdate(index);
+  }
+
   mesh_.SetVertex(index, new_vertex);
 }
 
@@ -3027,10 +3351,13 @@ void Geometry::SetTriangleIndices(
     bool update_save_state) {
   if (update_save_state && save_point_state_.is_active &&
       triangle_index < save_point_state_.n_mesh_triangles) {
-    save_point_state_.saved_triangle_indices.emplace(
-        triangle_index, mesh_.GetTriangleIndices(triangle_index));
+    JournalTriangleIndices(triangle_index,
+                           mesh_.GetTriangleIndices(triangle_index),
+                           save_point_state_);
   }
 
+  MarkTriangleForDerivativeUpdate(mesh_.GetTriangleIndices(triangle_index));
+  MarkNewTriangleForDerivativeUpdate(triangle_index, new_indices);
   mesh_.SetTriangleIndices(triangle_index, new_indices);
 }
 
@@ -3041,8 +3368,7 @@ void Geometry::UpdateOppositeSideOffset(MutableMeshView::IndexType index,
   if (current_offset == new_offset) return;
   if (update_save_state && save_point_state_.is_active &&
       index < save_point_state_.n_mesh_vertices) {
-    save_point_state_.saved_opposite_side_offsets.emplace(index,
-                                                          current_offset);
+    JournalOppositeSideOffset(index, current_offset, save_point_state_);
   }
   current_offset = new_offset;
 }
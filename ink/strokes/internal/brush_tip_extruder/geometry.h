@@ -19,12 +19,11 @@
 #include <cstddef>
 #include <cstdint>
 #include <optional>
+#include <utility>
 #include <vector>
 
 #include "absl/base/attributes.h"
 #include "absl/base/nullability.h"
-#include "absl/container/btree_map.h"
-#include "absl/container/flat_hash_map.h"
 #include "absl/types/span.h"
 #include "ink/geometry/envelope.h"
 #include "ink/geometry/point.h"
@@ -110,23 +109,29 @@ struct GeometrySavePointState {
   std::vector<SideId> saved_vertex_side_ids;
   std::vector<uint32_t> saved_side_offsets;
 
-  // A record of any vertices, triangle indices, and opposite side offsets that
-  // existed prior to setting the save point and have been modified since.
+  // Journals of the original values of any vertices, triangle indices, and
+  // opposite side offsets that existed prior to setting the save point and have
+  // been modified since.
   //
-  // We expect a small number will need to be saved, but without expected order,
-  // so we use maps for simpler bookkeeping during extrusion instead of trying
-  // to store a sub-vectors for faster revert.
-  //
-  // We use `btree_map` rather than `flat_hash_map` for `saved_vertices` and
-  // `saved_triangle_indices`, because when restoring a save point, we need to
-  // be able to re-add removed vertices/triangles in order.
-  absl::btree_map<MutableMeshView::IndexType, ExtrudedVertex> saved_vertices;
-  absl::btree_map<MutableMeshView::IndexType,
-                  std::array<MutableMeshView::IndexType, 3>>
+  // Each index is recorded at most once per save point. Appending to and
+  // replaying these takes constant time per mutation and reuses allocations
+  // across save points, unlike a map. Entries are in no particular order.
+  std::vector<std::pair<MutableMeshView::IndexType, ExtrudedVertex>>
+      saved_vertices;
+  std::vector<std::pair<uint32_t, std::array<MutableMeshView::IndexType, 3>>>
       saved_triangle_indices;
-  absl::flat_hash_map<MutableMeshView::IndexType, uint32_t>
+  std::vector<std::pair<MutableMeshView::IndexType, uint32_t>>
       saved_opposite_side_offsets;
 
+  // Identifies the current save point in the `*_save_ids` below, which hold the
+  // value of `save_id` when the vertex, triangle, or opposite side offset at
+  // that index was last journaled. This lets us skip already journaled indices
+  // without clearing any per-index state when setting a new save point.
+  uint32_t save_id = 0;
+  std::vector<uint32_t> vertex_save_ids;
+  std::vector<uint32_t> triangle_save_ids;
+  std::vector<uint32_t> opposite_side_offset_save_ids;
+
   GeometryLastExtrusionBreakMetadata saved_last_extrusion_break;
 
   SideState left_side_state;
@@ -263,14 +268,24 @@ class Geometry {
 
   // Updates the derivative attribute properties inside the current mesh.
   //
-  // Derivative values will be updated for vertices based on the current value
-  // of `FirstVisuallyMutatedTriangle()`. A vertex will be updated if it is part
-  // of the visually affected triangulation or if it coincides with a different
-  // vertex that is. For efficiency, this function should be called only once in
-  // between resetting mutation tracking, because calling it will generally
-  // decrease the value returned by `FirstVisuallyMutatedTriangle()`.
+  // By default, derivative values are recalculated for every vertex on each
+  // side starting from the first exterior vertex of the first visually mutated
+  // triangle. When that range is large, derivative values are instead updated
+  // only for vertices whose derivatives may have changed since the last call
+  // to `ResetMutationTracking()`. In that case a vertex will be updated if it
+  // is new, if a triangle that includes it was added, removed, or modified, or
+  // if it coincides with a different vertex that is updated. For efficiency,
+  // this function should be called only once in between resetting mutation
+  // tracking, because calling it will generally decrease the value returned by
+  // `FirstVisuallyMutatedTriangle()`.
   void UpdateMeshDerivatives();
 
+  // For testing only: Sets the largest number of side vertices that
+  // `UpdateMeshDerivatives()` will recalculate by default, after which it only
+  // updates the vertices whose derivatives may have changed. Passing 0 always
+  // selects the latter.
+  void DebugSetMaxFullDerivativeUpdateVertexCount(uint32_t count);
+
   // TODO: b/294561921 - Add an API to start or find a "connected" partition.
   // This would be used to build strokes that exceeds the 16-bit index limit
   // into multiple `MutableMesh` instead of relying on renderers to do the
@@ -617,6 +632,39 @@ class Geometry {
       const std::array<MutableMeshView::IndexType, 3>& new_indices,
       bool update_save_state = true);
 
+  // Records that the derivatives of the vertex at `index` need to be updated by
+  // the next call to `UpdateMeshDerivatives()`.
+  void MarkVertexForDerivativeUpdate(MutableMeshView::IndexType index);
+
+  // Records that the derivatives of each vertex of a triangle with `indices`
+  // need to be updated by the next call to `UpdateMeshDerivatives()`, because
+  // the triangle was added to, removed from, or modified in `mesh_`.
+  void MarkTriangleForDerivativeUpdate(
+      const std::array<MutableMeshView::IndexType, 3>& indices);
+
+  // Like `MarkTriangleForDerivativeUpdate()`, but for `indices` that are about
+  // to be assigned to the triangle at `triangle`. This also updates
+  // `first_triangle_lower_bounds_`.
+  void MarkNewTriangleForDerivativeUpdate(
+      uint32_t triangle,
+      const std::array<MutableMeshView::IndexType, 3>& indices);
+
+  // Updates derivatives for only the vertices marked by the functions above.
+  // Used by `UpdateMeshDerivatives()` when its default range is too large.
+  void UpdateMarkedMeshDerivatives();
+
+  // Empties `vertices_needing_derivative_update_`.
+  void ClearVerticesNeedingDerivativeUpdate();
+
+  // Marks the vertices of each triangle in `mesh_` starting at
+  // `first_triangle` for derivative update. This should be called before the
+  // triangles are truncated.
+  void MarkTrianglesForDerivativeUpdate(uint32_t first_triangle);
+
+  // Marks every vertex of each triangle that includes one of
+  // `vertices_with_changed_geometry_` for derivative update.
+  void MarkTrianglesWithChangedGeometryForDerivativeUpdate();
+
   // Sets a new value for an existing index's `opposite_side_offset_`. If
   // `update_save_state` is true and a save point is set, the function will save
   // the current value as needed.
@@ -712,6 +760,34 @@ class Geometry {
   uint32_t first_mutated_right_index_offset_in_current_partition_ = 0;
 
   DerivativeCalculator derivative_calculator_;
+  // The largest number of side vertices that `UpdateMeshDerivatives()` will
+  // recalculate starting from the first visually mutated triangle. Beyond this,
+  // only the vertices marked as needing an update are recalculated.
+  uint32_t max_full_derivative_update_vertex_count_ = 256;
+
+  // Vertices whose derivatives must be recalculated by the next call to
+  // `UpdateMeshDerivatives()`, because they are new or a triangle that includes
+  // them was added, removed, or modified since the last call to
+  // `ResetMutationTracking()`. This may contain indices of vertices that have
+  // since been removed. `vertex_needs_derivative_update_` is true for exactly
+  // the indices in the list, and is used to avoid adding duplicates.
+  std::vector<MutableMeshView::IndexType> vertices_needing_derivative_update_;
+  std::vector<bool> vertex_needs_derivative_update_;
+  // Vertices whose position or label categories have changed since the last
+  // call to `ResetMutationTracking()`. This changes the derivatives of every
+  // vertex that shares a triangle with them.
+  std::vector<MutableMeshView::IndexType> vertices_with_changed_geometry_;
+  // For each vertex, a lower bound on the index of the first triangle in
+  // `mesh_` that includes it. This is used to limit the triangles visited when
+  // updating derivatives, since triangles that include a vertex are not always
+  // near the end of the mesh, e.g. at the pivot of a triangle fan.
+  std::vector<uint32_t> first_triangle_lower_bounds_;
+  // Scratch storage used by `UpdateMeshDerivatives()` to reuse allocations.
+  std::vector<bool> vertex_has_changed_geometry_;
+  std::vector<uint32_t> left_offsets_needing_derivative_update_;
+  std::vector<uint32_t> right_offsets_needing_derivative_update_;
+  std::vector<absl::Span<const MutableMeshView::IndexType>>
+      index_runs_needing_derivative_update_;
 };
 
 // --------------------------------------------------------------------------
@@ -723,6 +799,11 @@ inline void Geometry::SetTextureCoordType(TextureCoordType type) {
 
 inline const MutableMeshView& Geometry::GetMeshView() const { return mesh_; }
 
+inline void Geometry::DebugSetMaxFullDerivativeUpdateVertexCount(
+    uint32_t count) {
+  max_full_derivative_update_vertex_count_ = count;
+}
+
 inline const Side& Geometry::LeftSide() const { return left_side_; }
 
 inline const Side& Geometry::RightSide() const { return right_side_; }
@@ -12,7 +12,10 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstddef>
 #include <cstdint>
+#include <iterator>
+#include <utility>
 #include <vector>
 
 #include "gmock/gmock.h"
@@ -23,8 +26,10 @@
 #include "ink/geometry/rect.h"
 #include "ink/geometry/type_matchers.h"
 #include "ink/geometry/vec.h"
+#include "ink/strokes/internal/brush_tip_extruder/derivative_calculator.h"
 #include "ink/strokes/internal/brush_tip_extruder/geometry.h"
 #include "ink/strokes/internal/brush_tip_extruder/mutable_mesh_view.h"
+#include "ink/strokes/internal/brush_tip_extruder/side.h"
 #include "ink/strokes/internal/brush_tip_state.h"
 #include "ink/types/small_array.h"
 
@@ -34,7 +39,9 @@ namespace {
 using ::ink::strokes_internal::BrushTipState;
 using ::ink::strokes_internal::StrokeVertex;
 using ::testing::Each;
+using ::testing::Eq;
 using ::testing::Not;
+using ::testing::Pointwise;
 
 Vec ToVec(const SmallArray<float, 4>& attribute) {
   ABSL_CHECK_EQ(attribute.Size(), 2);
@@ -61,6 +68,35 @@ class GeometryMeshDerivativesTest : public ::testing::Test {
         StrokeVertex::kFullFormatAttributeIndices.side_derivative);
   }
 
+  std::vector<Vec> GetForwardDerivatives() const {
+    return GetDerivativeValues(
+        StrokeVertex::kFullFormatAttributeIndices.forward_derivative);
+  }
+
+  // Expects that the derivative attributes of every vertex in the current
+  // partition match the result of recalculating them for the whole partition.
+  void ExpectDerivativesMatchFullRecalculation() {
+    MutableMesh expected_mesh = mesh_.Clone();
+    MutableMeshView expected_view(expected_mesh);
+    DerivativeCalculator().UpdateMesh(geometry_.LeftSide().indices,
+                                      geometry_.RightSide().indices,
+                                      expected_view);
+
+    for (const Side* side : {&geometry_.LeftSide(), &geometry_.RightSide()}) {
+      for (uint32_t index : side->indices) {
+        EXPECT_THAT(geometry_.GetMeshView().GetSideDerivative(index),
+                    VecNear(expected_view.GetSideDerivative(index), 1e-5))
+            << "at vertex " << index;
+        EXPECT_THAT(geometry_.GetMeshView().GetForwardDerivative(index),
+                    VecNear(expected_view.GetForwardDerivative(index), 1e-5))
+            << "at vertex " << index;
+        EXPECT_EQ(geometry_.GetMeshView().GetSideLabel(index),
+                  expected_view.GetSideLabel(index))
+            << "at vertex " << index;
+      }
+    }
+  }
+
   MutableMesh mesh_;
   Geometry geometry_;
 };
@@ -103,6 +139,74 @@ TEST_F(GeometryMeshDerivativesTest, ContiguousExtrusions) {
               EnvelopeEq(Rect::FromTwoPoints({0, 1}, {3, 6})));
 }
 
+TEST_F(GeometryMeshDerivativesTest, IncrementalUpdatesMatchFullRecalculation) {
+  // Left and right positions of a scribble that turns sharply and changes
+  // width, so that intersection handling re-indexes earlier triangles. The
+  // vertices of those triangles can need new derivatives even though they come
+  // before the first visually mutated triangle.
+  std::pair<Point, Point> left_and_right_positions[] = {
+      {{0.29, 2.36}, {0.96, -2.17}}, {{-1.57, 1.70}, {3.32, -0.32}},
+      {{-0.42, 1.92}, {2.60, 1.12}}, {{-0.44, 2.03}, {2.47, 2.36}},
+      {{-1.68, 2.76}, {3.76, 2.36}}, {{1.80, 3.89}, {2.19, 1.56}},
+      {{2.96, 5.07}, {2.07, 0.19}},  {{1.77, 4.26}, {4.10, 1.79}},
+      {{0.89, 5.01}, {5.50, 1.78}},  {{1.89, 3.03}, {4.37, 4.06}},
+      {{3.28, 4.41}, {4.01, 3.59}},  {{3.50, 7.01}, {5.39, 1.54}},
+      {{2.07, 5.54}, {6.99, 3.44}},  {{2.62, 4.14}, {5.18, 6.33}},
+      {{3.13, 3.55}, {3.02, 6.86}},
+  };
+  // The default update path is known to leave some of these stale, so only
+  // update the vertices marked as needing it.
+  geometry_.DebugSetMaxFullDerivativeUpdateVertexCount(0);
+  for (size_t i = 0; i < std::size(left_and_right_positions); ++i) {
+    geometry_.ResetMutationTracking();
+    geometry_.AppendLeftVertex(left_and_right_positions[i].first);
+    geometry_.AppendRightVertex(left_and_right_positions[i].second);
+    geometry_.ProcessNewVertices(0, BrushTipState{});
+    geometry_.UpdateMeshDerivatives();
+
+    SCOPED_TRACE(testing::Message() << "after extrusion " << i);
+    ExpectDerivativesMatchFullRecalculation();
+    if (HasFailure()) return;
+  }
+}
+
+TEST_F(GeometryMeshDerivativesTest, RepeatedExtrusionUpdatesMinimalRegion) {
+  geometry_.DebugSetMaxFullDerivativeUpdateVertexCount(0);
+  for (int i = 0; i < 3; ++i) {
+    geometry_.AppendLeftVertex(Point{0, static_cast<float>(i)});
+    geometry_.AppendRightVertex(Point{1, static_cast<float>(i)});
+  }
+  geometry_.ProcessNewVertices(0, BrushTipState{});
+  geometry_.UpdateMeshDerivatives();
+  geometry_.ResetMutationTracking();
+  geometry_.SetSavePoint();
+  geometry_.AppendLeftVertex(Point{0, 3});
+  geometry_.AppendRightVertex(Point{1, 3});
+  geometry_.ProcessNewVertices(0, BrushTipState{});
+  geometry_.UpdateMeshDerivatives();
+  std::vector<Vec> side_derivatives = GetSideDerivatives();
+  std::vector<Vec> forward_derivatives = GetForwardDerivatives();
+
+  // Revert and repeat the last extrusion. The derivatives of the vertices
+  // before the save point are recalculated, because their triangles were
+  // removed and added again, but they keep the same values.
+  geometry_.ResetMutationTracking();
+  geometry_.RevertToSavePoint();
+  geometry_.AppendLeftVertex(Point{0, 3});
+  geometry_.AppendRightVertex(Point{1, 3});
+  geometry_.ProcessNewVertices(0, BrushTipState{});
+  geometry_.UpdateMeshDerivatives();
+
+  EXPECT_THAT(GetSideDerivatives(), Pointwise(Eq(), side_derivatives));
+  EXPECT_THAT(GetForwardDerivatives(), Pointwise(Eq(), forward_derivatives));
+  ExpectDerivativesMatchFullRecalculation();
+
+  // Since no derivatives changed, the visually updated region should only
+  // cover the triangles that were replaced.
+  EXPECT_THAT(geometry_.CalculateVisuallyUpdatedRegion(),
+              EnvelopeEq(Rect::FromTwoPoints({0, 2}, {1, 3})));
+}
+
 TEST_F(GeometryMeshDerivativesTest, WithExtrusionBreak) {
   geometry_.AppendLeftVertex(Point{0, 0});
   geometry_.AppendLeftVertex(Point{0, 1});
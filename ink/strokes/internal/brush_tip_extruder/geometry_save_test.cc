@@ -355,6 +355,39 @@ TEST_F(GeometrySaveTest, ContinueIntersection) {
   EXPECT_THAT(g1.RightSide(), SideEq(g2.RightSide()));
 }
 
+TEST_F(GeometrySaveTest, RepeatedSaveAndRevertWithIntersection) {
+  // Same extrusion as `ContinueIntersection`, but the volatile extrusion is
+  // reverted and re-extruded repeatedly, so that the same vertices and
+  // triangles are modified after each save point.
+
+  MeshData m1, m2;
+  Geometry g1(MakeView(m1)), g2(MakeView(m2));
+  Extrude({&g1, &g2}, {
+                          {.left = {{-1, 0}, {-1, 1}, {-1, 2}},
+                           .right = {{1, 0}, {1, 1}, {1, 2}}},
+                          {.left = {{-0.5, 1.5}}, .right = {{0.5, 2.5}}},
+                          {.left = {{0, 1.5}}, .right = {{0, 2.5}}},
+                      });
+
+  for (int i = 0; i < 3; ++i) {
+    g1.SetSavePoint();
+    Extrude(&g1,
+            {
+                {.left = {{0, 0.5}}, .right = {{-1, 2.5}, {-2, 1}, {-2, 0.5}}},
+            });
+    g1.RevertToSavePoint();
+    EXPECT_THAT(m1, VerticesAndIndicesEq(m2));
+    EXPECT_THAT(g1.LeftSide(), SideEq(g2.LeftSide()));
+    EXPECT_THAT(g1.RightSide(), SideEq(g2.RightSide()));
+  }
+
+  // Extruding a fixed state after reverting continues to match.
+  Extrude({&g1, &g2}, {
+                          {.left = {{0, 1}}, .right = {{-0.5, 2.5}}},
+                      });
+  EXPECT_THAT(m1, VerticesAndIndicesEq(m2));
+}
+
 TEST_F(GeometrySaveTest, EndIntersection) {
   // Extrusion travels up and then sharply to the left. Intersection is ongoing
   // prior to the save point and is finished prior to reverting.
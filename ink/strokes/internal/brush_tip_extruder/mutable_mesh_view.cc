@@ -28,6 +28,7 @@
 #include "ink/geometry/triangle.h"
 #include "ink/geometry/vec.h"
 #include "ink/strokes/internal/brush_tip_extruder/extruded_vertex.h"
+#include "ink/strokes/internal/brush_tip_extruder/typed_mesh.h"
 #include "ink/strokes/internal/legacy_vertex.h"
 #include "ink/strokes/internal/stroke_vertex.h"
 
@@ -48,8 +49,14 @@ MutableMeshView::MutableMeshView(
   ResetMutationTracking();
 }
 
+MutableMeshView::MutableMeshView(TypedMesh& mesh) : data_(&mesh) {
+  ResetMutationTracking();
+}
+
 void MutableMeshView::Clear() {
-  if (LegacyVectors* legacy = std::get_if<LegacyVectors>(&data_)) {
+  if (TypedMesh** typed_mesh = std::get_if<TypedMesh*>(&data_)) {
+    (*typed_mesh)->Clear();
+  } else if (LegacyVectors* legacy = std::get_if<LegacyVectors>(&data_)) {
     legacy->vertices->clear();
     legacy->indices->clear();
   } else if (MutableMesh** mutable_mesh = std::get_if<MutableMesh*>(&data_)) {
@@ -59,6 +66,9 @@ void MutableMeshView::Clear() {
 
 uint32_t MutableMeshView::VertexCount() const {
   ABSL_CHECK(HasMeshData());
+  if (const auto* typed_mesh = std::get_if<TypedMesh*>(&data_)) {
+    return (*typed_mesh)->VertexCount();
+  }
   if (const auto* legacy = std::get_if<LegacyVectors>(&data_)) {
     ABSL_DCHECK_LE(legacy->vertices->size(),
                    std::numeric_limits<uint32_t>::max());
@@ -69,6 +79,9 @@ uint32_t MutableMeshView::VertexCount() const {
 
 uint32_t MutableMeshView::TriangleCount() const {
   ABSL_CHECK(HasMeshData());
+  if (const auto* typed_mesh = std::get_if<TypedMesh*>(&data_)) {
+    return (*typed_mesh)->TriangleCount();
+  }
   if (const auto* legacy = std::get_if<LegacyVectors>(&data_)) {
     ABSL_DCHECK_EQ(legacy->indices->size() % 3, 0);
     ABSL_DCHECK_LE(legacy->indices->size() / 3,
@@ -80,6 +93,9 @@ uint32_t MutableMeshView::TriangleCount() const {
 
 Point MutableMeshView::GetPosition(uint32_t index) const {
   ABSL_CHECK_LT(index, VertexCount());
+  if (const auto* typed_mesh = std::get_if<TypedMesh*>(&data_)) {
+    return (*typed_mesh)->GetPosition(index);
+  }
   if (const auto* legacy = std::get_if<LegacyVectors>(&data_)) {
     return (*legacy->vertices)[index].position;
   }
@@ -88,6 +104,11 @@ Point MutableMeshView::GetPosition(uint32_t index) const {
 
 ExtrudedVertex MutableMeshView::GetVertex(uint32_t index) const {
   ABSL_CHECK_LT(index, VertexCount());
+  if (const auto* typed_mesh = std::get_if<TypedMesh*>(&data_)) {
+    return {.position = (*typed_mesh)->GetPosition(index),
+            .new_non_position_attributes =
+                (*typed_mesh)->GetNonPositionAttributes(index)};
+  }
   if (const auto* legacy = std::get_if<LegacyVectors>(&data_)) {
     return ExtrudedVertex::FromLegacy((*legacy->vertices)[index]);
   }
@@ -101,6 +122,9 @@ ExtrudedVertex MutableMeshView::GetVertex(uint32_t index) const {
 Vec MutableMeshView::GetSideDerivative(uint32_t index) const {
   ABSL_CHECK_LT(index, VertexCount());
 
+  if (const auto* typed_mesh = std::get_if<TypedMesh*>(&data_)) {
+    return (*typed_mesh)->GetNonPositionAttributes(index).side_derivative;
+  }
   if (const MutableMesh* const* mesh = std::get_if<MutableMesh*>(&data_)) {
     return StrokeVertex::GetSideDerivativeFromMesh(**mesh, index);
   }
@@ -110,6 +134,9 @@ Vec MutableMeshView::GetSideDerivative(uint32_t index) const {
 Vec MutableMeshView::GetForwardDerivative(uint32_t index) const {
   ABSL_CHECK_LT(index, VertexCount());
 
+  if (const auto* typed_mesh = std::get_if<TypedMesh*>(&data_)) {
+    return (*typed_mesh)->GetNonPositionAttributes(index).forward_derivative;
+  }
   if (const MutableMesh* const* mesh = std::get_if<MutableMesh*>(&data_)) {
     return StrokeVertex::GetForwardDerivativeFromMesh(**mesh, index);
   }
@@ -119,6 +146,9 @@ Vec MutableMeshView::GetForwardDerivative(uint32_t index) const {
 StrokeVertex::Label MutableMeshView::GetSideLabel(uint32_t index) const {
   ABSL_CHECK_LT(index, VertexCount());
 
+  if (const auto* typed_mesh = std::get_if<TypedMesh*>(&data_)) {
+    return (*typed_mesh)->GetNonPositionAttributes(index).side_label;
+  }
   if (const MutableMesh* const* mesh = std::get_if<MutableMesh*>(&data_)) {
     return StrokeVertex::GetSideLabelFromMesh(**mesh, index);
   }
@@ -128,6 +158,9 @@ StrokeVertex::Label MutableMeshView::GetSideLabel(uint32_t index) const {
 StrokeVertex::Label MutableMeshView::GetForwardLabel(uint32_t index) const {
   ABSL_CHECK_LT(index, VertexCount());
 
+  if (const auto* typed_mesh = std::get_if<TypedMesh*>(&data_)) {
+    return (*typed_mesh)->GetNonPositionAttributes(index).forward_label;
+  }
   if (const MutableMesh* const* mesh = std::get_if<MutableMesh*>(&data_)) {
     return StrokeVertex::GetForwardLabelFromMesh(**mesh, index);
   }
@@ -136,7 +169,7 @@ StrokeVertex::Label MutableMeshView::GetForwardLabel(uint32_t index) const {
 
 Triangle MutableMeshView::GetTriangle(uint32_t triangle) const {
   ABSL_CHECK_LT(triangle, TriangleCount());
-  if (const auto* legacy = std::get_if<LegacyVectors>(&data_)) {
+  if (!std::holds_alternative<MutableMesh*>(data_)) {
     std::array<uint32_t, 3> indices = GetTriangleIndices(triangle);
     return {.p0 = GetPosition(indices[0]),
             .p1 = GetPosition(indices[1]),
@@ -149,6 +182,9 @@ Triangle MutableMeshView::GetTriangle(uint32_t triangle) const {
 std::array<uint32_t, 3> MutableMeshView::GetTriangleIndices(
     uint32_t triangle) const {
   ABSL_CHECK_LT(triangle, TriangleCount());
+  if (const auto* typed_mesh = std::get_if<TypedMesh*>(&data_)) {
+    return (*typed_mesh)->GetTriangleIndices(triangle);
+  }
   if (const auto* legacy = std::get_if<LegacyVectors>(&data_)) {
     uint32_t* index_data = legacy->indices->data() + 3 * triangle;
     return {index_data[0], index_data[1], index_data[2]};
@@ -161,6 +197,9 @@ uint32_t MutableMeshView::GetVertexIndex(uint32_t triangle,
                                          uint32_t triangle_vertex) const {
   ABSL_CHECK_LT(triangle, TriangleCount());
   ABSL_CHECK_LT(triangle_vertex, 3u);
+  if (const auto* typed_mesh = std::get_if<TypedMesh*>(&data_)) {
+    return (*typed_mesh)->GetTriangleIndices(triangle)[triangle_vertex];
+  }
   if (const auto* legacy = std::get_if<LegacyVectors>(&data_)) {
     return (*legacy->indices)[3 * triangle + triangle_vertex];
   }
@@ -171,7 +210,10 @@ uint32_t MutableMeshView::GetVertexIndex(uint32_t triangle,
 
 void MutableMeshView::AppendVertex(const ExtrudedVertex& vertex) {
   ABSL_CHECK(HasMeshData());
-  if (const auto* legacy = std::get_if<LegacyVectors>(&data_)) {
+  if (auto* typed_mesh = std::get_if<TypedMesh*>(&data_)) {
+    (*typed_mesh)->AppendVertex(vertex.position,
+                                vertex.new_non_position_attributes);
+  } else if (const auto* legacy = std::get_if<LegacyVectors>(&data_)) {
     legacy->vertices->push_back(vertex.ToLegacy());
   } else {
     StrokeVertex::AppendToMesh(
@@ -184,7 +226,9 @@ void MutableMeshView::AppendVertex(const ExtrudedVertex& vertex) {
 void MutableMeshView::AppendTriangleIndices(
     const std::array<uint32_t, 3>& indices) {
   ABSL_CHECK(HasMeshData());
-  if (const auto* legacy = std::get_if<LegacyVectors>(&data_)) {
+  if (auto* typed_mesh = std::get_if<TypedMesh*>(&data_)) {
+    (*typed_mesh)->AppendTriangleIndices(indices);
+  } else if (const auto* legacy = std::get_if<LegacyVectors>(&data_)) {
     legacy->indices->insert(legacy->indices->end(),
                             {indices[0], indices[1], indices[2]});
   } else {
@@ -194,7 +238,11 @@ void MutableMeshView::AppendTriangleIndices(
 
 void MutableMeshView::SetVertex(uint32_t index, const ExtrudedVertex& vertex) {
   ABSL_CHECK_LT(index, VertexCount());
-  if (const auto* legacy = std::get_if<LegacyVectors>(&data_)) {
+  if (auto* typed_mesh = std::get_if<TypedMesh*>(&data_)) {
+    (*typed_mesh)->SetPosition(index, vertex.position);
+    (*typed_mesh)->SetNonPositionAttributes(index,
+                                            vertex.new_non_position_attributes);
+  } else if (const auto* legacy = std::get_if<LegacyVectors>(&data_)) {
     (*legacy->vertices)[index] = vertex.ToLegacy();
   } else {
     StrokeVertex::SetInMesh(
@@ -209,8 +257,13 @@ void MutableMeshView::SetSideDerivative(uint32_t index, Vec derivative) {
   ABSL_CHECK_LT(index, VertexCount());
   if (std::holds_alternative<LegacyVectors>(data_)) return;
 
-  StrokeVertex::SetSideDerivativeInMesh(*std::get<MutableMesh*>(data_), index,
-                                        derivative);
+  if (auto* typed_mesh = std::get_if<TypedMesh*>(&data_)) {
+    (*typed_mesh)->MutableNonPositionAttributes(index).side_derivative =
+        derivative;
+  } else {
+    StrokeVertex::SetSideDerivativeInMesh(*std::get<MutableMesh*>(data_), index,
+                                          derivative);
+  }
   first_mutated_vertex_ = std::min(first_mutated_vertex_, index);
 }
 
@@ -218,8 +271,13 @@ void MutableMeshView::SetForwardDerivative(uint32_t index, Vec derivative) {
   ABSL_CHECK_LT(index, VertexCount());
   if (std::holds_alternative<LegacyVectors>(data_)) return;
 
-  StrokeVertex::SetForwardDerivativeInMesh(*std::get<MutableMesh*>(data_),
-                                           index, derivative);
+  if (auto* typed_mesh = std::get_if<TypedMesh*>(&data_)) {
+    (*typed_mesh)->MutableNonPositionAttributes(index).forward_derivative =
+        derivative;
+  } else {
+    StrokeVertex::SetForwardDerivativeInMesh(*std::get<MutableMesh*>(data_),
+                                             index, derivative);
+  }
   first_mutated_vertex_ = std::min(first_mutated_vertex_, index);
 }
 
@@ -228,8 +286,12 @@ void MutableMeshView::SetSideLabel(
   ABSL_CHECK_LT(index, VertexCount());
   if (std::holds_alternative<LegacyVectors>(data_)) return;
 
-  StrokeVertex::SetSideLabelInMesh(*std::get<MutableMesh*>(data_), index,
-                                   label);
+  if (auto* typed_mesh = std::get_if<TypedMesh*>(&data_)) {
+    (*typed_mesh)->MutableNonPositionAttributes(index).side_label = label;
+  } else {
+    StrokeVertex::SetSideLabelInMesh(*std::get<MutableMesh*>(data_), index,
+                                     label);
+  }
   first_mutated_vertex_ = std::min(first_mutated_vertex_, index);
 }
 
@@ -238,15 +300,21 @@ void MutableMeshView::SetForwardLabel(
   ABSL_CHECK_LT(index, VertexCount());
   if (std::holds_alternative<LegacyVectors>(data_)) return;
 
-  StrokeVertex::SetForwardLabelInMesh(*std::get<MutableMesh*>(data_), index,
-                                      label);
+  if (auto* typed_mesh = std::get_if<TypedMesh*>(&data_)) {
+    (*typed_mesh)->MutableNonPositionAttributes(index).forward_label = label;
+  } else {
+    StrokeVertex::SetForwardLabelInMesh(*std::get<MutableMesh*>(data_), index,
+                                        label);
+  }
   first_mutated_vertex_ = std::min(first_mutated_vertex_, index);
 }
 
 void MutableMeshView::SetTriangleIndices(
     uint32_t triangle, const std::array<uint32_t, 3>& indices) {
   ABSL_CHECK_LT(triangle, TriangleCount());
-  if (const auto* legacy = std::get_if<LegacyVectors>(&data_)) {
+  if (auto* typed_mesh = std::get_if<TypedMesh*>(&data_)) {
+    (*typed_mesh)->SetTriangleIndices(triangle, indices);
+  } else if (const auto* legacy = std::get_if<LegacyVectors>(&data_)) {
     uint32_t* index_data = legacy->indices->data() + 3 * triangle;
     index_data[0] = indices[0];
     index_data[1] = indices[1];
@@ -260,7 +328,9 @@ void MutableMeshView::SetTriangleIndices(
 void MutableMeshView::InsertTriangleIndices(
     uint32_t triangle, const std::array<uint32_t, 3>& indices) {
   ABSL_CHECK_LE(triangle, TriangleCount());
-  if (const auto* legacy = std::get_if<LegacyVectors>(&data_)) {
+  if (auto* typed_mesh = std::get_if<TypedMesh*>(&data_)) {
+    (*typed_mesh)->InsertTriangleIndices(triangle, indices);
+  } else if (const auto* legacy = std::get_if<LegacyVectors>(&data_)) {
     auto iter = legacy->indices->begin() + 3 * triangle;
     legacy->indices->insert(iter, {indices[0], indices[1], indices[2]});
   } else {
@@ -272,7 +342,9 @@ void MutableMeshView::InsertTriangleIndices(
 
 void MutableMeshView::TruncateTriangles(uint32_t new_triangle_count) {
   if (new_triangle_count >= TriangleCount()) return;
-  if (const auto* legacy = std::get_if<LegacyVectors>(&data_)) {
+  if (auto* typed_mesh = std::get_if<TypedMesh*>(&data_)) {
+    (*typed_mesh)->TruncateTriangles(new_triangle_count);
+  } else if (const auto* legacy = std::get_if<LegacyVectors>(&data_)) {
     legacy->indices->resize(3 * new_triangle_count);
   } else {
     MutableMesh* mesh = std::get<MutableMesh*>(data_);
@@ -284,7 +356,9 @@ void MutableMeshView::TruncateTriangles(uint32_t new_triangle_count) {
 
 void MutableMeshView::TruncateVertices(uint32_t new_vertex_count) {
   if (new_vertex_count >= VertexCount()) return;
-  if (const auto* legacy = std::get_if<LegacyVectors>(&data_)) {
+  if (auto* typed_mesh = std::get_if<TypedMesh*>(&data_)) {
+    (*typed_mesh)->TruncateVertices(new_vertex_count);
+  } else if (const auto* legacy = std::get_if<LegacyVectors>(&data_)) {
     legacy->vertices->resize(new_vertex_count);
   } else {
     MutableMesh* mesh = std::get<MutableMesh*>(data_);
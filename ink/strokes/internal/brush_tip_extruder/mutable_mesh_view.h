@@ -25,6 +25,7 @@
 #include "ink/geometry/triangle.h"
 #include "ink/geometry/vec.h"
 #include "ink/strokes/internal/brush_tip_extruder/extruded_vertex.h"
+#include "ink/strokes/internal/brush_tip_extruder/typed_mesh.h"
 #include "ink/strokes/internal/legacy_vertex.h"
 #include "ink/strokes/internal/stroke_vertex.h"
 
@@ -79,6 +80,10 @@ class MutableMeshView {
   MutableMeshView(std::vector<strokes_internal::LegacyVertex>& vertices,
                   std::vector<IndexType>& indices);
 
+  // Constructs a view with a reference to a `TypedMesh`, which must outlive
+  // this object.
+  explicit MutableMeshView(TypedMesh& mesh);
+
   MutableMeshView(const MutableMeshView&) = default;
   MutableMeshView& operator=(const MutableMeshView&) = default;
 
@@ -183,7 +188,7 @@ class MutableMeshView {
     std::vector<IndexType>* indices;
   };
 
-  std::variant<std::monostate, LegacyVectors, MutableMesh*> data_;
+  std::variant<std::monostate, LegacyVectors, MutableMesh*, TypedMesh*> data_;
   IndexType first_mutated_triangle_ = 0;
   IndexType first_mutated_vertex_ = 0;
 };
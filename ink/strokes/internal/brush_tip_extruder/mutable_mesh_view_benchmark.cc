@@ -24,11 +24,14 @@
 #include "ink/geometry/mutable_mesh.h"
 #include "ink/strokes/internal/brush_tip_extruder/extruded_vertex.h"
 #include "ink/strokes/internal/brush_tip_extruder/mutable_mesh_view.h"
+#include "ink/strokes/internal/brush_tip_extruder/typed_mesh.h"
+#include "ink/strokes/internal/stroke_vertex.h"
 
 namespace ink::brush_tip_extruder_internal {
 namespace {
 
 using ::benchmark::internal::Benchmark;
+using ::ink::strokes_internal::StrokeVertex;
 
 void BM_GetVerticesAndTriangles(benchmark::State& state) {
   state.SetLabel(absl::StrFormat("mesh: %s", kTestMeshFiles[state.range(0)]));
@@ -89,5 +92,54 @@ void BM_CreateMeshIncrementally(benchmark::State& state) {
 }
 BENCHMARK(BM_CreateMeshIncrementally)->DenseRange(0, kTestMeshFiles.size() - 1);
 
+constexpr int kAttributeBenchmarkVertexCount = 1024;
+
+// Writes the derivatives and labels of every vertex a few times, similar to how
+// the extruder repeatedly updates recent vertices.
+void SetAttributesRepeatedly(MutableMeshView& mesh_view) {
+  constexpr int kWritesPerVertex = 4;
+  for (int j = 0; j < kWritesPerVertex; ++j) {
+    for (uint32_t i = 0; i < mesh_view.VertexCount(); ++i) {
+      mesh_view.SetSideDerivative(i, {static_cast<float>(j), 1});
+      mesh_view.SetForwardDerivative(i, {1, static_cast<float>(j)});
+      mesh_view.SetSideLabel(i, StrokeVertex::kExteriorLeftLabel);
+      mesh_view.SetForwardLabel(i, StrokeVertex::kExteriorFrontLabel);
+    }
+  }
+}
+
+void BM_SetAttributesInMutableMesh(benchmark::State& state) {
+  MutableMesh mutable_mesh(StrokeVertex::FullMeshFormat());
+  MutableMeshView mesh_view(mutable_mesh);
+  for (int i = 0; i < kAttributeBenchmarkVertexCount; ++i) {
+    mesh_view.AppendVertex({.position = {static_cast<float>(i), 0}});
+  }
+
+  for (auto s : state) {
+    SetAttributesRepeatedly(mesh_view);
+    benchmark::DoNotOptimize(mutable_mesh.RawVertexData().data());
+  }
+}
+BENCHMARK(BM_SetAttributesInMutableMesh);
+
+// Same as above, but writes to a `TypedMesh` and then copies the changes to the
+// `MutableMesh`, as done by the extruder at the end of every update.
+void BM_SetAttributesInTypedMesh(benchmark::State& state) {
+  MutableMesh mutable_mesh(StrokeVertex::FullMeshFormat());
+  TypedMesh typed_mesh;
+  MutableMeshView mesh_view(typed_mesh);
+  for (int i = 0; i < kAttributeBenchmarkVertexCount; ++i) {
+    mesh_view.AppendVertex({.position = {static_cast<float>(i), 0}});
+  }
+  typed_mesh.CopyChangesToMesh(mutable_mesh);
+
+  for (auto s : state) {
+    SetAttributesRepeatedly(mesh_view);
+    typed_mesh.CopyChangesToMesh(mutable_mesh);
+    benchmark::DoNotOptimize(mutable_mesh.RawVertexData().data());
+  }
+}
+BENCHMARK(BM_SetAttributesInTypedMesh);
+
 }  // namespace
 }  // namespace ink::brush_tip_extruder_internal
@@ -22,6 +22,7 @@
 #include "ink/geometry/mutable_mesh.h"
 #include "ink/geometry/type_matchers.h"
 #include "ink/strokes/internal/brush_tip_extruder/extruded_vertex.h"
+#include "ink/strokes/internal/brush_tip_extruder/typed_mesh.h"
 #include "ink/strokes/internal/legacy_vertex.h"
 #include "ink/strokes/internal/stroke_vertex.h"
 
@@ -667,6 +668,87 @@ TEST(MutableMeshViewTest, MutationTrackingWithNewMesh) {
   EXPECT_EQ(mesh_view.FirstMutatedTriangle(), mesh_view.TriangleCount());
 }
 
+TEST(MutableMeshViewTest, GetAndSetVertexAndTrianglesWithTypedMesh) {
+  TypedMesh mesh;
+  MutableMeshView mesh_view(mesh);
+  ASSERT_TRUE(mesh_view.HasMeshData());
+
+  mesh_view.AppendVertex({.position = {0, 0}});
+  mesh_view.AppendVertex({.position = {1, 0}});
+  ExtrudedVertex appended_vertex = {
+      .position = {1, 2},
+      .new_non_position_attributes = {
+          .opacity_shift = 0.5,
+          .hsl_shift = {0.1, -0.3, 0.8},
+          .side_derivative = {3, 4},
+          .side_label = StrokeVertex::kExteriorLeftLabel,
+          .forward_derivative = {6, 7},
+          .forward_label = StrokeVertex::kExteriorBackLabel}};
+  mesh_view.AppendVertex(appended_vertex);
+  mesh_view.AppendTriangleIndices({0, 1, 2});
+  mesh_view.AppendTriangleIndices({2, 1, 0});
+  EXPECT_EQ(mesh_view.VertexCount(), 3);
+  EXPECT_EQ(mesh_view.TriangleCount(), 2);
+
+  EXPECT_THAT(mesh_view.GetPosition(2), PointEq(appended_vertex.position));
+  EXPECT_EQ(mesh_view.GetVertex(2), appended_vertex);
+  EXPECT_THAT(mesh_view.GetSideDerivative(2), VecEq({3, 4}));
+  EXPECT_THAT(mesh_view.GetForwardDerivative(2), VecEq({6, 7}));
+  EXPECT_EQ(mesh_view.GetSideLabel(2), StrokeVertex::kExteriorLeftLabel);
+  EXPECT_EQ(mesh_view.GetForwardLabel(2), StrokeVertex::kExteriorBackLabel);
+  EXPECT_THAT(mesh_view.GetTriangle(1),
+              TriangleEq({.p0 = {1, 2}, .p1 = {1, 0}, .p2 = {0, 0}}));
+  EXPECT_THAT(mesh_view.GetTriangleIndices(1), ElementsAre(2, 1, 0));
+  EXPECT_EQ(mesh_view.GetVertexIndex(1, 0), 2);
+
+  mesh_view.SetVertex(0, appended_vertex);
+  mesh_view.SetSideDerivative(1, {3, 5});
+  mesh_view.SetForwardDerivative(1, {2, 7});
+  mesh_view.SetSideLabel(1, StrokeVertex::kExteriorRightLabel);
+  mesh_view.SetForwardLabel(1, StrokeVertex::kExteriorFrontLabel);
+  mesh_view.SetTriangleIndices(0, {1, 2, 0});
+  mesh_view.InsertTriangleIndices(0, {0, 2, 1});
+
+  EXPECT_EQ(mesh_view.GetVertex(0), appended_vertex);
+  EXPECT_THAT(mesh_view.GetSideDerivative(1), VecEq({3, 5}));
+  EXPECT_THAT(mesh_view.GetForwardDerivative(1), VecEq({2, 7}));
+  EXPECT_EQ(mesh_view.GetSideLabel(1), StrokeVertex::kExteriorRightLabel);
+  EXPECT_EQ(mesh_view.GetForwardLabel(1), StrokeVertex::kExteriorFrontLabel);
+  EXPECT_THAT(mesh.GetTriangleIndices(0), ElementsAre(0, 2, 1));
+  EXPECT_THAT(mesh.GetTriangleIndices(1), ElementsAre(1, 2, 0));
+  EXPECT_THAT(mesh.GetTriangleIndices(2), ElementsAre(2, 1, 0));
+
+  mesh_view.TruncateTriangles(1);
+  mesh_view.TruncateVertices(2);
+  EXPECT_EQ(mesh.VertexCount(), 2);
+  EXPECT_EQ(mesh.TriangleCount(), 1);
+
+  mesh_view.Clear();
+  EXPECT_EQ(mesh.VertexCount(), 0);
+  EXPECT_EQ(mesh.TriangleCount(), 0);
+}
+
+TEST(MutableMeshViewTest, MutationTrackingWithTypedMesh) {
+  TypedMesh mesh;
+  MutableMeshView mesh_view(mesh);
+  for (int i = 0; i < 5; ++i) mesh_view.AppendVertex({});
+  for (int i = 0; i < 4; ++i) mesh_view.AppendTriangleIndices({});
+
+  mesh_view.ResetMutationTracking();
+  EXPECT_EQ(mesh_view.FirstMutatedVertex(), 5);
+  EXPECT_EQ(mesh_view.FirstMutatedTriangle(), 4);
+
+  mesh_view.SetSideLabel(3, StrokeVertex::kExteriorLeftLabel);
+  mesh_view.SetTriangleIndices(2, {});
+  EXPECT_EQ(mesh_view.FirstMutatedVertex(), 3);
+  EXPECT_EQ(mesh_view.FirstMutatedTriangle(), 2);
+
+  mesh_view.SetForwardDerivative(1, {3, 5});
+  mesh_view.InsertTriangleIndices(1, {});
+  EXPECT_EQ(mesh_view.FirstMutatedVertex(), 1);
+  EXPECT_EQ(mesh_view.FirstMutatedTriangle(), 1);
+}
+
 TEST(MutableMeshViewDeathTest, ConstructedWithIncompatibleMutableMeshFormat) {
   MutableMesh mesh;
   EXPECT_DEATH_IF_SUPPORTED(MutableMeshView mesh_view(mesh), "");
@@ -0,0 +1,116 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ink/strokes/internal/brush_tip_extruder/typed_mesh.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "absl/log/absl_check.h"
+#include "absl/types/span.h"
+#include "ink/geometry/mesh_format.h"
+#include "ink/geometry/mutable_mesh.h"
+#include "ink/geometry/point.h"
+#include "ink/strokes/internal/stroke_vertex.h"
+
+namespace ink::brush_tip_extruder_internal {
+namespace {
+
+using ::ink::strokes_internal::StrokeVertex;
+
+// Returns `attributes` with the opacity and HSL shifts clamped the same way as
+// when they are written to a `MutableMesh` by `StrokeVertex`.
+StrokeVertex::NonPositionAttributes ClampShifts(
+    StrokeVertex::NonPositionAttributes attributes) {
+  attributes.opacity_shift = std::clamp(attributes.opacity_shift, -1.f, 1.f);
+  for (float& shift : attributes.hsl_shift) {
+    shift = std::clamp(shift, -1.f, 1.f);
+  }
+  return attributes;
+}
+
+}  // namespace
+
+void TypedMesh::Clear() {
+  positions_.clear();
+  non_position_attributes_.clear();
+  triangle_indices_.clear();
+  first_vertex_to_copy_ = 0;
+  first_triangle_to_copy_ = 0;
+}
+
+void TypedMesh::AppendVertex(
+    Point position, const StrokeVertex::NonPositionAttributes& attributes) {
+  positions_.push_back(position);
+  non_position_attributes_.push_back(ClampShifts(attributes));
+}
+
+void TypedMesh::SetNonPositionAttributes(
+    IndexType index, const StrokeVertex::NonPositionAttributes& attributes) {
+  MutableNonPositionAttributes(index) = ClampShifts(attributes);
+}
+
+void TypedMesh::InsertTriangleIndices(IndexType triangle,
+                                      const std::array<IndexType, 3>& indices) {
+  ABSL_DCHECK_LE(triangle, TriangleCount());
+  triangle_indices_.insert(triangle_indices_.begin() + triangle, indices);
+  first_triangle_to_copy_ = std::min(first_triangle_to_copy_, triangle);
+}
+
+void TypedMesh::TruncateTriangles(uint32_t new_triangle_count) {
+  if (new_triangle_count >= TriangleCount()) return;
+  triangle_indices_.resize(new_triangle_count);
+  first_triangle_to_copy_ =
+      std::min(first_triangle_to_copy_, new_triangle_count);
+}
+
+void TypedMesh::TruncateVertices(uint32_t new_vertex_count) {
+  if (new_vertex_count >= VertexCount()) return;
+  positions_.resize(new_vertex_count);
+  non_position_attributes_.resize(new_vertex_count);
+  first_vertex_to_copy_ = std::min(first_vertex_to_copy_, new_vertex_count);
+}
+
+void TypedMesh::CopyChangesToMesh(MutableMesh& mesh) {
+  ABSL_DCHECK(MeshFormat::IsUnpackedEquivalent(mesh.Format(),
+                                               StrokeVertex::FullMeshFormat()));
+  // Appended vertices and triangles are not tracked by the "to copy" members,
+  // so also copy everything past the current end of `mesh`.
+  uint32_t first_vertex = std::min(first_vertex_to_copy_, mesh.VertexCount());
+  uint32_t first_triangle =
+      std::min(first_triangle_to_copy_, mesh.TriangleCount());
+  mesh.Resize(VertexCount(), TriangleCount());
+
+  // The unpacked layout of the full stroke format matches `StrokeVertex`, the
+  // same as assumed by `StrokeVertex::GetFromMesh()`.
+  absl::Span<std::byte> vertex_data = mesh.MutableRawVertexData();
+  for (uint32_t i = first_vertex; i < VertexCount(); ++i) {
+    StrokeVertex vertex = {.position = positions_[i],
+                           .non_position_attributes =
+                               non_position_attributes_[i]};
+    std::memcpy(&vertex_data[i * sizeof(StrokeVertex)], &vertex,
+                sizeof(StrokeVertex));
+  }
+  for (uint32_t i = first_triangle; i < TriangleCount(); ++i) {
+    mesh.SetTriangleIndices(i, triangle_indices_[i]);
+  }
+
+  first_vertex_to_copy_ = VertexCount();
+  first_triangle_to_copy_ = TriangleCount();
+}
+
+}  // namespace ink::brush_tip_extruder_internal
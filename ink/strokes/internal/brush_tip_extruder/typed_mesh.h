@@ -0,0 +1,168 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INK_STROKES_INTERNAL_BRUSH_TIP_EXTRUDER_TYPED_MESH_H_
+#define INK_STROKES_INTERNAL_BRUSH_TIP_EXTRUDER_TYPED_MESH_H_
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "ink/geometry/mutable_mesh.h"
+#include "ink/geometry/point.h"
+#include "ink/strokes/internal/stroke_vertex.h"
+
+namespace ink::brush_tip_extruder_internal {
+
+// An indexed triangle mesh of `StrokeVertex` values stored in typed arrays.
+//
+// The extruder repeatedly rewrites the attributes of recently added vertices
+// while it builds a stroke. Writing each of these to a `MutableMesh` goes
+// through its type-erased byte storage, looking up the attribute's offset in
+// the `MeshFormat` every time. This type instead keeps the values in plain
+// structs, and keeps track of the first vertex and triangle that changed since
+// they were last copied to a `MutableMesh` by `CopyChangesToMesh()`.
+//
+// The `opacity_shift` and `hsl_shift` attributes are clamped to [-1, 1] when
+// stored, to match the values that would be read back from a `MutableMesh`
+// after `StrokeVertex::AppendToMesh()` or `StrokeVertex::SetInMesh()`.
+class TypedMesh {
+ public:
+  using IndexType = uint32_t;
+
+  TypedMesh() = default;
+  TypedMesh(const TypedMesh&) = delete;
+  TypedMesh& operator=(const TypedMesh&) = delete;
+  TypedMesh(TypedMesh&&) = default;
+  TypedMesh& operator=(TypedMesh&&) = default;
+  ~TypedMesh() = default;
+
+  // Removes all vertices and triangles.
+  void Clear();
+
+  uint32_t VertexCount() const;
+  uint32_t TriangleCount() const;
+
+  // The following return the values stored for the vertex or triangle at the
+  // given index. The index is only checked in debug builds.
+  Point GetPosition(IndexType index) const;
+  const strokes_internal::StrokeVertex::NonPositionAttributes&
+  GetNonPositionAttributes(IndexType index) const;
+  const std::array<IndexType, 3>& GetTriangleIndices(IndexType triangle) const;
+
+  void AppendVertex(
+      Point position,
+      const strokes_internal::StrokeVertex::NonPositionAttributes& attributes);
+  void AppendTriangleIndices(const std::array<IndexType, 3>& indices);
+
+  void SetPosition(IndexType index, Point position);
+  void SetNonPositionAttributes(
+      IndexType index,
+      const strokes_internal::StrokeVertex::NonPositionAttributes& attributes);
+
+  // Returns a mutable reference to the attributes of the vertex at `index`,
+  // which is marked as changed. This should be used to set attributes other
+  // than `opacity_shift` and `hsl_shift`, which are expected to be clamped.
+  //
+  // The reference is invalidated by appending or truncating vertices.
+  strokes_internal::StrokeVertex::NonPositionAttributes&
+  MutableNonPositionAttributes(IndexType index);
+
+  void SetTriangleIndices(IndexType triangle,
+                          const std::array<IndexType, 3>& indices);
+  void InsertTriangleIndices(IndexType triangle,
+                             const std::array<IndexType, 3>& indices);
+
+  // Removes triangles/vertices from the mesh, if the new count is smaller than
+  // the old. If the new count is greater than or equal to the old, these have
+  // no effect.
+  void TruncateTriangles(uint32_t new_triangle_count);
+  void TruncateVertices(uint32_t new_vertex_count);
+
+  // Updates `mesh` to be equal to this mesh, assuming that it was equal after
+  // the last call to this function, or that it is empty if this function has
+  // not been called since construction or `Clear()`.
+  //
+  // Only vertices and triangles that were added or changed since the last call
+  // are written to `mesh`, which must have a format whose unpacked
+  // representation is equivalent to that of `StrokeVertex::FullMeshFormat()`.
+  void CopyChangesToMesh(MutableMesh& mesh);
+
+ private:
+  std::vector<Point> positions_;
+  std::vector<strokes_internal::StrokeVertex::NonPositionAttributes>
+      non_position_attributes_;
+  std::vector<std::array<IndexType, 3>> triangle_indices_;
+  // The first vertex and triangle that have been changed or added since the
+  // last call to `CopyChangesToMesh()`.
+  IndexType first_vertex_to_copy_ = 0;
+  IndexType first_triangle_to_copy_ = 0;
+};
+
+// ---------------------------------------------------------------------------
+//                     Implementation details below
+
+inline uint32_t TypedMesh::VertexCount() const { return positions_.size(); }
+
+inline uint32_t TypedMesh::TriangleCount() const {
+  return triangle_indices_.size();
+}
+
+inline Point TypedMesh::GetPosition(IndexType index) const {
+  ABSL_DCHECK_LT(index, VertexCount());
+  return positions_[index];
+}
+
+inline const strokes_internal::StrokeVertex::NonPositionAttributes&
+TypedMesh::GetNonPositionAttributes(IndexType index) const {
+  ABSL_DCHECK_LT(index, VertexCount());
+  return non_position_attributes_[index];
+}
+
+inline const std::array<TypedMesh::IndexType, 3>& TypedMesh::GetTriangleIndices(
+    IndexType triangle) const {
+  ABSL_DCHECK_LT(triangle, TriangleCount());
+  return triangle_indices_[triangle];
+}
+
+inline void TypedMesh::AppendTriangleIndices(
+    const std::array<IndexType, 3>& indices) {
+  triangle_indices_.push_back(indices);
+}
+
+inline void TypedMesh::SetPosition(IndexType index, Point position) {
+  ABSL_DCHECK_LT(index, VertexCount());
+  positions_[index] = position;
+  first_vertex_to_copy_ = std::min(first_vertex_to_copy_, index);
+}
+
+inline strokes_internal::StrokeVertex::NonPositionAttributes&
+TypedMesh::MutableNonPositionAttributes(IndexType index) {
+  ABSL_DCHECK_LT(index, VertexCount());
+  first_vertex_to_copy_ = std::min(first_vertex_to_copy_, index);
+  return non_position_attributes_[index];
+}
+
+inline void TypedMesh::SetTriangleIndices(
+    IndexType triangle, const std::array<IndexType, 3>& indices) {
+  ABSL_DCHECK_LT(triangle, TriangleCount());
+  triangle_indices_[triangle] = indices;
+  first_triangle_to_copy_ = std::min(first_triangle_to_copy_, triangle);
+}
+
+}  // namespace ink::brush_tip_extruder_internal
+
+#endif  // INK_STROKES_INTERNAL_BRUSH_TIP_EXTRUDER_TYPED_MESH_H_
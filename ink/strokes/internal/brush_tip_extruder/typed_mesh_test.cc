@@ -0,0 +1,177 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ink/strokes/internal/brush_tip_extruder/typed_mesh.h"
+
+#include <array>
+#include <cstdint>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "ink/geometry/mutable_mesh.h"
+#include "ink/geometry/point.h"
+#include "ink/geometry/type_matchers.h"
+#include "ink/strokes/internal/stroke_vertex.h"
+
+namespace ink::brush_tip_extruder_internal {
+namespace {
+
+using ::ink::strokes_internal::StrokeVertex;
+
+// Expects `mesh` to have the same vertices and triangles as `typed_mesh`.
+void ExpectMeshesAreEqual(const TypedMesh& typed_mesh,
+                          const MutableMesh& mesh) {
+  ASSERT_EQ(mesh.VertexCount(), typed_mesh.VertexCount());
+  ASSERT_EQ(mesh.TriangleCount(), typed_mesh.TriangleCount());
+  for (uint32_t i = 0; i < mesh.VertexCount(); ++i) {
+    StrokeVertex vertex = StrokeVertex::GetFromMesh(mesh, i);
+    EXPECT_THAT(vertex.position, PointEq(typed_mesh.GetPosition(i)))
+        << "vertex " << i;
+    EXPECT_EQ(vertex.non_position_attributes,
+              typed_mesh.GetNonPositionAttributes(i))
+        << "vertex " << i;
+  }
+  for (uint32_t i = 0; i < mesh.TriangleCount(); ++i) {
+    EXPECT_EQ(mesh.TriangleIndices(i), typed_mesh.GetTriangleIndices(i))
+        << "triangle " << i;
+  }
+}
+
+// Appends a strip of `2 * n` vertices and `2 * (n - 1)` triangles.
+void AppendStrip(TypedMesh& mesh, uint32_t n) {
+  uint32_t first = mesh.VertexCount();
+  for (uint32_t i = 0; i < n; ++i) {
+    mesh.AppendVertex({static_cast<float>(i), 0},
+                      {.side_label = StrokeVertex::kExteriorLeftLabel});
+    mesh.AppendVertex({static_cast<float>(i), 1},
+                      {.side_label = StrokeVertex::kExteriorRightLabel});
+  }
+  for (uint32_t i = 0; i + 1 < n; ++i) {
+    uint32_t v = first + 2 * i;
+    mesh.AppendTriangleIndices({v, v + 2, v + 1});
+    mesh.AppendTriangleIndices({v + 1, v + 2, v + 3});
+  }
+}
+
+TEST(TypedMeshTest, DefaultConstructedIsEmpty) {
+  TypedMesh mesh;
+  EXPECT_EQ(mesh.VertexCount(), 0);
+  EXPECT_EQ(mesh.TriangleCount(), 0);
+}
+
+TEST(TypedMeshTest, AppendAndGet) {
+  TypedMesh mesh;
+  StrokeVertex::NonPositionAttributes attributes = {
+      .opacity_shift = 0.5,
+      .hsl_shift = {0.1, -0.3, 0.8},
+      .side_derivative = {3, 4},
+      .side_label = StrokeVertex::kExteriorLeftLabel,
+      .forward_derivative = {6, 7},
+      .forward_label = StrokeVertex::kExteriorBackLabel,
+      .surface_uv = {0.25, 0.75},
+      .animation_offset = 0.5};
+  mesh.AppendVertex({1, 2}, attributes);
+  mesh.AppendVertex({3, 4}, {});
+  mesh.AppendVertex({5, 6}, {});
+  mesh.AppendTriangleIndices({0, 1, 2});
+
+  EXPECT_EQ(mesh.VertexCount(), 3);
+  EXPECT_EQ(mesh.TriangleCount(), 1);
+  EXPECT_THAT(mesh.GetPosition(0), PointEq({1, 2}));
+  EXPECT_EQ(mesh.GetNonPositionAttributes(0), attributes);
+  EXPECT_THAT(mesh.GetPosition(2), PointEq({5, 6}));
+  EXPECT_EQ(mesh.GetTriangleIndices(0), (std::array<uint32_t, 3>{0, 1, 2}));
+}
+
+TEST(TypedMeshTest, ClampsOpacityAndHslShifts) {
+  TypedMesh mesh;
+  mesh.AppendVertex({0, 0},
+                    {.opacity_shift = 2, .hsl_shift = {-1.5, 0.5, 1.5}});
+  EXPECT_EQ(mesh.GetNonPositionAttributes(0).opacity_shift, 1);
+  EXPECT_EQ(mesh.GetNonPositionAttributes(0).hsl_shift,
+            (std::array<float, 3>{-1, 0.5, 1}));
+
+  mesh.SetNonPositionAttributes(0, {.opacity_shift = -3});
+  EXPECT_EQ(mesh.GetNonPositionAttributes(0).opacity_shift, -1);
+}
+
+TEST(TypedMeshTest, CopyChangesToEmptyMesh) {
+  TypedMesh typed_mesh;
+  AppendStrip(typed_mesh, 4);
+
+  MutableMesh mesh(StrokeVertex::FullMeshFormat());
+  typed_mesh.CopyChangesToMesh(mesh);
+  ExpectMeshesAreEqual(typed_mesh, mesh);
+}
+
+TEST(TypedMeshTest, CopyChangesMatchesWritingToMutableMesh) {
+  StrokeVertex::NonPositionAttributes attributes = {
+      .opacity_shift = 2,
+      .hsl_shift = {-1.5, 0.5, 1.5},
+      .side_derivative = {3, 4},
+      .forward_label = StrokeVertex::kExteriorFrontLabel};
+
+  TypedMesh typed_mesh;
+  typed_mesh.AppendVertex({1, 2}, attributes);
+  MutableMesh copied_mesh(StrokeVertex::FullMeshFormat());
+  typed_mesh.CopyChangesToMesh(copied_mesh);
+
+  MutableMesh written_mesh(StrokeVertex::FullMeshFormat());
+  StrokeVertex::AppendToMesh(written_mesh, {.position = {1, 2},
+                                            .non_position_attributes =
+                                                attributes});
+
+  EXPECT_TRUE(copied_mesh.RawVertexData() == written_mesh.RawVertexData());
+}
+
+TEST(TypedMeshTest, CopyChangesAfterMutations) {
+  TypedMesh typed_mesh;
+  AppendStrip(typed_mesh, 4);
+  MutableMesh mesh(StrokeVertex::FullMeshFormat());
+  typed_mesh.CopyChangesToMesh(mesh);
+
+  typed_mesh.SetPosition(1, {-1, -1});
+  typed_mesh.MutableNonPositionAttributes(5).side_derivative = {2, 3};
+  typed_mesh.SetTriangleIndices(2, {0, 1, 2});
+  typed_mesh.InsertTriangleIndices(1, {3, 4, 5});
+  AppendStrip(typed_mesh, 2);
+  typed_mesh.CopyChangesToMesh(mesh);
+  ExpectMeshesAreEqual(typed_mesh, mesh);
+
+  typed_mesh.TruncateTriangles(3);
+  typed_mesh.TruncateVertices(5);
+  typed_mesh.AppendVertex({7, 7}, {});
+  typed_mesh.AppendTriangleIndices({4, 5, 0});
+  typed_mesh.CopyChangesToMesh(mesh);
+  ExpectMeshesAreEqual(typed_mesh, mesh);
+}
+
+TEST(TypedMeshTest, CopyChangesAfterClear) {
+  TypedMesh typed_mesh;
+  AppendStrip(typed_mesh, 4);
+  MutableMesh mesh(StrokeVertex::FullMeshFormat());
+  typed_mesh.CopyChangesToMesh(mesh);
+
+  typed_mesh.Clear();
+  typed_mesh.CopyChangesToMesh(mesh);
+  EXPECT_EQ(mesh.VertexCount(), 0);
+  EXPECT_EQ(mesh.TriangleCount(), 0);
+
+  AppendStrip(typed_mesh, 2);
+  typed_mesh.CopyChangesToMesh(mesh);
+  ExpectMeshesAreEqual(typed_mesh, mesh);
+}
+
+}  // namespace
+}  // namespace ink::brush_tip_extruder_internal
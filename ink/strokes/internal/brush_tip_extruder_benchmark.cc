@@ -0,0 +1,117 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cmath>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "benchmark/benchmark.h"
+#include "ink/geometry/mutable_mesh.h"
+#include "ink/geometry/point.h"
+#include "ink/strokes/internal/brush_tip_extruder.h"
+#include "ink/strokes/internal/brush_tip_state.h"
+#include "ink/strokes/internal/stroke_vertex.h"
+
+namespace ink::strokes_internal {
+namespace {
+
+constexpr float kBrushEpsilon = 0.01;
+constexpr float kPi = 3.14159265358979323846f;
+
+BrushTipState MakeCircularTipState(Point position, float radius) {
+  return {.position = position,
+          .width = 2 * radius,
+          .height = 2 * radius,
+          .corner_rounding = 1};
+}
+
+// Returns tip states for a tight back-and-forth scribble, where each stroke of
+// the scribble is shorter than the tip is wide and so overlaps most of the
+// previous ones. This makes the extruder handle a self-intersection on nearly
+// every turn.
+std::vector<BrushTipState> MakeScribbleTipStates(int count) {
+  std::vector<BrushTipState> tip_states;
+  tip_states.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    // Triangle wave with a period of 16 tip states, slowly advancing in x.
+    float phase = (i % 16) / 16.f;
+    float y = 4 * (phase < 0.5f ? phase : 1 - phase);
+    tip_states.push_back(MakeCircularTipState({0.02f * i, y}, 3));
+  }
+  return tip_states;
+}
+
+// Returns tip states that go around a small circle many times, with the circle
+// being smaller than the tip, so that the stroke stays entirely in its own
+// interior.
+std::vector<BrushTipState> MakeSlowCircleTipStates(int count) {
+  std::vector<BrushTipState> tip_states;
+  tip_states.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    float angle = 2 * kPi * i / 64.f;
+    tip_states.push_back(
+        MakeCircularTipState({std::cos(angle), std::sin(angle)}, 3));
+  }
+  return tip_states;
+}
+
+void ExtrudeIncrementally(benchmark::State& state,
+                          const std::vector<BrushTipState>& tip_states) {
+  MutableMesh mesh(StrokeVertex::FullMeshFormat());
+  BrushTipExtruder extruder;
+  for (auto s : state) {
+    extruder.StartStroke(kBrushEpsilon, /* is_particle_brush = */ false, mesh);
+    for (const BrushTipState& tip_state : tip_states) {
+      extruder.ExtendStroke({tip_state}, {});
+    }
+    benchmark::DoNotOptimize(mesh.TriangleCount());
+  }
+  state.counters["triangles"] = mesh.TriangleCount();
+}
+
+void BM_ExtrudeScribble(benchmark::State& state) {
+  ExtrudeIncrementally(state, MakeScribbleTipStates(state.range(0)));
+}
+BENCHMARK(BM_ExtrudeScribble)->RangeMultiplier(4)->Range(256, 4096);
+
+void BM_ExtrudeSlowCircle(benchmark::State& state) {
+  ExtrudeIncrementally(state, MakeSlowCircleTipStates(state.range(0)));
+}
+BENCHMARK(BM_ExtrudeSlowCircle)->RangeMultiplier(4)->Range(256, 4096);
+
+// Extrudes `fixed_count` tip states of a slow circle one at a time, each
+// followed by `state.range(0)` volatile states that continue along the circle,
+// so that every update reverts and re-extrudes a volatile tail of that length.
+void BM_ExtrudeWithVolatileTail(benchmark::State& state) {
+  constexpr int kFixedCount = 512;
+  int volatile_count = state.range(0);
+  std::vector<BrushTipState> tip_states =
+      MakeSlowCircleTipStates(kFixedCount + volatile_count);
+  MutableMesh mesh(StrokeVertex::FullMeshFormat());
+  BrushTipExtruder extruder;
+  for (auto s : state) {
+    extruder.StartStroke(kBrushEpsilon, /* is_particle_brush = */ false, mesh);
+    for (int i = 0; i < kFixedCount; ++i) {
+      extruder.ExtendStroke(
+          {tip_states[i]},
+          absl::MakeSpan(tip_states).subspan(i + 1, volatile_count));
+    }
+    benchmark::DoNotOptimize(mesh.TriangleCount());
+  }
+  state.counters["triangles"] = mesh.TriangleCount();
+}
+BENCHMARK(BM_ExtrudeWithVolatileTail)->RangeMultiplier(4)->Range(4, 64);
+
+}  // namespace
+}  // namespace ink::strokes_internal
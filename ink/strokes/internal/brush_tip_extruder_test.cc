@@ -17,6 +17,7 @@
 #include <cmath>
 #include <cstdint>
 #include <optional>
+#include <utility>
 #include <vector>
 
 #include "gmock/gmock.h"
@@ -516,6 +517,65 @@ TEST_F(BrushTipExtruderTest, StartSecondStroke) {
   EXPECT_THAT(extruder.GetOutlines()[0].GetIndices(), Not(IsEmpty()));
 }
 
+TEST_F(BrushTipExtruderTest, MoveMidStrokeAndKeepExtruding) {
+  std::vector<BrushTipState> first_states =
+      MakeUniformCircularTipStates({{0, 0}, {1, 0}, {2, 1}}, 1);
+  std::vector<BrushTipState> second_states =
+      MakeUniformCircularTipStates({{3, 2}, {3, 4}, {1, 4}}, 1);
+  std::vector<BrushTipState> third_states =
+      MakeUniformCircularTipStates({{0, 3}, {-1, 1}}, 1);
+
+  // Extrude the same states with an extruder that is never moved, to compare
+  // against.
+  MutableMesh expected_mesh(StrokeVertex::FullMeshFormat());
+  BrushTipExtruder expected_extruder;
+  expected_extruder.StartStroke(kBrushEpsilon,
+                                /* is_particle_brush = */ false, expected_mesh);
+  expected_extruder.ExtendStroke(first_states,
+                                 {MakeCircularTipState({3, 1}, 1)});
+  expected_extruder.ExtendStroke(second_states,
+                                 {MakeCircularTipState({0, 4}, 1)});
+  expected_extruder.ExtendStroke(third_states, {});
+
+  std::optional<BrushTipExtruder> original_extruder;
+  original_extruder.emplace();
+  original_extruder->StartStroke(kBrushEpsilon,
+                                 /* is_particle_brush = */ false, mesh_);
+  original_extruder->ExtendStroke(first_states,
+                                  {MakeCircularTipState({3, 1}, 1)});
+
+  // Move-construct, and destroy the original so that any remaining pointers
+  // into it would dangle.
+  BrushTipExtruder move_constructed_extruder(std::move(*original_extruder));
+  original_extruder.reset();
+  move_constructed_extruder.ExtendStroke(second_states,
+                                         {MakeCircularTipState({0, 4}, 1)});
+
+  BrushTipExtruder move_assigned_extruder;
+  move_assigned_extruder = std::move(move_constructed_extruder);
+  move_assigned_extruder.ExtendStroke(third_states, {});
+
+  ASSERT_EQ(mesh_.VertexCount(), expected_mesh.VertexCount());
+  ASSERT_EQ(mesh_.TriangleCount(), expected_mesh.TriangleCount());
+  for (uint32_t i = 0; i < mesh_.VertexCount(); ++i) {
+    EXPECT_THAT(mesh_.VertexPosition(i),
+                PointEq(expected_mesh.VertexPosition(i)))
+        << "vertex " << i;
+  }
+  for (uint32_t i = 0; i < mesh_.TriangleCount(); ++i) {
+    EXPECT_THAT(mesh_.TriangleIndices(i),
+                ElementsAreArray(expected_mesh.TriangleIndices(i)))
+        << "triangle " << i;
+  }
+  EXPECT_THAT(move_assigned_extruder.GetBounds(),
+              EnvelopeEq(expected_extruder.GetBounds()));
+  ASSERT_EQ(move_assigned_extruder.GetOutlines().size(),
+            expected_extruder.GetOutlines().size());
+  EXPECT_THAT(
+      move_assigned_extruder.GetOutlines()[0].GetIndices(),
+      ElementsAreArray(expected_extruder.GetOutlines()[0].GetIndices()));
+}
+
 TEST_F(BrushTipExtruderTest, WidthAndHeightLessThanEpsilonCreatesBreakPoint) {
   float tip_radius = kBrushEpsilon * 0.4;
 
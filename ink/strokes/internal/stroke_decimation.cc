@@ -0,0 +1,155 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ink/strokes/internal/stroke_decimation.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/substitute.h"
+#include "absl/types/span.h"
+#include "ink/geometry/mesh.h"
+#include "ink/geometry/mesh_format.h"
+#include "ink/geometry/mutable_mesh.h"
+#include "ink/geometry/partitioned_mesh.h"
+#include "ink/geometry/point.h"
+#include "ink/strokes/internal/stroke_vertex.h"
+
+namespace ink::strokes_internal {
+namespace {
+
+// Returns the index along one axis of the grid cell containing `coordinate`,
+// clamped to the range of `int32_t`.
+int32_t CellCoordinate(float coordinate, float cell_size) {
+  // The largest float that is less than 2^31.
+  constexpr float kMaxCellCoordinate = 2147483520.f;
+  return static_cast<int32_t>(std::clamp(std::floor(coordinate / cell_size),
+                                         -kMaxCellCoordinate,
+                                         kMaxCellCoordinate));
+}
+
+// Packs the x- and y-indices of the grid cell containing `p` into a key.
+uint64_t CellKey(Point p, float cell_size) {
+  return (uint64_t{static_cast<uint32_t>(CellCoordinate(p.x, cell_size))}
+          << 32) |
+         static_cast<uint32_t>(CellCoordinate(p.y, cell_size));
+}
+
+// The decimated vertices, triangles and outlines of one render group.
+struct DecimatedGroup {
+  MutableMesh mesh;
+  std::vector<std::vector<uint32_t>> outlines;
+};
+
+DecimatedGroup DecimateGroup(const PartitionedMesh& shape, uint32_t group_index,
+                             float cell_size) {
+  const MeshFormat& format = shape.RenderGroupFormat(group_index);
+  absl::Span<const Mesh> meshes = shape.RenderGroupMeshes(group_index);
+  DecimatedGroup group = {.mesh = MutableMesh(format), .outlines = {}};
+  MutableMesh& decimated_mesh = group.mesh;
+
+  // For each vertex of each mesh, the index of the vertex in `decimated_mesh`
+  // that it was merged into.
+  std::vector<std::vector<uint32_t>> merged_indices(meshes.size());
+  absl::flat_hash_map<uint64_t, uint32_t> cell_vertices;
+  // Triangles are keyed on their sorted indices, so that a triangle and its
+  // mirror image, which cover the same region, count as duplicates.
+  absl::flat_hash_set<std::array<uint32_t, 3>> triangles;
+  for (uint32_t m = 0; m < meshes.size(); ++m) {
+    const Mesh& mesh = meshes[m];
+    merged_indices[m].resize(mesh.VertexCount());
+    for (uint32_t v = 0; v < mesh.VertexCount(); ++v) {
+      Point position = mesh.VertexPosition(v);
+      auto [it, inserted] = cell_vertices.try_emplace(
+          CellKey(position, cell_size), decimated_mesh.VertexCount());
+      merged_indices[m][v] = it->second;
+      if (!inserted) continue;
+      decimated_mesh.AppendVertex(position);
+      for (uint32_t a = 0; a < format.Attributes().size(); ++a) {
+        if (a == format.PositionAttributeIndex()) continue;
+        decimated_mesh.SetFloatVertexAttribute(it->second, a,
+                                               mesh.FloatVertexAttribute(v, a));
+      }
+    }
+
+    for (uint32_t t = 0; t < mesh.TriangleCount(); ++t) {
+      std::array<uint32_t, 3> triangle = mesh.TriangleIndices(t);
+      for (uint32_t& index : triangle) index = merged_indices[m][index];
+      std::array<uint32_t, 3> key = triangle;
+      std::sort(key.begin(), key.end());
+      if (key[0] == key[1] || key[1] == key[2]) continue;
+      if (!triangles.insert(key).second) continue;
+      decimated_mesh.AppendTriangleIndices(triangle);
+    }
+  }
+
+  for (uint32_t o = 0; o < shape.OutlineCount(group_index); ++o) {
+    std::vector<uint32_t> outline;
+    for (VertexIndexPair pair : shape.Outline(group_index, o)) {
+      uint32_t index = merged_indices[pair.mesh_index][pair.vertex_index];
+      if (outline.empty() || outline.back() != index) outline.push_back(index);
+    }
+    // The outline is closed, so its last vertex is adjacent to its first.
+    if (outline.size() > 1 && outline.back() == outline.front()) {
+      outline.pop_back();
+    }
+    if (outline.size() >= 3) group.outlines.push_back(std::move(outline));
+  }
+  return group;
+}
+
+}  // namespace
+
+absl::StatusOr<PartitionedMesh> DecimateShape(const PartitionedMesh& shape,
+                                              float cell_size) {
+  if (!std::isfinite(cell_size) || cell_size <= 0) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "`cell_size` must be a finite and positive value. Received: $0",
+        cell_size));
+  }
+
+  std::vector<DecimatedGroup> decimated_groups;
+  decimated_groups.reserve(shape.RenderGroupCount());
+  for (uint32_t g = 0; g < shape.RenderGroupCount(); ++g) {
+    decimated_groups.push_back(DecimateGroup(shape, g, cell_size));
+  }
+
+  std::vector<std::vector<absl::Span<const uint32_t>>> outline_spans(
+      decimated_groups.size());
+  std::vector<StrokeVertex::CustomPackingArray> packing_arrays;
+  packing_arrays.reserve(decimated_groups.size());
+  std::vector<PartitionedMesh::MutableMeshGroup> groups;
+  groups.reserve(decimated_groups.size());
+  for (size_t g = 0; g < decimated_groups.size(); ++g) {
+    const DecimatedGroup& group = decimated_groups[g];
+    outline_spans[g].assign(group.outlines.begin(), group.outlines.end());
+    packing_arrays.push_back(
+        StrokeVertex::MakeCustomPackingArray(group.mesh.Format()));
+    groups.push_back({
+        .mesh = &group.mesh,
+        .outlines = outline_spans[g],
+        .packing_params = packing_arrays[g].Values(),
+    });
+  }
+  return PartitionedMesh::FromMutableMeshGroups(groups);
+}
+
+}  // namespace ink::strokes_internal
@@ -0,0 +1,42 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INK_STROKES_INTERNAL_STROKE_DECIMATION_H_
+#define INK_STROKES_INTERNAL_STROKE_DECIMATION_H_
+
+#include "absl/status/statusor.h"
+#include "ink/geometry/partitioned_mesh.h"
+
+namespace ink::strokes_internal {
+
+// Returns a simplified copy of `shape`, for drawing it at a scale where
+// features smaller than `cell_size` are not visible.
+//
+// This uses vertex clustering: the plane is divided into a grid of square cells
+// with sides of `cell_size`, and the vertices of each render group that fall in
+// the same cell are merged into the first of them (in mesh order), keeping all
+// of its attributes. Triangles that collapse to a point or a segment are
+// dropped, as are triangles that become duplicates of an earlier one. Outlines
+// are remapped to the merged vertices, and dropped if they collapse to fewer
+// than three vertices.
+//
+// Each vertex moves by at most the diagonal of a cell, and the result has the
+// same number of render groups, with the same formats, as `shape`. Returns an
+// error if `cell_size` is not finite and positive.
+absl::StatusOr<PartitionedMesh> DecimateShape(const PartitionedMesh& shape,
+                                              float cell_size);
+
+}  // namespace ink::strokes_internal
+
+#endif  // INK_STROKES_INTERNAL_STROKE_DECIMATION_H_
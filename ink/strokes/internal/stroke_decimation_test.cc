@@ -0,0 +1,172 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ink/strokes/internal/stroke_decimation.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "ink/geometry/affine_transform.h"
+#include "ink/geometry/mesh.h"
+#include "ink/geometry/mesh_format.h"
+#include "ink/geometry/mesh_test_helpers.h"
+#include "ink/geometry/mutable_mesh.h"
+#include "ink/geometry/partitioned_mesh.h"
+#include "ink/geometry/point.h"
+#include "ink/geometry/type_matchers.h"
+
+namespace ink::strokes_internal {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+
+std::vector<Point> VertexPositions(const PartitionedMesh& shape) {
+  std::vector<Point> positions;
+  for (const Mesh& mesh : shape.Meshes()) {
+    for (uint32_t v = 0; v < mesh.VertexCount(); ++v) {
+      positions.push_back(mesh.VertexPosition(v));
+    }
+  }
+  return positions;
+}
+
+uint32_t TriangleCount(const PartitionedMesh& shape) {
+  uint32_t count = 0;
+  for (const Mesh& mesh : shape.Meshes()) count += mesh.TriangleCount();
+  return count;
+}
+
+TEST(StrokeDecimationTest, InvalidCellSize) {
+  PartitionedMesh shape = MakeStraightLinePartitionedMesh(4);
+  for (float cell_size : {0.f, -1.f, std::numeric_limits<float>::infinity(),
+                          std::numeric_limits<float>::quiet_NaN()}) {
+    EXPECT_THAT(DecimateShape(shape, cell_size),
+                StatusIs(absl::StatusCode::kInvalidArgument,
+                         HasSubstr("cell_size")));
+  }
+}
+
+TEST(StrokeDecimationTest, EmptyShape) {
+  absl::StatusOr<PartitionedMesh> decimated =
+      DecimateShape(PartitionedMesh(), 1);
+  ASSERT_THAT(decimated, IsOk());
+  EXPECT_EQ(decimated->RenderGroupCount(), 0);
+
+  decimated = DecimateShape(PartitionedMesh::WithEmptyGroups(2), 1);
+  ASSERT_THAT(decimated, IsOk());
+  EXPECT_EQ(decimated->RenderGroupCount(), 2);
+  EXPECT_TRUE(decimated->Meshes().empty());
+}
+
+TEST(StrokeDecimationTest, SmallCellSizeKeepsAllVertices) {
+  PartitionedMesh shape = MakeStraightLinePartitionedMesh(10);
+  absl::StatusOr<PartitionedMesh> decimated = DecimateShape(shape, 0.5);
+  ASSERT_THAT(decimated, IsOk());
+
+  std::vector<Point> positions = VertexPositions(shape);
+  std::vector<Point> decimated_positions = VertexPositions(*decimated);
+  ASSERT_EQ(decimated_positions.size(), positions.size());
+  for (size_t i = 0; i < positions.size(); ++i) {
+    EXPECT_THAT(decimated_positions[i], PointEq(positions[i]));
+  }
+  EXPECT_EQ(TriangleCount(*decimated), 10);
+}
+
+TEST(StrokeDecimationTest, MergesVerticesInTheSameCell) {
+  // The strip's vertices are at (0, 0), (1, -1), (2, 0), ..., (15, -1). With
+  // cells of size 4, the vertices at (4i, 0) and (4i + 2, 0) are merged, as
+  // are those at (4i + 1, -1) and (4i + 3, -1), into the first of each pair.
+  PartitionedMesh shape = MakeStraightLinePartitionedMesh(14);
+  absl::StatusOr<PartitionedMesh> decimated = DecimateShape(shape, 4);
+  ASSERT_THAT(decimated, IsOk());
+
+  EXPECT_THAT(VertexPositions(*decimated),
+              ElementsAre(PointEq({0, 0}), PointEq({1, -1}), PointEq({4, 0}),
+                          PointEq({5, -1}), PointEq({8, 0}), PointEq({9, -1}),
+                          PointEq({12, 0}), PointEq({13, -1})));
+  // Triangles whose first and last vertices are merged collapse to a segment,
+  // which leaves every other pair of triangles.
+  EXPECT_EQ(TriangleCount(*decimated), 6);
+}
+
+TEST(StrokeDecimationTest, RemapsOutlines) {
+  //  4-------------3
+  //  | \         / |
+  //  |   \     /   |
+  //  |     \ /     |
+  //  0-1-----------2
+  MutableMesh mesh(MeshFormat{});
+  for (Point p : {Point{0, 0}, Point{0.5, 0}, Point{10, 0}, Point{10, 10},
+                  Point{0, 10}}) {
+    mesh.AppendVertex(p);
+  }
+  mesh.AppendTriangleIndices({0, 1, 4});
+  mesh.AppendTriangleIndices({1, 2, 3});
+  mesh.AppendTriangleIndices({1, 3, 4});
+  std::vector<uint32_t> outline = {0, 1, 2, 3, 4};
+  absl::StatusOr<PartitionedMesh> shape =
+      PartitionedMesh::FromMutableMesh(mesh, {outline});
+  ASSERT_THAT(shape, IsOk());
+
+  // Vertex 1 is merged into vertex 0, which collapses the first triangle.
+  absl::StatusOr<PartitionedMesh> decimated = DecimateShape(*shape, 2);
+  ASSERT_THAT(decimated, IsOk());
+  EXPECT_EQ(TriangleCount(*decimated), 2);
+  ASSERT_EQ(decimated->OutlineCount(0), 1);
+  EXPECT_EQ(decimated->OutlineVertexCount(0, 0), 4);
+  EXPECT_THAT(decimated->OutlinePosition(0, 0, 0), PointEq({0, 0}));
+  EXPECT_THAT(decimated->OutlinePosition(0, 0, 1), PointEq({10, 0}));
+
+  // With one cell covering the whole shape, there is nothing left of the
+  // triangles or the outline.
+  decimated = DecimateShape(*shape, 100);
+  ASSERT_THAT(decimated, IsOk());
+  EXPECT_EQ(decimated->RenderGroupCount(), 1);
+  EXPECT_EQ(TriangleCount(*decimated), 0);
+  EXPECT_EQ(decimated->OutlineCount(0), 0);
+}
+
+TEST(StrokeDecimationTest, KeepsRenderGroups) {
+  MutableMesh mesh_a = MakeStraightLineMutableMesh(20);
+  MutableMesh mesh_b = MakeCoiledRingMutableMesh(
+      20, 10, MeshFormat(), AffineTransform::Scale(10));
+  absl::StatusOr<PartitionedMesh> shape =
+      PartitionedMesh::FromMutableMeshGroups(
+          {{.mesh = &mesh_a}, {.mesh = &mesh_b}});
+  ASSERT_THAT(shape, IsOk());
+
+  absl::StatusOr<PartitionedMesh> decimated = DecimateShape(*shape, 3);
+  ASSERT_THAT(decimated, IsOk());
+  ASSERT_EQ(decimated->RenderGroupCount(), 2);
+  for (uint32_t g = 0; g < 2; ++g) {
+    EXPECT_THAT(decimated->RenderGroupFormat(g),
+                MeshFormatEq(shape->RenderGroupFormat(g)));
+    EXPECT_FALSE(decimated->RenderGroupMeshes(g).empty());
+  }
+  EXPECT_LT(VertexPositions(*decimated).size(),
+            VertexPositions(*shape).size());
+}
+
+}  // namespace
+}  // namespace ink::strokes_internal
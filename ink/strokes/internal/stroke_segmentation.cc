@@ -16,29 +16,50 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 #include "absl/algorithm/container.h"
+#include "absl/container/inlined_vector.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
 #include "ink/geometry/affine_transform.h"
+#include "ink/geometry/envelope.h"
 #include "ink/geometry/mesh.h"
 #include "ink/geometry/mesh_format.h"
 #include "ink/geometry/mutable_mesh.h"
 #include "ink/geometry/partitioned_mesh.h"
 #include "ink/geometry/point.h"
+#include "ink/geometry/rect.h"
 #include "ink/strokes/internal/stroke_vertex.h"
+#include "ink/types/executor.h"
 
 namespace ink::strokes_internal {
 namespace {
 
+// The number of vertices or triangles handled by each task of the union-find,
+// when it is run on an executor. Each step does very little work per element,
+// so tasks need to be fairly large to be worth scheduling.
+constexpr uint32_t kElementsPerTask = 16384;
+
 // A disjoint-set data structure over vertex indices, to help union-find
 // connected components. See
 // https://en.wikipedia.org/wiki/Disjoint-set_data_structure.
+//
+// If `kIsConcurrent`, `Union` may be called concurrently from several threads:
+// the links between trees are made with compare-and-swap, as in "Wait-free
+// Parallel Algorithms for the Union-Find Problem" (Anderson and Woll, 1991).
+// Otherwise, the forest is updated with plain loads and stores, which is
+// considerably faster when there is only one thread. Since every tree is linked
+// under the smaller of the two roots, the resulting forest, and so the result
+// of `Components`, doesn't depend on the order of the calls.
+template <bool kIsConcurrent>
 class ConnectedComponents {
   // The connected components are represented as a forest of trees, with each
   // tree corresponding to a connected component. The forest is stored as a list
@@ -48,65 +69,92 @@ class ConnectedComponents {
  public:
   explicit ConnectedComponents(uint32_t num_vertices) : parent_(num_vertices) {
     // Initialize each vertex to its own component.
-    for (uint32_t i = 0; i < num_vertices; ++i) parent_[i] = i;
+    for (uint32_t i = 0; i < num_vertices; ++i) Store(i, i);
   }
 
   // Union the two sets containing `i` and `j`.
   void Union(uint32_t i, uint32_t j) {
-    uint32_t root_i = Root(i);
-    uint32_t root_j = Root(j);
-
-    // When merging the two components, always choose the smaller index to be
-    // the root. This ensures the convenient property that the component index
-    // of every vertex is always less than or equal to the vertex index.
-    if (root_i < root_j) {
-      parent_[root_j] = root_i;
-    } else if (root_j < root_i) {
-      parent_[root_i] = root_j;
+    while (true) {
+      uint32_t root_i = Root(i);
+      uint32_t root_j = Root(j);
+      if (root_i == root_j) return;
+
+      // When merging the two components, always choose the smaller index to be
+      // the root. This ensures the convenient property that the component index
+      // of every vertex is always less than or equal to the vertex index.
+      if (root_j < root_i) std::swap(root_i, root_j);
+      if constexpr (!kIsConcurrent) {
+        parent_[root_j] = root_i;
+        return;
+      } else {
+        // This fails if another thread has linked `root_j` to some other tree
+        // in the meantime, in which case we start over from the new roots.
+        if (parent_[root_j].compare_exchange_strong(
+                root_j, root_i, std::memory_order_relaxed)) {
+          return;
+        }
+      }
+    }
+  }
+
+  // Returns the root of the tree `i` belongs to, and compresses the path from
+  // `i` to its root by path halving.
+  uint32_t Root(uint32_t i) {
+    uint32_t curr = i;
+    while (true) {
+      uint32_t parent = Load(curr);
+      if (parent == curr) return curr;
+      uint32_t grandparent = Load(parent);
+      if (grandparent == parent) return parent;
+      if constexpr (!kIsConcurrent) {
+        parent_[curr] = grandparent;
+      } else {
+        // If this fails, another thread has already moved `curr` further up
+        // the tree, which is just as good.
+        parent_[curr].compare_exchange_weak(parent, grandparent,
+                                            std::memory_order_relaxed);
+      }
+      curr = grandparent;
     }
   }
 
   // Returns a list mapping each vertex to its connected component index.
   // Component indices are in [0,...,num_components-1], but ordered arbitrarily.
-  absl::Span<const uint32_t> Components() {
-    for (uint32_t i = 0; i < parent_.size(); ++i) Root(i);
+  // This must not be called concurrently with `Union`.
+  std::vector<uint32_t> Components() {
+    std::vector<uint32_t> components(parent_.size());
     uint32_t next_id = 0;
 
-    // Here we exploit the fact that component_[i] <= i for all i, which means
-    // that we always encounter the root of a component (the i for which
-    // i == parent_[i]) before we encounter any other vertex in the
-    // component.
+    // Here we exploit the fact that the root of i is <= i for all i, which
+    // means that we always encounter the root of a component (the i for which
+    // i == Root(i)) before we encounter any other vertex in the component.
     for (uint32_t i = 0; i < parent_.size(); ++i) {
-      uint32_t root = parent_[i];
-      if (root == i) {
-        parent_[i] = next_id++;
-      } else {
-        parent_[i] = parent_[root];
-      }
+      uint32_t root = Root(i);
+      components[i] = root == i ? next_id++ : components[root];
     }
-    return parent_;
+    return components;
   }
 
  private:
-  // Returns the root of the tree `i` belongs to, and compresses the path from
-  // `i` to its root.
-  uint32_t Root(uint32_t i) {
-    uint32_t root = i;
-
-    // Traverse up the tree to find the root.
-    while (parent_[root] != root) root = parent_[root];
+  uint32_t Load(uint32_t i) const {
+    if constexpr (kIsConcurrent) {
+      return parent_[i].load(std::memory_order_relaxed);
+    } else {
+      return parent_[i];
+    }
+  }
 
-    // Traverse up the tree again to flatten the path.
-    uint32_t curr = i;
-    while (curr != root) {
-      uint32_t next = parent_[curr];
-      parent_[curr] = root;
-      curr = next;
+  void Store(uint32_t i, uint32_t parent) {
+    if constexpr (kIsConcurrent) {
+      parent_[i].store(parent, std::memory_order_relaxed);
+    } else {
+      parent_[i] = parent;
     }
-    return root;
   }
 
-  std::vector<uint32_t> parent_;
+  std::vector<
+      std::conditional_t<kIsConcurrent, std::atomic<uint32_t>, uint32_t>>
+      parent_;
 };
 
 std::vector<Point> GetAllVertices(const PartitionedMesh& shape,
@@ -130,50 +178,184 @@ std::vector<Point> GetAllVertices(const PartitionedMesh& shape,
 }
 
 // Updates `components` by unioning vertices that share a triangle in `shape`.
-void ConnectByTriangles(const PartitionedMesh& shape,
-                        ConnectedComponents& components) {
+template <typename Components>
+void ConnectByTriangles(const PartitionedMesh& shape, Executor& executor,
+                        Components& components) {
   uint32_t offset = 0;
   for (uint32_t g = 0; g < shape.RenderGroupCount(); ++g) {
     for (const Mesh& mesh : shape.RenderGroupMeshes(g)) {
-      for (uint32_t t = 0; t < mesh.TriangleCount(); ++t) {
-        std::array<uint32_t, 3> indices = mesh.TriangleIndices(t);
-        components.Union(offset + indices[0], offset + indices[1]);
-        components.Union(offset + indices[1], offset + indices[2]);
-      }
+      ParallelForRanges(
+          mesh.TriangleCount(), kElementsPerTask, executor,
+          [&mesh, &components, offset](uint32_t begin, uint32_t end) {
+            for (uint32_t t = begin; t < end; ++t) {
+              std::array<uint32_t, 3> indices = mesh.TriangleIndices(t);
+              components.Union(offset + indices[0], offset + indices[1]);
+              components.Union(offset + indices[1], offset + indices[2]);
+            }
+          });
       offset += mesh.VertexCount();
     }
   }
 }
 
+// The number of cells along each axis of the grid in
+// `ConnectBySpatialProximity` is capped at this, so that cell coordinates fit
+// in 32 bits however small `tolerance` is compared to the mesh.
+constexpr float kMaxCellsPerAxis = 1 << 20;
+
+// A vertex, and the key of the grid cell that contains it, which packs the
+// cell's x- and y-coordinates into the high and low 32 bits, respectively.
+struct CellVertex {
+  uint64_t cell;
+  uint32_t vertex;
+};
+
+uint64_t CellKey(uint32_t x, uint32_t y) {
+  return (uint64_t{x} << 32) | uint64_t{y};
+}
+
 // Updates `components` by unioning vertices that are within `tolerance` of each
 // other.
+template <typename Components>
 void ConnectBySpatialProximity(const std::vector<Point>& vertices,
-                               float tolerance,
-                               ConnectedComponents& components) {
-  // Linesweep approach: sort vertices by x-coordinate to help prune the
-  // vertices within `tolerance`.
-  std::vector<uint32_t> indices(vertices.size());
-  for (uint32_t i = 0; i < indices.size(); ++i) {
-    indices[i] = i;
-  }
-
-  absl::c_sort(indices, [&](uint32_t a, uint32_t b) {
-    return vertices[a].x < vertices[b].x;
+                               float tolerance, Executor& executor,
+                               Components& components) {
+  // Nothing is within a negative (or NaN) distance.
+  if (!(tolerance >= 0)) return;
+
+  // Bucket the vertices into a uniform grid, whose cells are small enough that
+  // any two vertices in the same cell are within `tolerance` of each other, so
+  // that they can be connected without comparing them. Then vertices within
+  // `tolerance` of each other are in the same cell, or in cells at most
+  // `reach` apart along each axis. Unlike a sweep along one axis, this doesn't
+  // degrade when many vertices share a narrow range of that axis, e.g. in
+  // a vertical stroke.
+  Envelope envelope;
+  for (Point p : vertices) envelope.Add(p);
+  Rect bounds = *envelope.AsRect();
+  // A cell's diagonal is 0.7 * sqrt(2) < 1 times `tolerance`, with a margin
+  // for rounding error.
+  float cell_size =
+      std::max(0.7f * tolerance,
+               std::max(bounds.Width(), bounds.Height()) / kMaxCellsPerAxis);
+  // This only happens if all of the vertices are in the same place, and
+  // `tolerance` is zero, in which case any cell size will do.
+  if (cell_size == 0) cell_size = 1;
+  bool cells_are_connected = cell_size * std::sqrt(2.f) <= tolerance;
+  int reach = static_cast<int>(tolerance / cell_size) + 1;
+
+  auto cell_coordinate = [cell_size](float offset) -> uint32_t {
+    float coordinate = std::floor(offset / cell_size);
+    // This also maps NaN to zero.
+    if (!(coordinate > 0)) return 0;
+    return static_cast<uint32_t>(std::min(coordinate, kMaxCellsPerAxis));
+  };
+  uint32_t n_vertices = vertices.size();
+  std::vector<CellVertex> cell_vertices(n_vertices);
+  ParallelForRanges(
+      n_vertices, kElementsPerTask, executor,
+      [&vertices, &bounds, &cell_coordinate, &cell_vertices](uint32_t begin,
+                                                             uint32_t end) {
+        for (uint32_t v = begin; v < end; ++v) {
+          cell_vertices[v] = {
+              .cell = CellKey(cell_coordinate(vertices[v].x - bounds.XMin()),
+                              cell_coordinate(vertices[v].y - bounds.YMin())),
+              .vertex = v};
+        }
+      });
+  absl::c_sort(cell_vertices, [](const CellVertex& a, const CellVertex& b) {
+    return a.cell < b.cell || (a.cell == b.cell && a.vertex < b.vertex);
   });
 
+  // The key of each non-empty cell, in increasing order, and the start of its
+  // range in `cell_vertices`, with the end of the last range as a sentinel.
+  std::vector<uint64_t> cell_keys;
+  std::vector<uint32_t> cell_starts;
+  for (uint32_t i = 0; i < n_vertices; ++i) {
+    if (i == 0 || cell_vertices[i].cell != cell_vertices[i - 1].cell) {
+      cell_keys.push_back(cell_vertices[i].cell);
+      cell_starts.push_back(i);
+    }
+  }
+  uint32_t n_cells = cell_keys.size();
+  cell_starts.push_back(n_vertices);
+
   float tolerance_squared = tolerance * tolerance;
-  for (uint32_t i = 0; i < vertices.size(); ++i) {
-    uint32_t u = indices[i];
-    Point p_u = vertices[u];
-    for (uint32_t j = i + 1; j < vertices.size(); ++j) {
-      uint32_t v = indices[j];
-      Point p_v = vertices[v];
-      if (p_v.x - p_u.x > tolerance) break;
-      if ((p_u - p_v).MagnitudeSquared() <= tolerance_squared) {
-        components.Union(u, v);
+  // Unions the vertices of the cells with indices `a` and `b` that are within
+  // `tolerance` of each other, where `a` may equal `b`. If
+  // `cells_are_connected`, then each cell is already a single component, so
+  // this stops after the first such pair.
+  auto connect_cells = [&cell_vertices, &cell_starts, &vertices, &components,
+                        tolerance_squared, cells_are_connected](uint32_t a,
+                                                                uint32_t b) {
+    if (cells_are_connected &&
+        components.Root(cell_vertices[cell_starts[a]].vertex) ==
+            components.Root(cell_vertices[cell_starts[b]].vertex)) {
+      return;
+    }
+    for (uint32_t i = cell_starts[a]; i < cell_starts[a + 1]; ++i) {
+      uint32_t u = cell_vertices[i].vertex;
+      for (uint32_t j = a == b ? i + 1 : cell_starts[b];
+           j < cell_starts[b + 1]; ++j) {
+        uint32_t v = cell_vertices[j].vertex;
+        if ((vertices[u] - vertices[v]).MagnitudeSquared() <=
+            tolerance_squared) {
+          components.Union(u, v);
+          if (cells_are_connected) return;
+        }
       }
     }
-  }
+  };
+
+  // First connect the vertices within each cell, so that when comparing cells,
+  // `connect_cells` can skip pairs that are already in the same component.
+  ParallelForRanges(
+      n_cells, kElementsPerTask, executor,
+      [&cell_vertices, &cell_starts, &components, &connect_cells,
+       cells_are_connected](uint32_t begin, uint32_t end) {
+        for (uint32_t c = begin; c < end; ++c) {
+          if (!cells_are_connected) {
+            connect_cells(c, c);
+            continue;
+          }
+          for (uint32_t i = cell_starts[c] + 1; i < cell_starts[c + 1]; ++i) {
+            components.Union(cell_vertices[cell_starts[c]].vertex,
+                             cell_vertices[i].vertex);
+          }
+        }
+      });
+
+  // Then connect each cell to its neighbors. Only the neighbors that come after
+  // it in key order are visited, so that each pair of cells is compared once.
+  // The neighbors in column x + dx of the cell at (x, y) are the cells with
+  // keys from (x + dx, y - reach) to (x + dx, y + reach), which are contiguous
+  // in `cell_keys`. Since the start of that range only increases from one cell
+  // to the next, it's found by walking a cursor for each column, as in a merge.
+  ParallelForRanges(
+      n_cells, kElementsPerTask, executor,
+      [&cell_keys, &connect_cells, reach](uint32_t begin, uint32_t end) {
+        absl::InlinedVector<uint32_t, 3> cursors(reach + 1, begin);
+        for (uint32_t c = begin; c < end; ++c) {
+          uint32_t x = cell_keys[c] >> 32;
+          uint32_t y = cell_keys[c] & 0xffffffff;
+          for (int dx = 0; dx <= reach; ++dx) {
+            uint64_t first_key =
+                dx == 0 ? cell_keys[c] + 1
+                        : CellKey(x + dx, y > static_cast<uint32_t>(reach)
+                                              ? y - reach
+                                              : 0);
+            uint64_t last_key = CellKey(x + dx, y + reach);
+            uint32_t& cursor = cursors[dx];
+            while (cursor < cell_keys.size() && cell_keys[cursor] < first_key) {
+              ++cursor;
+            }
+            for (uint32_t n = cursor;
+                 n < cell_keys.size() && cell_keys[n] <= last_key; ++n) {
+              connect_cells(c, n);
+            }
+          }
+        }
+      });
 }
 
 // Returns PartitionedMeshes for each connected component in `shape` as
@@ -259,11 +441,24 @@ absl::StatusOr<std::vector<PartitionedMesh>> ConstructMeshes(
   return result_meshes;
 }
 
+// Returns a list mapping each of the `vertices` of `shape` to its connected
+// component index, as for `ConnectedComponents::Components`, where `Components`
+// is the `ConnectedComponents` to use for the union-find.
+template <typename Components>
+std::vector<uint32_t> ComputeComponents(const PartitionedMesh& shape,
+                                        const std::vector<Point>& vertices,
+                                        float tolerance, Executor& executor) {
+  Components components(vertices.size());
+  ConnectByTriangles(shape, executor, components);
+  ConnectBySpatialProximity(vertices, tolerance, executor, components);
+  return components.Components();
+}
+
 }  // namespace
 
 absl::StatusOr<std::vector<PartitionedMesh>> SegmentSpatially(
     const PartitionedMesh& shape, const AffineTransform& transform,
-    float tolerance) {
+    float tolerance, Executor& executor) {
   // The approach is to first compute the connected component for each vertex
   // in `shape`, and then to copy each vertex and triangle from `shape` into
   // the PartitionedMesh corresponding to its component.
@@ -273,11 +468,16 @@ absl::StatusOr<std::vector<PartitionedMesh>> SegmentSpatially(
   // vertices that are within `tolerance` of each other.
   std::vector<Point> vertices = GetAllVertices(shape, transform);
   if (vertices.empty()) return std::vector<PartitionedMesh>{};
-  ConnectedComponents components(vertices.size());
-  ConnectByTriangles(shape, components);
-  ConnectBySpatialProximity(vertices, tolerance, components);
+  // The union-find only needs atomics if the executor may run its tasks
+  // concurrently.
+  std::vector<uint32_t> components =
+      executor.IsSerial()
+          ? ComputeComponents<ConnectedComponents<false>>(
+                shape, vertices, tolerance, executor)
+          : ComputeComponents<ConnectedComponents<true>>(shape, vertices,
+                                                         tolerance, executor);
 
   // Construct new partitioned meshes for each component.
-  return ConstructMeshes(shape, components.Components());
+  return ConstructMeshes(shape, components);
 }
 }  // namespace ink::strokes_internal
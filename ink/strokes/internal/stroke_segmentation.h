@@ -20,6 +20,7 @@
 #include "absl/status/statusor.h"
 #include "ink/geometry/affine_transform.h"
 #include "ink/geometry/partitioned_mesh.h"
+#include "ink/types/executor.h"
 
 namespace ink::strokes_internal {
 
@@ -31,9 +32,13 @@ namespace ink::strokes_internal {
 // The order of the returned meshes is arbitrary. Each returned PartitionedMesh
 // has the same number of render groups as the input. Every connected component
 // is placed in the same render group as the group it originated from.
+//
+// Nearby vertices are found by bucketing them into a uniform grid with cells
+// sized by `tolerance`. For large meshes, the union-find over the vertices is
+// run in chunks on `executor`; the result does not depend on the executor.
 absl::StatusOr<std::vector<PartitionedMesh>> SegmentSpatially(
     const PartitionedMesh& shape, const AffineTransform& transform,
-    float tolerance);
+    float tolerance, Executor& executor = SerialExecutor());
 
 }  // namespace ink::strokes_internal
 
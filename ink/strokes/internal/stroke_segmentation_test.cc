@@ -14,6 +14,10 @@
 
 #include "ink/strokes/internal/stroke_segmentation.h"
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
 #include <vector>
 
 #include "gmock/gmock.h"
@@ -21,11 +25,14 @@
 #include "absl/status/status_matchers.h"
 #include "absl/status/statusor.h"
 #include "ink/geometry/affine_transform.h"
+#include "ink/geometry/angle.h"
 #include "ink/geometry/mesh_format.h"
 #include "ink/geometry/mutable_mesh.h"
 #include "ink/geometry/partitioned_mesh.h"
 #include "ink/geometry/point.h"
 #include "ink/geometry/type_matchers.h"
+#include "ink/geometry/vec.h"
+#include "ink/types/executor.h"
 
 namespace ink::strokes_internal {
 namespace {
@@ -290,5 +297,116 @@ TEST(StrokeSegmentationTest, SegmentSpatiallyWithAttributes) {
                                PartitionedMeshDeepEq(*expected_pm2))));
 }
 
+// Returns a mesh of `n_triangles` small disjoint triangles, with random
+// positions in a `width` by `height` rectangle.
+MutableMesh MakeScatteredTriangles(int n_triangles, float width, float height,
+                                   int seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> x(0, width);
+  std::uniform_real_distribution<float> y(0, height);
+  MutableMesh mesh(MeshFormat{});
+  for (int i = 0; i < n_triangles; ++i) {
+    Point p = {x(rng), y(rng)};
+    uint32_t first = mesh.VertexCount();
+    mesh.AppendVertex(p);
+    mesh.AppendVertex(p + Vec{0.25, 0});
+    mesh.AppendVertex(p + Vec{0, 0.25});
+    mesh.AppendTriangleIndices({first, first + 1, first + 2});
+  }
+  return mesh;
+}
+
+// Returns the number of connected components of `mesh` with the given
+// `tolerance`, by comparing every pair of vertices.
+int CountComponentsByBruteForce(const MutableMesh& mesh, float tolerance) {
+  std::vector<uint32_t> parent(mesh.VertexCount());
+  for (uint32_t i = 0; i < parent.size(); ++i) parent[i] = i;
+  auto root = [&parent](uint32_t i) {
+    while (parent[i] != i) i = parent[i];
+    return i;
+  };
+  auto union_vertices = [&parent, &root](uint32_t i, uint32_t j) {
+    parent[root(i)] = root(j);
+  };
+  for (uint32_t t = 0; t < mesh.TriangleCount(); ++t) {
+    std::array<uint32_t, 3> indices = mesh.TriangleIndices(t);
+    union_vertices(indices[0], indices[1]);
+    union_vertices(indices[1], indices[2]);
+  }
+  for (uint32_t i = 0; i < mesh.VertexCount(); ++i) {
+    for (uint32_t j = i + 1; j < mesh.VertexCount(); ++j) {
+      if ((mesh.VertexPosition(i) - mesh.VertexPosition(j)).Magnitude() <=
+          tolerance) {
+        union_vertices(i, j);
+      }
+    }
+  }
+  int n_components = 0;
+  for (uint32_t i = 0; i < parent.size(); ++i) {
+    if (parent[i] == i) ++n_components;
+  }
+  return n_components;
+}
+
+TEST(StrokeSegmentationTest, SegmentSpatiallyMatchesBruteForce) {
+  // The wide and tall cases have the same vertices, rotated, which is the worst
+  // case for a sweep along the x-axis.
+  for (AffineTransform transform :
+       {AffineTransform(), AffineTransform::Rotate(kQuarterTurn)}) {
+    MutableMesh mesh = MakeScatteredTriangles(500, 200, 10, /*seed=*/1);
+    absl::StatusOr<PartitionedMesh> pm =
+        PartitionedMesh::FromMutableMesh(mesh);
+    ASSERT_THAT(pm, IsOk());
+    for (float tolerance : {0.f, 0.1f, 0.5f, 1.f, 3.f}) {
+      EXPECT_THAT(SegmentSpatially(*pm, transform, tolerance),
+                  IsOkAndHolds(SizeIs(CountComponentsByBruteForce(
+                      mesh, tolerance))))
+          << "tolerance: " << tolerance;
+    }
+  }
+}
+
+TEST(StrokeSegmentationTest, SegmentSpatiallyWithZeroToleranceJoinsCoincident) {
+  //  C  E
+  //  |\ |\
+  //  |_\|_\
+  //  A  B  F
+  // The triangles ABC and BFE have separate vertices at B.
+  MutableMesh mesh(MeshFormat{});
+  for (Point p : {Point{0, 0}, Point{1, 0}, Point{0, 1}, Point{1, 0},
+                  Point{1, 1}, Point{2, 0}}) {
+    mesh.AppendVertex(p);
+  }
+  mesh.AppendTriangleIndices({0, 1, 2});
+  mesh.AppendTriangleIndices({3, 5, 4});
+  absl::StatusOr<PartitionedMesh> pm = PartitionedMesh::FromMutableMesh(mesh);
+  ASSERT_THAT(pm, IsOk());
+
+  EXPECT_THAT(SegmentSpatially(*pm, AffineTransform(), /*tolerance=*/0),
+              IsOkAndHolds(SizeIs(1)));
+  EXPECT_THAT(SegmentSpatially(*pm, AffineTransform(), /*tolerance=*/-1),
+              IsOkAndHolds(SizeIs(2)));
+}
+
+TEST(StrokeSegmentationTest, ThreadExecutorMatchesSerialExecutor) {
+  // Enough triangles to be split across several tasks.
+  MutableMesh mesh = MakeScatteredTriangles(20000, 400, 400, /*seed=*/2);
+  absl::StatusOr<PartitionedMesh> pm = PartitionedMesh::FromMutableMesh(mesh);
+  ASSERT_THAT(pm, IsOk());
+  ThreadExecutor executor(4);
+
+  absl::StatusOr<std::vector<PartitionedMesh>> serial =
+      SegmentSpatially(*pm, AffineTransform(), /*tolerance=*/1);
+  absl::StatusOr<std::vector<PartitionedMesh>> threaded =
+      SegmentSpatially(*pm, AffineTransform(), /*tolerance=*/1, executor);
+  ASSERT_THAT(serial, IsOk());
+  ASSERT_THAT(threaded, IsOk());
+  EXPECT_GT(serial->size(), 1u);
+  ASSERT_EQ(threaded->size(), serial->size());
+  for (size_t i = 0; i < serial->size(); ++i) {
+    EXPECT_THAT((*threaded)[i], PartitionedMeshDeepEq((*serial)[i]));
+  }
+}
+
 }  // namespace
 }  // namespace ink::strokes_internal
@@ -19,12 +19,16 @@
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <iterator>
 #include <optional>
+#include <tuple>
 #include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/inlined_vector.h"
+#include "absl/functional/function_ref.h"
 #include "absl/log/absl_check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -34,12 +38,14 @@
 #include "ink/geometry/internal/outline_processing.h"
 #include "ink/geometry/mesh.h"
 #include "ink/geometry/mesh_format.h"
+#include "ink/geometry/mesh_index_types.h"
 #include "ink/geometry/mutable_mesh.h"
 #include "ink/geometry/partitioned_mesh.h"
 #include "ink/geometry/point.h"
 #include "ink/geometry/triangle.h"
 #include "ink/geometry/vec.h"
 #include "ink/strokes/internal/stroke_vertex.h"
+#include "ink/types/executor.h"
 #include "ink/types/numbers.h"
 #include "ink/types/small_array.h"
 
@@ -57,6 +63,17 @@ using TriangleAttributes =
 
 float DistanceSquared(Point a, Point b) { return (a - b).MagnitudeSquared(); }
 
+// Returns true if `transform` flips orientation.
+bool IsReflection(const AffineTransform& transform) {
+  return transform.M00() * transform.M11() < transform.M10() * transform.M01();
+}
+
+bool IsIdentity(const AffineTransform& transform) {
+  return transform.M00() == 1 && transform.M10() == 0 &&
+         transform.M20() == 0 && transform.M01() == 0 &&
+         transform.M11() == 1 && transform.M21() == 0;
+}
+
 // A representation of a triangulation, consisting of a list of `vertices` and
 // `triangles` represented by triplets of indices of vertices.
 struct Triangulation {
@@ -129,8 +146,11 @@ SmallArray<float, 4> LinearSpaceToHslShift(SmallArray<float, 4> val) {
 // LINT.ThenChange(../../rendering/skia/common_internal/sksl_vertex_shader_helper_functions.h:apply_hsl_and_opacity_shift)
 
 // Helper function to extract and linearize triangle vertex attributes.
+// `MeshType` may be `Mesh`, or any other type with the same `Format` and
+// `FloatVertexAttribute` methods.
+template <typename MeshType>
 TriangleAttributes GetTriangleAttributes(
-    const Mesh& mesh, const std::array<uint32_t, 3>& indices) {
+    const MeshType& mesh, const std::array<uint32_t, 3>& indices) {
   absl::InlinedVector<std::array<SmallArray<float, 4>, 3>, 4> attributes(
       mesh.Format().Attributes().size());
   for (uint32_t i = 0; i < attributes.size(); ++i) {
@@ -182,12 +202,29 @@ struct TriangleData {
 // vertices back together along shared edges.
 class MeshBuilder {
  public:
-  explicit MeshBuilder(const MeshFormat& format) : mutable_mesh_(format) {}
+  // Vertices are numbered from `first_vertex_index`, so that the builder can
+  // hold just the vertices that are added to another mesh, whose vertices are
+  // numbered from zero.
+  explicit MeshBuilder(const MeshFormat& format,
+                       uint32_t first_vertex_index = 0)
+      : mutable_mesh_(format), first_vertex_index_(first_vertex_index) {}
+
+  MeshBuilder(const MeshBuilder& other)
+      : mutable_mesh_(other.mutable_mesh_.Clone()),
+        edge_vertex_map_(other.edge_vertex_map_),
+        first_vertex_index_(other.first_vertex_index_) {}
+  MeshBuilder(MeshBuilder&&) = default;
+  MeshBuilder& operator=(const MeshBuilder& other) {
+    if (this != &other) *this = MeshBuilder(other);
+    return *this;
+  }
+  MeshBuilder& operator=(MeshBuilder&&) = default;
 
-  // Copies the vertex and its attributes from the given `mesh` at
-  // `vertex_index` and appends it to this mesh, and returns
+  // Copies the vertex and its attributes from the given `mesh` (a `Mesh` or
+  // `MutableMesh`) at `vertex_index` and appends it to this mesh, and returns
   // the index of the newly added vertex in this mesh.
-  uint32_t CopyVertex(const Mesh& mesh, uint32_t vertex_index) {
+  template <typename MeshType>
+  uint32_t CopyVertex(const MeshType& mesh, uint32_t vertex_index) {
     uint32_t new_index = mutable_mesh_.VertexCount();
     mutable_mesh_.AppendVertex(mesh.VertexPosition(vertex_index));
     const MeshFormat& format = mutable_mesh_.Format();
@@ -196,7 +233,7 @@ class MeshBuilder {
       mutable_mesh_.SetFloatVertexAttribute(
           new_index, i, mesh.FloatVertexAttribute(vertex_index, i));
     }
-    return new_index;
+    return first_vertex_index_ + new_index;
   }
 
   // Finds an existing vertex or adds one for a point `p` contained in the
@@ -225,6 +262,10 @@ class MeshBuilder {
     return AddVertex(p, triangle, weights);
   }
 
+  // Returns the mesh built so far. Vertex `i` of the builder is vertex
+  // `i - first_vertex_index` of the returned mesh.
+  const MutableMesh& GetMesh() const { return mutable_mesh_; }
+
   // Extracts the underlying MutableMesh by moving it, consuming the
   // MeshBuilder.
   MutableMesh ExtractMesh() && { return std::move(mutable_mesh_); }
@@ -269,7 +310,7 @@ class MeshBuilder {
       }
       mutable_mesh_.SetFloatVertexAttribute(new_index, attr, interp_val);
     }
-    return new_index;
+    return first_vertex_index_ + new_index;
   }
 
   // Finds an existing vertex or adds one for a point `p` lying along the side
@@ -302,6 +343,8 @@ class MeshBuilder {
   absl::flat_hash_map<std::pair<uint32_t, uint32_t>,
                       absl::InlinedVector<std::pair<Point, uint32_t>, 2>>
       edge_vertex_map_;
+
+  uint32_t first_vertex_index_;
 };
 
 // Computes the geometric boolean difference `tri` - `shape_b` as a
@@ -314,38 +357,88 @@ Triangulation SubtractTriangle(const Triangle& tri,
                        .triangles = std::move(triangles)};
 }
 
-// Computes outlines and returns the (clockwise oriented) outlines of the given
-// `mesh`.
-std::vector<std::vector<uint32_t>> ComputeOutlines(const MutableMesh& mesh) {
-  // To compute the outline, we first compute the "simplicial boundary"
-  // (the set of directed boundary edges of triangles that aren't
-  // "cancelled" out by an adjacent triangle) of the mesh. Then we trace the
-  // boundary edges to extract the outline.
-  // TODO(b/523326691): Consider initializing `boundary` with the existing mesh
-  // outlines to avoid recomputing the outline for untouched parts of the mesh.
+// The transforms between the coordinates of the meshes being subtracted from
+// and those of `shape_b`, when they differ.
+struct MeshToShapeTransforms {
+  AffineTransform mesh_to_shape;
+  AffineTransform shape_to_mesh;
+  // Whether the transforms flip orientation.
+  bool is_reflection;
+};
 
-  // We store the simplicial boundary in a vertex adjacency list `boundary`,
-  // representing directed edges of the mesh. As we add triangle boundaries, we
-  // make sure to remove cancelled edges (i.e. if (v, u) is already present in
-  // the adjacency list, adding (u, v) removes it). The capacity of 4 is chosen
-  // as 4 is the typical degree of a vertex in a triangle strip.
-  std::vector<absl::InlinedVector<uint32_t, 4>> boundary(mesh.VertexCount());
-  for (uint32_t tri_idx = 0; tri_idx < mesh.TriangleCount(); ++tri_idx) {
-    std::array<uint32_t, 3> triangle = mesh.TriangleIndices(tri_idx);
-    uint32_t u = triangle[2];
-    for (uint32_t v : triangle) {
-      if (absl::erase_if(boundary[v], [u](uint32_t x) { return x == u; }) ==
-          0) {
-        boundary[u].push_back(v);
-      }
-      u = v;
+// Returns the `MeshToShapeTransforms` for `mesh_to_shape`, which must be
+// invertible, or `std::nullopt` if it is the identity.
+std::optional<MeshToShapeTransforms> GetMeshToShapeTransforms(
+    const AffineTransform& mesh_to_shape) {
+  if (IsIdentity(mesh_to_shape)) return std::nullopt;
+  std::optional<AffineTransform> shape_to_mesh = mesh_to_shape.Inverse();
+  ABSL_CHECK(shape_to_mesh.has_value());
+  return MeshToShapeTransforms{
+      .mesh_to_shape = mesh_to_shape,
+      .shape_to_mesh = *shape_to_mesh,
+      .is_reflection = IsReflection(mesh_to_shape),
+  };
+}
+
+// As `SubtractTriangle`, but for a `tri` in mesh coordinates and a `shape_b`
+// in the coordinates given by `transforms`. The triangle is mapped into
+// `shape_b`'s coordinates, and the resulting fragments are mapped back.
+Triangulation SubtractTriangle(const Triangle& tri,
+                               const ShapeOutline& shape_b,
+                               const MeshToShapeTransforms& transforms) {
+  Triangle shape_tri = transforms.mesh_to_shape.Apply(tri);
+  // `ShapeOutline` expects a counter-clockwise triangle.
+  if (transforms.is_reflection) std::swap(shape_tri.p1, shape_tri.p2);
+  Triangulation fragments = SubtractTriangle(shape_tri, shape_b);
+  for (Point& vertex : fragments.vertices) {
+    vertex = transforms.shape_to_mesh.Apply(vertex);
+  }
+  if (transforms.is_reflection) {
+    for (std::array<uint32_t, 3>& fragment : fragments.triangles) {
+      std::swap(fragment[1], fragment[2]);
     }
   }
+  return fragments;
+}
 
-  // `boundary` now is an adjaceny map of the boundary outline of the graph: for
-  // any boundary vertex u, `boundary[u]` is the singleton list consisting of
-  // the successor vertex of `u` in a counterclockwise walk of the boundary. We
-  // now traverse the `boundary` to extract the outline as a sequence of
+// The "simplicial boundary" of a set of triangles (the set of directed boundary
+// edges of triangles that aren't "cancelled" out by an adjacent triangle),
+// stored as a vertex adjacency list: `boundary[u]` holds `v` for each directed
+// boundary edge (u, v). The capacity of 4 is chosen as 4 is the typical degree
+// of a vertex in a triangle strip.
+using Boundary = std::vector<absl::InlinedVector<uint32_t, 4>>;
+
+// Adds the directed edges of `triangle` to `boundary`, removing any edges that
+// they cancel out (i.e. if (v, u) is already present, adding (u, v) removes
+// it). Each vertex of `triangle` must be less than `boundary.size()`.
+void AddToBoundary(const std::array<uint32_t, 3>& triangle,
+                   Boundary& boundary) {
+  uint32_t u = triangle[2];
+  for (uint32_t v : triangle) {
+    auto reverse_edge = absl::c_find(boundary[v], u);
+    if (reverse_edge != boundary[v].end()) {
+      boundary[v].erase(reverse_edge);
+    } else {
+      boundary[u].push_back(v);
+    }
+    u = v;
+  }
+}
+
+// Removes the directed edges of `triangle`, which must have been added to
+// `boundary`, restoring any edges that they cancelled out. This is the same as
+// adding the triangle with the opposite orientation.
+void RemoveFromBoundary(const std::array<uint32_t, 3>& triangle,
+                        Boundary& boundary) {
+  AddToBoundary({triangle[0], triangle[2], triangle[1]}, boundary);
+}
+
+// Traces the edges of `boundary`, and returns the (clockwise oriented)
+// outlines that they form.
+std::vector<std::vector<uint32_t>> TraceOutlines(Boundary boundary) {
+  // For any boundary vertex u, `boundary[u]` is the singleton list consisting
+  // of the successor vertex of `u` in a counterclockwise walk of the boundary.
+  // We traverse the `boundary` to extract the outline as a sequence of
   // vertices.
   std::vector<std::vector<uint32_t>> outlines;
   for (uint32_t start = 0; start < boundary.size(); ++start) {
@@ -369,25 +462,159 @@ std::vector<std::vector<uint32_t>> ComputeOutlines(const MutableMesh& mesh) {
   return outlines;
 }
 
+// Computes outlines and returns the (clockwise oriented) outlines of the given
+// `mesh`.
+std::vector<std::vector<uint32_t>> ComputeOutlines(const MutableMesh& mesh) {
+  // To compute the outline, we first compute the simplicial boundary of the
+  // mesh, and then trace the boundary edges to extract the outline.
+  // TODO(b/523326691): Consider initializing `boundary` with the existing mesh
+  // outlines to avoid recomputing the outline for untouched parts of the mesh.
+  Boundary boundary(mesh.VertexCount());
+  for (uint32_t tri_idx = 0; tri_idx < mesh.TriangleCount(); ++tri_idx) {
+    AddToBoundary(mesh.TriangleIndices(tri_idx), boundary);
+  }
+  return TraceOutlines(std::move(boundary));
+}
+
+// Adds the vertices of `fragments`, the triangulation of what remains of
+// `tri`, to `builder`, and calls `add_triangle` with each non-degenerate
+// fragment triangle. The vertices of `tri` are `indices` in `builder`, and
+// `attributes` are their linearized attributes.
+void AddFragments(
+    const Triangle& tri, const Triangulation& fragments,
+    const std::array<uint32_t, 3>& indices, TriangleAttributes attributes,
+    float epsilon, MeshBuilder& builder,
+    absl::FunctionRef<void(const std::array<uint32_t, 3>&)> add_triangle) {
+  // Compute and store some properties of the triangle helpful for
+  // interpolation.
+  std::array<double, 9> transform = ComputeBarycentricTransform(tri);
+  const TriangleData triangle = {
+      .indices = indices,
+      .transform = transform,
+      .heights = ComputeHeights(tri, transform[8]),
+      .attributes = std::move(attributes)};
+
+  // Add all the vertices of the fragments and get their indices.
+  std::vector<uint32_t> mapped_indices(fragments.vertices.size());
+  for (size_t i = 0; i < fragments.vertices.size(); ++i) {
+    mapped_indices[i] =
+        builder.GetOrAddVertex(fragments.vertices[i], triangle, epsilon);
+  }
+
+  // Add all the triangle fragments.
+  for (const std::array<uint32_t, 3>& fragment : fragments.triangles) {
+    std::array<uint32_t, 3> fragment_triangle = {mapped_indices[fragment[0]],
+                                                 mapped_indices[fragment[1]],
+                                                 mapped_indices[fragment[2]]};
+    if (fragment_triangle[0] == fragment_triangle[1] ||
+        fragment_triangle[1] == fragment_triangle[2] ||
+        fragment_triangle[2] == fragment_triangle[0]) {
+      continue;
+    }
+    add_triangle(fragment_triangle);
+  }
+}
+
 struct SubtractedMesh {
   MutableMesh mesh;
   std::vector<std::vector<uint32_t>> outlines;
 };
 
-// Returns a `SubtractedMesh` representing the subtraction of `shape_b` from
-// `meshes`.
+// The result of `SubtractTriangle` for one triangle of the input meshes, which
+// is identified by its index across all of the meshes, i.e. its index within
+// its mesh plus the number of triangles in the meshes before it.
+struct TriangleFragments {
+  uint32_t triangle_index;
+  Triangle triangle;
+  Triangulation fragments;
+};
+
+// The number of consecutive triangles handled by each task of
+// `ComputeTriangleFragments`. Most triangles are rejected by the bounding box
+// test, so tasks need to be fairly large to be worth scheduling.
+constexpr uint32_t kTrianglesPerTask = 1024;
+
+// Computes `SubtractTriangle` for every triangle of `meshes` whose bounding box
+// intersects `shape_b`, running chunks of consecutive triangles as tasks on
+// `executor`. Returns the results ordered by triangle index; the triangles that
+// are not in the result are untouched by `shape_b`. If `transforms` is present,
+// `shape_b` is in the coordinates that it describes, and otherwise it is in the
+// coordinates of `meshes`.
+std::vector<TriangleFragments> ComputeTriangleFragments(
+    absl::Span<const Mesh> meshes, const ShapeOutline& shape_b,
+    const std::optional<MeshToShapeTransforms>& transforms,
+    Executor& executor) {
+  std::vector<uint32_t> first_triangle_indices;
+  first_triangle_indices.reserve(meshes.size());
+  uint32_t n_triangles = 0;
+  for (const Mesh& mesh : meshes) {
+    first_triangle_indices.push_back(n_triangles);
+    n_triangles += mesh.TriangleCount();
+  }
+
+  uint32_t n_tasks = (n_triangles + kTrianglesPerTask - 1) / kTrianglesPerTask;
+  std::vector<std::vector<TriangleFragments>> task_fragments(n_tasks);
+  executor.ParallelFor(n_tasks, [&meshes, &shape_b, &transforms,
+                                 &first_triangle_indices, &task_fragments,
+                                 n_triangles](size_t task) {
+    uint32_t begin = task * kTrianglesPerTask;
+    uint32_t end = std::min(begin + kTrianglesPerTask, n_triangles);
+    size_t mesh_index =
+        absl::c_upper_bound(first_triangle_indices, begin) -
+        first_triangle_indices.begin() - 1;
+    for (uint32_t index = begin; index < end; ++index) {
+      // Skip past the end of the current mesh, and any empty meshes after it.
+      while (index - first_triangle_indices[mesh_index] >=
+             meshes[mesh_index].TriangleCount()) {
+        ++mesh_index;
+      }
+      Triangle tri = meshes[mesh_index].GetTriangle(
+          index - first_triangle_indices[mesh_index]);
+      Envelope shape_bounds =
+          transforms.has_value()
+              ? Envelope(transforms->mesh_to_shape.Apply(tri))
+              : Envelope(tri);
+      if (!Intersects(shape_b, shape_bounds.AsRect().value())) continue;
+      task_fragments[task].push_back(
+          {.triangle_index = index,
+           .triangle = tri,
+           .fragments = transforms.has_value()
+                            ? SubtractTriangle(tri, shape_b, *transforms)
+                            : SubtractTriangle(tri, shape_b)});
+    }
+  });
+
+  if (task_fragments.size() == 1) return std::move(task_fragments.front());
+  std::vector<TriangleFragments> fragments;
+  for (std::vector<TriangleFragments>& task_result : task_fragments) {
+    fragments.insert(fragments.end(),
+                     std::make_move_iterator(task_result.begin()),
+                     std::make_move_iterator(task_result.end()));
+  }
+  return fragments;
+}
+
+// Returns a `SubtractedMesh` representing the subtraction of a shape from
+// `meshes`, given the `all_fragments` computed for it by
+// `ComputeTriangleFragments`.
 SubtractedMesh SubtractMeshes(absl::Span<const Mesh> meshes,
                               const MeshFormat& format,
-                              const ShapeOutline& shape_b, float epsilon) {
+                              std::vector<TriangleFragments> all_fragments,
+                              float epsilon) {
   // To compute the subtraction `meshes` - `shape_b`, we process each
   // triangle in `meshes` individually. For each triangle, we first handle the
   // geometry by computing a triangulation of the shape of `triangle` -
-  // `shape_b`. Next, we add all the vertices from the triangulation to the
+  // `shape_b`. This is the expensive part, and is independent for each
+  // triangle, so it is done up front by the caller. Next, in order of the
+  // triangles, we add all the vertices from the triangulation to the
   // `mutable_mesh` result (making sure to re-use existing vertices to properly
   // glue the triangulations together along shared vertices and edges) and
   // set their attributes by interpolating from the original triangle vertices.
   // Finally, we add all the triangles from the triangulation, using the mapped
   // indices of the corresponding vertices in the resulting `mutable_mesh`.
+  // Since the gluing is done serially, the result does not depend on the
+  // executor.
+  auto next_fragments = all_fragments.begin();
 
   MeshBuilder sub_mesh(format);
 
@@ -401,6 +628,7 @@ SubtractedMesh SubtractMeshes(absl::Span<const Mesh> meshes,
 
   // Process the triangles.
   uint32_t vertex_offset = 0;
+  uint32_t triangle_offset = 0;
   for (const Mesh& mesh : meshes) {
     for (uint32_t tri_idx = 0; tri_idx < mesh.TriangleCount(); ++tri_idx) {
       std::array<uint32_t, 3> old_indices = mesh.TriangleIndices(tri_idx);
@@ -410,54 +638,34 @@ SubtractedMesh SubtractMeshes(absl::Span<const Mesh> meshes,
                                          old_indices[1] + vertex_offset,
                                          old_indices[2] + vertex_offset};
 
-      Triangle tri = mesh.GetTriangle(tri_idx);
-
-      // If there is no intersection with the bounding box, add the triangle
+      // If there was no intersection with the bounding box, add the triangle
       // and move on.
-      if (!Intersects(shape_b, Envelope(tri).AsRect().value())) {
+      if (next_fragments == all_fragments.end() ||
+          next_fragments->triangle_index != triangle_offset + tri_idx) {
         sub_mesh.AddTriangle(indices);
         continue;
       }
 
-      // Otherwise, compute the subtraction and get a triangulation of the
-      // leftover geometry of the triangle.
-      Triangulation fragments = SubtractTriangle(tri, shape_b);
+      // Otherwise, use the triangulation of the leftover geometry of the
+      // triangle.
+      const Triangle& tri = next_fragments->triangle;
+      const Triangulation& fragments = next_fragments->fragments;
+      ++next_fragments;
 
       // Early skip if the triangle was entirely erased.
       if (fragments.triangles.empty()) continue;
 
-      // Compute and store some properties of the triangle helpful for
-      // interpolation.
-      std::array<double, 9> transform = ComputeBarycentricTransform(tri);
-      const TriangleData triangle = {
-          .indices = indices,
-          .transform = transform,
-          .heights = ComputeHeights(tri, transform[8]),
-          .attributes = GetTriangleAttributes(mesh, old_indices)};
-
-      // Add all the vertices of the fragments and get their indices.
-      std::vector<uint32_t> mapped_indices(fragments.vertices.size());
-      for (size_t i = 0; i < fragments.vertices.size(); ++i) {
-        mapped_indices[i] =
-            sub_mesh.GetOrAddVertex(fragments.vertices[i], triangle, epsilon);
-      }
-
-      // Add all the triangle fragments.
-      for (const std::array<uint32_t, 3>& fragment : fragments.triangles) {
-        std::array<uint32_t, 3> fragment_triangle = {
-            mapped_indices[fragment[0]], mapped_indices[fragment[1]],
-            mapped_indices[fragment[2]]};
-        if (fragment_triangle[0] == fragment_triangle[1] ||
-            fragment_triangle[1] == fragment_triangle[2] ||
-            fragment_triangle[2] == fragment_triangle[0]) {
-          continue;
-        }
-        sub_mesh.AddTriangle(fragment_triangle);
-      }
+      AddFragments(tri, fragments, indices,
+                   GetTriangleAttributes(mesh, old_indices), epsilon, sub_mesh,
+                   [&sub_mesh](const std::array<uint32_t, 3>& fragment) {
+                     sub_mesh.AddTriangle(fragment);
+                   });
     }
 
     vertex_offset += mesh.VertexCount();
+    triangle_offset += mesh.TriangleCount();
   }
+  ABSL_DCHECK(next_fragments == all_fragments.end());
 
   MutableMesh result_mesh = std::move(sub_mesh).ExtractMesh();
   std::vector<std::vector<uint32_t>> outlines = ComputeOutlines(result_mesh);
@@ -475,6 +683,7 @@ ShapeOutline GetShapeB(const PartitionedMesh& mesh,
                        const AffineTransform& transform, float epsilon) {
   std::vector<std::vector<Point>> loops;
   float epsilon_squared = epsilon * epsilon;
+  bool is_reflection = IsReflection(transform);
   for (uint32_t group = 0; group < mesh.RenderGroupCount(); ++group) {
     for (uint32_t outline = 0; outline < mesh.OutlineCount(group); ++outline) {
       uint32_t num_vertices = mesh.OutlineVertexCount(group, outline);
@@ -504,22 +713,85 @@ ShapeOutline GetShapeB(const PartitionedMesh& mesh,
 
       if (loop.size() < 3) continue;
 
+      // If `transform` flips orientation, the transformed outline is already
+      // counter-clockwise, so undo the reversal.
+      if (is_reflection) absl::c_reverse(loop);
+
       loops.push_back(std::move(loop));
     }
   }
   return ShapeOutline(loops);
 }
+
+// Returns a `PartitionedMesh` with the `subtracted_groups`, one for each render
+// group of `original`, which is the mesh that they were subtracted from.
+absl::StatusOr<PartitionedMesh> AssembleMesh(
+    const PartitionedMesh& original,
+    absl::Span<SubtractedMesh> subtracted_groups) {
+  uint32_t num_groups = original.RenderGroupCount();
+  ABSL_DCHECK_EQ(subtracted_groups.size(), num_groups);
+  std::vector<PartitionedMesh::MutableMeshGroup> groups(num_groups);
+  std::vector<std::vector<absl::Span<const uint32_t>>> groups_outline_spans(
+      num_groups);
+  std::vector<StrokeVertex::CustomPackingArray> packing_arrays(num_groups);
+  for (uint32_t group = 0; group < num_groups; ++group) {
+    for (const std::vector<uint32_t>& outline :
+         subtracted_groups[group].outlines) {
+      groups_outline_spans[group].push_back(outline);
+    }
+    packing_arrays[group] =
+        StrokeVertex::MakeCustomPackingArray(original.RenderGroupFormat(group));
+    groups[group] = PartitionedMesh::MutableMeshGroup{
+        .mesh = &subtracted_groups[group].mesh,
+        .outlines = groups_outline_spans[group],
+        .packing_params = packing_arrays[group].Values(),
+    };
+  }
+  return PartitionedMesh::FromMutableMeshGroups(groups);
+}
+
+// Returns the subtraction of `shape_b` from `mesh_a`, where `transforms` is as
+// for `ComputeTriangleFragments`.
+absl::StatusOr<PartitionedMesh> SubtractShape(
+    const PartitionedMesh& mesh_a, const ShapeOutline& shape_b,
+    const std::optional<MeshToShapeTransforms>& transforms, float epsilon,
+    Executor& executor) {
+  // For each coat of `mesh_a`, we compute a new mutable mesh representing the
+  // coat minus `shape_b`. Then we assemble the resulting coats into a
+  // PartitionedMesh.
+  uint32_t num_groups = mesh_a.RenderGroupCount();
+
+  // If `shape_b` doesn't come near any triangle, then `mesh_a` is unchanged,
+  // and there is no need to rebuild it. This is common when erasing
+  // incrementally, where each part of the eraser touches few strokes.
+  std::vector<std::vector<TriangleFragments>> group_fragments(num_groups);
+  bool any_fragments = false;
+  for (uint32_t group = 0; group < num_groups; ++group) {
+    group_fragments[group] = ComputeTriangleFragments(
+        mesh_a.RenderGroupMeshes(group), shape_b, transforms, executor);
+    any_fragments = any_fragments || !group_fragments[group].empty();
+  }
+  if (!any_fragments) return mesh_a;
+
+  std::vector<SubtractedMesh> subtracted_groups;
+  subtracted_groups.reserve(num_groups);
+  for (uint32_t group = 0; group < num_groups; ++group) {
+    // Each coat is handled independently.
+    subtracted_groups.push_back(SubtractMeshes(
+        mesh_a.RenderGroupMeshes(group), mesh_a.RenderGroupFormat(group),
+        std::move(group_fragments[group]), epsilon));
+  }
+  return AssembleMesh(mesh_a, absl::MakeSpan(subtracted_groups));
+}
+
 }  // namespace
 
-absl::StatusOr<PartitionedMesh> Subtract(const PartitionedMesh& mesh_a,
-                                         const AffineTransform& transform_a,
-                                         const PartitionedMesh& mesh_b,
-                                         const AffineTransform& transform_b,
-                                         float epsilon) {
-  // The approach in this function is to first compute a silhouette of `mesh_b`.
-  // Then, for each coat of `mesh_a`, we compute a new mutable mesh representing
-  // for the coat minus the silhouette of b. Finally, we assemble the resulting
-  // coats into a PartitionedMesh.
+absl::StatusOr<PartitionedMesh> Subtract(
+    const PartitionedMesh& mesh_a, const AffineTransform& transform_a,
+    const PartitionedMesh& mesh_b, const AffineTransform& transform_b,
+    float epsilon, Executor& executor) {
+  // The approach in this function is to first compute a silhouette of `mesh_b`
+  // in `mesh_a`'s coordinates, and then subtract it from each coat of `mesh_a`.
 
   std::optional<AffineTransform> inv_transform_a = transform_a.Inverse();
   if (!inv_transform_a.has_value())
@@ -534,37 +806,297 @@ absl::StatusOr<PartitionedMesh> Subtract(const PartitionedMesh& mesh_a,
   AffineTransform b_to_a = *inv_transform_a * transform_b;
   ShapeOutline shape_b = GetShapeB(mesh_b, b_to_a, epsilon);
 
-  uint32_t num_groups = mesh_a.RenderGroupCount();
+  return SubtractShape(mesh_a, shape_b, std::nullopt, epsilon, executor);
+}
 
-  std::vector<PartitionedMesh::MutableMeshGroup> groups(num_groups);
-  std::vector<MutableMesh> group_mutable_meshes(num_groups);
-  std::vector<std::vector<std::vector<uint32_t>>> groups_outlines(num_groups);
-  std::vector<std::vector<absl::Span<const uint32_t>>> groups_outline_spans(
-      num_groups);
-  std::vector<StrokeVertex::CustomPackingArray> packing_arrays(num_groups);
+absl::StatusOr<ShapeOutline> ComputeMaskOutline(
+    const PartitionedMesh& mesh, const AffineTransform& transform,
+    float epsilon) {
+  if (!transform.Inverse().has_value())
+    return absl::InvalidArgumentError("transform must be invertible.");
+  return GetShapeB(mesh, transform, epsilon);
+}
 
-  for (uint32_t group = 0; group < num_groups; ++group) {
-    // Each coat is handled independently.
-    const MeshFormat& format = mesh_a.RenderGroupFormat(group);
-    SubtractedMesh subtracted = SubtractMeshes(mesh_a.RenderGroupMeshes(group),
-                                               format, shape_b, epsilon);
+absl::StatusOr<PartitionedMesh> Subtract(const PartitionedMesh& mesh_a,
+                                         const AffineTransform& transform_a,
+                                         const ShapeOutline& mask,
+                                         float epsilon, Executor& executor) {
+  if (!transform_a.Inverse().has_value())
+    return absl::InvalidArgumentError("transform_a must be invertible.");
 
-    group_mutable_meshes[group] = std::move(subtracted.mesh);
-    groups_outlines[group] = std::move(subtracted.outlines);
-    for (const std::vector<uint32_t>& outline : groups_outlines[group]) {
-      groups_outline_spans[group].push_back(outline);
+  return SubtractShape(mesh_a, mask, GetMeshToShapeTransforms(transform_a),
+                       epsilon, executor);
+}
+
+namespace {
+
+// The triangles that a triangle of the original mesh has been split into, as
+// triples of vertex indices within its render group.
+using TrianglePieces = absl::InlinedVector<std::array<uint32_t, 3>, 4>;
+
+// A piece of a triangle of the original mesh whose bounds intersect a mask,
+// identified by the index of its render group, the index of its mesh within
+// the group, the index of the triangle within the mesh, and its index among
+// the triangle's pieces.
+struct AffectedPiece {
+  uint32_t group_index;
+  uint32_t mesh_index;
+  uint32_t triangle_index;
+  uint32_t piece_index;
+  Triangle triangle;
+  Triangulation fragments;
+};
+
+bool IsSameTriangle(const AffectedPiece& a, const AffectedPiece& b) {
+  return a.group_index == b.group_index && a.mesh_index == b.mesh_index &&
+         a.triangle_index == b.triangle_index;
+}
+
+}  // namespace
+
+// The vertices of a render group are numbered consecutively across its meshes,
+// followed by the vertices added by the subtractions, as they are in the mesh
+// returned by `Build`.
+class IncrementalSubtraction::RenderGroup {
+ public:
+  // `meshes` must outlive this object; this is the case for the meshes of a
+  // `PartitionedMesh`, which are shared by its copies.
+  RenderGroup(absl::Span<const Mesh> meshes, const MeshFormat& format)
+      : meshes_(meshes), new_vertices_(format) {
+    first_vertex_indices_.reserve(meshes.size());
+    first_triangle_indices_.reserve(meshes.size());
+    uint32_t n_triangles = 0;
+    for (const Mesh& mesh : meshes) {
+      first_vertex_indices_.push_back(original_vertex_count_);
+      first_triangle_indices_.push_back(n_triangles);
+      original_vertex_count_ += mesh.VertexCount();
+      n_triangles += mesh.TriangleCount();
+    }
+    new_vertices_ = MeshBuilder(format, original_vertex_count_);
+    boundary_.resize(original_vertex_count_);
+    for (uint32_t m = 0; m < meshes.size(); ++m) {
+      for (uint32_t t = 0; t < meshes[m].TriangleCount(); ++t) {
+        AddToBoundary(OriginalTriangle(m, t), boundary_);
+      }
     }
+  }
 
-    packing_arrays[group] = StrokeVertex::MakeCustomPackingArray(format);
+  const MeshFormat& Format() const { return new_vertices_.GetMesh().Format(); }
 
-    groups[group] = PartitionedMesh::MutableMeshGroup{
-        .mesh = &group_mutable_meshes[group],
-        .outlines = groups_outline_spans[group],
-        .packing_params = packing_arrays[group].Values(),
-    };
+  Point VertexPosition(uint32_t v) const {
+    if (v >= original_vertex_count_) {
+      return new_vertices_.GetMesh().VertexPosition(v - original_vertex_count_);
+    }
+    uint32_t m = MeshIndexOfVertex(v);
+    return meshes_[m].VertexPosition(v - first_vertex_indices_[m]);
   }
 
-  return PartitionedMesh::FromMutableMeshGroups(groups);
+  SmallArray<float, 4> FloatVertexAttribute(uint32_t v, uint32_t attr) const {
+    if (v >= original_vertex_count_) {
+      return new_vertices_.GetMesh().FloatVertexAttribute(
+          v - original_vertex_count_, attr);
+    }
+    uint32_t m = MeshIndexOfVertex(v);
+    return meshes_[m].FloatVertexAttribute(v - first_vertex_indices_[m], attr);
+  }
+
+  Triangle GetTriangle(const std::array<uint32_t, 3>& piece) const {
+    return {VertexPosition(piece[0]), VertexPosition(piece[1]),
+            VertexPosition(piece[2])};
+  }
+
+  // Returns the current pieces of triangle `t` of mesh `m`.
+  TrianglePieces Pieces(uint32_t m, uint32_t t) const {
+    auto it = split_triangles_.find(first_triangle_indices_[m] + t);
+    if (it != split_triangles_.end()) return it->second;
+    return {OriginalTriangle(m, t)};
+  }
+
+  // Replaces the `affected` pieces of triangle `t` of mesh `m`, which are
+  // ordered by piece index, with their fragments.
+  void SplitPieces(uint32_t m, uint32_t t,
+                   absl::Span<const AffectedPiece> affected, float epsilon) {
+    TrianglePieces old_pieces = Pieces(m, t);
+    TrianglePieces new_pieces;
+    auto next_affected = affected.begin();
+    for (uint32_t i = 0; i < old_pieces.size(); ++i) {
+      const std::array<uint32_t, 3>& piece = old_pieces[i];
+      if (next_affected == affected.end() || next_affected->piece_index != i) {
+        new_pieces.push_back(piece);
+        continue;
+      }
+      const AffectedPiece& affected_piece = *next_affected++;
+      RemoveFromBoundary(piece, boundary_);
+      if (affected_piece.fragments.triangles.empty()) continue;
+      AddFragments(
+          affected_piece.triangle, affected_piece.fragments, piece,
+          GetTriangleAttributes(*this, piece), epsilon, new_vertices_,
+          [this, &new_pieces](const std::array<uint32_t, 3>& fragment) {
+            boundary_.resize(original_vertex_count_ +
+                             new_vertices_.GetMesh().VertexCount());
+            AddToBoundary(fragment, boundary_);
+            new_pieces.push_back(fragment);
+          });
+    }
+    ABSL_DCHECK(next_affected == affected.end());
+    split_triangles_[first_triangle_indices_[m] + t] = std::move(new_pieces);
+  }
+
+  // Returns the subtracted mesh for the render group, with the pieces of each
+  // triangle in place of the triangle.
+  SubtractedMesh Build() const {
+    MeshBuilder builder(Format());
+    for (const Mesh& mesh : meshes_) {
+      for (uint32_t i = 0; i < mesh.VertexCount(); ++i) {
+        builder.CopyVertex(mesh, i);
+      }
+    }
+    const MutableMesh& new_vertices = new_vertices_.GetMesh();
+    for (uint32_t i = 0; i < new_vertices.VertexCount(); ++i) {
+      builder.CopyVertex(new_vertices, i);
+    }
+    for (uint32_t m = 0; m < meshes_.size(); ++m) {
+      for (uint32_t t = 0; t < meshes_[m].TriangleCount(); ++t) {
+        auto it = split_triangles_.find(first_triangle_indices_[m] + t);
+        if (it == split_triangles_.end()) {
+          builder.AddTriangle(OriginalTriangle(m, t));
+          continue;
+        }
+        for (const std::array<uint32_t, 3>& piece : it->second) {
+          builder.AddTriangle(piece);
+        }
+      }
+    }
+    return SubtractedMesh{.mesh = std::move(builder).ExtractMesh(),
+                          .outlines = TraceOutlines(boundary_)};
+  }
+
+ private:
+  uint32_t MeshIndexOfVertex(uint32_t v) const {
+    return absl::c_upper_bound(first_vertex_indices_, v) -
+           first_vertex_indices_.begin() - 1;
+  }
+
+  std::array<uint32_t, 3> OriginalTriangle(uint32_t m, uint32_t t) const {
+    std::array<uint32_t, 3> indices = meshes_[m].TriangleIndices(t);
+    for (uint32_t& index : indices) index += first_vertex_indices_[m];
+    return indices;
+  }
+
+  absl::Span<const Mesh> meshes_;
+  std::vector<uint32_t> first_vertex_indices_;
+  std::vector<uint32_t> first_triangle_indices_;
+  uint32_t original_vertex_count_ = 0;
+  // Holds the vertices added by the subtractions, and welds the pieces of
+  // adjacent triangles together along their shared edges.
+  MeshBuilder new_vertices_;
+  // The pieces of each triangle that has been split, keyed by its index across
+  // the meshes of the group. Triangles that have been entirely erased have no
+  // pieces.
+  absl::flat_hash_map<uint32_t, TrianglePieces> split_triangles_;
+  // The boundary of all of the current pieces.
+  Boundary boundary_;
+};
+
+IncrementalSubtraction::IncrementalSubtraction(const PartitionedMesh& mesh,
+                                               float epsilon)
+    : mesh_(mesh), epsilon_(epsilon) {}
+
+IncrementalSubtraction::IncrementalSubtraction(const IncrementalSubtraction&) =
+    default;
+IncrementalSubtraction::IncrementalSubtraction(IncrementalSubtraction&&) =
+    default;
+IncrementalSubtraction& IncrementalSubtraction::operator=(
+    const IncrementalSubtraction&) = default;
+IncrementalSubtraction& IncrementalSubtraction::operator=(
+    IncrementalSubtraction&&) = default;
+IncrementalSubtraction::~IncrementalSubtraction() = default;
+
+bool IncrementalSubtraction::Subtract(const ShapeOutline& mask,
+                                      Executor& executor) {
+  Envelope mask_bounds;
+  for (const geometry_internal::MonotoneChain& chain : mask.Chains()) {
+    mask_bounds.Add(chain.Bounds());
+  }
+  if (!mask_bounds.AsRect().has_value()) return false;
+
+  // Every piece lies within its original triangle, so only the pieces of the
+  // triangles found with the spatial index can intersect `mask`.
+  std::vector<TriangleIndexPair> candidates;
+  mesh_.VisitIntersectedTriangles(
+      *mask_bounds.AsRect(), [&candidates](TriangleIndexPair index) {
+        candidates.push_back(index);
+        return PartitionedMesh::FlowControl::kContinue;
+      });
+  if (candidates.empty()) return false;
+
+  if (groups_.empty()) {
+    groups_.reserve(mesh_.RenderGroupCount());
+    for (uint32_t g = 0; g < mesh_.RenderGroupCount(); ++g) {
+      groups_.emplace_back(mesh_.RenderGroupMeshes(g),
+                           mesh_.RenderGroupFormat(g));
+    }
+  }
+
+  // The candidates are in an arbitrary order, so sort them to make the order
+  // in which vertices are added deterministic. Sorting by the index across all
+  // meshes also sorts them by render group.
+  absl::c_sort(candidates, [](TriangleIndexPair a, TriangleIndexPair b) {
+    return std::tie(a.mesh_index, a.triangle_index) <
+           std::tie(b.mesh_index, b.triangle_index);
+  });
+  std::vector<AffectedPiece> affected;
+  uint32_t group_index = 0;
+  uint32_t group_first_mesh_index = 0;
+  for (TriangleIndexPair candidate : candidates) {
+    while (candidate.mesh_index - group_first_mesh_index >=
+           mesh_.RenderGroupMeshes(group_index).size()) {
+      group_first_mesh_index += mesh_.RenderGroupMeshes(group_index).size();
+      ++group_index;
+    }
+    const RenderGroup& group = groups_[group_index];
+    uint32_t mesh_index = candidate.mesh_index - group_first_mesh_index;
+    TrianglePieces pieces = group.Pieces(mesh_index, candidate.triangle_index);
+    for (uint32_t i = 0; i < pieces.size(); ++i) {
+      Triangle tri = group.GetTriangle(pieces[i]);
+      if (!Intersects(mask, Envelope(tri).AsRect().value())) continue;
+      affected.push_back({.group_index = group_index,
+                          .mesh_index = mesh_index,
+                          .triangle_index = candidate.triangle_index,
+                          .piece_index = i,
+                          .triangle = tri});
+    }
+  }
+  if (affected.empty()) return false;
+  has_changed_ = true;
+
+  executor.ParallelFor(affected.size(), [&affected, &mask](size_t i) {
+    affected[i].fragments = SubtractTriangle(affected[i].triangle, mask);
+  });
+
+  absl::Span<const AffectedPiece> remaining = absl::MakeConstSpan(affected);
+  while (!remaining.empty()) {
+    size_t n = 1;
+    while (n < remaining.size() && IsSameTriangle(remaining[0], remaining[n])) {
+      ++n;
+    }
+    const AffectedPiece& first = remaining[0];
+    groups_[first.group_index].SplitPieces(
+        first.mesh_index, first.triangle_index, remaining.subspan(0, n),
+        epsilon_);
+    remaining.remove_prefix(n);
+  }
+  return true;
+}
+
+absl::StatusOr<PartitionedMesh> IncrementalSubtraction::BuildMesh() const {
+  if (!has_changed_) return mesh_;
+  std::vector<SubtractedMesh> subtracted_groups;
+  subtracted_groups.reserve(groups_.size());
+  for (const RenderGroup& group : groups_) {
+    subtracted_groups.push_back(group.Build());
+  }
+  return AssembleMesh(mesh_, absl::MakeSpan(subtracted_groups));
 }
 
 }  // namespace ink::strokes_internal
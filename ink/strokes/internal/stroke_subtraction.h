@@ -15,9 +15,13 @@
 #ifndef INK_STROKES_INTERNAL_STROKE_SUBTRACTION_H_
 #define INK_STROKES_INTERNAL_STROKE_SUBTRACTION_H_
 
+#include <vector>
+
 #include "absl/status/statusor.h"
 #include "ink/geometry/affine_transform.h"
+#include "ink/geometry/internal/outline_processing.h"
 #include "ink/geometry/partitioned_mesh.h"
+#include "ink/types/executor.h"
 
 namespace ink::strokes_internal {
 
@@ -43,12 +47,104 @@ namespace ink::strokes_internal {
 // input mesh. The attributes of vertices in the returned mesh are obtained
 // by linearly interpolating the attributes of the input mesh, except for
 // anti-aliasing attributes (kSideLabel, kSideDerivative, kForwardLabel,
-// kForwardDerivative), which are set to default values.
-absl::StatusOr<PartitionedMesh> Subtract(const PartitionedMesh& mesh_a,
-                                         const AffineTransform& transform_a,
-                                         const PartitionedMesh& mesh_b,
-                                         const AffineTransform& transform_b,
-                                         float epsilon);
+// kForwardDerivative), which are set to default values. If `mesh_b` doesn't
+// intersect the bounds of any triangle of `mesh_a`, then `mesh_a` is returned
+// as is, sharing its meshes.
+//
+// The subtraction of each triangle of `mesh_a` is computed in chunks on
+// `executor`, and the results are then welded together in the order of the
+// triangles, so the returned mesh does not depend on the executor.
+absl::StatusOr<PartitionedMesh> Subtract(
+    const PartitionedMesh& mesh_a, const AffineTransform& transform_a,
+    const PartitionedMesh& mesh_b, const AffineTransform& transform_b,
+    float epsilon, Executor& executor = SerialExecutor());
+
+// Returns the silhouette of `mesh` when transformed by `transform`, for use as
+// the `mask` of the overload of `Subtract` below. This is the part of
+// `Subtract` that depends only on `mesh_b`, so computing it once lets one mask
+// be subtracted from many meshes. Consecutive outline points closer than
+// `epsilon` (in the transformed coordinate space) are merged.
+//
+// Returns an error if `transform` is not invertible.
+absl::StatusOr<geometry_internal::ShapeOutline> ComputeMaskOutline(
+    const PartitionedMesh& mesh, const AffineTransform& transform,
+    float epsilon);
+
+// As above, but subtracts a `mask` from `ComputeMaskOutline`, where
+// `transform_a` maps `mesh_a` into the coordinate space of `mask`. `mask` is
+// only read, so the same mask may be subtracted from several meshes at once on
+// different threads.
+//
+// If `transform_a` is the identity, this computes the same mesh as the overload
+// above does with `mesh_b` and `transform_b` as passed to
+// `ComputeMaskOutline`. Otherwise, each triangle of `mesh_a` is mapped into the
+// coordinates of `mask` to be subtracted, and the resulting vertices are mapped
+// back, so they may differ from the above by rounding error. Vertices within
+// `epsilon` of the original triangle's vertices and edges are snapped to them,
+// as usual.
+//
+// Returns an error if `transform_a` is not invertible.
+absl::StatusOr<PartitionedMesh> Subtract(
+    const PartitionedMesh& mesh_a, const AffineTransform& transform_a,
+    const geometry_internal::ShapeOutline& mask, float epsilon,
+    Executor& executor = SerialExecutor());
+
+// Subtracts a sequence of masks from a `PartitionedMesh` one at a time, as for
+// the segments of a partial eraser gesture, without redoing the work for the
+// whole mesh for each mask as `Subtract` does.
+//
+// This keeps the state of the subtraction between masks: the vertices added so
+// far, the pieces that each touched triangle of the original mesh has been
+// split into, and the boundary edges from which the outlines are traced. Every
+// piece lies within its original triangle, so the spatial index of the
+// original mesh can be used to find the pieces near each mask, and a call to
+// `Subtract` only does work for those. The result is only assembled into a
+// `PartitionedMesh` when it is requested.
+//
+// Since subtracting the masks one at a time removes their union, the result
+// covers the same region as subtracting all of them at once, but it may be
+// triangulated differently.
+class IncrementalSubtraction {
+ public:
+  // Starts subtracting from `mesh`, where `epsilon` is as for `Subtract`. The
+  // masks are expected to be in the coordinate space of `mesh`.
+  IncrementalSubtraction(const PartitionedMesh& mesh, float epsilon);
+
+  IncrementalSubtraction(const IncrementalSubtraction&);
+  IncrementalSubtraction(IncrementalSubtraction&&);
+  IncrementalSubtraction& operator=(const IncrementalSubtraction&);
+  IncrementalSubtraction& operator=(IncrementalSubtraction&&);
+  ~IncrementalSubtraction();
+
+  // Subtracts `mask` from the result so far. The pieces of the affected
+  // triangles are computed on `executor`, and then spliced in serially, so
+  // the result does not depend on the executor. Returns false if `mask`
+  // doesn't intersect the bounds of any piece, in which case the result is
+  // unchanged.
+  bool Subtract(const geometry_internal::ShapeOutline& mask,
+                Executor& executor = SerialExecutor());
+
+  // Returns true if any call to `Subtract` has changed the result.
+  bool HasChanged() const { return has_changed_; }
+
+  // Assembles the result of the subtractions so far into a `PartitionedMesh`,
+  // which takes time proportional to the size of the mesh. If nothing has
+  // changed, this returns the original mesh as is, sharing its meshes.
+  absl::StatusOr<PartitionedMesh> BuildMesh() const;
+
+ private:
+  // The state of the subtraction for one render group. This is defined in the
+  // .cc file.
+  class RenderGroup;
+
+  PartitionedMesh mesh_;
+  float epsilon_;
+  bool has_changed_ = false;
+  // The state for each render group of `mesh_`. This is empty until the first
+  // call to `Subtract` that comes near the mesh, since it takes time
+  // proportional to the size of the mesh to set up.
+  std::vector<RenderGroup> groups_;
+};
 
 }  // namespace ink::strokes_internal
 
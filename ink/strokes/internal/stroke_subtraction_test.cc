@@ -24,12 +24,17 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "fuzztest/fuzztest.h"
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
 #include "absl/status/statusor.h"
 #include "ink/geometry/affine_transform.h"
+#include "ink/geometry/angle.h"
 #include "ink/geometry/fuzz_domains.h"
 #include "ink/geometry/internal/algorithms.h"
+#include "ink/geometry/internal/outline_processing.h"
 #include "ink/geometry/internal/test_matchers.h"
+#include "ink/geometry/mesh.h"
 #include "ink/geometry/mesh_format.h"
 #include "ink/geometry/mesh_test_helpers.h"
 #include "ink/geometry/mutable_mesh.h"
@@ -37,12 +42,15 @@
 #include "ink/geometry/point.h"
 #include "ink/geometry/rect.h"
 #include "ink/geometry/triangle.h"
+#include "ink/geometry/type_matchers.h"
+#include "ink/types/executor.h"
 #include "ink/types/small_array.h"
 
 namespace ink::strokes_internal {
 namespace {
 
 using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
 using ::ink::geometry_internal::IsCyclicPermutationOf;
 using ::testing::ElementsAre;
 using ::testing::FloatEq;
@@ -87,6 +95,64 @@ uint32_t NumTriangles(const PartitionedMesh& partitioned_mesh) {
   return count;
 }
 
+// Returns the total (signed) area of the triangles of `partitioned_mesh`, and
+// checks that none of them are clockwise.
+float TotalAreaOfCounterClockwiseTriangles(
+    const PartitionedMesh& partitioned_mesh) {
+  float area = 0;
+  for (const Mesh& mesh : partitioned_mesh.Meshes()) {
+    for (uint32_t i = 0; i < mesh.TriangleCount(); ++i) {
+      float triangle_area = mesh.GetTriangle(i).SignedArea();
+      EXPECT_GE(triangle_area, -kFloatTolerance) << "at triangle " << i;
+      area += triangle_area;
+    }
+  }
+  return area;
+}
+
+// Returns a single-coat `PartitionedMesh` covering the rectangle from `min` to
+// `max`, with an outline.
+PartitionedMesh MakeRectPartitionedMesh(Point min, Point max) {
+  MutableMesh mesh(MeshFormat{});
+  for (Point p : {min, Point{max.x, min.y}, max, Point{min.x, max.y}}) {
+    mesh.AppendVertex(p);
+  }
+  mesh.AppendTriangleIndices({0, 1, 2});
+  mesh.AppendTriangleIndices({0, 2, 3});
+  std::vector<uint32_t> outline = {0, 3, 2, 1};
+  absl::StatusOr<PartitionedMesh> partitioned_mesh =
+      PartitionedMesh::FromMutableMesh(mesh, {{outline}});
+  ABSL_CHECK_OK(partitioned_mesh);
+  return *std::move(partitioned_mesh);
+}
+
+// Expects `actual` to have exactly the same vertices, triangles, and outlines
+// as `expected`.
+void ExpectIdenticalMeshes(const PartitionedMesh& actual,
+                           const PartitionedMesh& expected) {
+  ASSERT_EQ(actual.Meshes().size(), expected.Meshes().size());
+  for (size_t m = 0; m < actual.Meshes().size(); ++m) {
+    const Mesh& actual_mesh = actual.Meshes()[m];
+    const Mesh& expected_mesh = expected.Meshes()[m];
+    ASSERT_EQ(actual_mesh.VertexCount(), expected_mesh.VertexCount());
+    for (uint32_t i = 0; i < actual_mesh.VertexCount(); ++i) {
+      EXPECT_EQ(actual_mesh.VertexPosition(i), expected_mesh.VertexPosition(i))
+          << "at vertex " << i;
+    }
+    ASSERT_EQ(actual_mesh.TriangleCount(), expected_mesh.TriangleCount());
+    for (uint32_t i = 0; i < actual_mesh.TriangleCount(); ++i) {
+      EXPECT_EQ(actual_mesh.TriangleIndices(i),
+                expected_mesh.TriangleIndices(i))
+          << "at triangle " << i;
+    }
+  }
+  ASSERT_EQ(actual.OutlineCount(0), expected.OutlineCount(0));
+  for (uint32_t i = 0; i < actual.OutlineCount(0); ++i) {
+    EXPECT_EQ(GetOutlinePoints(actual, 0, i), GetOutlinePoints(expected, 0, i))
+        << "at outline " << i;
+  }
+}
+
 // Returns the index of a vertex in `mesh` that is near the point `p` if exists.
 std::optional<uint32_t> FindVertexIndex(const Mesh& mesh, Point p) {
   for (uint32_t i = 0; i < mesh.VertexCount(); ++i) {
@@ -169,6 +235,8 @@ TEST(StrokeSubtractionTest, Disjoint) {
 
   EXPECT_EQ(NumTriangles(*result), 1);
   EXPECT_EQ(NumVertices(*result), 3);
+  // Since `mesh_b` doesn't touch `mesh_a`, `mesh_a` is returned as is.
+  EXPECT_THAT(*result, PartitionedMeshShallowEq(*mesh_a_pm));
 }
 
 TEST(StrokeSubtractionTest, TriangleMinusTriangle) {
@@ -706,6 +774,205 @@ TEST(StrokeSubtractionTest, EpsilonDeduplication) {
       IsCyclicPermutationOf(std::vector<Point>{B, X0, E, X1, C}, epsilon));
 }
 
+TEST(StrokeSubtractionTest, ThreadExecutorMatchesSerialExecutor) {
+  // mesh_a is a long strip of triangles, enough to be split across several
+  // tasks, and mesh_b is a rectangle that covers half of the width of the strip
+  // along most of its length.
+  PartitionedMesh mesh_a = MakeStraightLinePartitionedMesh(5000);
+  PartitionedMesh mesh_b =
+      MakeRectPartitionedMesh({500.3, -0.55}, {4600.7, 0.45});
+
+  absl::StatusOr<PartitionedMesh> serial =
+      Subtract(mesh_a, AffineTransform::Identity(), mesh_b,
+               AffineTransform::Identity(), 0.01f);
+  ASSERT_THAT(serial, IsOk());
+  ThreadExecutor executor(4);
+  absl::StatusOr<PartitionedMesh> parallel =
+      Subtract(mesh_a, AffineTransform::Identity(), mesh_b,
+               AffineTransform::Identity(), 0.01f, executor);
+  ASSERT_THAT(parallel, IsOk());
+
+  EXPECT_GT(NumTriangles(*serial), NumTriangles(mesh_a));
+  ExpectIdenticalMeshes(*parallel, *serial);
+}
+
+TEST(StrokeSubtractionTest, MaskOutlineMatchesMeshInSameCoordinates) {
+  PartitionedMesh mesh_a = MakeStraightLinePartitionedMesh(100);
+  PartitionedMesh mesh_b = MakeRectPartitionedMesh({0, 0}, {40.4, 1});
+  AffineTransform transform_b =
+      AffineTransform::Translate({20.3, -0.55}) * AffineTransform::Scale(1, 2);
+
+  absl::StatusOr<geometry_internal::ShapeOutline> mask =
+      ComputeMaskOutline(mesh_b, transform_b, 0.01f);
+  ASSERT_THAT(mask, IsOk());
+  absl::StatusOr<PartitionedMesh> with_mask =
+      Subtract(mesh_a, AffineTransform::Identity(), *mask, 0.01f);
+  ASSERT_THAT(with_mask, IsOk());
+  absl::StatusOr<PartitionedMesh> with_mesh = Subtract(
+      mesh_a, AffineTransform::Identity(), mesh_b, transform_b, 0.01f);
+  ASSERT_THAT(with_mesh, IsOk());
+
+  EXPECT_GT(NumTriangles(*with_mesh), NumTriangles(mesh_a));
+  ExpectIdenticalMeshes(*with_mask, *with_mesh);
+}
+
+TEST(StrokeSubtractionTest, MaskOutlineWithTransformedMesh) {
+  PartitionedMesh mesh_a = MakeStraightLinePartitionedMesh(100);
+  PartitionedMesh mesh_b =
+      MakeRectPartitionedMesh({20.3, -0.55}, {60.7, 0.45});
+  absl::StatusOr<PartitionedMesh> expected = Subtract(
+      mesh_a, AffineTransform::Identity(), mesh_b, AffineTransform(), 0.01f);
+  ASSERT_THAT(expected, IsOk());
+  float expected_area = TotalAreaOfCounterClockwiseTriangles(*expected);
+
+  // Moving both meshes by the same transform gives the same result in
+  // `mesh_a`'s coordinates, up to rounding, including for transforms that flip
+  // orientation.
+  for (const AffineTransform& transform :
+       {AffineTransform::Translate({3, 1}) *
+            AffineTransform::Rotate(Angle::Degrees(30)),
+        AffineTransform::Scale(-2, 1)}) {
+    absl::StatusOr<geometry_internal::ShapeOutline> mask =
+        ComputeMaskOutline(mesh_b, transform, 0.01f);
+    ASSERT_THAT(mask, IsOk());
+    absl::StatusOr<PartitionedMesh> actual =
+        Subtract(mesh_a, transform, *mask, 0.01f);
+    ASSERT_THAT(actual, IsOk());
+
+    EXPECT_EQ(NumTriangles(*actual), NumTriangles(*expected));
+    EXPECT_THAT(TotalAreaOfCounterClockwiseTriangles(*actual),
+                FloatNear(expected_area, 1e-3));
+    ASSERT_EQ(actual->OutlineCount(0), expected->OutlineCount(0));
+  }
+}
+
+TEST(StrokeSubtractionTest, MaskTransformThatFlipsOrientation) {
+  PartitionedMesh mesh_a = MakeStraightLinePartitionedMesh(100);
+  absl::StatusOr<PartitionedMesh> expected =
+      Subtract(mesh_a, AffineTransform::Identity(),
+               MakeRectPartitionedMesh({20.3, -0.55}, {60.7, 0.45}),
+               AffineTransform::Identity(), 0.01f);
+  ASSERT_THAT(expected, IsOk());
+
+  // The same mask, mirrored, and then mirrored back by its transform.
+  absl::StatusOr<PartitionedMesh> actual =
+      Subtract(mesh_a, AffineTransform::Identity(),
+               MakeRectPartitionedMesh({-60.7, -0.55}, {-20.3, 0.45}),
+               AffineTransform::Scale(-1, 1), 0.01f);
+  ASSERT_THAT(actual, IsOk());
+
+  EXPECT_EQ(NumTriangles(*actual), NumTriangles(*expected));
+  EXPECT_THAT(TotalAreaOfCounterClockwiseTriangles(*actual),
+              FloatNear(TotalAreaOfCounterClockwiseTriangles(*expected), 1e-3));
+}
+
+TEST(StrokeSubtractionTest, MaskOutlineWithNonInvertibleTransform) {
+  PartitionedMesh mesh_a = MakeStraightLinePartitionedMesh(10);
+  PartitionedMesh mesh_b = MakeRectPartitionedMesh({2, -1}, {4, 1});
+  EXPECT_THAT(ComputeMaskOutline(mesh_b, AffineTransform::Scale(0), 0.01f),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  absl::StatusOr<geometry_internal::ShapeOutline> mask =
+      ComputeMaskOutline(mesh_b, AffineTransform(), 0.01f);
+  ASSERT_THAT(mask, IsOk());
+  EXPECT_THAT(Subtract(mesh_a, AffineTransform::Scale(0), *mask, 0.01f),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+// Returns the mask for the rectangle from `min` to `max`, in the coordinates of
+// the rectangle.
+geometry_internal::ShapeOutline MakeRectMask(Point min, Point max) {
+  absl::StatusOr<geometry_internal::ShapeOutline> mask = ComputeMaskOutline(
+      MakeRectPartitionedMesh(min, max), AffineTransform(), 0.01f);
+  ABSL_CHECK_OK(mask);
+  return *std::move(mask);
+}
+
+TEST(IncrementalSubtractionTest, CoversSameRegionAsSubtractingEachMask) {
+  PartitionedMesh mesh = MakeStraightLinePartitionedMesh(200);
+  std::vector<geometry_internal::ShapeOutline> masks = {
+      MakeRectMask({20.3, -0.55}, {40.7, 0.45}),
+      MakeRectMask({35.1, -0.25}, {60.2, 2}),
+      MakeRectMask({120.5, -2}, {130.5, 2})};
+
+  IncrementalSubtraction subtraction(mesh, 0.01f);
+  PartitionedMesh expected = mesh;
+  for (const geometry_internal::ShapeOutline& mask : masks) {
+    EXPECT_TRUE(subtraction.Subtract(mask));
+    absl::StatusOr<PartitionedMesh> subtracted =
+        Subtract(expected, AffineTransform(), mask, 0.01f);
+    ASSERT_THAT(subtracted, IsOk());
+    expected = *std::move(subtracted);
+  }
+  EXPECT_TRUE(subtraction.HasChanged());
+  absl::StatusOr<PartitionedMesh> actual = subtraction.BuildMesh();
+  ASSERT_THAT(actual, IsOk());
+
+  EXPECT_THAT(TotalAreaOfCounterClockwiseTriangles(*actual),
+              FloatNear(TotalAreaOfCounterClockwiseTriangles(expected), 1e-3));
+  ASSERT_EQ(actual->OutlineCount(0), expected.OutlineCount(0));
+  for (uint32_t i = 0; i < actual->OutlineCount(0); ++i) {
+    EXPECT_EQ(actual->OutlineVertexCount(0, i),
+              expected.OutlineVertexCount(0, i))
+        << "at outline " << i;
+  }
+}
+
+TEST(IncrementalSubtractionTest, MaskThatMissesMeshLeavesItUnchanged) {
+  PartitionedMesh mesh = MakeStraightLinePartitionedMesh(100);
+  IncrementalSubtraction subtraction(mesh, 0.01f);
+  EXPECT_FALSE(subtraction.Subtract(MakeRectMask({20, 5}, {40, 6})));
+  EXPECT_FALSE(subtraction.HasChanged());
+
+  absl::StatusOr<PartitionedMesh> result = subtraction.BuildMesh();
+  ASSERT_THAT(result, IsOk());
+  EXPECT_THAT(*result, PartitionedMeshShallowEq(mesh));
+}
+
+TEST(IncrementalSubtractionTest, MaskOverErasedRegionChangesNothing) {
+  PartitionedMesh mesh = MakeStraightLinePartitionedMesh(100);
+  IncrementalSubtraction subtraction(mesh, 0.01f);
+  EXPECT_TRUE(subtraction.Subtract(MakeRectMask({20.3, -2}, {40.7, 2})));
+  // The triangles under this mask have already been entirely erased.
+  EXPECT_FALSE(subtraction.Subtract(MakeRectMask({25.1, -1}, {35.2, 1})));
+}
+
+TEST(IncrementalSubtractionTest, CopyIsIndependent) {
+  PartitionedMesh mesh = MakeStraightLinePartitionedMesh(100);
+  IncrementalSubtraction subtraction(mesh, 0.01f);
+  ASSERT_TRUE(subtraction.Subtract(MakeRectMask({20.3, -2}, {40.7, 2})));
+  absl::StatusOr<PartitionedMesh> before = subtraction.BuildMesh();
+  ASSERT_THAT(before, IsOk());
+
+  IncrementalSubtraction copy = subtraction;
+  ASSERT_TRUE(copy.Subtract(MakeRectMask({60.3, -2}, {80.7, 2})));
+
+  absl::StatusOr<PartitionedMesh> after = subtraction.BuildMesh();
+  ASSERT_THAT(after, IsOk());
+  ExpectIdenticalMeshes(*after, *before);
+  absl::StatusOr<PartitionedMesh> copy_result = copy.BuildMesh();
+  ASSERT_THAT(copy_result, IsOk());
+  EXPECT_LT(NumTriangles(*copy_result), NumTriangles(*before));
+}
+
+TEST(IncrementalSubtractionTest, ThreadExecutorMatchesSerialExecutor) {
+  PartitionedMesh mesh = MakeStraightLinePartitionedMesh(5000);
+  geometry_internal::ShapeOutline mask =
+      MakeRectMask({500.3, -0.55}, {4600.7, 0.45});
+
+  IncrementalSubtraction serial(mesh, 0.01f);
+  ASSERT_TRUE(serial.Subtract(mask));
+  IncrementalSubtraction parallel(mesh, 0.01f);
+  ThreadExecutor executor(4);
+  ASSERT_TRUE(parallel.Subtract(mask, executor));
+
+  absl::StatusOr<PartitionedMesh> serial_result = serial.BuildMesh();
+  ASSERT_THAT(serial_result, IsOk());
+  absl::StatusOr<PartitionedMesh> parallel_result = parallel.BuildMesh();
+  ASSERT_THAT(parallel_result, IsOk());
+  ExpectIdenticalMeshes(*parallel_result, *serial_result);
+}
+
 void StrokeSubtractionDoesNotCrash(
     std::pair<Triangle, Triangle> outer_and_inner) {
   const auto& [outer, inner] = outer_and_inner;
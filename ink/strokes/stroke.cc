@@ -14,7 +14,9 @@
 
 #include "ink/strokes/stroke.h"
 
+#include <cmath>
 #include <cstddef>
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -24,12 +26,14 @@
 #include "absl/status/status.h"
 #include "absl/status/status_macros.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/substitute.h"
 #include "absl/types/span.h"
 #include "ink/brush/brush.h"
 #include "ink/brush/brush_coat.h"
 #include "ink/brush/brush_family.h"
 #include "ink/color/color.h"
 #include "ink/geometry/affine_transform.h"
+#include "ink/geometry/internal/outline_processing.h"
 #include "ink/geometry/mesh.h"
 #include "ink/geometry/partitioned_mesh.h"
 #include "ink/strokes/input/stroke_input_batch.h"
@@ -39,10 +43,12 @@
 #include "ink/strokes/internal/stroke_subtraction.h"
 #include "ink/strokes/internal/stroke_vertex.h"
 #include "ink/types/duration.h"
+#include "ink/types/executor.h"
 
 namespace ink {
 namespace {
 
+using ::ink::geometry_internal::ShapeOutline;
 using ::ink::strokes_internal::StrokeInputModeler;
 using ::ink::strokes_internal::StrokeShapeBuilder;
 using ::ink::strokes_internal::StrokeVertex;
@@ -209,21 +215,55 @@ void Stroke::RegenerateShape() {
   ABSL_DCHECK_EQ(shape_.RenderGroupCount(), brush_.CoatCount());
 }
 
+SubtractionMask::SubtractionMask()
+    : outline_(std::make_shared<const ShapeOutline>()) {}
+
+SubtractionMask::SubtractionMask(std::shared_ptr<const ShapeOutline> outline)
+    : outline_(std::move(outline)) {}
+
+absl::StatusOr<SubtractionMask> SubtractionMask::Create(
+    const PartitionedMesh& mask_shape, const AffineTransform& mask_transform,
+    float epsilon) {
+  if (!std::isfinite(epsilon) || epsilon <= 0) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "`epsilon` must be a finite and positive value. Received: $0",
+        epsilon));
+  }
+  absl::StatusOr<ShapeOutline> outline = strokes_internal::ComputeMaskOutline(
+      mask_shape, mask_transform, epsilon);
+  if (!outline.ok()) return outline.status();
+  return SubtractionMask(
+      std::make_shared<const ShapeOutline>(*std::move(outline)));
+}
+
 Stroke Stroke::Subtract(const PartitionedMesh& mask_shape,
                         const AffineTransform& mask_transform,
-                        const AffineTransform& stroke_transform) const {
+                        const AffineTransform& stroke_transform,
+                        Executor& executor) const {
   absl::StatusOr<PartitionedMesh> remaining_mesh =
       strokes_internal::Subtract(shape_, stroke_transform, mask_shape,
-                                 mask_transform, brush_.GetEpsilon());
+                                 mask_transform, brush_.GetEpsilon(), executor);
+  if (!remaining_mesh.ok()) return *this;
+
+  return Stroke(brush_, inputs_, *remaining_mesh);
+}
+
+Stroke Stroke::Subtract(const SubtractionMask& mask,
+                        const AffineTransform& stroke_transform,
+                        Executor& executor) const {
+  absl::StatusOr<PartitionedMesh> remaining_mesh =
+      strokes_internal::Subtract(shape_, stroke_transform, *mask.outline_,
+                                 brush_.GetEpsilon(), executor);
   if (!remaining_mesh.ok()) return *this;
 
   return Stroke(brush_, inputs_, *remaining_mesh);
 }
 
 std::vector<Stroke> Stroke::Split(const AffineTransform& stroke_transform,
-                                  float tolerance) const {
+                                  float tolerance, Executor& executor) const {
   absl::StatusOr<std::vector<PartitionedMesh>> partitioned_meshes =
-      strokes_internal::SegmentSpatially(shape_, stroke_transform, tolerance);
+      strokes_internal::SegmentSpatially(shape_, stroke_transform, tolerance,
+                                         executor);
   if (!partitioned_meshes.ok()) return {*this};
 
   std::vector<Stroke> results;
@@ -234,4 +274,17 @@ std::vector<Stroke> Stroke::Split(const AffineTransform& stroke_transform,
   return results;
 }
 
+std::vector<Stroke> SubtractFromStrokes(
+    absl::Span<const Stroke> strokes,
+    absl::Span<const AffineTransform> stroke_transforms,
+    const SubtractionMask& mask, Executor& executor) {
+  ABSL_CHECK_EQ(strokes.size(), stroke_transforms.size());
+  std::vector<Stroke> results(strokes.begin(), strokes.end());
+  executor.ParallelFor(strokes.size(), [&strokes, &stroke_transforms, &mask,
+                                        &results](size_t i) {
+    results[i] = strokes[i].Subtract(mask, stroke_transforms[i]);
+  });
+  return results;
+}
+
 }  // namespace ink
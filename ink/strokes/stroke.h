@@ -15,9 +15,12 @@
 #ifndef INK_STROKES_STROKE_H_
 #define INK_STROKES_STROKE_H_
 
+#include <memory>
 #include <vector>
 
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "ink/brush/brush.h"
 #include "ink/brush/brush_family.h"
 #include "ink/color/color.h"
@@ -25,9 +28,54 @@
 #include "ink/geometry/partitioned_mesh.h"
 #include "ink/strokes/input/stroke_input_batch.h"
 #include "ink/types/duration.h"
+#include "ink/types/executor.h"
 
 namespace ink {
 
+namespace geometry_internal {
+class ShapeOutline;
+}  // namespace geometry_internal
+
+// A mask shape that has been prepared for subtraction from `Stroke`s.
+//
+// `Stroke::Subtract` with a `PartitionedMesh` recomputes the outline of the
+// mask for every stroke. When erasing one mask from many strokes, create a
+// `SubtractionMask` once and pass it to `Stroke::Subtract` or
+// `SubtractFromStrokes` instead. The mask is immutable, so copies are cheap
+// and it may be used from several threads at once.
+class SubtractionMask {
+ public:
+  // Constructs an empty mask, which doesn't remove anything.
+  SubtractionMask();
+
+  // Prepares `mask_shape`, as mapped by `mask_transform` into the coordinate
+  // space that is shared with the strokes it will be subtracted from.
+  // Consecutive points of the mask outline that are closer than `epsilon` in
+  // that space are merged; typically, this is the smallest `epsilon` of the
+  // brushes of those strokes.
+  //
+  // Returns an error if `mask_transform` is not invertible, or if `epsilon`
+  // is not finite and positive.
+  static absl::StatusOr<SubtractionMask> Create(
+      const PartitionedMesh& mask_shape, const AffineTransform& mask_transform,
+      float epsilon);
+
+  SubtractionMask(const SubtractionMask&) = default;
+  SubtractionMask(SubtractionMask&&) = default;
+  SubtractionMask& operator=(const SubtractionMask&) = default;
+  SubtractionMask& operator=(SubtractionMask&&) = default;
+
+ private:
+  friend class Stroke;
+
+  explicit SubtractionMask(
+      std::shared_ptr<const geometry_internal::ShapeOutline> outline);
+
+  // The outline of the mask in the shared coordinate space. This is never
+  // null.
+  std::shared_ptr<const geometry_internal::ShapeOutline> outline_;
+};
+
 // A `Stroke` is combination of a `StrokeInputBatch` that represents a
 // user-drawn (or sometimes synthetic) path, a `Brush` that contains information
 // on how that path should be converted into a geometric shape and rendered on
@@ -117,9 +165,27 @@ class Stroke {
   //
   // The coordinate transformations are expected to be non-degenerate; otherwise
   // the stroke is returned as is.
+  //
+  // The per-triangle work is run on `executor`, which does not affect the
+  // result; a `ThreadExecutor` can speed up the subtraction of large strokes.
   Stroke Subtract(const PartitionedMesh& mask_shape,
                   const AffineTransform& mask_transform,
-                  const AffineTransform& stroke_transform) const;
+                  const AffineTransform& stroke_transform,
+                  Executor& executor = SerialExecutor()) const;
+
+  // Subtracts the prepared `mask` from this stroke geometry, where
+  // `stroke_transform` maps the stroke to the coordinates of the mask. This is
+  // equivalent to the overload above, but doesn't recompute the mask's outline.
+  //
+  // If `stroke_transform` is not the identity, the stroke's triangles are
+  // mapped into the mask's coordinates to be subtracted, so the new vertices
+  // may differ from the overload above by rounding error.
+  //
+  // `stroke_transform` is expected to be non-degenerate; otherwise the stroke
+  // is returned as is.
+  Stroke Subtract(const SubtractionMask& mask,
+                  const AffineTransform& stroke_transform,
+                  Executor& executor = SerialExecutor()) const;
 
   // Splits this stroke into a set of spatially disconnected `Stroke`s.
   //
@@ -131,8 +197,12 @@ class Stroke {
   //
   // The order of the fragments in the returned vector is arbitrary and carries
   // no guarantee.
+  //
+  // For large strokes, finding the connected regions is parallelized on
+  // `executor`; the result does not depend on the executor.
   std::vector<Stroke> Split(const AffineTransform& stroke_transform,
-                            float tolerance) const;
+                            float tolerance,
+                            Executor& executor = SerialExecutor()) const;
 
  private:
   // Regenerates the PartitionedMesh.
@@ -143,6 +213,19 @@ class Stroke {
   PartitionedMesh shape_;
 };
 
+// Subtracts `mask` from each of `strokes`, where `stroke_transforms[i]` maps
+// `strokes[i]` to the coordinates of the mask, and returns the results in the
+// same order, as if by calling `Stroke::Subtract` for each stroke.
+//
+// The strokes are subtracted in parallel on `executor`, one task per stroke;
+// the triangles of each stroke are processed serially within its task.
+//
+// This CHECK-fails if `strokes` and `stroke_transforms` have different sizes.
+std::vector<Stroke> SubtractFromStrokes(
+    absl::Span<const Stroke> strokes,
+    absl::Span<const AffineTransform> stroke_transforms,
+    const SubtractionMask& mask, Executor& executor = SerialExecutor());
+
 }  // namespace ink
 
 #endif  // INK_STROKES_STROKE_H_
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <cstddef>
+#include <cstdint>
 #include <utility>
 #include <vector>
 
@@ -21,13 +22,24 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "ink/brush/brush.h"
 #include "ink/brush/brush_family.h"
 #include "ink/brush/stock_brushes_test_params.h"
 #include "ink/color/color.h"
+#include "ink/geometry/affine_transform.h"
+#include "ink/geometry/angle.h"
+#include "ink/geometry/mesh_format.h"
+#include "ink/geometry/mesh_test_helpers.h"
+#include "ink/geometry/mutable_mesh.h"
+#include "ink/geometry/partitioned_mesh.h"
+#include "ink/geometry/point.h"
+#include "ink/geometry/rect.h"
 #include "ink/strokes/in_progress_stroke.h"
 #include "ink/strokes/input/recorded_test_inputs.h"
+#include "ink/strokes/input/stroke_input_batch.h"
 #include "ink/strokes/stroke.h"
+#include "ink/types/executor.h"
 
 namespace ink {
 namespace {
@@ -108,5 +120,155 @@ void BM_InProgressStroke(benchmark::State& state) {
 }
 BENCHMARK(BM_InProgressStroke)->Apply(BenchmarkTestCases);
 
+// Erases the middle of a highlighter stroke with a large marker stroke that
+// crosses it. Takes the highlighter's brush size, and the number of threads to
+// run the subtraction on.
+void BM_StrokeSubtract(benchmark::State& state) {
+  const BrushFamily highlighter = stock_brushes::GetParams()[2].second;
+  const BrushFamily marker = stock_brushes::GetParams()[0].second;
+  auto inputs = LoadCompleteStrokeInputs(kTestDataFiles[0]);
+  ABSL_CHECK_OK(inputs);
+  Stroke stroke(MakeBrush(highlighter, state.range(0), kTestBrushEpsilon),
+                *inputs);
+  Stroke eraser(MakeBrush(marker, 64, kTestBrushEpsilon), *inputs);
+  // Rotate the eraser about the center of the stroke, so that it crosses the
+  // stroke in many places.
+  Point center = stroke.GetShape().Bounds().AsRect()->Center();
+  AffineTransform eraser_transform =
+      AffineTransform::RotateAboutPoint(kQuarterTurn, center);
+  ThreadExecutor executor(state.range(1));
+
+  state.SetLabel(absl::StrFormat("brush size: %d, threads: %d", state.range(0),
+                                 state.range(1)));
+  for (auto s : state) {
+    benchmark::DoNotOptimize(stroke.Subtract(
+        eraser.GetShape(), eraser_transform, AffineTransform(), executor));
+  }
+}
+BENCHMARK(BM_StrokeSubtract)->ArgsProduct({{8, 32}, {1, 4}});
+
+// Copies of a highlighter stroke, offset from each other vertically, and an
+// eraser that crosses all of them, as when erasing a column of handwriting.
+struct ErasedDocument {
+  std::vector<Stroke> strokes;
+  std::vector<AffineTransform> stroke_transforms;
+  Stroke eraser;
+  AffineTransform eraser_transform;
+};
+
+ErasedDocument MakeErasedDocument(int n_strokes) {
+  const BrushFamily highlighter = stock_brushes::GetParams()[2].second;
+  const BrushFamily marker = stock_brushes::GetParams()[0].second;
+  auto inputs = LoadCompleteStrokeInputs(kTestDataFiles[0]);
+  ABSL_CHECK_OK(inputs);
+  Stroke stroke(MakeBrush(highlighter, 8, kTestBrushEpsilon), *inputs);
+  Stroke eraser(MakeBrush(marker, 64, kTestBrushEpsilon), *inputs);
+  Rect bounds = *stroke.GetShape().Bounds().AsRect();
+  ErasedDocument document = {
+      .strokes = std::vector<Stroke>(n_strokes, stroke),
+      .stroke_transforms = {},
+      .eraser = eraser,
+      .eraser_transform = AffineTransform::RotateAboutPoint(
+          kQuarterTurn, bounds.Center()),
+  };
+  document.stroke_transforms.reserve(n_strokes);
+  for (int i = 0; i < n_strokes; ++i) {
+    document.stroke_transforms.push_back(AffineTransform::Translate(
+        {0, (i - n_strokes / 2) * bounds.Height() / n_strokes}));
+  }
+  return document;
+}
+
+// Erases from each stroke in turn, recomputing the eraser's outline each time.
+// Takes the number of strokes.
+void BM_SubtractMaskShapeFromStrokes(benchmark::State& state) {
+  ErasedDocument document = MakeErasedDocument(state.range(0));
+  for (auto s : state) {
+    for (size_t i = 0; i < document.strokes.size(); ++i) {
+      benchmark::DoNotOptimize(document.strokes[i].Subtract(
+          document.eraser.GetShape(), document.eraser_transform,
+          document.stroke_transforms[i]));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SubtractMaskShapeFromStrokes)->RangeMultiplier(4)->Range(4, 64);
+
+// As above, but preparing the eraser's outline once, and erasing from the
+// strokes in parallel. Takes the number of strokes, and the number of threads.
+void BM_SubtractFromStrokes(benchmark::State& state) {
+  ErasedDocument document = MakeErasedDocument(state.range(0));
+  ThreadExecutor executor(state.range(1));
+  for (auto s : state) {
+    absl::StatusOr<SubtractionMask> mask =
+        SubtractionMask::Create(document.eraser.GetShape(),
+                                document.eraser_transform, kTestBrushEpsilon);
+    ABSL_CHECK_OK(mask);
+    benchmark::DoNotOptimize(SubtractFromStrokes(
+        document.strokes, document.stroke_transforms, *mask, executor));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SubtractFromStrokes)->ArgsProduct({{4, 16, 64}, {1, 4}});
+
+// Returns `n_bars` disjoint bars that cross `bounds` perpendicular to its
+// longer side, evenly spaced along it, each covering a quarter of the spacing.
+PartitionedMesh MakeCombMesh(const Rect& bounds, int n_bars) {
+  bool is_wide = bounds.Width() >= bounds.Height();
+  float spacing = (is_wide ? bounds.Width() : bounds.Height()) / n_bars;
+  MutableMesh mesh;
+  std::vector<std::vector<uint32_t>> outlines;
+  for (int i = 0; i < n_bars; ++i) {
+    float start = (i + 0.375f) * spacing;
+    Rect bar = is_wide ? Rect::FromTwoPoints(
+                             {bounds.XMin() + start, bounds.YMin() - 1},
+                             {bounds.XMin() + start + spacing / 4,
+                              bounds.YMax() + 1})
+                       : Rect::FromTwoPoints(
+                             {bounds.XMin() - 1, bounds.YMin() + start},
+                             {bounds.XMax() + 1,
+                              bounds.YMin() + start + spacing / 4});
+    uint32_t first = mesh.VertexCount();
+    for (Point corner : bar.Corners()) mesh.AppendVertex(corner);
+    mesh.AppendTriangleIndices({first, first + 1, first + 2});
+    mesh.AppendTriangleIndices({first, first + 2, first + 3});
+    outlines.push_back({first, first + 3, first + 2, first + 1});
+  }
+  std::vector<absl::Span<const uint32_t>> outline_spans(outlines.begin(),
+                                                        outlines.end());
+  absl::StatusOr<PartitionedMesh> comb =
+      PartitionedMesh::FromMutableMesh(mesh, outline_spans);
+  ABSL_CHECK_OK(comb);
+  return *std::move(comb);
+}
+
+// Splits a straight stroke that has been cut into 64 pieces by a comb-shaped
+// eraser. Takes the number of triangles in the stroke, whether the stroke is
+// split in a frame where it is vertical (where its vertices share a narrow
+// range of x-coordinates), and the number of threads to split it on.
+void BM_StrokeSplit(benchmark::State& state) {
+  Stroke stroke(Brush(), StrokeInputBatch(),
+                MakeStraightLinePartitionedMesh(state.range(0), MeshFormat(),
+                                                AffineTransform::Scale(1, 4)));
+  PartitionedMesh comb =
+      MakeCombMesh(*stroke.GetShape().Bounds().AsRect(), /*n_bars=*/64);
+  Stroke erased = stroke.Subtract(comb, AffineTransform(), AffineTransform());
+  AffineTransform split_transform = state.range(1) != 0
+                                        ? AffineTransform::Rotate(kQuarterTurn)
+                                        : AffineTransform();
+  ThreadExecutor executor(state.range(2));
+  state.counters["pieces"] =
+      erased.Split(split_transform, kTestBrushEpsilon).size();
+
+  state.SetLabel(absl::StrFormat("triangles: %d, vertical: %d, threads: %d",
+                                 state.range(0), state.range(1),
+                                 state.range(2)));
+  for (auto s : state) {
+    benchmark::DoNotOptimize(
+        erased.Split(split_transform, kTestBrushEpsilon, executor));
+  }
+}
+BENCHMARK(BM_StrokeSplit)->ArgsProduct({{1000, 10000, 100000}, {0, 1}, {1, 4}});
+
 }  // namespace
 }  // namespace ink
@@ -0,0 +1,119 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ink/strokes/stroke_levels_of_detail.h"
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+#include "absl/log/absl_check.h"
+#include "absl/status/statusor.h"
+#include "ink/geometry/mesh.h"
+#include "ink/geometry/partitioned_mesh.h"
+#include "ink/strokes/internal/stroke_decimation.h"
+#include "ink/strokes/stroke.h"
+#include "ink/types/executor.h"
+
+namespace ink {
+namespace {
+
+bool HasTriangles(const PartitionedMesh& shape) {
+  for (const Mesh& mesh : shape.Meshes()) {
+    if (mesh.TriangleCount() > 0) return true;
+  }
+  return false;
+}
+
+// Returns the decimated shape for a level with grid cells of `cell_size`, or
+// nullopt if decimation fails or leaves no triangles, in which case the level
+// before it should be used instead.
+std::optional<PartitionedMesh> DecimateLevel(const PartitionedMesh& shape,
+                                             float cell_size) {
+  absl::StatusOr<PartitionedMesh> decimated =
+      strokes_internal::DecimateShape(shape, cell_size);
+  if (!decimated.ok() || !HasTriangles(*decimated)) return std::nullopt;
+  return *std::move(decimated);
+}
+
+}  // namespace
+
+StrokeLevelsOfDetail::StrokeLevelsOfDetail(const Stroke& stroke,
+                                           float max_screen_error)
+    : stroke_(stroke), max_screen_error_(max_screen_error) {
+  levels_[0] = stroke_.GetShape();
+}
+
+float StrokeLevelsOfDetail::CellSize(int level) const {
+  return stroke_.GetBrush().GetEpsilon() * std::pow(kCellSizeGrowth, level);
+}
+
+float StrokeLevelsOfDetail::LevelError(int level) const {
+  ABSL_CHECK_GE(level, 0);
+  ABSL_CHECK_LT(level, kLevelCount);
+  if (level == 0) return stroke_.GetBrush().GetEpsilon();
+  // A merged vertex can move as far as the diagonal of its cell.
+  return CellSize(level) * std::sqrt(2.f);
+}
+
+int StrokeLevelsOfDetail::LevelForScale(float stroke_to_screen_scale) const {
+  if (!std::isfinite(stroke_to_screen_scale) || stroke_to_screen_scale <= 0) {
+    return 0;
+  }
+  int level = 0;
+  while (level + 1 < kLevelCount &&
+         LevelError(level + 1) * stroke_to_screen_scale <= max_screen_error_) {
+    ++level;
+  }
+  return level;
+}
+
+bool StrokeLevelsOfDetail::HasLevel(int level) const {
+  ABSL_CHECK_GE(level, 0);
+  ABSL_CHECK_LT(level, kLevelCount);
+  return levels_[level].has_value();
+}
+
+const PartitionedMesh& StrokeLevelsOfDetail::GetLevel(int level) {
+  ABSL_CHECK_GE(level, 0);
+  ABSL_CHECK_LT(level, kLevelCount);
+  if (!levels_[level].has_value()) {
+    std::optional<PartitionedMesh> decimated =
+        DecimateLevel(stroke_.GetShape(), CellSize(level));
+    levels_[level] =
+        decimated.has_value() ? *std::move(decimated) : GetLevel(level - 1);
+  }
+  return *levels_[level];
+}
+
+void StrokeLevelsOfDetail::BuildAllLevels(Executor& executor) {
+  // Each level is decimated from the full-resolution shape, so they can be
+  // built independently of each other.
+  std::array<std::optional<PartitionedMesh>, kLevelCount> decimated;
+  executor.ParallelFor(kLevelCount - 1, [this, &decimated](size_t i) {
+    int level = i + 1;
+    if (levels_[level].has_value()) return;
+    decimated[level] = DecimateLevel(stroke_.GetShape(), CellSize(level));
+  });
+  for (int level = 1; level < kLevelCount; ++level) {
+    if (levels_[level].has_value()) continue;
+    levels_[level] = decimated[level].has_value()
+                         ? *std::move(decimated[level])
+                         : *levels_[level - 1];
+  }
+}
+
+}  // namespace ink
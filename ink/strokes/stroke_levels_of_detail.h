@@ -0,0 +1,119 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INK_STROKES_STROKE_LEVELS_OF_DETAIL_H_
+#define INK_STROKES_STROKE_LEVELS_OF_DETAIL_H_
+
+#include <array>
+#include <optional>
+
+#include "ink/geometry/partitioned_mesh.h"
+#include "ink/strokes/stroke.h"
+#include "ink/types/executor.h"
+
+namespace ink {
+
+// Simplified versions of the shape of a `Stroke`, for drawing it zoomed out.
+//
+// When a whole page is visible, most of the triangles of a stroke are smaller
+// than a pixel, so drawing its full-resolution shape wastes vertex throughput.
+// Level 0 is the stroke's own shape. Each level after that merges the vertices
+// of the level-0 shape that are within a grid cell of each other, with cells
+// `kCellSizeGrowth` times as large as those of the level before it, starting at
+// `kCellSizeGrowth` times the brush epsilon. Since this decimates the stroke's
+// shape, rather than regenerating it from the inputs, it also applies to
+// strokes that have been partially erased. See
+// `strokes_internal::DecimateShape` for details.
+//
+// Levels are built the first time they are requested, or all at once with
+// `BuildAllLevels`. This class is not thread-safe; to build levels off of the
+// render thread, call `BuildAllLevels` on another thread before handing the
+// object over.
+class StrokeLevelsOfDetail {
+ public:
+  // The number of levels, including level 0.
+  static constexpr int kLevelCount = 6;
+
+  // The ratio between the grid cell sizes of consecutive levels.
+  static constexpr float kCellSizeGrowth = 4;
+
+  // The default for the maximum distance, in screen units (typically pixels),
+  // that a vertex of the drawn shape may be from where it would be at full
+  // resolution.
+  static constexpr float kDefaultMaxScreenError = 0.5;
+
+  // Holds levels of detail for `stroke`. The level chosen for a given scale is
+  // the coarsest one whose vertices are within `max_screen_error` screen units
+  // of the full-resolution shape. `max_screen_error` is expected to be finite
+  // and positive.
+  explicit StrokeLevelsOfDetail(
+      const Stroke& stroke, float max_screen_error = kDefaultMaxScreenError);
+
+  StrokeLevelsOfDetail(const StrokeLevelsOfDetail&) = default;
+  StrokeLevelsOfDetail(StrokeLevelsOfDetail&&) = default;
+  StrokeLevelsOfDetail& operator=(const StrokeLevelsOfDetail&) = default;
+  StrokeLevelsOfDetail& operator=(StrokeLevelsOfDetail&&) = default;
+  ~StrokeLevelsOfDetail() = default;
+
+  const Stroke& GetStroke() const { return stroke_; }
+
+  // Returns the maximum distance, in stroke coordinates, between a vertex of
+  // `level` and where it would be in the stroke's full-resolution shape. For
+  // level 0, this is the brush epsilon.
+  //
+  // CHECK-fails if `level` is not in [0, `kLevelCount`).
+  float LevelError(int level) const;
+
+  // Returns the coarsest level to draw the stroke with when one unit of stroke
+  // coordinates is `stroke_to_screen_scale` screen units long, e.g. the
+  // largest scale factor of the stroke-to-screen transform. Returns 0 for a
+  // scale that is not finite and positive.
+  int LevelForScale(float stroke_to_screen_scale) const;
+
+  // Returns the shape for `level`, building it if it hasn't been yet. If a
+  // level would have no triangles, e.g. because the whole stroke fits in one
+  // grid cell, it is the same as the level before it, so that the stroke
+  // doesn't disappear when zoomed out.
+  //
+  // CHECK-fails if `level` is not in [0, `kLevelCount`).
+  const PartitionedMesh& GetLevel(int level);
+
+  // Equivalent to `GetLevel(LevelForScale(stroke_to_screen_scale))`.
+  const PartitionedMesh& GetShapeForScale(float stroke_to_screen_scale) {
+    return GetLevel(LevelForScale(stroke_to_screen_scale));
+  }
+
+  // Returns true if `level` has been built.
+  //
+  // CHECK-fails if `level` is not in [0, `kLevelCount`).
+  bool HasLevel(int level) const;
+
+  // Builds all of the levels that haven't been built yet, on `executor`. The
+  // result does not depend on the executor.
+  void BuildAllLevels(Executor& executor = SerialExecutor());
+
+ private:
+  // Returns the size of the grid cells for `level`, which must be at least 1.
+  float CellSize(int level) const;
+
+  Stroke stroke_;
+  float max_screen_error_;
+  // The shape of each level, or nullopt if it hasn't been built. Level 0 is
+  // always present.
+  std::array<std::optional<PartitionedMesh>, kLevelCount> levels_;
+};
+
+}  // namespace ink
+
+#endif  // INK_STROKES_STROKE_LEVELS_OF_DETAIL_H_
@@ -0,0 +1,80 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+
+#include "benchmark/benchmark.h"
+#include "absl/log/absl_check.h"
+#include "absl/status/statusor.h"
+#include "ink/brush/brush.h"
+#include "ink/brush/brush_family.h"
+#include "ink/brush/stock_brushes_test_params.h"
+#include "ink/color/color.h"
+#include "ink/geometry/mesh.h"
+#include "ink/geometry/partitioned_mesh.h"
+#include "ink/strokes/input/recorded_test_inputs.h"
+#include "ink/strokes/stroke.h"
+#include "ink/strokes/stroke_levels_of_detail.h"
+#include "ink/types/executor.h"
+
+namespace ink {
+namespace {
+
+// Returns a stroke drawn with the marker brush from the first recorded test
+// input.
+Stroke MakeStroke() {
+  const BrushFamily marker = stock_brushes::GetParams()[0].second;
+  absl::StatusOr<Brush> brush =
+      Brush::Create(marker, Color::Black(), 4, kTestBrushEpsilon);
+  ABSL_CHECK_OK(brush);
+  auto inputs = LoadCompleteStrokeInputs(kTestDataFiles[0]);
+  ABSL_CHECK_OK(inputs);
+  return Stroke(*brush, *inputs);
+}
+
+uint32_t VertexCount(const PartitionedMesh& shape) {
+  uint32_t count = 0;
+  for (const Mesh& mesh : shape.Meshes()) count += mesh.VertexCount();
+  return count;
+}
+
+// Builds a single level, and reports how many vertices it has compared to the
+// full-resolution shape. Takes the level.
+void BM_BuildLevel(benchmark::State& state) {
+  Stroke stroke = MakeStroke();
+  int level = state.range(0);
+  uint32_t vertex_count = 0;
+  for (auto s : state) {
+    StrokeLevelsOfDetail levels(stroke);
+    vertex_count = VertexCount(levels.GetLevel(level));
+  }
+  state.counters["vertices"] = vertex_count;
+  state.counters["full_vertices"] = VertexCount(stroke.GetShape());
+}
+BENCHMARK(BM_BuildLevel)->DenseRange(1, StrokeLevelsOfDetail::kLevelCount - 1);
+
+// Builds all of the levels at once. Takes the number of threads.
+void BM_BuildAllLevels(benchmark::State& state) {
+  Stroke stroke = MakeStroke();
+  ThreadExecutor executor(state.range(0));
+  for (auto s : state) {
+    StrokeLevelsOfDetail levels(stroke);
+    levels.BuildAllLevels(executor);
+    benchmark::DoNotOptimize(levels);
+  }
+}
+BENCHMARK(BM_BuildAllLevels)->Arg(1)->Arg(4);
+
+}  // namespace
+}  // namespace ink
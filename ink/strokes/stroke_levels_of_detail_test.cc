@@ -0,0 +1,138 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ink/strokes/stroke_levels_of_detail.h"
+
+#include <cstdint>
+#include <limits>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "ink/brush/brush.h"
+#include "ink/geometry/affine_transform.h"
+#include "ink/geometry/mesh.h"
+#include "ink/geometry/mesh_format.h"
+#include "ink/geometry/mesh_test_helpers.h"
+#include "ink/geometry/partitioned_mesh.h"
+#include "ink/geometry/type_matchers.h"
+#include "ink/strokes/input/stroke_input_batch.h"
+#include "ink/strokes/stroke.h"
+#include "ink/types/executor.h"
+
+namespace ink {
+namespace {
+
+// Returns a stroke with the default brush, whose epsilon is 0.1, and whose
+// shape is a strip of `n_triangles` triangles, each about one unit wide.
+Stroke MakeStroke(uint32_t n_triangles) {
+  return Stroke(Brush(), StrokeInputBatch(),
+                MakeStraightLinePartitionedMesh(n_triangles));
+}
+
+uint32_t VertexCount(const PartitionedMesh& shape) {
+  uint32_t count = 0;
+  for (const Mesh& mesh : shape.Meshes()) count += mesh.VertexCount();
+  return count;
+}
+
+TEST(StrokeLevelsOfDetailTest, LevelZeroIsStrokeShape) {
+  Stroke stroke = MakeStroke(100);
+  StrokeLevelsOfDetail levels(stroke);
+
+  EXPECT_TRUE(levels.HasLevel(0));
+  EXPECT_FALSE(levels.HasLevel(1));
+  EXPECT_THAT(levels.GetLevel(0), PartitionedMeshShallowEq(stroke.GetShape()));
+  EXPECT_FLOAT_EQ(levels.LevelError(0), 0.1);
+}
+
+TEST(StrokeLevelsOfDetailTest, LevelErrorGrowsByCellSizeGrowth) {
+  StrokeLevelsOfDetail levels(MakeStroke(100));
+  for (int level = 2; level < StrokeLevelsOfDetail::kLevelCount; ++level) {
+    EXPECT_FLOAT_EQ(levels.LevelError(level) / levels.LevelError(level - 1),
+                    StrokeLevelsOfDetail::kCellSizeGrowth);
+  }
+}
+
+TEST(StrokeLevelsOfDetailTest, LevelForScale) {
+  StrokeLevelsOfDetail levels(MakeStroke(100), /*max_screen_error=*/0.5);
+
+  EXPECT_EQ(levels.LevelForScale(100), 0);
+  for (int level = 1; level < StrokeLevelsOfDetail::kLevelCount; ++level) {
+    // The scale at which the error of `level` is exactly 0.5 screen units.
+    float scale = 0.5 / levels.LevelError(level);
+    EXPECT_EQ(levels.LevelForScale(0.99 * scale), level);
+    EXPECT_EQ(levels.LevelForScale(1.01 * scale), level - 1);
+  }
+  EXPECT_EQ(levels.LevelForScale(1e-9),
+            StrokeLevelsOfDetail::kLevelCount - 1);
+
+  EXPECT_EQ(levels.LevelForScale(0), 0);
+  EXPECT_EQ(levels.LevelForScale(-1), 0);
+  EXPECT_EQ(levels.LevelForScale(std::numeric_limits<float>::infinity()), 0);
+  EXPECT_EQ(levels.LevelForScale(std::numeric_limits<float>::quiet_NaN()), 0);
+}
+
+TEST(StrokeLevelsOfDetailTest, CoarserLevelsHaveFewerVertices) {
+  StrokeLevelsOfDetail levels(MakeStroke(1000));
+
+  uint32_t full_vertex_count = VertexCount(levels.GetLevel(0));
+  uint32_t previous_vertex_count = full_vertex_count;
+  for (int level = 1; level < StrokeLevelsOfDetail::kLevelCount; ++level) {
+    uint32_t vertex_count = VertexCount(levels.GetLevel(level));
+    EXPECT_LE(vertex_count, previous_vertex_count) << "level " << level;
+    previous_vertex_count = vertex_count;
+  }
+  EXPECT_LT(previous_vertex_count * 10, full_vertex_count);
+}
+
+TEST(StrokeLevelsOfDetailTest, GetShapeForScale) {
+  StrokeLevelsOfDetail levels(MakeStroke(1000));
+  const PartitionedMesh& shape = levels.GetShapeForScale(0.01);
+  int level = levels.LevelForScale(0.01);
+  EXPECT_GT(level, 0);
+  EXPECT_THAT(shape, PartitionedMeshShallowEq(levels.GetLevel(level)));
+  EXPECT_LT(VertexCount(shape), VertexCount(levels.GetLevel(0)));
+}
+
+TEST(StrokeLevelsOfDetailTest, LevelWithNoTrianglesUsesLevelBefore) {
+  // The whole stroke fits in a grid cell of level 1, which would leave no
+  // triangles.
+  StrokeLevelsOfDetail levels(
+      Stroke(Brush(), StrokeInputBatch(),
+             MakeStraightLinePartitionedMesh(2, MeshFormat(),
+                                             AffineTransform::Scale(0.01))));
+
+  for (int level = 1; level < StrokeLevelsOfDetail::kLevelCount; ++level) {
+    EXPECT_THAT(levels.GetLevel(level),
+                PartitionedMeshShallowEq(levels.GetLevel(0)));
+  }
+}
+
+TEST(StrokeLevelsOfDetailTest, BuildAllLevelsMatchesGetLevel) {
+  Stroke stroke = MakeStroke(5000);
+  StrokeLevelsOfDetail built(stroke);
+  ThreadExecutor executor(4);
+  built.BuildAllLevels(executor);
+  StrokeLevelsOfDetail lazy(stroke);
+
+  for (int level = 0; level < StrokeLevelsOfDetail::kLevelCount; ++level) {
+    EXPECT_TRUE(built.HasLevel(level));
+    EXPECT_THAT(built.GetLevel(level),
+                PartitionedMeshDeepEq(lazy.GetLevel(level)))
+        << "level " << level;
+  }
+}
+
+}  // namespace
+}  // namespace ink
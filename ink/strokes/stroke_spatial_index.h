@@ -0,0 +1,484 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INK_STROKES_STROKE_SPATIAL_INDEX_H_
+#define INK_STROKES_STROKE_SPATIAL_INDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
+#include "absl/log/absl_check.h"
+#include "absl/types/span.h"
+#include "ink/geometry/affine_transform.h"
+#include "ink/geometry/envelope.h"
+#include "ink/geometry/internal/flat_static_rtree.h"
+#include "ink/geometry/intersects.h"
+#include "ink/geometry/partitioned_mesh.h"
+#include "ink/geometry/point.h"
+#include "ink/geometry/quad.h"
+#include "ink/geometry/rect.h"
+#include "ink/geometry/segment.h"
+#include "ink/geometry/triangle.h"
+#include "ink/strokes/stroke.h"
+
+namespace ink {
+
+// A spatial index over the strokes of a document, which can be used as the
+// broad phase of hit-testing and erasing, so that only the strokes near a
+// query need to be tested against it. Strokes are keyed by a caller-provided
+// ID of type `Id`, which must be hashable by `absl::Hash` and
+// equality-comparable, and each stroke is placed in the document by a
+// stroke-to-document transform.
+//
+// Queries are given in document coordinates; the exact queries forward to the
+// `Intersects` functions for each stroke whose bounds intersect the query's,
+// which in turn use the spatial index of the stroke's `PartitionedMesh`.
+//
+// The index is a set of bulk-loaded R-Trees of geometrically increasing sizes
+// (the "logarithmic method"), plus a small buffer of recently inserted strokes:
+// when the buffer fills up, it is merged with the smallest trees into a new
+// tree. This makes insertion O(log(n)) amortized, while keeping the
+// query-optimized layout of `FlatStaticRTree` for almost all strokes. Removed
+// strokes are dropped from their tree the next time it is rebuilt, and the
+// whole index is rebuilt once more than half of the strokes in it have been
+// removed.
+//
+// The index holds a copy of each stroke's `PartitionedMesh`, which shares its
+// data (and its spatial index) with the stroke. It does not hold the stroke
+// itself, so it is not invalidated when the stroke is destroyed, but it must
+// be updated when the stroke's shape is.
+template <typename Id>
+class StrokeSpatialIndex {
+ public:
+  // This enumerator is returned by visitor functions, indicating whether the
+  // search should continue to the next stroke, or stop.
+  enum class FlowControl : uint8_t { kBreak, kContinue };
+
+  StrokeSpatialIndex() = default;
+  StrokeSpatialIndex(const StrokeSpatialIndex&) = default;
+  StrokeSpatialIndex(StrokeSpatialIndex&&) = default;
+  StrokeSpatialIndex& operator=(const StrokeSpatialIndex&) = default;
+  StrokeSpatialIndex& operator=(StrokeSpatialIndex&&) = default;
+  ~StrokeSpatialIndex() = default;
+
+  // Adds `stroke`, placed in the document by `stroke_to_document`, to the
+  // index under `id`. If there is already a stroke with the given `id`, it is
+  // replaced.
+  void Insert(const Id& id, const Stroke& stroke,
+              const AffineTransform& stroke_to_document = {});
+
+  // Changes the transform of the stroke with the given `id`. Returns false,
+  // and does nothing, if there is no such stroke.
+  bool UpdateTransform(const Id& id,
+                       const AffineTransform& stroke_to_document);
+
+  // Removes the stroke with the given `id`. Returns false if there is no such
+  // stroke.
+  bool Remove(const Id& id);
+
+  // Removes all strokes from the index.
+  void Clear();
+
+  // Returns true if there is a stroke with the given `id` in the index.
+  bool Contains(const Id& id) const { return slot_by_id_.contains(id); }
+
+  // Returns the number of strokes in the index.
+  size_t Size() const { return slot_by_id_.size(); }
+
+  // Returns the bounds of the stroke with the given `id` in document
+  // coordinates, which are empty if the stroke has no shape. This
+  // CHECK-fails if there is no such stroke.
+  Envelope Bounds(const Id& id) const;
+
+  // Visits the IDs of the strokes whose bounds, in document coordinates,
+  // intersect `query`. This does not test the strokes' shapes, so it is
+  // cheaper, but less precise, than the `VisitIntersectedStrokes` functions.
+  // `visitor`'s return value indicates whether the visit should continue or
+  // stop early. The visitation order should be assumed to be arbitrary.
+  void VisitStrokesWithIntersectedBounds(
+      const Rect& query,
+      absl::FunctionRef<FlowControl(const Id&)> visitor) const;
+
+  // Visits the IDs of the strokes whose shapes intersect `query`, as per the
+  // `Intersects` family of functions, where `query` is in document
+  // coordinates. `visitor`'s return value indicates whether the visit should
+  // continue or stop early. The visitation order should be assumed to be
+  // arbitrary.
+  void VisitIntersectedStrokes(
+      Point query, absl::FunctionRef<FlowControl(const Id&)> visitor) const;
+  void VisitIntersectedStrokes(
+      const Segment& query,
+      absl::FunctionRef<FlowControl(const Id&)> visitor) const;
+  void VisitIntersectedStrokes(
+      const Triangle& query,
+      absl::FunctionRef<FlowControl(const Id&)> visitor) const;
+  void VisitIntersectedStrokes(
+      const Rect& query,
+      absl::FunctionRef<FlowControl(const Id&)> visitor) const;
+  void VisitIntersectedStrokes(
+      const Quad& query,
+      absl::FunctionRef<FlowControl(const Id&)> visitor) const;
+
+  // As above, but for a `PartitionedMesh` query (e.g. an eraser or lasso
+  // shape), which is placed in the document by `query_to_document`.
+  void VisitIntersectedStrokes(
+      const PartitionedMesh& query, const AffineTransform& query_to_document,
+      absl::FunctionRef<FlowControl(const Id&)> visitor) const;
+
+ private:
+  // The number of strokes that are buffered before they are put in a tree.
+  // Level `i` holds at most `kBufferCapacity << i` strokes.
+  static constexpr size_t kBufferCapacity = 32;
+
+  struct Entry {
+    Id id;
+    PartitionedMesh shape;
+    AffineTransform stroke_to_document;
+    // The bounds of the stroke in document coordinates, or nullopt if the
+    // stroke has no shape, in which case it is in neither the buffer nor a
+    // level.
+    std::optional<Rect> bounds;
+    // False if the stroke has been removed, but its slot is still referenced
+    // by a level.
+    bool is_live;
+  };
+
+  struct Level {
+    std::vector<uint32_t> slots;
+    geometry_internal::FlatStaticRTree<uint32_t> rtree;
+  };
+
+  // Implementation of `Insert` and `UpdateTransform`.
+  void InsertShape(const Id& id, PartitionedMesh shape,
+                   const AffineTransform& stroke_to_document);
+
+  // Adds `entry` to `entries_`, returning its slot.
+  uint32_t AllocateSlot(Entry entry);
+  // Releases the `PartitionedMesh` in `slot` and makes it available for reuse.
+  void FreeSlot(uint32_t slot);
+
+  // Removes the entry in `slot`, which must be live, from the index.
+  void RemoveSlot(uint32_t slot);
+
+  // Moves the buffered strokes into a tree, merging it with the smallest
+  // levels to keep the number of levels logarithmic in the number of strokes.
+  void FlushBuffer();
+  // Rebuilds the index as a single level, without the removed strokes.
+  void Rebuild();
+  // Appends the live slots in `level` to `slots`, and frees the dead ones.
+  void TakeLiveSlots(const Level& level, std::vector<uint32_t>& slots);
+  // Builds a tree over `slots` in `levels_[level_index]`.
+  void BuildLevel(size_t level_index, std::vector<uint32_t> slots);
+
+  // Visits the slots of the live strokes whose bounds intersect `bounds`.
+  // Stops if `visitor` returns false.
+  void VisitCandidateSlots(const Rect& bounds,
+                           absl::FunctionRef<bool(uint32_t)> visitor) const;
+
+  template <typename Query>
+  void VisitIntersectedStrokesImpl(
+      const Query& query,
+      absl::FunctionRef<FlowControl(const Id&)> visitor) const;
+
+  std::vector<Entry> entries_;
+  std::vector<uint32_t> free_slots_;
+  absl::flat_hash_map<Id, uint32_t> slot_by_id_;
+  // Strokes that have been inserted since the last `FlushBuffer`; these are
+  // always live.
+  std::vector<uint32_t> buffer_;
+  std::vector<std::optional<Level>> levels_;
+  // The number of dead entries that are still referenced by a level.
+  size_t n_dead_entries_ = 0;
+};
+
+// ---------------------------------------------------------------------------
+//                     Implementation details below
+
+template <typename Id>
+void StrokeSpatialIndex<Id>::Insert(
+    const Id& id, const Stroke& stroke,
+    const AffineTransform& stroke_to_document) {
+  InsertShape(id, stroke.GetShape(), stroke_to_document);
+}
+
+template <typename Id>
+bool StrokeSpatialIndex<Id>::UpdateTransform(
+    const Id& id, const AffineTransform& stroke_to_document) {
+  auto it = slot_by_id_.find(id);
+  if (it == slot_by_id_.end()) return false;
+  // The stroke's bounds in its tree are stale, so it is removed and reinserted
+  // into the buffer.
+  PartitionedMesh shape = entries_[it->second].shape;
+  InsertShape(id, std::move(shape), stroke_to_document);
+  return true;
+}
+
+template <typename Id>
+bool StrokeSpatialIndex<Id>::Remove(const Id& id) {
+  auto it = slot_by_id_.find(id);
+  if (it == slot_by_id_.end()) return false;
+  uint32_t slot = it->second;
+  slot_by_id_.erase(it);
+  RemoveSlot(slot);
+  return true;
+}
+
+template <typename Id>
+void StrokeSpatialIndex<Id>::Clear() {
+  entries_.clear();
+  free_slots_.clear();
+  slot_by_id_.clear();
+  buffer_.clear();
+  levels_.clear();
+  n_dead_entries_ = 0;
+}
+
+template <typename Id>
+Envelope StrokeSpatialIndex<Id>::Bounds(const Id& id) const {
+  auto it = slot_by_id_.find(id);
+  ABSL_CHECK(it != slot_by_id_.end()) << "No stroke with the given ID";
+  const std::optional<Rect>& bounds = entries_[it->second].bounds;
+  return bounds.has_value() ? Envelope(*bounds) : Envelope();
+}
+
+template <typename Id>
+void StrokeSpatialIndex<Id>::VisitStrokesWithIntersectedBounds(
+    const Rect& query,
+    absl::FunctionRef<FlowControl(const Id&)> visitor) const {
+  VisitCandidateSlots(query, [this, &visitor](uint32_t slot) {
+    return visitor(entries_[slot].id) == FlowControl::kContinue;
+  });
+}
+
+template <typename Id>
+void StrokeSpatialIndex<Id>::VisitIntersectedStrokes(
+    Point query, absl::FunctionRef<FlowControl(const Id&)> visitor) const {
+  VisitIntersectedStrokesImpl(query, visitor);
+}
+
+template <typename Id>
+void StrokeSpatialIndex<Id>::VisitIntersectedStrokes(
+    const Segment& query,
+    absl::FunctionRef<FlowControl(const Id&)> visitor) const {
+  VisitIntersectedStrokesImpl(query, visitor);
+}
+
+template <typename Id>
+void StrokeSpatialIndex<Id>::VisitIntersectedStrokes(
+    const Triangle& query,
+    absl::FunctionRef<FlowControl(const Id&)> visitor) const {
+  VisitIntersectedStrokesImpl(query, visitor);
+}
+
+template <typename Id>
+void StrokeSpatialIndex<Id>::VisitIntersectedStrokes(
+    const Rect& query,
+    absl::FunctionRef<FlowControl(const Id&)> visitor) const {
+  VisitIntersectedStrokesImpl(query, visitor);
+}
+
+template <typename Id>
+void StrokeSpatialIndex<Id>::VisitIntersectedStrokes(
+    const Quad& query,
+    absl::FunctionRef<FlowControl(const Id&)> visitor) const {
+  VisitIntersectedStrokesImpl(query, visitor);
+}
+
+template <typename Id>
+void StrokeSpatialIndex<Id>::VisitIntersectedStrokes(
+    const PartitionedMesh& query, const AffineTransform& query_to_document,
+    absl::FunctionRef<FlowControl(const Id&)> visitor) const {
+  std::optional<Rect> query_bounds = query.Bounds().AsRect();
+  if (!query_bounds.has_value()) return;
+  Envelope document_bounds(query_to_document.Apply(*query_bounds));
+  VisitCandidateSlots(
+      *document_bounds.AsRect(),
+      [this, &query, &query_to_document, &visitor](uint32_t slot) {
+        const Entry& entry = entries_[slot];
+        if (!Intersects(entry.shape, entry.stroke_to_document, query,
+                        query_to_document)) {
+          return true;
+        }
+        return visitor(entry.id) == FlowControl::kContinue;
+      });
+}
+
+template <typename Id>
+void StrokeSpatialIndex<Id>::InsertShape(
+    const Id& id, PartitionedMesh shape,
+    const AffineTransform& stroke_to_document) {
+  Remove(id);
+  std::optional<Rect> bounds;
+  if (std::optional<Rect> shape_bounds = shape.Bounds().AsRect();
+      shape_bounds.has_value()) {
+    // The corners are transformed individually, rather than by transforming
+    // the `Rect` to a `Quad`, so that the bounds are as tight as possible.
+    Envelope envelope;
+    for (Point corner : shape_bounds->Corners()) {
+      envelope.Add(stroke_to_document.Apply(corner));
+    }
+    bounds = envelope.AsRect();
+  }
+  uint32_t slot = AllocateSlot({.id = id,
+                                .shape = std::move(shape),
+                                .stroke_to_document = stroke_to_document,
+                                .bounds = bounds,
+                                .is_live = true});
+  slot_by_id_.emplace(id, slot);
+  if (!bounds.has_value()) return;
+  buffer_.push_back(slot);
+  if (buffer_.size() >= kBufferCapacity) FlushBuffer();
+}
+
+template <typename Id>
+uint32_t StrokeSpatialIndex<Id>::AllocateSlot(Entry entry) {
+  if (free_slots_.empty()) {
+    entries_.push_back(std::move(entry));
+    return entries_.size() - 1;
+  }
+  uint32_t slot = free_slots_.back();
+  free_slots_.pop_back();
+  entries_[slot] = std::move(entry);
+  return slot;
+}
+
+template <typename Id>
+void StrokeSpatialIndex<Id>::FreeSlot(uint32_t slot) {
+  entries_[slot].shape = PartitionedMesh();
+  entries_[slot].is_live = false;
+  free_slots_.push_back(slot);
+}
+
+template <typename Id>
+void StrokeSpatialIndex<Id>::RemoveSlot(uint32_t slot) {
+  Entry& entry = entries_[slot];
+  ABSL_DCHECK(entry.is_live);
+  if (!entry.bounds.has_value()) {
+    FreeSlot(slot);
+    return;
+  }
+  if (auto it = absl::c_find(buffer_, slot); it != buffer_.end()) {
+    *it = buffer_.back();
+    buffer_.pop_back();
+    FreeSlot(slot);
+    return;
+  }
+  // The slot is referenced by a level; it can only be freed once that level is
+  // rebuilt.
+  entry.shape = PartitionedMesh();
+  entry.is_live = false;
+  ++n_dead_entries_;
+  if (n_dead_entries_ > kBufferCapacity && n_dead_entries_ > Size()) {
+    Rebuild();
+  }
+}
+
+template <typename Id>
+void StrokeSpatialIndex<Id>::FlushBuffer() {
+  std::vector<uint32_t> slots = std::move(buffer_);
+  buffer_.clear();
+  size_t level_index = 0;
+  // The buffer and levels [0, i) together hold at most `kBufferCapacity << i`
+  // strokes, so they fit in the first empty level.
+  for (; level_index < levels_.size() && levels_[level_index].has_value();
+       ++level_index) {
+    TakeLiveSlots(*levels_[level_index], slots);
+    levels_[level_index].reset();
+  }
+  BuildLevel(level_index, std::move(slots));
+}
+
+template <typename Id>
+void StrokeSpatialIndex<Id>::Rebuild() {
+  std::vector<uint32_t> slots = std::move(buffer_);
+  buffer_.clear();
+  for (std::optional<Level>& level : levels_) {
+    if (!level.has_value()) continue;
+    TakeLiveSlots(*level, slots);
+    level.reset();
+  }
+  ABSL_DCHECK_EQ(n_dead_entries_, 0u);
+  size_t level_index = 0;
+  while ((kBufferCapacity << level_index) < slots.size()) ++level_index;
+  BuildLevel(level_index, std::move(slots));
+}
+
+template <typename Id>
+void StrokeSpatialIndex<Id>::TakeLiveSlots(const Level& level,
+                                           std::vector<uint32_t>& slots) {
+  for (uint32_t slot : level.slots) {
+    if (entries_[slot].is_live) {
+      slots.push_back(slot);
+    } else {
+      FreeSlot(slot);
+      --n_dead_entries_;
+    }
+  }
+}
+
+template <typename Id>
+void StrokeSpatialIndex<Id>::BuildLevel(size_t level_index,
+                                        std::vector<uint32_t> slots) {
+  if (slots.empty()) return;
+  if (levels_.size() <= level_index) levels_.resize(level_index + 1);
+  geometry_internal::FlatStaticRTree<uint32_t> rtree(
+      absl::MakeConstSpan(slots),
+      [this](uint32_t slot) { return *entries_[slot].bounds; });
+  levels_[level_index].emplace(
+      Level{.slots = std::move(slots), .rtree = std::move(rtree)});
+}
+
+template <typename Id>
+void StrokeSpatialIndex<Id>::VisitCandidateSlots(
+    const Rect& bounds, absl::FunctionRef<bool(uint32_t)> visitor) const {
+  for (uint32_t slot : buffer_) {
+    if (Intersects(*entries_[slot].bounds, bounds) && !visitor(slot)) return;
+  }
+  for (const std::optional<Level>& level : levels_) {
+    if (!level.has_value()) continue;
+    bool stopped = false;
+    level->rtree.VisitIntersectedElements(
+        bounds, [this, &visitor, &stopped](uint32_t slot) {
+          if (!entries_[slot].is_live) return true;
+          stopped = !visitor(slot);
+          return !stopped;
+        });
+    if (stopped) return;
+  }
+}
+
+template <typename Id>
+template <typename Query>
+void StrokeSpatialIndex<Id>::VisitIntersectedStrokesImpl(
+    const Query& query,
+    absl::FunctionRef<FlowControl(const Id&)> visitor) const {
+  VisitCandidateSlots(
+      *Envelope(query).AsRect(), [this, &query, &visitor](uint32_t slot) {
+        const Entry& entry = entries_[slot];
+        if (!Intersects(entry.shape, entry.stroke_to_document, query)) {
+          return true;
+        }
+        return visitor(entry.id) == FlowControl::kContinue;
+      });
+}
+
+}  // namespace ink
+
+#endif  // INK_STROKES_STROKE_SPATIAL_INDEX_H_
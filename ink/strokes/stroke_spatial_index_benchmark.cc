@@ -0,0 +1,196 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "ink/brush/brush.h"
+#include "ink/geometry/affine_transform.h"
+#include "ink/geometry/angle.h"
+#include "ink/geometry/intersects.h"
+#include "ink/geometry/mesh_format.h"
+#include "ink/geometry/mesh_test_helpers.h"
+#include "ink/geometry/partitioned_mesh.h"
+#include "ink/geometry/point.h"
+#include "ink/geometry/rect.h"
+#include "ink/strokes/input/stroke_input_batch.h"
+#include "ink/strokes/stroke.h"
+#include "ink/strokes/stroke_spatial_index.h"
+
+namespace ink {
+namespace {
+
+using Index = StrokeSpatialIndex<int>;
+using FlowControl = Index::FlowControl;
+
+// A synthetic document: `n_strokes` strokes, each 10 units long and 1 unit
+// wide, with random positions and rotations, scattered over a square whose
+// area grows with the number of strokes, so that the density of strokes (and
+// so the number of strokes near any one point) is about constant.
+struct Document {
+  Stroke stroke;
+  std::vector<AffineTransform> transforms;
+  float size;
+};
+
+Document MakeDocument(int n_strokes) {
+  Document document = {
+      .stroke = Stroke(Brush(), StrokeInputBatch(),
+                       MakeStraightLinePartitionedMesh(
+                           50, MeshFormat(), AffineTransform::Scale(0.2, 1))),
+      .transforms = {},
+      .size = 4 * std::sqrt(static_cast<float>(n_strokes)),
+  };
+  document.stroke.GetShape().InitializeSpatialIndex();
+  std::mt19937 rng(n_strokes);
+  std::uniform_real_distribution<float> position(0, document.size);
+  std::uniform_real_distribution<float> rotation(0, 1);
+  document.transforms.reserve(n_strokes);
+  for (int i = 0; i < n_strokes; ++i) {
+    document.transforms.push_back(
+        AffineTransform::Translate({position(rng), position(rng)}) *
+        AffineTransform::Rotate(rotation(rng) * kFullTurn));
+  }
+  return document;
+}
+
+Index MakeIndex(const Document& document) {
+  Index index;
+  for (size_t i = 0; i < document.transforms.size(); ++i) {
+    index.Insert(i, document.stroke, document.transforms[i]);
+  }
+  return index;
+}
+
+// Returns `n` random points in the document.
+std::vector<Point> MakeQueryPoints(const Document& document, int n) {
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> position(0, document.size);
+  std::vector<Point> points;
+  points.reserve(n);
+  for (int i = 0; i < n; ++i) points.push_back({position(rng), position(rng)});
+  return points;
+}
+
+void BM_InsertStrokes(benchmark::State& state) {
+  Document document = MakeDocument(state.range(0));
+  for (auto s : state) {
+    benchmark::DoNotOptimize(MakeIndex(document));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_InsertStrokes)->RangeMultiplier(10)->Range(10000, 100000);
+
+void BM_HitTestPoint(benchmark::State& state) {
+  Document document = MakeDocument(state.range(0));
+  Index index = MakeIndex(document);
+  std::vector<Point> points = MakeQueryPoints(document, 1024);
+  size_t i = 0;
+  for (auto s : state) {
+    int n_hits = 0;
+    index.VisitIntersectedStrokes(points[i++ % points.size()],
+                                  [&n_hits](int id) {
+                                    ++n_hits;
+                                    return FlowControl::kContinue;
+                                  });
+    benchmark::DoNotOptimize(n_hits);
+  }
+}
+BENCHMARK(BM_HitTestPoint)->RangeMultiplier(10)->Range(10000, 100000);
+
+// As above, but without the index, testing each stroke in turn, as an app
+// without a broad phase would.
+void BM_HitTestPointLinearScan(benchmark::State& state) {
+  Document document = MakeDocument(state.range(0));
+  std::vector<Point> points = MakeQueryPoints(document, 1024);
+  size_t i = 0;
+  for (auto s : state) {
+    Point point = points[i++ % points.size()];
+    int n_hits = 0;
+    for (const AffineTransform& transform : document.transforms) {
+      if (Intersects(document.stroke.GetShape(), transform, point)) ++n_hits;
+    }
+    benchmark::DoNotOptimize(n_hits);
+  }
+}
+BENCHMARK(BM_HitTestPointLinearScan)->RangeMultiplier(10)->Range(10000, 100000);
+
+// Queries with a 20x20 rectangle, as when selecting a region.
+void BM_RegionQuery(benchmark::State& state) {
+  Document document = MakeDocument(state.range(0));
+  Index index = MakeIndex(document);
+  std::vector<Point> points = MakeQueryPoints(document, 1024);
+  size_t i = 0;
+  for (auto s : state) {
+    int n_hits = 0;
+    index.VisitIntersectedStrokes(
+        Rect::FromCenterAndDimensions(points[i++ % points.size()], 20, 20),
+        [&n_hits](int id) {
+          ++n_hits;
+          return FlowControl::kContinue;
+        });
+    benchmark::DoNotOptimize(n_hits);
+  }
+}
+BENCHMARK(BM_RegionQuery)->RangeMultiplier(10)->Range(10000, 100000);
+
+// Queries with a stroke-shaped eraser mesh.
+void BM_EraserMeshQuery(benchmark::State& state) {
+  Document document = MakeDocument(state.range(0));
+  Index index = MakeIndex(document);
+  std::vector<Point> points = MakeQueryPoints(document, 1024);
+  size_t i = 0;
+  for (auto s : state) {
+    Point point = points[i++ % points.size()];
+    int n_hits = 0;
+    index.VisitIntersectedStrokes(
+        document.stroke.GetShape(),
+        AffineTransform::Translate(point.Offset()), [&n_hits](int id) {
+          ++n_hits;
+          return FlowControl::kContinue;
+        });
+    benchmark::DoNotOptimize(n_hits);
+  }
+}
+BENCHMARK(BM_EraserMeshQuery)->RangeMultiplier(10)->Range(10000, 100000);
+
+// Moves a stroke and then hit-tests, as when dragging a selection.
+void BM_UpdateTransformAndHitTest(benchmark::State& state) {
+  Document document = MakeDocument(state.range(0));
+  Index index = MakeIndex(document);
+  std::vector<Point> points = MakeQueryPoints(document, 1024);
+  size_t i = 0;
+  for (auto s : state) {
+    Point point = points[i % points.size()];
+    index.UpdateTransform(i % document.transforms.size(),
+                          AffineTransform::Translate(point.Offset()));
+    int n_hits = 0;
+    index.VisitIntersectedStrokes(point, [&n_hits](int id) {
+      ++n_hits;
+      return FlowControl::kContinue;
+    });
+    benchmark::DoNotOptimize(n_hits);
+    ++i;
+  }
+}
+BENCHMARK(BM_UpdateTransformAndHitTest)
+    ->RangeMultiplier(10)
+    ->Range(10000, 100000);
+
+}  // namespace
+}  // namespace ink
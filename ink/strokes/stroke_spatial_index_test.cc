@@ -0,0 +1,283 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ink/strokes/stroke_spatial_index.h"
+
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "ink/brush/brush.h"
+#include "ink/geometry/affine_transform.h"
+#include "ink/geometry/angle.h"
+#include "ink/geometry/envelope.h"
+#include "ink/geometry/intersects.h"
+#include "ink/geometry/mesh_format.h"
+#include "ink/geometry/mesh_test_helpers.h"
+#include "ink/geometry/partitioned_mesh.h"
+#include "ink/geometry/point.h"
+#include "ink/geometry/quad.h"
+#include "ink/geometry/rect.h"
+#include "ink/geometry/segment.h"
+#include "ink/geometry/type_matchers.h"
+#include "ink/geometry/vec.h"
+#include "ink/strokes/input/stroke_input_batch.h"
+#include "ink/strokes/stroke.h"
+
+namespace ink {
+namespace {
+
+using ::testing::IsEmpty;
+using ::testing::UnorderedElementsAre;
+using ::testing::UnorderedElementsAreArray;
+
+using Index = StrokeSpatialIndex<int>;
+using FlowControl = Index::FlowControl;
+
+// Returns a stroke whose shape is a horizontal strip of triangles, spanning
+// [0, 10] on the x-axis and [-1, 0] on the y-axis.
+Stroke MakeStroke() {
+  return Stroke(Brush(), StrokeInputBatch(),
+                MakeStraightLinePartitionedMesh(
+                    10, MeshFormat(), AffineTransform::Scale(10.f / 11, 1)));
+}
+
+template <typename Query>
+std::vector<int> FindIntersectedStrokes(const Index& index,
+                                        const Query& query) {
+  std::vector<int> ids;
+  index.VisitIntersectedStrokes(query, [&ids](int id) {
+    ids.push_back(id);
+    return FlowControl::kContinue;
+  });
+  return ids;
+}
+
+std::vector<int> FindStrokesWithIntersectedBounds(const Index& index,
+                                                  const Rect& query) {
+  std::vector<int> ids;
+  index.VisitStrokesWithIntersectedBounds(query, [&ids](int id) {
+    ids.push_back(id);
+    return FlowControl::kContinue;
+  });
+  return ids;
+}
+
+TEST(StrokeSpatialIndexTest, EmptyIndex) {
+  Index index;
+  EXPECT_EQ(index.Size(), 0u);
+  EXPECT_FALSE(index.Contains(0));
+  EXPECT_FALSE(index.Remove(0));
+  EXPECT_FALSE(index.UpdateTransform(0, AffineTransform()));
+  EXPECT_THAT(FindIntersectedStrokes(index, Point{0, 0}), IsEmpty());
+  EXPECT_THAT(
+      FindStrokesWithIntersectedBounds(
+          index, Rect::FromTwoPoints({-100, -100}, {100, 100})),
+      IsEmpty());
+}
+
+TEST(StrokeSpatialIndexTest, InsertAndQuery) {
+  Stroke stroke = MakeStroke();
+  Index index;
+  index.Insert(1, stroke);
+  index.Insert(2, stroke, AffineTransform::Translate({0, 5}));
+  index.Insert(3, stroke, AffineTransform::Translate({20, 0}));
+
+  EXPECT_EQ(index.Size(), 3u);
+  EXPECT_TRUE(index.Contains(2));
+  EXPECT_THAT(index.Bounds(2),
+              EnvelopeEq(Rect::FromTwoPoints({0, 4}, {10, 5})));
+
+  EXPECT_THAT(FindIntersectedStrokes(index, Point{5, -0.5}),
+              UnorderedElementsAre(1));
+  EXPECT_THAT(FindIntersectedStrokes(index, Segment{{5, -2}, {5, 6}}),
+              UnorderedElementsAre(1, 2));
+  EXPECT_THAT(FindIntersectedStrokes(
+                  index, Rect::FromTwoPoints({8, -0.5}, {22, -0.25})),
+              UnorderedElementsAre(1, 3));
+  EXPECT_THAT(FindIntersectedStrokes(
+                  index, Quad::FromCenterDimensionsAndRotation(
+                             {5, 2}, 40, 0.1, kFullTurn / 8)),
+              UnorderedElementsAre(1, 2));
+  EXPECT_THAT(FindIntersectedStrokes(index, Point{15, -0.5}), IsEmpty());
+}
+
+TEST(StrokeSpatialIndexTest, PartitionedMeshQuery) {
+  Stroke stroke = MakeStroke();
+  Index index;
+  index.Insert(1, stroke);
+  index.Insert(2, stroke, AffineTransform::Translate({0, 5}));
+
+  // The query is the same shape, rotated to cross the first stroke vertically;
+  // it reaches y = 3.75, so its bounds overlap the second stroke's bounds, but
+  // it does not reach the second stroke.
+  PartitionedMesh eraser = stroke.GetShape();
+  AffineTransform eraser_transform =
+      AffineTransform::Translate({5.25, -6.25}) *
+      AffineTransform::Rotate(kQuarterTurn);
+  std::vector<int> ids;
+  index.VisitIntersectedStrokes(eraser, eraser_transform, [&ids](int id) {
+    ids.push_back(id);
+    return FlowControl::kContinue;
+  });
+  EXPECT_THAT(ids, UnorderedElementsAre(1));
+}
+
+TEST(StrokeSpatialIndexTest, BoundsQueryIsConservative) {
+  Stroke stroke = MakeStroke();
+  Index index;
+  index.Insert(1, stroke, AffineTransform::Rotate(kFullTurn / 8));
+
+  // This point is inside the rotated stroke's bounds, but not its shape.
+  Point query = {6, 1};
+  EXPECT_THAT(FindStrokesWithIntersectedBounds(
+                  index, Rect::FromCenterAndDimensions(query, 0, 0)),
+              UnorderedElementsAre(1));
+  EXPECT_THAT(FindIntersectedStrokes(index, query), IsEmpty());
+}
+
+TEST(StrokeSpatialIndexTest, InsertReplacesExistingStroke) {
+  Stroke stroke = MakeStroke();
+  Index index;
+  index.Insert(1, stroke);
+  index.Insert(1, stroke, AffineTransform::Translate({0, 5}));
+
+  EXPECT_EQ(index.Size(), 1u);
+  EXPECT_THAT(FindIntersectedStrokes(index, Point{5, -0.5}), IsEmpty());
+  EXPECT_THAT(FindIntersectedStrokes(index, Point{5, 4.5}),
+              UnorderedElementsAre(1));
+}
+
+TEST(StrokeSpatialIndexTest, StrokeWithEmptyShape) {
+  Index index;
+  index.Insert(1, Stroke(Brush()));
+
+  EXPECT_TRUE(index.Contains(1));
+  EXPECT_TRUE(index.Bounds(1).IsEmpty());
+  EXPECT_THAT(
+      FindStrokesWithIntersectedBounds(
+          index, Rect::FromTwoPoints({-100, -100}, {100, 100})),
+      IsEmpty());
+  EXPECT_TRUE(index.UpdateTransform(1, AffineTransform::Scale(2)));
+  EXPECT_TRUE(index.Remove(1));
+  EXPECT_EQ(index.Size(), 0u);
+}
+
+TEST(StrokeSpatialIndexTest, VisitorStopsEarly) {
+  Stroke stroke = MakeStroke();
+  Index index;
+  for (int id = 0; id < 100; ++id) index.Insert(id, stroke);
+
+  int n_visited = 0;
+  index.VisitIntersectedStrokes(Point{5, -0.5}, [&n_visited](int id) {
+    ++n_visited;
+    return n_visited < 3 ? FlowControl::kContinue : FlowControl::kBreak;
+  });
+  EXPECT_EQ(n_visited, 3);
+}
+
+TEST(StrokeSpatialIndexTest, ClearRemovesAllStrokes) {
+  Stroke stroke = MakeStroke();
+  Index index;
+  for (int id = 0; id < 100; ++id) index.Insert(id, stroke);
+  index.Clear();
+
+  EXPECT_EQ(index.Size(), 0u);
+  EXPECT_THAT(FindIntersectedStrokes(index, Point{5, -0.5}), IsEmpty());
+  index.Insert(7, stroke);
+  EXPECT_THAT(FindIntersectedStrokes(index, Point{5, -0.5}),
+              UnorderedElementsAre(7));
+}
+
+TEST(StrokeSpatialIndexTest, StringIds) {
+  Stroke stroke = MakeStroke();
+  StrokeSpatialIndex<std::string> index;
+  index.Insert("a", stroke);
+  index.Insert("b", stroke, AffineTransform::Translate({0, 5}));
+
+  std::vector<std::string> ids;
+  index.VisitIntersectedStrokes(
+      Segment{{5, -2}, {5, 6}}, [&ids](const std::string& id) {
+        ids.push_back(id);
+        return StrokeSpatialIndex<std::string>::FlowControl::kContinue;
+      });
+  EXPECT_THAT(ids, UnorderedElementsAre("a", "b"));
+}
+
+// Inserts, moves, and removes strokes in a grid, enough that the index is
+// flushed and rebuilt several times, and checks the queries against a brute
+// force search after each phase.
+TEST(StrokeSpatialIndexTest, MatchesBruteForceAfterMutations) {
+  Stroke stroke = MakeStroke();
+  Index index;
+  absl::flat_hash_map<int, AffineTransform> transforms;
+  auto insert = [&stroke, &index, &transforms](int id,
+                                               const AffineTransform& t) {
+    index.Insert(id, stroke, t);
+    transforms[id] = t;
+  };
+  auto expect_matches_brute_force = [&stroke, &index, &transforms]() {
+    ASSERT_EQ(index.Size(), transforms.size());
+    for (float x = -5; x < 120; x += 7.5) {
+      for (float y = -5; y < 120; y += 7.5) {
+        Rect query = Rect::FromCenterAndDimensions({x, y}, 6, 3);
+        std::vector<int> expected;
+        for (const auto& [id, transform] : transforms) {
+          if (Intersects(stroke.GetShape(), transform, query)) {
+            expected.push_back(id);
+          }
+        }
+        EXPECT_THAT(FindIntersectedStrokes(index, query),
+                    UnorderedElementsAreArray(expected))
+            << "query centered at (" << x << ", " << y << ")";
+      }
+    }
+  };
+
+  for (int id = 0; id < 500; ++id) {
+    insert(id, AffineTransform::Translate(
+                   {static_cast<float>(id % 10) * 11.f,
+                    static_cast<float>(id / 10) * 2.f}) *
+                   AffineTransform::Rotate(Angle::Radians(id * 0.1f)));
+  }
+  expect_matches_brute_force();
+
+  for (int id = 0; id < 500; id += 3) {
+    EXPECT_TRUE(index.UpdateTransform(
+        id, AffineTransform::Translate({static_cast<float>(id % 7) * 15.f,
+                                        static_cast<float>(id % 50) * 2.f})));
+    transforms[id] = AffineTransform::Translate(
+        {static_cast<float>(id % 7) * 15.f, static_cast<float>(id % 50) * 2.f});
+  }
+  expect_matches_brute_force();
+
+  for (int id = 0; id < 500; ++id) {
+    if (id % 5 == 0) continue;
+    EXPECT_TRUE(index.Remove(id));
+    transforms.erase(id);
+  }
+  expect_matches_brute_force();
+
+  for (int id = 1000; id < 1100; ++id) {
+    insert(id, AffineTransform::Translate(
+                   {static_cast<float>(id % 13) * 8.f,
+                    static_cast<float>(id % 17) * 6.f}));
+  }
+  expect_matches_brute_force();
+}
+
+}  // namespace
+}  // namespace ink
@@ -14,9 +14,12 @@
 
 #include "ink/strokes/stroke.h"
 
+#include <cstddef>
+#include <limits>
 #include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -631,6 +634,82 @@ TEST(StrokeTest, SubtractWithDegenerateTransformReturnsStroke) {
   EXPECT_THAT(result.GetShape(), PartitionedMeshDeepEq(stroke.GetShape()));
 }
 
+TEST(StrokeTest, SubtractionMaskCreateWithInvalidArguments) {
+  PartitionedMesh mask_shape = CreateFilledShape();
+
+  EXPECT_THAT(SubtractionMask::Create(mask_shape, AffineTransform::Scale(1, 0),
+                                      0.01),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(SubtractionMask::Create(mask_shape, AffineTransform(), 0),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(
+      SubtractionMask::Create(mask_shape, AffineTransform(),
+                              std::numeric_limits<float>::infinity()),
+      StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(StrokeTest, SubtractWithEmptySubtractionMaskReturnsStroke) {
+  Stroke stroke(CreateBrush(), CreateFilledInputs());
+
+  Stroke result = stroke.Subtract(SubtractionMask(), AffineTransform());
+
+  EXPECT_THAT(result.GetBrush(), BrushEq(stroke.GetBrush()));
+  EXPECT_THAT(result.GetInputs(), StrokeInputBatchEq(stroke.GetInputs()));
+}
+
+TEST(StrokeTest, SubtractWithSubtractionMaskMatchesMaskShape) {
+  Stroke stroke(CreateBrush(), CreateFilledInputs());
+  // Erase the right-hand side of the stroke with a copy of itself.
+  PartitionedMesh mask_shape = stroke.GetShape();
+  AffineTransform mask_transform = AffineTransform::Translate({3, 0});
+  absl::StatusOr<SubtractionMask> mask = SubtractionMask::Create(
+      mask_shape, mask_transform, stroke.GetBrush().GetEpsilon());
+  ASSERT_THAT(mask, IsOk());
+
+  Stroke result = stroke.Subtract(*mask, AffineTransform());
+
+  EXPECT_THAT(result.GetBrush(), BrushEq(stroke.GetBrush()));
+  EXPECT_THAT(result.GetInputs(), StrokeInputBatchEq(stroke.GetInputs()));
+  EXPECT_THAT(result.GetShape(),
+              PartitionedMeshDeepEq(
+                  stroke.Subtract(mask_shape, mask_transform, AffineTransform())
+                      .GetShape()));
+}
+
+TEST(StrokeTest, SubtractFromStrokesMatchesSubtract) {
+  Stroke stroke(CreateBrush(), CreateFilledInputs());
+  absl::StatusOr<SubtractionMask> mask =
+      SubtractionMask::Create(stroke.GetShape(), AffineTransform::Scale(0.5),
+                              stroke.GetBrush().GetEpsilon());
+  ASSERT_THAT(mask, IsOk());
+  std::vector<Stroke> strokes = {stroke, stroke, Stroke(CreateBrush())};
+  std::vector<AffineTransform> stroke_transforms = {
+      AffineTransform(), AffineTransform::Translate({-5, 0}),
+      AffineTransform()};
+
+  std::vector<Stroke> results =
+      SubtractFromStrokes(strokes, stroke_transforms, *mask);
+
+  ASSERT_THAT(results, SizeIs(strokes.size()));
+  for (size_t i = 0; i < strokes.size(); ++i) {
+    EXPECT_THAT(results[i].GetInputs(),
+                StrokeInputBatchEq(strokes[i].GetInputs()));
+    Stroke expected = strokes[i].Subtract(*mask, stroke_transforms[i]);
+    EXPECT_THAT(results[i].GetShape(),
+                PartitionedMeshDeepEq(expected.GetShape()))
+        << "stroke " << i;
+  }
+}
+
+TEST(StrokeDeathTest, SubtractFromStrokesWithMismatchedTransforms) {
+  Stroke stroke(CreateBrush(), CreateFilledInputs());
+  std::vector<Stroke> strokes = {stroke, stroke};
+  std::vector<AffineTransform> stroke_transforms = {AffineTransform()};
+
+  EXPECT_DEATH_IF_SUPPORTED(
+      SubtractFromStrokes(strokes, stroke_transforms, SubtractionMask()), "");
+}
+
 TEST(StrokeTest, ParticleBrushWithOneDimensionZero) {
   // Brush which will create a tip geometry with a width that is 0 and is a
   // particle brush, so it will hit the case in
@@ -0,0 +1,135 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ink/types/executor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/functional/function_ref.h"
+#include "absl/log/absl_check.h"
+#include "absl/synchronization/mutex.h"
+
+namespace ink {
+namespace {
+
+class SerialExecutorImpl : public Executor {
+ public:
+  void ParallelFor(size_t n, absl::FunctionRef<void(size_t)> task) override {
+    for (size_t i = 0; i < n; ++i) task(i);
+  }
+
+  bool IsSerial() const override { return true; }
+};
+
+}  // namespace
+
+void ParallelForRanges(size_t n, size_t elements_per_task, Executor& executor,
+                       absl::FunctionRef<void(size_t begin, size_t end)> fn) {
+  ABSL_CHECK_GT(elements_per_task, 0u);
+  size_t n_tasks = n / elements_per_task + (n % elements_per_task != 0);
+  executor.ParallelFor(n_tasks, [n, elements_per_task, fn](size_t task) {
+    size_t begin = task * elements_per_task;
+    fn(begin, begin + std::min(elements_per_task, n - begin));
+  });
+}
+
+Executor& SerialExecutor() {
+  static SerialExecutorImpl* executor = new SerialExecutorImpl();
+  return *executor;
+}
+
+ThreadExecutor::ThreadExecutor(int max_threads)
+    : max_threads_(std::max(max_threads, 1)) {
+  workers_.reserve(max_threads_ - 1);
+  for (int i = 1; i < max_threads_; ++i) {
+    workers_.emplace_back([this] { RunWorker(); });
+  }
+}
+
+ThreadExecutor::~ThreadExecutor() {
+  {
+    absl::MutexLock lock(mutex_);
+    stopping_ = true;
+  }
+  for (std::thread& worker : workers_) worker.join();
+}
+
+void ThreadExecutor::ParallelFor(size_t n,
+                                 absl::FunctionRef<void(size_t)> task) {
+  if (workers_.empty() || n <= 1) {
+    SerialExecutor().ParallelFor(n, task);
+    return;
+  }
+
+  absl::MutexLock batch_lock(batch_mutex_);
+  {
+    absl::MutexLock lock(mutex_);
+    task_ = &task;
+    n_tasks_ = n;
+    next_task_.store(0, std::memory_order_relaxed);
+    n_running_workers_ = workers_.size();
+    ++batch_id_;
+  }
+  RunTasks(task, n);
+
+  // Every worker has to finish the batch before `task` goes out of scope, even
+  // if there were no tasks left for it to claim.
+  absl::MutexLock lock(mutex_);
+  auto workers_are_done = [this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return n_running_workers_ == 0;
+  };
+  mutex_.Await(absl::Condition(&workers_are_done));
+  task_ = nullptr;
+}
+
+void ThreadExecutor::RunWorker() {
+  uint64_t last_batch_id = 0;
+  while (true) {
+    const absl::FunctionRef<void(size_t)>* task;
+    size_t n;
+    {
+      absl::MutexLock lock(mutex_);
+      auto has_work = [this, last_batch_id]()
+          ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+            return stopping_ || batch_id_ != last_batch_id;
+          };
+      mutex_.Await(absl::Condition(&has_work));
+      if (stopping_) return;
+      last_batch_id = batch_id_;
+      task = task_;
+      n = n_tasks_;
+    }
+    RunTasks(*task, n);
+    absl::MutexLock lock(mutex_);
+    --n_running_workers_;
+  }
+}
+
+void ThreadExecutor::RunTasks(absl::FunctionRef<void(size_t)> task, size_t n) {
+  // Tasks are handed out one at a time, so that threads that happen to get
+  // cheaper tasks pick up more of them. Releasing `mutex_` after the batch
+  // makes the results visible to the thread that called `ParallelFor`.
+  for (size_t i = next_task_.fetch_add(1, std::memory_order_relaxed); i < n;
+       i = next_task_.fetch_add(1, std::memory_order_relaxed)) {
+    task(i);
+  }
+}
+
+}  // namespace ink
@@ -0,0 +1,127 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INK_TYPES_EXECUTOR_H_
+#define INK_TYPES_EXECUTOR_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/functional/function_ref.h"
+#include "absl/synchronization/mutex.h"
+
+namespace ink {
+
+// Interface for running a batch of independent tasks, which lets callers of
+// expensive operations (e.g. `MutableMesh::AsMeshes`) decide whether, and on
+// which threads, that work is parallelized.
+//
+// Operations that accept an `Executor` only use it to run tasks that write to
+// disjoint state, and combine the results in a fixed order afterwards, so
+// their output does not depend on the implementation that is used.
+class Executor {
+ public:
+  virtual ~Executor() = default;
+
+  // Calls `task(i)` exactly once for each `i` in [0, `n`), and returns once
+  // all of those calls have completed. The calls may be made concurrently, on
+  // any thread, and in any order.
+  //
+  // Tasks must not call `ParallelFor` on the same `Executor`.
+  virtual void ParallelFor(size_t n, absl::FunctionRef<void(size_t)> task) = 0;
+
+  // Returns true if this never runs tasks concurrently, in which case callers
+  // may skip synchronizing the tasks with each other. This is false by default,
+  // which is always safe.
+  virtual bool IsSerial() const { return false; }
+};
+
+// Splits [0, `n`) into consecutive ranges of at most `elements_per_task`
+// elements, and calls `fn(begin, end)` for each of them as a task on
+// `executor`. `elements_per_task` must be positive; it should be large enough
+// that the cost of scheduling a task is negligible compared to the work done
+// for that many elements.
+void ParallelForRanges(size_t n, size_t elements_per_task, Executor& executor,
+                       absl::FunctionRef<void(size_t begin, size_t end)> fn);
+
+// Returns an `Executor` that runs every task on the calling thread, in order
+// of increasing index. This is the default for operations that take an
+// `Executor`.
+Executor& SerialExecutor();
+
+// An `Executor` that runs each batch of tasks on up to `max_threads` threads,
+// including the calling thread. The other `max_threads - 1` worker threads are
+// started on construction, wait between calls to `ParallelFor`, and are joined
+// on destruction, so a `ThreadExecutor` should be created once and reused, e.g.
+// for every frame. Each call still has to wake the workers and wait for them,
+// so this is only worthwhile for batches where the tasks do a substantial
+// amount of work in total.
+//
+// `ParallelFor` may be called from several threads at once, in which case the
+// batches are run one at a time.
+class ThreadExecutor : public Executor {
+ public:
+  // `max_threads` is clamped to be at least 1, in which case this behaves the
+  // same as `SerialExecutor()` and starts no threads.
+  explicit ThreadExecutor(int max_threads);
+
+  ThreadExecutor(const ThreadExecutor&) = delete;
+  ThreadExecutor& operator=(const ThreadExecutor&) = delete;
+
+  ~ThreadExecutor() override;
+
+  void ParallelFor(size_t n, absl::FunctionRef<void(size_t)> task) override;
+
+  bool IsSerial() const override { return max_threads_ == 1; }
+
+  int MaxThreads() const { return max_threads_; }
+
+ private:
+  // The loop run by each of `workers_`, which helps run each batch that
+  // `ParallelFor` starts until the executor is destroyed.
+  void RunWorker();
+
+  // Calls `task` for the indices in [0, `n`) that haven't been claimed yet by
+  // another thread running the same batch.
+  void RunTasks(absl::FunctionRef<void(size_t)> task, size_t n);
+
+  int max_threads_;
+
+  // Held by `ParallelFor` for the duration of a batch.
+  absl::Mutex batch_mutex_;
+
+  absl::Mutex mutex_;
+  // The current batch, which is only valid until `ParallelFor` returns.
+  const absl::FunctionRef<void(size_t)>* task_ ABSL_GUARDED_BY(mutex_) =
+      nullptr;
+  size_t n_tasks_ ABSL_GUARDED_BY(mutex_) = 0;
+  // Incremented for each batch, so that each worker can tell when there is a
+  // new one.
+  uint64_t batch_id_ ABSL_GUARDED_BY(mutex_) = 0;
+  // The number of workers that have not yet finished the current batch.
+  size_t n_running_workers_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool stopping_ ABSL_GUARDED_BY(mutex_) = false;
+  // The next task index of the current batch to be claimed by a thread.
+  std::atomic<size_t> next_task_ = 0;
+
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace ink
+
+#endif  // INK_TYPES_EXECUTOR_H_
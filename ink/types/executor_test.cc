@@ -0,0 +1,117 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ink/types/executor.h"
+
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace ink {
+namespace {
+
+using ::testing::Each;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::Pair;
+
+TEST(ExecutorTest, SerialExecutorRunsTasksInOrder) {
+  std::vector<size_t> order;
+  SerialExecutor().ParallelFor(4, [&order](size_t i) { order.push_back(i); });
+  EXPECT_THAT(order, ElementsAre(0, 1, 2, 3));
+}
+
+TEST(ExecutorTest, SerialExecutorWithNoTasks) {
+  std::vector<size_t> order;
+  SerialExecutor().ParallelFor(0, [&order](size_t i) { order.push_back(i); });
+  EXPECT_THAT(order, IsEmpty());
+}
+
+TEST(ExecutorTest, IsSerial) {
+  EXPECT_TRUE(SerialExecutor().IsSerial());
+  EXPECT_TRUE(ThreadExecutor(1).IsSerial());
+  EXPECT_FALSE(ThreadExecutor(2).IsSerial());
+}
+
+TEST(ExecutorTest, ThreadExecutorClampsMaxThreads) {
+  EXPECT_EQ(ThreadExecutor(4).MaxThreads(), 4);
+  EXPECT_EQ(ThreadExecutor(0).MaxThreads(), 1);
+  EXPECT_EQ(ThreadExecutor(-3).MaxThreads(), 1);
+}
+
+TEST(ExecutorTest, ThreadExecutorRunsEachTaskOnce) {
+  for (int max_threads : {1, 2, 8}) {
+    ThreadExecutor executor(max_threads);
+    for (size_t n : {0, 1, 3, 1000}) {
+      std::vector<int> run_counts(n, 0);
+      executor.ParallelFor(n, [&run_counts](size_t i) { ++run_counts[i]; });
+      EXPECT_THAT(run_counts, Each(1))
+          << "max_threads: " << max_threads << ", n: " << n;
+    }
+  }
+}
+
+TEST(ExecutorTest, ThreadExecutorCanBeReused) {
+  ThreadExecutor executor(4);
+  std::vector<int> run_counts(64, 0);
+  for (int i = 0; i < 100; ++i) {
+    executor.ParallelFor(run_counts.size(),
+                         [&run_counts](size_t i) { ++run_counts[i]; });
+  }
+  EXPECT_THAT(run_counts, Each(100));
+}
+
+TEST(ExecutorTest, ThreadExecutorAllowsConcurrentCalls) {
+  ThreadExecutor executor(4);
+  auto run_batches = [&executor]() {
+    for (int i = 0; i < 50; ++i) {
+      std::vector<int> run_counts(16, 0);
+      executor.ParallelFor(run_counts.size(),
+                           [&run_counts](size_t i) { ++run_counts[i]; });
+      EXPECT_THAT(run_counts, Each(1));
+    }
+  };
+  std::thread other_thread(run_batches);
+  run_batches();
+  other_thread.join();
+}
+
+TEST(ExecutorTest, ParallelForRangesCoversEachElementOnce) {
+  ThreadExecutor executor(4);
+  for (size_t n : {0, 1, 9, 10, 11, 1000}) {
+    std::vector<int> run_counts(n, 0);
+    ParallelForRanges(n, 10, executor,
+                      [&run_counts](size_t begin, size_t end) {
+                        EXPECT_LE(end - begin, 10u);
+                        for (size_t i = begin; i < end; ++i) ++run_counts[i];
+                      });
+    EXPECT_THAT(run_counts, Each(1)) << "n: " << n;
+  }
+}
+
+TEST(ExecutorTest, ParallelForRangesWithSerialExecutorRunsRangesInOrder) {
+  std::vector<std::pair<size_t, size_t>> ranges;
+  ParallelForRanges(7, 3, SerialExecutor(),
+                    [&ranges](size_t begin, size_t end) {
+                      ranges.emplace_back(begin, end);
+                    });
+  EXPECT_THAT(ranges, ElementsAre(Pair(0, 3), Pair(3, 6), Pair(6, 7)));
+}
+
+}  // namespace
+}  // namespace ink